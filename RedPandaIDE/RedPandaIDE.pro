@@ -135,6 +135,7 @@ SOURCES += \
     compiler/compilermanager.cpp \
     compiler/executablerunner.cpp \
     compiler/filecompiler.cpp \
+    compiler/precompiledheaderbuilder.cpp \
     compiler/stdincompiler.cpp \
     debugger/debugger.cpp \
     debugger/gdbmidebugger.cpp \
@@ -194,10 +195,12 @@ SOURCES += \
     widgets/choosethemedialog.cpp \
     widgets/classbrowser.cpp \
     widgets/codecompletionlistview.cpp \
+    widgets/codecompletionmatcher.cpp \
     widgets/codecompletionpopup.cpp \
     widgets/cpudialog.cpp \
     editor.cpp \
     editorlist.cpp \
+    filesearcher.cpp \
     iconsmanager.cpp \
     main.cpp \
     mainwindow.cpp \
@@ -231,6 +234,7 @@ SOURCES += \
     widgets/filepropertiesdialog.cpp \
     widgets/functiontooltipwidget.cpp \
     widgets/headercompletionpopup.cpp \
+    widgets/includedirindex.cpp \
     widgets/infomessagebox.cpp \
     widgets/issuestable.cpp \
     widgets/labelwithmenu.cpp \
@@ -272,6 +276,7 @@ HEADERS += \
     compiler/ojproblemcasesrunner.h \
     compiler/projectcompiler.h \
     compiler/runner.h \
+    compiler/precompiledheaderbuilder.h \
     compiler/stdincompiler.h \
     debugger/debugger.h \
     debugger/gdbmidebugger.h \
@@ -332,10 +337,12 @@ HEADERS += \
     widgets/choosethemedialog.h \
     widgets/classbrowser.h \
     widgets/codecompletionlistview.h \
+    widgets/codecompletionmatcher.h \
     widgets/codecompletionpopup.h \
     widgets/cpudialog.h \
     editor.h \
     editorlist.h \
+    filesearcher.h \
     iconsmanager.h \
     mainwindow.h \
     settingsdialog/compilersetdirectorieswidget.h \
@@ -369,6 +376,7 @@ HEADERS += \
     widgets/filepropertiesdialog.h \
     widgets/functiontooltipwidget.h \
     widgets/headercompletionpopup.h \
+    widgets/includedirindex.h \
     widgets/infomessagebox.h \
     widgets/issuestable.h \
     widgets/labelwithmenu.h \
@@ -22,10 +22,12 @@
 #include "../systemconsts.h"
 
 #include <cmath>
+#include <QEventLoop>
 #include <QFileInfo>
 #include <QProcess>
 #include <QString>
 #include <QTime>
+#include <QTimer>
 #include <QApplication>
 #include "../editor.h"
 #include "../mainwindow.h"
@@ -43,7 +45,8 @@ Compiler::Compiler(const QString &filename, bool onlyCheckSyntax):
     mFilename{filename},
     mRebuild{false},
     mParserForFile{},
-    mForceEnglishOutput{false}
+    mForceEnglishOutput{false},
+    mStop{false}
 {
     getParserForFile(filename);
 }
@@ -63,6 +66,7 @@ void Compiler::run()
         }
         mErrorCount = 0;
         mWarningCount = 0;
+        mProcessExitTimer.invalidate();
         QElapsedTimer timer;
         timer.start();
         runCommand(mCompiler, mArguments, mDirectory, pipedText());
@@ -88,6 +92,8 @@ void Compiler::run()
             log(tr("- Output Size: %1").arg(locale.formattedDataSize(QFileInfo(mOutputFile).size())));
         }
         log(tr("- Compilation Time: %1 secs").arg(timer.elapsed() / 1000.0));
+        if (mProcessExitTimer.isValid())
+            log(tr("- Process Exit to Result: %1 ms").arg(mProcessExitTimer.nsecsElapsed() / 1000000.0));
     } catch (CompileError e) {
         emit compileErrorOccured(e.reason());
     }
@@ -347,6 +353,11 @@ void Compiler::stopCompile()
     mStop = true;
 }
 
+bool Compiler::isStopped() const
+{
+    return mStop;
+}
+
 QStringList Compiler::getCharsetArgument(const QByteArray& encoding,FileType fileType, bool checkSyntax)
 {
     QStringList result;
@@ -702,15 +713,9 @@ bool Compiler::parseForceUTF8ForAutolink(const QString &filename, QSet<QString>
     return false;
 }
 
-void Compiler::runCommand(const QString &cmd, const QStringList &arguments, const QString &workingDir, const QByteArray& inputText, const QString& outputFile)
+QProcessEnvironment Compiler::processEnvironment(const QString &cmd)
 {
-    QProcess process;
-    mStop = false;
-    bool errorOccurred = false;
-    process.setProgram(cmd);
     QString cmdDir = extractFileDir(cmd);
-    bool compilerErrorUTF8=compilerSet()->isCompilerInfoUsingUTF8();
-    bool outputUTF8=compilerSet()->forceUTF8();
     QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
 #ifdef Q_OS_WIN
     QStringList binDirs=compilerSet()->binDirs();
@@ -737,6 +742,20 @@ void Compiler::runCommand(const QString &cmd, const QStringList &arguments, cons
     env.insert("LDFLAGS","");
     env.insert("CFLAGS","");
     env.insert("CXXFLAGS","");
+    return env;
+}
+
+void Compiler::runCommand(const QString &cmd, const QStringList &arguments, const QString &workingDir, const QByteArray& inputText, const QString& outputFile)
+{
+    // stopped before the process is started
+    if (mStop)
+        return;
+    QProcess process;
+    bool errorOccurred = false;
+    process.setProgram(cmd);
+    bool compilerErrorUTF8=compilerSet()->isCompilerInfoUsingUTF8();
+    bool outputUTF8=compilerSet()->forceUTF8();
+    QProcessEnvironment env = processEnvironment(cmd);
     process.setProcessEnvironment(env);
     process.setArguments(arguments);
     process.setWorkingDirectory(workingDir);
@@ -769,29 +788,30 @@ void Compiler::runCommand(const QString &cmd, const QStringList &arguments, cons
         }
     });
     process.connect(&process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),[this](){
+        mProcessExitTimer.start();
         this->error(COMPILE_PROCESS_END);
     });
+    // wait for the notifications of the process, instead of polling it
+    QEventLoop loop;
+    process.connect(&process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+                    &loop, &QEventLoop::quit);
+    process.connect(&process, &QProcess::errorOccurred, &loop, &QEventLoop::quit);
+    // stopCompile() is called from other threads, so it's checked periodically
+    QTimer stopTimer;
+    stopTimer.setInterval(100);
+    process.connect(&stopTimer, &QTimer::timeout, &loop, [&process,this](){
+        if (mStop)
+            process.terminate();
+    });
     process.start();
     process.waitForStarted(5000);
-    if (!inputText.isEmpty()) {
+    if (!inputText.isEmpty())
         process.write(inputText);
-        process.waitForFinished(0);
-    }
-    bool writeChannelClosed = false;
-    while (true) {
-        if (process.bytesToWrite()==0 && !writeChannelClosed ) {
-            writeChannelClosed=true;
-            process.closeWriteChannel();
-        }
-        process.waitForFinished(100);
-        if (process.state()!=QProcess::Running) {
-            break;
-        }
-        if (mStop) {
-            process.terminate();
-        }
-        if (errorOccurred)
-            break;
+    // closed after all input is written
+    process.closeWriteChannel();
+    if (process.state()!=QProcess::NotRunning && !errorOccurred) {
+        stopTimer.start();
+        loop.exec();
     }
     if (errorOccurred) {
         switch (process.error()) {
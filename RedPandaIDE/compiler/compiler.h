@@ -17,6 +17,8 @@
 #ifndef COMPILER_H
 #define COMPILER_H
 
+#include <QElapsedTimer>
+#include <QProcessEnvironment>
 #include <QThread>
 #include "settings.h"
 #include "../common.h"
@@ -46,6 +48,8 @@ public:
 
     PCppParser parser() const;
 
+    bool isStopped() const;
+
 signals:
     void compileStarted();
     void compileFinished(QString filename);
@@ -85,6 +89,7 @@ protected:
             QSet<QString>& parsedFiles);
     void log(const QString& msg);
     void error(const QString& msg);
+    QProcessEnvironment processEnvironment(const QString& cmd);
     void runCommand(const QString& cmd, const QStringList& arguments, const QString& workingDir, const QByteArray& inputText=QByteArray(), const QString& outputFile=QString());
     QString escapeCommandForLog(const QString &cmd, const QStringList &arguments);
 
@@ -109,6 +114,8 @@ protected:
 
 private:
     bool mStop;
+    // started when the last command exits, for the latency of the compile result
+    QElapsedTimer mProcessExitTimer;
 };
 
 
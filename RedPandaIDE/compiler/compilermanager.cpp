@@ -22,6 +22,7 @@
 #include "sdccprojectcompiler.h"
 #endif
 #include "stdincompiler.h"
+#include "precompiledheaderbuilder.h"
 #include "../mainwindow.h"
 #include "executablerunner.h"
 #include "ojproblemcasesrunner.h"
@@ -29,6 +30,7 @@
 #include "utils/parsearg.h"
 #include "../systemconsts.h"
 #include "../settings.h"
+#include <QDir>
 #include <QMessageBox>
 #include <QUuid>
 #include "projectcompiler.h"
@@ -36,6 +38,9 @@
 #include <sys/posix_shm.h>
 #endif
 
+// precompiled headers kept for syntax checks
+#define SYNTAX_CHECK_PCH_MAX_COUNT 4
+
 CompilerManager::CompilerManager(QObject *parent) : QObject(parent),
     mCompileMutex(),
     mBackgroundSyntaxCheckMutex(),
@@ -43,6 +48,7 @@ CompilerManager::CompilerManager(QObject *parent) : QObject(parent),
 {
     mCompiler = nullptr;
     mBackgroundSyntaxChecker = nullptr;
+    mPrecompiledHeaderBuilder = nullptr;
     mRunner = nullptr;
     mSyntaxCheckErrorCount = 0;
     mSyntaxCheckIssueCount = 0;
@@ -51,6 +57,16 @@ CompilerManager::CompilerManager(QObject *parent) : QObject(parent),
     mSyntaxCheckErrorCount = 0;
 }
 
+CompilerManager::~CompilerManager()
+{
+    // don't leave the compiler process and its temporary output behind
+    if (mPrecompiledHeaderBuilder) {
+        mPrecompiledHeaderBuilder->stop();
+        mPrecompiledHeaderBuilder->wait();
+        delete mPrecompiledHeaderBuilder;
+    }
+}
+
 bool CompilerManager::compiling()
 {
     QMutexLocker locker(&mCompileMutex);
@@ -381,6 +397,7 @@ void CompilerManager::doRunProblem(const QString &filename, const QString &argum
         execRunner->setExecTimeout(timeLimit);
     if (memoryLimit)
         execRunner->setMemoryLimit(memoryLimit);
+    execRunner->setParallelCount(pSettings->executor().parallelCaseCount());
     connect(mRunner, &Runner::finished, this ,&CompilerManager::onRunnerTerminated);
     connect(mRunner, &Runner::finished, mRunner ,&Runner::deleteLater);
     connect(mRunner, &Runner::finished, pMainWindow ,&MainWindow::onRunProblemFinished);
@@ -429,11 +446,23 @@ void CompilerManager::stopCompile()
         mCompiler->stopCompile();
 }
 
-void CompilerManager::stopCheckSyntax()
+void CompilerManager::stopCheckSyntax(bool stopPrecompiledHeaderBuild)
 {
     QMutexLocker locker(&mBackgroundSyntaxCheckMutex);
     if (mBackgroundSyntaxChecker!=nullptr)
         mBackgroundSyntaxChecker->stopCompile();
+    if (stopPrecompiledHeaderBuild && mPrecompiledHeaderBuilder!=nullptr)
+        mPrecompiledHeaderBuilder->stop();
+}
+
+void CompilerManager::removePrecompiledHeaders()
+{
+    QMutexLocker locker(&mBackgroundSyntaxCheckMutex);
+    if (mPrecompiledHeaderBuilder!=nullptr)
+        mPrecompiledHeaderBuilder->stop();
+    mFailedPrecompiledHeaders.clear();
+    QDir dir(includeTrailingPathDelimiter(pSettings->dirs().config()) + DEV_SYNTAX_CHECK_PCH_DIR);
+    dir.removeRecursively();
 }
 
 bool CompilerManager::canCompile(const QString &)
@@ -476,10 +505,54 @@ void CompilerManager::onCompileIssue(PCompileIssue issue)
 void CompilerManager::onSyntaxCheckFinished(QString filename)
 {
     QMutexLocker locker(&mBackgroundSyntaxCheckMutex);
+    // the checker is deleted later, after its thread is finished
+    if (mBackgroundSyntaxChecker!=nullptr && !mBackgroundSyntaxChecker->isStopped()
+            && !mBackgroundSyntaxChecker->precompiledHeaderTask().header.isEmpty())
+        buildPrecompiledHeader(mBackgroundSyntaxChecker->precompiledHeaderTask());
     mBackgroundSyntaxChecker=nullptr;
     pMainWindow->onCompileFinished(filename, true);
 }
 
+void CompilerManager::buildPrecompiledHeader(const PrecompiledHeaderTask &task)
+{
+    // one at a time, the others are requested again by later checks
+    if (mPrecompiledHeaderBuilder!=nullptr)
+        return;
+    if (mFailedPrecompiledHeaders.contains(task.header))
+        return;
+    mPrecompiledHeaderBuilder = new PrecompiledHeaderBuilder(task);
+    connect(mPrecompiledHeaderBuilder, &QThread::finished,
+            this, &CompilerManager::onPrecompiledHeaderBuilt);
+    mPrecompiledHeaderBuilder->start();
+}
+
+void CompilerManager::onPrecompiledHeaderBuilt()
+{
+    QMutexLocker locker(&mBackgroundSyntaxCheckMutex);
+    if (mPrecompiledHeaderBuilder==nullptr)
+        return;
+    // a stopped build is tried again by the next check
+    if (!mPrecompiledHeaderBuilder->succeeded() && !mPrecompiledHeaderBuilder->isStopped())
+        mFailedPrecompiledHeaders.insert(mPrecompiledHeaderBuilder->header());
+    if (mPrecompiledHeaderBuilder->succeeded())
+        removeLeastRecentlyUsedPrecompiledHeaders();
+    mPrecompiledHeaderBuilder->deleteLater();
+    mPrecompiledHeaderBuilder = nullptr;
+}
+
+void CompilerManager::removeLeastRecentlyUsedPrecompiledHeaders()
+{
+    // a .gch of bits/stdc++.h is hundreds of MB, so only a few are kept.
+    // StdinCompiler touches the .gch when it's used.
+    QDir dir(includeTrailingPathDelimiter(pSettings->dirs().config()) + DEV_SYNTAX_CHECK_PCH_DIR);
+    QFileInfoList list = dir.entryInfoList(QStringList{"*.h.gch"}, QDir::Files, QDir::Time);
+    for (int i=SYNTAX_CHECK_PCH_MAX_COUNT;i<list.count();i++) {
+        QString gch = list[i].absoluteFilePath();
+        QFile::remove(gch);
+        QFile::remove(gch.chopped(4));
+    }
+}
+
 void CompilerManager::onSyntaxCheckIssue(PCompileIssue issue)
 {
     if (issue->type == CompileIssueType::Error)
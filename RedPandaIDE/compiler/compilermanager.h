@@ -19,6 +19,7 @@
 
 #include <QObject>
 #include <QMutex>
+#include <QSet>
 #include "qt_utils/utils.h"
 #include "../utils.h"
 #include "../common.h"
@@ -33,6 +34,9 @@ class Runner;
 class Project;
 class Compiler;
 class ProjectCompiler;
+class StdinCompiler;
+class PrecompiledHeaderBuilder;
+struct PrecompiledHeaderTask;
 struct OJProblem;
 using POJProblem = std::shared_ptr<OJProblem>;
 struct OJProblemCase;
@@ -44,6 +48,7 @@ public:
     explicit CompilerManager(QObject *parent = nullptr);
     CompilerManager(const CompilerManager&)=delete;
     CompilerManager& operator=(const CompilerManager&)=delete;
+    ~CompilerManager();
 
     bool compiling();
     bool backgroundSyntaxChecking();
@@ -70,7 +75,12 @@ public:
     void stopAllRunners();
     void stopPausing();
     void stopCompile();
-    void stopCheckSyntax();
+    // A stale check is stopped without the precompiled header build,
+    // so the header can still be used by the next checks.
+    void stopCheckSyntax(bool stopPrecompiledHeaderBuild=true);
+    // Removes the precompiled headers used by syntax checks,
+    // since they are outdated once the compiler sets are changed.
+    void removePrecompiledHeaders();
     bool canCompile(const QString& filename);
     int compileErrorCount() const;
 
@@ -93,15 +103,20 @@ private slots:
     void onCompileIssue(PCompileIssue issue);
     void onSyntaxCheckFinished(QString filename);
     void onSyntaxCheckIssue(PCompileIssue issue);
+    void onPrecompiledHeaderBuilt();
 private:
     ProjectCompiler* createProjectCompiler(std::shared_ptr<Project> project);
+    void buildPrecompiledHeader(const PrecompiledHeaderTask& task);
+    void removeLeastRecentlyUsedPrecompiledHeaders();
 private:
     Compiler* mCompiler;
     int mCompileErrorCount;
     int mCompileIssueCount;
     int mSyntaxCheckErrorCount;
     int mSyntaxCheckIssueCount;
-    Compiler* mBackgroundSyntaxChecker;
+    StdinCompiler* mBackgroundSyntaxChecker;
+    PrecompiledHeaderBuilder* mPrecompiledHeaderBuilder;
+    QSet<QString> mFailedPrecompiledHeaders;
     Runner* mRunner;
     PNonExclusiveTemporaryFileOwner mTempFileOwner;
     QRecursiveMutex mCompileMutex;
@@ -19,17 +19,256 @@
 #include "../settings.h"
 #include "../systemconsts.h"
 #include <QElapsedTimer>
+#include <QEventLoop>
 #include <QProcess>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QTimer>
 #ifdef Q_OS_WINDOWS
 #include <psapi.h>
 #endif
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/ptrace.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#endif
+
+#ifdef Q_OS_LINUX
+// Sent by the supervisor when the program exits
+struct CaseUsage {
+    struct rusage usage;
+    // VmHWM of the program in kb, -1 if it's unknown.
+    // ru_maxrss can't be used: it also counts the forked image before exec.
+    long long peakMemory;
+};
+
+// Reads VmHWM from /proc/<pid>/status. Only async-signal-safe calls are used.
+static long long readPeakMemory(pid_t pid)
+{
+    char path[32] = "/proc/";
+    char digits[16];
+    int len = 0;
+    do {
+        digits[len++] = '0' + pid % 10;
+        pid /= 10;
+    } while (pid > 0);
+    int pos = 6;
+    while (len > 0)
+        path[pos++] = digits[--len];
+    const char *suffix = "/status";
+    for (int i=0; suffix[i]; i++)
+        path[pos++] = suffix[i];
+    path[pos] = '\0';
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+    char buffer[8192];
+    size_t size = 0;
+    while (size < sizeof(buffer) - 1) {
+        ssize_t n = read(fd, buffer + size, sizeof(buffer) - 1 - size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        size += n;
+    }
+    close(fd);
+    buffer[size] = '\0';
+    const char *key = "\nVmHWM:";
+    for (size_t i=0; i<size; i++) {
+        int j = 0;
+        while (key[j] && buffer[i+j] == key[j])
+            j++;
+        if (key[j])
+            continue;
+        const char *p = buffer + i + j;
+        while (*p == ' ' || *p == '\t')
+            p++;
+        if (*p < '0' || *p > '9')
+            return -1;
+        long long value = 0;
+        while (*p >= '0' && *p <= '9')
+            value = value * 10 + (*p++ - '0');
+        return value;
+    }
+    return -1;
+}
+
+// Runs in the forked child, just before the case program is executed.
+// The child forks again: the grandchild goes on to exec the program,
+// while the child traces it, reads its peak memory when it's stopped at exit,
+// sends the usage through usageFd, and exits with the same status.
+// Only async-signal-safe calls are allowed here.
+static void superviseCaseProcess(int usageFd)
+{
+    signal(SIGCHLD, SIG_DFL);
+    pid_t supervisor = getpid();
+    pid_t pid = fork();
+    if (pid < 0)
+        return; // run the program without usage accounting
+    if (pid == 0) {
+        // don't outlive the supervisor, which is what QProcess kills
+        prctl(PR_SET_PDEATHSIG, SIGKILL);
+        if (getppid() != supervisor)
+            _exit(-1);
+        // if tracing is not allowed, the peak memory is unknown
+        ptrace(PTRACE_TRACEME, 0, nullptr, nullptr);
+        return;
+    }
+    // keep only usageFd, so pipes and QProcess's startup notification
+    // are closed as soon as the program is executed
+    if (usageFd != 3) {
+        dup2(usageFd, 3);
+        usageFd = 3;
+    }
+    for (int fd=0; fd<3; fd++)
+        close(fd);
+#ifdef SYS_close_range
+    if (syscall(SYS_close_range, 4, ~0U, 0) != 0)
+#endif
+    {
+        long maxFd = sysconf(_SC_OPEN_MAX);
+        for (long fd=4; fd<maxFd; fd++)
+            close(fd);
+    }
+    CaseUsage caseUsage;
+    caseUsage.peakMemory = -1;
+    bool executed = false;
+    int status = 0;
+    for (;;) {
+        if (wait4(pid, &status, 0, &caseUsage.usage) < 0) {
+            if (errno == EINTR)
+                continue;
+            _exit(-1);
+        }
+        if (!WIFSTOPPED(status))
+            break;
+        int sig = WSTOPSIG(status);
+        if (sig == SIGTRAP && (status >> 16) == PTRACE_EVENT_EXIT) {
+            // the program's memory is not released yet
+            caseUsage.peakMemory = readPeakMemory(pid);
+            sig = 0;
+        } else if (sig == SIGTRAP && !executed) {
+            // stopped after exec
+            executed = true;
+            ptrace(PTRACE_SETOPTIONS, pid, nullptr,
+                   (void*)(long)(PTRACE_O_TRACEEXIT | PTRACE_O_EXITKILL));
+            sig = 0;
+        }
+        // other signals are delivered to the program as usual
+        ptrace(PTRACE_CONT, pid, nullptr, (void*)(long)sig);
+    }
+    const char *data = reinterpret_cast<const char *>(&caseUsage);
+    size_t written = 0;
+    while (written < sizeof(caseUsage)) {
+        ssize_t n = write(usageFd, data + written, sizeof(caseUsage) - written);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        written += n;
+    }
+    if (WIFSIGNALED(status)) {
+        signal(WTERMSIG(status), SIG_DFL);
+        kill(supervisor, WTERMSIG(status));
+    }
+    _exit(WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+}
+#endif
+
+// QProcess that also collects cpu time and peak memory of the program on linux
+class CaseProcess : public QProcess {
+public:
+    explicit CaseProcess() {
+#ifdef Q_OS_LINUX
+        if (pipe2(mUsagePipe, O_CLOEXEC) != 0) {
+            mUsagePipe[0] = -1;
+            mUsagePipe[1] = -1;
+        }
+#if QT_VERSION_MAJOR >= 6
+        int usageFd = mUsagePipe[1];
+        if (usageFd >= 0)
+            setChildProcessModifier([usageFd]() {
+                superviseCaseProcess(usageFd);
+            });
+#endif
+#endif
+    }
+    ~CaseProcess() {
+#ifdef Q_OS_LINUX
+        closeUsageWriteEnd();
+        if (mUsagePipe[0] >= 0)
+            ::close(mUsagePipe[0]);
+#endif
+    }
+#ifdef Q_OS_LINUX
+    // must be called after start(), or reading usage never gets eof
+    void closeUsageWriteEnd() {
+        if (mUsagePipe[1] >= 0) {
+            ::close(mUsagePipe[1]);
+            mUsagePipe[1] = -1;
+        }
+    }
+    // false if the supervisor is killed before the program exits
+    bool readUsage(CaseUsage& usage) {
+        if (mUsagePipe[0] < 0 || mUsagePipe[1] >= 0)
+            return false;
+        char *data = reinterpret_cast<char *>(&usage);
+        size_t readed = 0;
+        while (readed < sizeof(usage)) {
+            ssize_t n = ::read(mUsagePipe[0], data + readed, sizeof(usage) - readed);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            readed += n;
+        }
+        return true;
+    }
+#endif
+protected:
+#if defined(Q_OS_LINUX) && QT_VERSION_MAJOR < 6
+    void setupChildProcess() override {
+        if (mUsagePipe[1] >= 0)
+            superviseCaseProcess(mUsagePipe[1]);
+    }
+#endif
+private:
+#ifdef Q_OS_LINUX
+    int mUsagePipe[2];
+#endif
+};
+
+class ProblemCaseTask : public QRunnable {
+public:
+    ProblemCaseTask(OJProblemCasesRunner* runner, int index, POJProblemCase problemCase):
+        mRunner{runner},
+        mIndex{index},
+        mProblemCase{problemCase} {}
+    void run() override {
+        mRunner->runCase(mIndex, mProblemCase, true);
+    }
+private:
+    OJProblemCasesRunner* mRunner;
+    int mIndex;
+    POJProblemCase mProblemCase;
+};
 
 
 OJProblemCasesRunner::OJProblemCasesRunner(const QString& filename, const QStringList& arguments, const QString& workDir,
                                            const QVector<POJProblemCase>& problemCases, QObject *parent):
     Runner(filename,arguments,workDir,parent),
     mExecTimeout(0),
-    mMemoryLimit(0)
+    mMemoryLimit(0),
+    mParallelCount(1),
+    mFinishedCount(0)
 {
     mProblemCases = problemCases;
     mBufferSize = 8192;
@@ -41,7 +280,9 @@ OJProblemCasesRunner::OJProblemCasesRunner(const QString& filename, const QStrin
                                            POJProblemCase problemCase, QObject *parent):
     Runner(filename,arguments,workDir,parent),
     mExecTimeout(0),
-    mMemoryLimit(0)
+    mMemoryLimit(0),
+    mParallelCount(1),
+    mFinishedCount(0)
 {
     mProblemCases.append(problemCase);
     mBufferSize = 8192;
@@ -49,18 +290,33 @@ OJProblemCasesRunner::OJProblemCasesRunner(const QString& filename, const QStrin
     setWaitForFinishTime(100);
 }
 
-void OJProblemCasesRunner::runCase(int index,POJProblemCase problemCase)
+void OJProblemCasesRunner::runCase(int index,POJProblemCase problemCase, bool parallel)
 {
-    emit caseStarted(problemCase->getId(),index, mProblemCases.count());
-    auto action = finally([this,&index, &problemCase]{
-        emit caseFinished(problemCase->getId(), index, mProblemCases.count());
+    // When cases run in parallel, the output and notifications of a case are
+    // held back until it finishes, so they don't interleave with other cases.
+    if (parallel && mStop)
+        return;
+    QString stderrOutput;
+    {
+        // not mixed into the notifications of a finished parallel case
+        QMutexLocker locker(&mNotifyMutex);
+        // cases finish out of order in parallel, so the progress is the finished count
+        emit caseStarted(problemCase->getId(), parallel?mFinishedCount:index, mProblemCases.count(), parallel);
+    }
+    auto action = finally([this,&index, &problemCase, &parallel, &stderrOutput]{
+        if (parallel) {
+            QMutexLocker locker(&mNotifyMutex);
+            if (!stderrOutput.isEmpty())
+                emit logStderrOutput(stderrOutput);
+            emit resetOutput(problemCase->getId(), problemCase->output);
+            emit caseFinished(problemCase->getId(), mFinishedCount++, mProblemCases.count());
+        } else
+            emit caseFinished(problemCase->getId(), index, mProblemCases.count());
     });
-    QProcess process;
+    CaseProcess process;
     bool errorOccurred = false;
-    QByteArray readed;
     QByteArray buffer;
     QByteArray output;
-    int noOutputTime = 0;
     QElapsedTimer elapsedTimer;
     bool execTimeouted = false;
     process.setProgram(mFilename);
@@ -69,7 +325,6 @@ void OJProblemCasesRunner::runCase(int index,POJProblemCase problemCase)
     QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
     QString path = env.value("PATH");
     QStringList pathAdded;
-    bool writeChannelClosed = false;
     if (pSettings->compilerSets().defaultSet()) {
         foreach(const QString& dir, pSettings->compilerSets().defaultSet()->binDirs()) {
             pathAdded.append(dir);
@@ -84,7 +339,11 @@ void OJProblemCasesRunner::runCase(int index,POJProblemCase problemCase)
     env.insert("PATH",path);
     process.setProcessEnvironment(env);
     if (pSettings->executor().redirectStderrToToolLog()) {
-        emit logStderrOutput("\n"+tr("--- stderr from %1 ---").arg(problemCase->name)+"\n");
+        QString header = "\n"+tr("--- stderr from %1 ---").arg(problemCase->name)+"\n";
+        if (parallel)
+            stderrOutput += header;
+        else
+            emit logStderrOutput(header);
     } else {
         process.setProcessChannelMode(QProcess::MergedChannels);
         process.setReadChannel(QProcess::StandardOutput);
@@ -96,6 +355,9 @@ void OJProblemCasesRunner::runCase(int index,POJProblemCase problemCase)
     });
     problemCase->output.clear();
     process.start();
+#ifdef Q_OS_LINUX
+    process.closeUsageWriteEnd();
+#endif
     process.waitForStarted(5000);
 #ifdef Q_OS_WIN
     HANDLE hProcess = NULL;
@@ -108,51 +370,82 @@ void OJProblemCasesRunner::runCase(int index,POJProblemCase problemCase)
             process.write(readFileToByteArray(problemCase->inputFileName));
         else
             process.write(problemCase->input.toLocal8Bit());
-        process.waitForFinished(0);
     }
+    // closed after all input is written
+    process.closeWriteChannel();
 
-    elapsedTimer.start();
-    while (true) {
-        if (process.bytesToWrite()==0 && !writeChannelClosed) {
-            writeChannelClosed = true;
-            process.closeWriteChannel();
-        }
-        process.waitForFinished(mWaitForFinishTime);
-        if (process.state()!=QProcess::Running) {
-            break;
-        }
-        if (mExecTimeout>0) {
-            int msec = elapsedTimer.elapsed();
-            if (msec>mExecTimeout) {
-                execTimeouted=true;
-            }
-        }
-        if (mStop || execTimeouted) {
-            process.terminate();
-            process.kill();
-            break;
-        }
-        if (errorOccurred)
-            break;
-        if (pSettings->executor().redirectStderrToToolLog()) {
+    // Everything below is driven by the process's notifications,
+    // so the case is done as soon as the program exits.
+    QEventLoop loop;
+    QTimer flushTimer;
+    flushTimer.setSingleShot(true);
+    flushTimer.setInterval(mOutputRefreshTime);
+    auto flushOutput = [&]() {
+        flushTimer.stop();
+        if (buffer.isEmpty())
+            return;
+        if (!parallel)
+            emit newOutputGetted(problemCase->getId(),QString::fromLocal8Bit(buffer));
+        output.append(buffer);
+        buffer.clear();
+    };
+    connect(&flushTimer, &QTimer::timeout, &loop, flushOutput);
+    connect(&process, &QProcess::readyReadStandardOutput, &loop, [&]() {
+        buffer += process.readAllStandardOutput();
+        if (buffer.length()>=mBufferSize)
+            flushOutput();
+        else if (!buffer.isEmpty() && !flushTimer.isActive())
+            flushTimer.start();
+    });
+    if (pSettings->executor().redirectStderrToToolLog()) {
+        connect(&process, &QProcess::readyReadStandardError, &loop, [&]() {
             QString s = QString::fromLocal8Bit(process.readAllStandardError());
-            if (!s.isEmpty())
+            if (parallel)
+                stderrOutput += s;
+            else if (!s.isEmpty())
                 emit logStderrOutput(s);
-        }
-        readed = process.read(mBufferSize);
-        buffer += readed;
-        if (buffer.length()>=mBufferSize || noOutputTime > mOutputRefreshTime) {
-            if (!buffer.isEmpty()) {
-                emit newOutputGetted(problemCase->getId(),QString::fromLocal8Bit(buffer));
-                output.append(buffer);
-                buffer.clear();
-            }
-            noOutputTime = 0;
-        } else {
-            noOutputTime += mWaitForFinishTime;
-        }
+        });
     }
+    problemCase->exitTimer.invalidate();
+    connect(&process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            &loop, [&]() {
+        problemCase->exitTimer.start();
+        loop.quit();
+    });
+    connect(&process, &QProcess::errorOccurred, &loop, &QEventLoop::quit);
+    QTimer timeoutTimer;
+    timeoutTimer.setSingleShot(true);
+    connect(&timeoutTimer, &QTimer::timeout, &loop, [&]() {
+        execTimeouted = true;
+        loop.quit();
+    });
+    // stop() is called from other threads, so it's checked periodically
+    QTimer stopTimer;
+    stopTimer.setInterval(mWaitForFinishTime);
+    connect(&stopTimer, &QTimer::timeout, &loop, [&]() {
+        if (mStop)
+            loop.quit();
+    });
+
+    elapsedTimer.start();
+    if (process.state()!=QProcess::NotRunning && !errorOccurred && !mStop) {
+        if (mExecTimeout>0)
+            timeoutTimer.start(mExecTimeout);
+        stopTimer.start();
+        loop.exec();
+    }
+    // after a read or write error the program may still be running,
+    // and readUsage() below would wait until it exits by itself
+    if (process.state()!=QProcess::NotRunning && (mStop || execTimeouted || errorOccurred)) {
+        process.terminate();
+        process.kill();
+        process.waitForFinished(mWaitForFinishTime);
+    }
+    if (!execTimeouted)
+        buffer += process.readAllStandardOutput();
+    flushTimer.stop();
     problemCase->runningTime=elapsedTimer.elapsed();
+    problemCase->runningCpuTime = 0;
     problemCase->runningMemory = 0;
 #ifdef Q_OS_WIN
     if (hProcess!=NULL) {
@@ -170,25 +463,40 @@ void OJProblemCasesRunner::runCase(int index,POJProblemCase problemCase)
             LONGLONG t=((LONGLONG)kernelTime.dwHighDateTime<<32)
                     +((LONGLONG)userTime.dwHighDateTime<<32)
                     +(kernelTime.dwLowDateTime)+(userTime.dwLowDateTime);
-            problemCase->runningTime=(double)t/10000;
+            problemCase->runningCpuTime=(double)t/10000;
         }
     }
+#endif
+#ifdef Q_OS_LINUX
+    CaseUsage caseUsage;
+    if (process.readUsage(caseUsage)) {
+        const struct rusage& usage = caseUsage.usage;
+        if (caseUsage.peakMemory >= 0)
+            problemCase->runningMemory = (qulonglong)caseUsage.peakMemory * 1024; // kb to bytes
+        problemCase->runningCpuTime = (qulonglong)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000
+                + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+    }
 #endif
     if (execTimeouted) {
         problemCase->output = tr("Time limit exceeded!");
-        emit resetOutput(problemCase->getId(), problemCase->output);
+        if (!parallel)
+            emit resetOutput(problemCase->getId(), problemCase->output);
     } else if (mMemoryLimit>0 && problemCase->runningMemory>mMemoryLimit) {
         problemCase->output = tr("Memory limit exceeded!");
-        emit resetOutput(problemCase->getId(), problemCase->output);
+        if (!parallel)
+            emit resetOutput(problemCase->getId(), problemCase->output);
     } else {
         if (pSettings->executor().redirectStderrToToolLog()) {
             QString s = QString::fromLocal8Bit(process.readAllStandardError());
-            if (!s.isEmpty())
+            if (parallel)
+                stderrOutput += s;
+            else if (!s.isEmpty())
                 emit logStderrOutput(s);
         }
         if (process.state() == QProcess::ProcessState::NotRunning)
             buffer += process.readAll();
-        emit newOutputGetted(problemCase->getId(),QString::fromLocal8Bit(buffer));
+        if (!parallel)
+            emit newOutputGetted(problemCase->getId(),QString::fromLocal8Bit(buffer));
         output.append(buffer);
         problemCase->output = QString::fromLocal8Bit(output);
 
@@ -224,12 +532,35 @@ void OJProblemCasesRunner::run()
     auto action = finally([this]{
         emit terminated();
     });
+    int parallelCount = mParallelCount;
+    if (parallelCount<=0)
+        parallelCount = QThread::idealThreadCount();
+    if (parallelCount<=1 || mProblemCases.size()<=1) {
+        for (int i=0; i < mProblemCases.size(); i++) {
+            if (mStop)
+                break;
+            POJProblemCase problemCase = mProblemCases[i];
+            runCase(i,problemCase,false);
+        }
+        return;
+    }
+    mFinishedCount = 0;
+    QThreadPool pool;
+    pool.setMaxThreadCount(parallelCount);
     for (int i=0; i < mProblemCases.size(); i++) {
-        if (mStop)
-            break;
-        POJProblemCase problemCase = mProblemCases[i];
-        runCase(i,problemCase);
+        pool.start(new ProblemCaseTask(this, i, mProblemCases[i]));
     }
+    pool.waitForDone();
+}
+
+int OJProblemCasesRunner::parallelCount() const
+{
+    return mParallelCount;
+}
+
+void OJProblemCasesRunner::setParallelCount(int newParallelCount)
+{
+    mParallelCount = newParallelCount;
 }
 
 int OJProblemCasesRunner::execTimeout() const
@@ -18,6 +18,7 @@
 #define OJPROBLEMCASESRUNNER_H
 
 #include "runner.h"
+#include <QMutex>
 #include <QVector>
 #include "../problems/ojproblemset.h"
 
@@ -52,14 +53,20 @@ public:
     bool includeOutputFromStderr() const;
     void setIncludeOutputFromStderr(bool newIncludeOutputFromStderr);
 
+    // max count of cases running at the same time, 0 for the count of cpu cores
+    int parallelCount() const;
+    void setParallelCount(int newParallelCount);
+
 signals:
-    void caseStarted(const QString &caseId, int current, int total);
+    // parallel is whether other cases are running at the same time
+    void caseStarted(const QString &caseId, int current, int total, bool parallel);
     void caseFinished(const QString &caseId, int current, int total);
     void newOutputGetted(const QString &caseId, const QString &newOutputLine);
     void resetOutput(const QString &caseId, const QString &newOutputLine);
     void logStderrOutput(const QString& msg);
 private:
-    void runCase(int index, POJProblemCase problemCase);
+    friend class ProblemCaseTask;
+    void runCase(int index, POJProblemCase problemCase, bool parallel);
 private:
     QVector<POJProblemCase> mProblemCases;
 
@@ -72,6 +79,9 @@ private:
     int mExecTimeout;
     size_t mMemoryLimit;
     bool mIncludeOutputFromStderr;
+    int mParallelCount;
+    int mFinishedCount;
+    QMutex mNotifyMutex;
 };
 
 #endif // OJPROBLEMCASESRUNNER_H
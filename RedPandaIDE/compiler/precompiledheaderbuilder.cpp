@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "precompiledheaderbuilder.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+
+// ms to wait for a precompiled header to be built
+#define PRECOMPILED_HEADER_BUILD_TIMEOUT 60000
+
+PrecompiledHeaderBuilder::PrecompiledHeaderBuilder(const PrecompiledHeaderTask &task, QObject *parent):
+    QThread{parent},
+    mTask{task},
+    mStop{0},
+    mSucceeded{false}
+{
+}
+
+const QString &PrecompiledHeaderBuilder::header() const
+{
+    return mTask.header;
+}
+
+bool PrecompiledHeaderBuilder::succeeded() const
+{
+    return mSucceeded;
+}
+
+bool PrecompiledHeaderBuilder::isStopped() const
+{
+    return mStop.loadRelaxed()!=0;
+}
+
+void PrecompiledHeaderBuilder::stop()
+{
+    mStop.storeRelaxed(1);
+}
+
+void PrecompiledHeaderBuilder::run()
+{
+    QString output = mTask.header + ".gch";
+    QString tempOutput = output + ".tmp";
+    QProcess process;
+    process.setProgram(mTask.compiler);
+    process.setArguments(mTask.arguments + QStringList{"-o", tempOutput});
+    process.setWorkingDirectory(QFileInfo(mTask.header).absolutePath());
+    process.setProcessEnvironment(mTask.environment);
+    process.start();
+    bool started = process.waitForStarted(5000);
+    QElapsedTimer timer;
+    timer.start();
+    // stop() is called from other threads, so it's checked periodically
+    while (process.state()!=QProcess::NotRunning
+           && !process.waitForFinished(100)) {
+        if (isStopped() || timer.elapsed()>PRECOMPILED_HEADER_BUILD_TIMEOUT) {
+            process.kill();
+            process.waitForFinished();
+            break;
+        }
+    }
+    mSucceeded = started && !isStopped()
+            && process.exitStatus()==QProcess::NormalExit
+            && process.exitCode()==0;
+    if (mSucceeded) {
+        QFile::remove(output);
+        mSucceeded = QFile::rename(tempOutput, output);
+    } else {
+        QFile::remove(tempOutput);
+    }
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PRECOMPILEDHEADERBUILDER_H
+#define PRECOMPILEDHEADERBUILDER_H
+
+#include <QAtomicInt>
+#include <QProcessEnvironment>
+#include <QStringList>
+#include <QThread>
+
+struct PrecompiledHeaderTask {
+    QString header; // the .gch is built next to it
+    QString compiler;
+    QStringList arguments;
+    QProcessEnvironment environment;
+};
+
+/*
+ * Builds the precompiled header used by background syntax checks.
+ * The output is written to a temporary file and renamed when it's complete,
+ * so checks never use a partially written one.
+ */
+class PrecompiledHeaderBuilder : public QThread
+{
+    Q_OBJECT
+public:
+    explicit PrecompiledHeaderBuilder(const PrecompiledHeaderTask& task, QObject* parent = nullptr);
+    PrecompiledHeaderBuilder(const PrecompiledHeaderBuilder&)=delete;
+    PrecompiledHeaderBuilder& operator=(const PrecompiledHeaderBuilder&)=delete;
+    const QString& header() const;
+    // false if it's failed or stopped
+    bool succeeded() const;
+    bool isStopped() const;
+public slots:
+    void stop();
+
+    // QThread interface
+protected:
+    void run() override;
+
+private:
+    PrecompiledHeaderTask mTask;
+    QAtomicInt mStop;
+    bool mSucceeded;
+};
+
+#endif // PRECOMPILEDHEADERBUILDER_H
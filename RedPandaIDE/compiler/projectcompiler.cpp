@@ -26,6 +26,8 @@
 #include "utils/parsearg.h"
 
 #include <QDir>
+#include <QHash>
+#include <algorithm>
 
 ProjectCompiler::ProjectCompiler(std::shared_ptr<Project> project):
     Compiler("",false),
@@ -194,12 +196,16 @@ void ProjectCompiler::writeMakeDefines(QFile &file, bool &genModuleDef)
                 QString relativeObjFile = extractRelativePath(mProject->directory(), changeFileExt(fullObjFile, OBJ_EXT));
                 objects << relativeObjFile;
                 cleanObjects << localizePath(relativeObjFile);
+                if (fileType != FileType::GAS)
+                    cleanObjects << localizePath(changeFileExt(relativeObjFile, DEP_EXT));
                 if (unit->link()) {
                     LinkObjects << relativeObjFile;
                 }
             } else {
                 objects << changeFileExt(relativeName, OBJ_EXT);
                 cleanObjects << localizePath(changeFileExt(relativeName, OBJ_EXT));
+                if (fileType != FileType::GAS)
+                    cleanObjects << localizePath(changeFileExt(relativeName, DEP_EXT));
                 if (unit->link())
                     LinkObjects << changeFileExt(relativeName, OBJ_EXT);
             }
@@ -369,9 +375,15 @@ void ProjectCompiler::writeMakeClean(QFile &file)
 void ProjectCompiler::writeMakeObjFilesRules(QFile &file)
 {
     PCppParser parser = mProject->cppParser();
-    QString precompileStr;
 
     QList<PProjectUnit> projectUnits=mProject->unitList();
+    // index of units, so included files are looked up instead of scanning all units
+    QHash<QString,int> unitIndexes;
+    for (int i=0;i<projectUnits.count();i++)
+        unitIndexes.insert(projectUnits[i]->fileName(), i);
+    QString allHeadersStr;
+    bool allHeadersCollected = false;
+    QStringList depFiles;
     foreach(const PProjectUnit &unit, projectUnits) {
         if (!unit->compile())
             continue;
@@ -383,45 +395,61 @@ void ProjectCompiler::writeMakeObjFilesRules(QFile &file)
 
         QString shortFileName = extractRelativePath(mProject->makeFileName(),unit->fileName());
 
+        QString objectFile;
+        if (!mProject->options().folderForObjFiles.isEmpty()) {
+            QString fullObjname = includeTrailingPathDelimiter(mProject->options().folderForObjFiles) +
+                    extractFileName(unit->fileName());
+            objectFile = extractRelativePath(mProject->makeFileName(), changeFileExt(fullObjname, OBJ_EXT));
+        } else {
+            objectFile = changeFileExt(shortFileName, OBJ_EXT);
+        }
+        QString objFileNameTarget = escapeFilenameForMakefileTarget(objectFile);
+        QString objFileNameCommand = escapeArgumentForMakefileRecipe(objectFile, false);
+        // dependencies emitted by the compiler, see -MMD below
+        bool useDepFile = (fileType==FileType::CSource || fileType==FileType::CppSource)
+                && !(unit->overrideBuildCmd() && !unit->buildCmd().isEmpty());
+        QString depFile = changeFileExt(objectFile, DEP_EXT);
+        if (useDepFile)
+            depFiles.append(depFile);
+
         writeln(file);
         QString objStr = escapeFilenameForMakefilePrerequisite(shortFileName);
+        QString precompileStr;
         // if we have scanned it, use scanned info
         if (parser && parser->fileScanned(unit->fileName())) {
             QSet<QString> includedFiles = parser->getIncludedFiles(unit->fileName());
-            foreach(const PProjectUnit &unit2, projectUnits) {
-                if (unit2==unit)
-                    continue;
-                if (includedFiles.contains(unit2->fileName())) {
-                    if (mProject->options().usePrecompiledHeader &&
-                           unit2->fileName() == mProject->options().precompiledHeader)
-                        precompileStr = " $(PCH) ";
-                    else {
-                        QString prereq = extractRelativePath(mProject->makeFileName(), unit2->fileName());
-                        objStr = objStr + ' ' + escapeFilenameForMakefilePrerequisite(prereq);
-                    }
-                }
+            QList<int> includedUnits;
+            foreach(const QString& includedFile, includedFiles) {
+                int index = unitIndexes.value(includedFile, -1);
+                if (index>=0 && projectUnits[index]!=unit)
+                    includedUnits.append(index);
             }
-        } else {
-            foreach(const PProjectUnit &unit2, projectUnits) {
-                FileType fileType = getFileType(unit2->fileName());
-                if (fileType == FileType::CHeader || fileType==FileType::CppHeader) {
+            // keep the order of the units, so the makefile is stable
+            std::sort(includedUnits.begin(),includedUnits.end());
+            foreach(int index, includedUnits) {
+                const PProjectUnit& unit2 = projectUnits[index];
+                if (mProject->options().usePrecompiledHeader &&
+                       unit2->fileName() == mProject->options().precompiledHeader)
+                    precompileStr = " $(PCH) ";
+                else {
                     QString prereq = extractRelativePath(mProject->makeFileName(), unit2->fileName());
                     objStr = objStr + ' ' + escapeFilenameForMakefilePrerequisite(prereq);
                 }
             }
-        }
-        QString objFileNameTarget;
-        QString objFileNameCommand;
-        if (!mProject->options().folderForObjFiles.isEmpty()) {
-            QString fullObjname = includeTrailingPathDelimiter(mProject->options().folderForObjFiles) +
-                    extractFileName(unit->fileName());
-            QString objectFile = extractRelativePath(mProject->makeFileName(), changeFileExt(fullObjname, OBJ_EXT));
-            objFileNameTarget = escapeFilenameForMakefileTarget(objectFile);
-            objFileNameCommand = escapeArgumentForMakefileRecipe(objectFile, false);
-        } else {
-            QString objectFile = changeFileExt(shortFileName, OBJ_EXT);
-            objFileNameTarget = escapeFilenameForMakefileTarget(objectFile);
-            objFileNameCommand = escapeArgumentForMakefileRecipe(objectFile, false);
+        } else if (!useDepFile
+                   || !fileExists(generateAbsolutePath(extractFileDir(mProject->makeFileName()), depFile))) {
+            // nothing is known about it, depend on all headers
+            if (!allHeadersCollected) {
+                foreach(const PProjectUnit &unit2, projectUnits) {
+                    FileType fileType = getFileType(unit2->fileName());
+                    if (fileType == FileType::CHeader || fileType==FileType::CppHeader) {
+                        QString prereq = extractRelativePath(mProject->makeFileName(), unit2->fileName());
+                        allHeadersStr = allHeadersStr + ' ' + escapeFilenameForMakefilePrerequisite(prereq);
+                    }
+                }
+                allHeadersCollected = true;
+            }
+            objStr += allHeadersStr;
         }
 
         objStr = objFileNameTarget + ": " + objStr + precompileStr;
@@ -487,16 +515,24 @@ void ProjectCompiler::writeMakeObjFilesRules(QFile &file)
             }
 
             if (fileType==FileType::CSource || fileType==FileType::CppSource) {
+                // -MMD writes the headers it includes to the .d file next to the object
                 if (unit->compileCpp())
-                    writeln(file, "\t$(CXX) -c " + escapeArgumentForMakefileRecipe(shortFileName, false) + " -o " + objFileNameCommand + " $(CXXFLAGS) " + encodingStr);
+                    writeln(file, "\t$(CXX) -c " + escapeArgumentForMakefileRecipe(shortFileName, false) + " -o " + objFileNameCommand + " $(CXXFLAGS) -MMD -MP " + encodingStr);
                 else
-                    writeln(file, "\t$(CC) -c " + escapeArgumentForMakefileRecipe(shortFileName, false) + " -o " + objFileNameCommand + " $(CFLAGS) " + encodingStr);
+                    writeln(file, "\t$(CC) -c " + escapeArgumentForMakefileRecipe(shortFileName, false) + " -o " + objFileNameCommand + " $(CFLAGS) -MMD -MP " + encodingStr);
             } else if (fileType==FileType::GAS) {
                 writeln(file, "\t$(CC) -c " + escapeArgumentForMakefileRecipe(shortFileName, false) + " -o " + objFileNameCommand + " $(CFLAGS) " + encodingStr);
             }
         }
     }
 
+    if (!depFiles.isEmpty()) {
+        writeln(file);
+        foreach(const QString& depFile, depFiles) {
+            writeln(file, "-include " + escapeFilenameForMakefileInclude(depFile));
+        }
+    }
+
 #ifdef Q_OS_WIN
     if (!mProject->options().privateResource.isEmpty()) {
         // Concatenate all resource include directories
@@ -16,6 +16,10 @@
  */
 #include "stdincompiler.h"
 #include "compilermanager.h"
+#include "../systemconsts.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
 #include <QFile>
 #include <QFileInfo>
 
@@ -83,6 +87,9 @@ bool StdinCompiler::prepareForCompile()
             return false;
     }
 
+    if (mOnlyCheckSyntax && fileType != FileType::GAS)
+        usePrecompiledHeader();
+
     log(tr("Processing %1 source file:").arg(strFileType));
     log("------------------");
     log(tr("%1 Compiler: %2").arg(strFileType).arg(mCompiler));
@@ -92,6 +99,116 @@ bool StdinCompiler::prepareForCompile()
     return true;
 }
 
+const PrecompiledHeaderTask &StdinCompiler::precompiledHeaderTask() const
+{
+    return mPrecompiledHeaderTask;
+}
+
+QStringList StdinCompiler::leadingSystemIncludes() const
+{
+    QStringList includes;
+    bool inComment = false;
+    int start = 0;
+    while (start < mContent.length()) {
+        int end = mContent.indexOf('\n', start);
+        if (end < 0)
+            end = mContent.length();
+        QString line = removeComments(mContent.mid(start, end-start), inComment).trimmed();
+        start = end + 1;
+        if (line.isEmpty())
+            continue;
+        if (!line.startsWith('#'))
+            break;
+        line = line.mid(1).trimmed();
+        if (!line.startsWith("include"))
+            break;
+        line = line.mid(7).trimmed();
+        // local headers are often edited, only system headers are precompiled
+        if (!line.startsWith('<') || !line.endsWith('>'))
+            break;
+        includes.append("#include "+line);
+    }
+    return includes;
+}
+
+QString StdinCompiler::removeComments(const QString &line, bool &inComment)
+{
+    QString code;
+    int i = 0;
+    while (i < line.length()) {
+        if (inComment) {
+            int end = line.indexOf("*/", i);
+            if (end < 0)
+                break;
+            inComment = false;
+            i = end + 2;
+            code += ' ';
+        } else if (line[i] == '/' && i+1 < line.length() && line[i+1] == '/') {
+            break;
+        } else if (line[i] == '/' && i+1 < line.length() && line[i+1] == '*') {
+            inComment = true;
+            i += 2;
+        } else {
+            code += line[i];
+            i++;
+        }
+    }
+    return code;
+}
+
+void StdinCompiler::usePrecompiledHeader()
+{
+    if (compilerSet()->compilerType() != CompilerType::GCC
+            && compilerSet()->compilerType() != CompilerType::GCC_UTF8)
+        return;
+    QStringList includes = leadingSystemIncludes();
+    if (includes.isEmpty())
+        return;
+    // stdin is replaced by the header, other options must be the same as the check
+    int inputIndex = mArguments.indexOf("-");
+    if (inputIndex < 2 || mArguments[inputIndex-2] != "-x")
+        return;
+    QStringList arguments = mArguments;
+    arguments.removeAll("-fsyntax-only");
+    inputIndex = arguments.indexOf("-");
+    arguments[inputIndex-1] += "-header";
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(compilerSet()->name().toUtf8());
+    hash.addData(mCompiler.toUtf8());
+    hash.addData(QByteArray::number(QFileInfo(mCompiler).lastModified().toMSecsSinceEpoch()));
+    hash.addData(arguments.join('\n').toUtf8());
+    hash.addData(includes.join('\n').toUtf8());
+    QDir dir(includeTrailingPathDelimiter(pSettings->dirs().config()) + DEV_SYNTAX_CHECK_PCH_DIR);
+    QString header = dir.absoluteFilePath(QString::fromLatin1(hash.result().toHex()) + ".h");
+
+    if (fileExists(header + ".gch")) {
+        // the least recently used ones are removed by CompilerManager
+        QFile file(header + ".gch");
+        if (file.open(QFile::ReadWrite))
+            file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+        mArguments += {"-include", header};
+        log(tr("- Precompiled Header: %1").arg(header));
+        return;
+    }
+    // built by CompilerManager after the check
+    if (!dir.exists() && !dir.mkpath(dir.absolutePath()))
+        return;
+    // the name is the hash of the content, so an existing one needn't be written again
+    if (!fileExists(header)) {
+        QFile file(header);
+        if (!file.open(QFile::WriteOnly | QFile::Truncate))
+            return;
+        file.write((includes.join('\n') + '\n').toUtf8());
+        file.close();
+    }
+    arguments[inputIndex] = header;
+    mPrecompiledHeaderTask.header = header;
+    mPrecompiledHeaderTask.compiler = mCompiler;
+    mPrecompiledHeaderTask.arguments = arguments;
+    mPrecompiledHeaderTask.environment = processEnvironment(mCompiler);
+}
+
 QByteArray StdinCompiler::pipedText()
 {
     if (mEncoding == ENCODING_ASCII)
@@ -18,6 +18,7 @@
 #define STDINCOMPILER_H
 
 #include "compiler.h"
+#include "precompiledheaderbuilder.h"
 
 class StdinCompiler : public Compiler
 {
@@ -28,12 +29,24 @@ public:
     StdinCompiler(const StdinCompiler&)=delete;
     StdinCompiler& operator=(const StdinCompiler&)=delete;
 
+    // header to precompile for later checks, empty if it's not needed.
+    // Valid after compileFinished is emitted.
+    const PrecompiledHeaderTask& precompiledHeaderTask() const;
+
 protected:
     bool prepareForCompile() override;
 
+private:
+    QStringList leadingSystemIncludes() const;
+    // inComment is whether the line starts inside a block comment,
+    // and is updated for the next line
+    static QString removeComments(const QString& line, bool& inComment);
+    void usePrecompiledHeader();
+
 private:
     QString mContent;
     QByteArray mEncoding;
+    PrecompiledHeaderTask mPrecompiledHeaderTask;
 
     // Compiler interface
 protected:
@@ -237,6 +237,7 @@ PSearchResultTreeItem CppRefacter::findOccurenceInFile(
         }
     }
     editor.setSyntaxer(syntaxerManager.getSyntaxer(QSynedit::ProgrammingLanguage::CPP));
+    editor.finishSyntaxScan();
     int posY = 0;
     while (posY < editor.lineCount()) {
         QString line = editor.document()->getLine(posY);
@@ -296,6 +297,7 @@ void CppRefacter::renameSymbolInFile(const QString &filename, const PStatement &
     if (oldEditor){
         QSynedit::PSyntaxer syntaxer = syntaxerManager.getSyntaxer(QSynedit::ProgrammingLanguage::CPP);
         int posY = 0;
+        oldEditor->finishSyntaxScan();
         oldEditor->clearSelection();
         oldEditor->addGroupBreak();
         oldEditor->beginEditing();
@@ -348,6 +350,7 @@ void CppRefacter::renameSymbolInFile(const QString &filename, const PStatement &
                         e.reason());
             return;
         }
+        editor.finishSyntaxScan();
 
         QStringList newContents;
         int posY = 0;
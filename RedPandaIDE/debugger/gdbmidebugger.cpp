@@ -22,6 +22,7 @@
 #include "../settings.h"
 
 #include <QFileInfo>
+#include <QEventLoop>
 
 
 const QRegularExpression GDBMIDebuggerClient::REGdbSourceLine("^(\\d)+\\s+in\\s+(.+)$");
@@ -48,6 +49,7 @@ void GDBMIDebuggerClient::postCommand(const QString &command, const QString &par
             if (mLastConsoleCmd) {
                 pCmd = mLastConsoleCmd;
                 mCmdQueue.enqueue(pCmd);
+                emit cmdQueueChanged();
                 return;
             }
         }
@@ -59,9 +61,7 @@ void GDBMIDebuggerClient::postCommand(const QString &command, const QString &par
     pCmd->params = params;
     pCmd->source = source;
     mCmdQueue.enqueue(pCmd);
-
-//    if (!mCmdRunning)
-    //        runNextCmd();
+    emit cmdQueueChanged();
 }
 
 void GDBMIDebuggerClient::registerInferiorStoppedCommand(const QString &command, const QString &params)
@@ -77,6 +77,7 @@ void GDBMIDebuggerClient::registerInferiorStoppedCommand(const QString &command,
 void GDBMIDebuggerClient::stopDebug()
 {
     mStop = true;
+    emit cmdQueueChanged();
 }
 
 DebuggerType GDBMIDebuggerClient::clientType()
@@ -120,46 +121,63 @@ void GDBMIDebuggerClient::run()
 
     mProcess->setWorkingDirectory(workingDir);
 
-    connect(mProcess.get(), &QProcess::errorOccurred,
+    QEventLoop loop;
+    connect(mProcess.get(), &QProcess::errorOccurred, &loop,
                     [&](){
                         errorOccured= true;
+                        loop.quit();
                     });
+    connect(mProcess.get(), QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            &loop, &QEventLoop::quit);
+
+    // unprocessed output, MI records are framed and parsed in place
     QByteArray buffer;
-    QByteArray readed;
+    buffer.reserve(64*1024);
+    int scanPos = 0;
+    connect(mProcess.get(), &QProcess::readyRead, &loop, [&](){
+        qint64 available = mProcess->bytesAvailable();
+        if (available<=0)
+            return;
+        int oldSize = buffer.size();
+        buffer.resize(oldSize + available);
+        qint64 readed = mProcess->read(buffer.data()+oldSize, available);
+        buffer.resize(oldSize + qMax(readed, (qint64)0));
+        int outputEnd = GDBMIResultParser::findOutputEnd(buffer, scanPos);
+        if (outputEnd>0) {
+            processDebugOutput(buffer, outputEnd);
+            buffer.remove(0, outputEnd);
+            scanPos -= outputEnd;
+        }
+        if (!mCmdRunning)
+            runNextCmd();
+    });
+    // commands are posted and stop is requested from other threads
+    connect(this, &GDBMIDebuggerClient::cmdQueueChanged, &loop, [&](){
+        if (mStop) {
+            loop.quit();
+            return;
+        }
+        if (!mCmdRunning)
+            runNextCmd();
+    }, Qt::QueuedConnection);
 
     mProcess->start();
     mProcess->waitForStarted(5000);
     mStartSemaphore.release(1);
-    while (true) {
-        mProcess->waitForFinished(1);
-        if (mProcess->state()!=QProcess::Running) {
-            break;
-        }
-        if (mStop) {
-            mProcess->readAll();
-            mProcess->write("-gdb-exit\n");
-            msleep(50);
-            mProcess->readAll();
-            msleep(50);
-            mProcess->terminate();
-            mProcess->kill();
-            break;
-        }
-        if (errorOccured)
-            break;
-        readed = mProcess->readAll();
-        buffer += readed;
-
-        if (readed.endsWith("\n")&& outputTerminated(buffer)) {
-            processDebugOutput(buffer);
-            buffer.clear();
-            // mCmdRunning = false;
-            // runNextCmd();
-        } else if (!mCmdRunning && readed.isEmpty()){
+    if (!errorOccured && mProcess->state()==QProcess::Running) {
+        if (!mCmdRunning)
             runNextCmd();
-        } else if (readed.isEmpty()){
-            msleep(1);
-        }
+        if (!mStop)
+            loop.exec();
+    }
+    if (mStop && mProcess->state()==QProcess::Running) {
+        mProcess->readAll();
+        mProcess->write("-gdb-exit\n");
+        msleep(50);
+        mProcess->readAll();
+        msleep(50);
+        mProcess->terminate();
+        mProcess->kill();
     }
     if (errorOccured) {
         emit processFailed(mProcess->error());
@@ -329,16 +347,6 @@ QStringList GDBMIDebuggerClient::tokenize(const QString &s) const
     return result;
 }
 
-bool GDBMIDebuggerClient::outputTerminated(const QByteArray &text) const
-{
-    QStringList lines = textToLines(QString::fromUtf8(text));
-    foreach (const QString& line,lines) {
-        if (line.trimmed() == "(gdb)")
-            return true;
-    }
-    return false;
-}
-
 void GDBMIDebuggerClient::handleBreakpoint(const GDBMIResultParser::ParseObject& breakpoint)
 {
     QString filename;
@@ -897,7 +905,7 @@ void GDBMIDebuggerClient::processResultRecord(const QByteArray &line)
     }
 }
 
-void GDBMIDebuggerClient::processDebugOutput(const QByteArray& debugOutput)
+void GDBMIDebuggerClient::processDebugOutput(QByteArray& buffer, int length)
 {
     // Only update once per update at most
     //WatchView.Items.BeginUpdate;
@@ -910,55 +918,36 @@ void GDBMIDebuggerClient::processDebugOutput(const QByteArray& debugOutput)
     mSignalReceived = false;
     mUpdateCPUInfo = false;
     mReceivedSFWarning = false;
-    QList<QByteArray> lines = splitByteArrayToLines(debugOutput);
-
-    for (int i=0;i<lines.count();i++) {
-         QByteArray line = lines[i];
-         if (pSettings->debugger().showDetailLog())
-            mFullOutput.append(line);
-         line = removeToken(line);
-         if (line.isEmpty()) {
-             continue;
-         }
-         switch (line[0]) {
-         case '~': // console stream output
-             processConsoleOutput(line);
-             break;
-         case '@': // target stream output
-             break;
-         case '&': // log stream output
-             processLogOutput(line);
-             break;
-         case '^': // result record
-             processResultRecord(line);
-             break;
-         case '*': // exec async output
-             processExecAsyncRecord(line);
-             break;
-         case '+': // status async output
-         case '=': // notify async output
-             break;
-         }
-    }
-    emit parseFinished();
-    mConsoleOutput.clear();
-    mFullOutput.clear();
-}
-
 
-QByteArray GDBMIDebuggerClient::removeToken(const QByteArray &line) const
-{
-    int p=0;
-    while (p<line.length()) {
-        QChar ch=line[p];
-        if (ch<'0' || ch>'9') {
+    // Handlers only read the records or copy what they keep.
+    splitGDBMIRecords(buffer, length, [this](const QByteArray& fullLine, const QByteArray& line) {
+        if (pSettings->debugger().showDetailLog())
+            mFullOutput.append(QString::fromUtf8(fullLine));
+        if (line.isEmpty())
+            return;
+        switch (line[0]) {
+        case '~': // console stream output
+            processConsoleOutput(line);
+            break;
+        case '@': // target stream output
+            break;
+        case '&': // log stream output
+            processLogOutput(line);
+            break;
+        case '^': // result record
+            processResultRecord(line);
+            break;
+        case '*': // exec async output
+            processExecAsyncRecord(line);
+            break;
+        case '+': // status async output
+        case '=': // notify async output
             break;
         }
-        p++;
-    }
-    if (p<line.length())
-        return line.mid(p);
-    return line;
+    });
+    emit parseFinished();
+    mConsoleOutput.clear();
+    mFullOutput.clear();
 }
 
 void GDBMIDebuggerClient::asyncUpdate()
@@ -95,7 +95,6 @@ protected:
     void runNextCmd();
 private:
     QStringList tokenize(const QString& s) const;
-    bool outputTerminated(const QByteArray& text) const;
     void handleBreakpoint(const GDBMIResultParser::ParseObject& breakpoint);
     void handleCreateVar(const GDBMIResultParser::ParseObject &multiVars);
     void handleFrame(const GDBMIResultParser::ParseValue &frame);
@@ -115,11 +114,13 @@ private:
     void processExecAsyncRecord(const QByteArray& line);
     void processError(const QByteArray& errorLine);
     void processResultRecord(const QByteArray& line);
-    void processDebugOutput(const QByteArray& debugOutput);
-    QByteArray removeToken(const QByteArray& line) const;
+    void processDebugOutput(QByteArray& buffer, int length);
     void runInferiorStoppedHook();
     void clearCmdQueue();
     void registerInferiorStoppedCommand(const QString &command, const QString &params);
+signals:
+    // wakes up the reader loop in run(), can be emitted from any thread
+    void cmdQueueChanged();
 private slots:
     void asyncUpdate();
 private:
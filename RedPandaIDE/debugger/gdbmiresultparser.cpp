@@ -19,6 +19,7 @@
 #include <QFileInfo>
 #include <QList>
 #include <QDebug>
+#include <string.h>
 
 GDBMIResultParser::GDBMIResultParser()
 {
@@ -55,6 +56,58 @@ bool GDBMIResultParser::parse(const QByteArray &record, const QString& command,
     return true;
 }
 
+int GDBMIResultParser::findOutputEnd(const QByteArray &buffer, int& scanPos)
+{
+    // scanPos is the start of the first unscanned line, so each line is only scanned once
+    const char* start = buffer.constData();
+    const char* end = start + buffer.length();
+    const char* p = start + scanPos;
+    int outputEnd = -1;
+    while (true) {
+        const char* lineEnd = (const char*)memchr(p, '\n', end-p);
+        if (!lineEnd)
+            break;
+        const char* s = p;
+        const char* e = lineEnd;
+        while (s<e && (*s==' ' || *s=='\t' || *s=='\r'))
+            s++;
+        while (e>s && (*(e-1)==' ' || *(e-1)=='\t' || *(e-1)=='\r'))
+            e--;
+        p = lineEnd+1;
+        if (e-s==5 && memcmp(s, "(gdb)", 5)==0)
+            outputEnd = p - start;
+    }
+    scanPos = p - start;
+    if (outputEnd<0)
+        return -1;
+    // lines after the prompt are also complete, process them together
+    return scanPos;
+}
+
+void splitGDBMIRecords(QByteArray &buffer, int length, const GDBMIRecordProc &proc)
+{
+    char* p = buffer.data();
+    char* end = p + length;
+    while (p<end) {
+        char* lineStart = p;
+        while (p<end && *p!='\n' && *p!='\r')
+            p++;
+        char* lineEnd = p;
+        if (p<end && *p=='\r')
+            p++;
+        if (p<end && *p=='\n')
+            p++;
+        if (lineEnd<end)
+            *lineEnd = '\0';
+        char* recordStart = lineStart;
+        //remove token
+        while (recordStart<lineEnd && *recordStart>='0' && *recordStart<='9')
+            recordStart++;
+        proc(QByteArray::fromRawData(lineStart, lineEnd-lineStart),
+             QByteArray::fromRawData(recordStart, lineEnd-recordStart));
+    }
+}
+
 bool GDBMIResultParser::parseAsyncResult(const QByteArray &record, QByteArray &result, ParseObject &multiValue)
 {
     const char* p =record.data();
@@ -20,6 +20,7 @@
 #include <QByteArray>
 #include <QHash>
 #include <QList>
+#include <functional>
 #include <memory>
 
 
@@ -99,6 +100,15 @@ public:
     GDBMIResultParser();
     bool parse(const QByteArray& record, const QString& command, GDBMIResultType& type, ParseObject& multiValues);
     bool parseAsyncResult(const QByteArray& record, QByteArray& result, ParseObject& multiValue);
+    /**
+     * @brief find the end of the complete output in the buffer
+     *
+     * The output is complete when a "(gdb)" prompt line is read.
+     * @param buffer the unprocessed output
+     * @param scanPos start of the first unscanned line, updated after the call
+     * @return the end of the complete lines, or -1 if there's no prompt yet
+     */
+    static int findOutputEnd(const QByteArray& buffer, int& scanPos);
 private:
     bool parseMultiValues(const char*p, ParseObject& multiValue);
     bool parseNameAndValue(const char *&p,QByteArray& name, ParseValue& value);
@@ -113,4 +123,17 @@ private:
     QHash<QString, GDBMIResultType> mResultTypes;
 };
 
+using GDBMIRecordProc = std::function<void (const QByteArray& line, const QByteArray& record)>;
+
+/**
+ * @brief split the complete output into lines and pass the MI records to proc
+ *
+ * Lines are terminated in place and wrapped by QByteArray::fromRawData,
+ * so records are not copied. proc is called for each line,
+ * with the record after its token, which may be empty.
+ * @param buffer the unprocessed output
+ * @param length end of the complete lines, see GDBMIResultParser::findOutputEnd()
+ */
+void splitGDBMIRecords(QByteArray& buffer, int length, const GDBMIRecordProc& proc);
+
 #endif // GDBMIRESULTPARSER_H
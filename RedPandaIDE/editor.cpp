@@ -167,6 +167,10 @@ Editor::Editor(QWidget *parent, const QString& filename,
 
     setAttribute(Qt::WA_Hover,true);
 
+    connect(document().get(), &QSynedit::Document::loadingProgress,
+            this, &Editor::onDocumentLoadingProgress);
+    connect(document().get(), &QSynedit::Document::loaded,
+            this, &Editor::onDocumentLoaded);
     connect(this,&QSynEdit::linesDeleted,
             this, &Editor::onLinesDeleted);
     connect(this,&QSynEdit::linesInserted,
@@ -274,7 +278,8 @@ void Editor::loadFile(QString filename) {
 
     //FileError should by catched by the caller of loadFile();
 
-    this->document()->loadFromFile(filename,mEncodingOption,mFileEncoding);
+    // large files are shown before all lines are loaded, see onDocumentLoaded()
+    this->document()->loadFromFile(filename,mEncodingOption,mFileEncoding,true);
 
     if (mProject) {
         PProjectUnit unit = mProject->findUnit(this);
@@ -1836,6 +1841,24 @@ Editor::PSyntaxIssue Editor::getSyntaxIssueAtPosition(const QSynedit::BufferCoor
     return PSyntaxIssue();
 }
 
+void Editor::onDocumentLoadingProgress(qint64 loadedSize, qint64 totalSize)
+{
+    if (!inTab() || totalSize<=0)
+        return;
+    pMainWindow->updateStatusbarMessage(tr("Loading %1: %2%")
+                                        .arg(extractFileName(mFilename))
+                                        .arg(loadedSize*100/totalSize));
+}
+
+void Editor::onDocumentLoaded()
+{
+    // parsing and syntax checking are put off until the whole file is loaded
+    reparse(true);
+    if (pSettings->editor().syntaxCheckWhenLineChanged())
+        checkSyntaxInBack();
+    reparseTodo();
+}
+
 void Editor::onStatusChanged(QSynedit::StatusChanges changes)
 {
     if ((!changes.testFlag(QSynedit::StatusChange::ReadOnly)
@@ -3246,6 +3269,9 @@ void Editor::reparse(bool resetParser)
 {
     if (!mInited)
         return;
+    // called again when all lines are loaded
+    if (document()->loading())
+        return;
     if (!inTab())
         return;
     if (!pSettings->codeCompletion().enabled())
@@ -3282,6 +3308,8 @@ void Editor::reparseTodo()
 {
     if (!mInited)
         return;
+    if (document()->loading())
+        return;
     if (!inTab())
         return;
     if (pSettings->editor().parseTodos())
@@ -5229,6 +5257,8 @@ void Editor::checkSyntaxInBack()
 {
     if (!mInited)
         return;
+    if (document()->loading())
+        return;
     if (!inTab())
         return;
     if (readOnly())
@@ -5485,12 +5515,14 @@ void Editor::applySettings()
         }
 #endif
         ((QSynedit::CppSyntaxer*)(syntaxer().get()))->setCustomTypeKeywords(set);
+        invalidateSyntaxTokens();
     }
 
     initAutoBackup();
 
     setMouseWheelScrollSpeed(pSettings->editor().mouseWheelScrollSpeed());
     setMouseSelectionScrollSpeed(pSettings->editor().mouseSelectionScrollSpeed());
+    setMaxUndoMemoryUsage((qint64)pSettings->editor().maxUndoMemoryUsage()*1024*1024);
     invalidate();
     decPaintLock();
 }
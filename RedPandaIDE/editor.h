@@ -264,6 +264,8 @@ private slots:
     void onAutoBackupTimer();
     void onTooltipTimer();
     void onEndParsing();
+    void onDocumentLoadingProgress(qint64 loadedSize, qint64 totalSize);
+    void onDocumentLoaded();
 
 private:
     void resolveAutoDetectEncodingOption();
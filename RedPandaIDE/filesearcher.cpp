@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "filesearcher.h"
+#include <algorithm>
+#include <QDir>
+#include <QFileInfo>
+#include <QFont>
+#include <QRunnable>
+#include <QThreadPool>
+#include <qsynedit/document.h>
+#include <qsynedit/searcher/basicsearcher.h>
+#include <qsynedit/searcher/regexsearcher.h>
+#include "systemconsts.h"
+
+class FolderScanTask : public QRunnable {
+public:
+    FolderScanTask(FileSearcher* searcher, const QString& folder):
+        mSearcher{searcher},
+        mFolder{folder} {}
+    void run() override {
+        mSearcher->scanFolder(mFolder);
+    }
+private:
+    FileSearcher* mSearcher;
+    QString mFolder;
+};
+
+class FileSearchTask : public QRunnable {
+public:
+    FileSearchTask(FileSearcher* searcher, int index):
+        mSearcher{searcher},
+        mIndex{index} {}
+    void run() override {
+        mSearcher->searchFile(mIndex);
+    }
+private:
+    FileSearcher* mSearcher;
+    int mIndex;
+};
+
+FileSearcher::FileSearcher(const QString &keyword, QSynedit::SearchOptions options, QObject *parent):
+    QThread{parent},
+    mKeyword{keyword},
+    mOptions{options},
+    mSearchFolder{false},
+    mSearchSubfolders{false},
+    mPool{nullptr},
+    mCanceled{0},
+    mNextFile{0}
+{
+}
+
+FileSearcher::~FileSearcher()
+{
+    cancel();
+    wait();
+}
+
+void FileSearcher::setFiles(const QList<FileSearchTarget> &files)
+{
+    mFiles = files;
+    mSearchFolder = false;
+}
+
+void FileSearcher::setFolder(const QString &folder, const QStringList &filters, bool searchSubfolders)
+{
+    mFolder = folder;
+    mFilters = filters;
+    mSearchSubfolders = searchSubfolders;
+    mSearchFolder = true;
+}
+
+void FileSearcher::setOpenedFileContents(const QHash<QString, QStringList> &contents)
+{
+    mOpenedFileContents.clear();
+    for (auto it=contents.begin();it!=contents.end();++it) {
+        mOpenedFileContents.insert(QFileInfo(it.key()).absoluteFilePath(), it.value());
+    }
+}
+
+void FileSearcher::cancel()
+{
+    mCanceled.storeRelaxed(1);
+}
+
+bool FileSearcher::isCanceled() const
+{
+    return mCanceled.loadRelaxed()!=0;
+}
+
+SearchResultTreeItemList FileSearcher::takeResults()
+{
+    QMutexLocker locker(&mResultsMutex);
+    SearchResultTreeItemList results;
+    results.swap(mResults);
+    return results;
+}
+
+void FileSearcher::scanFolder(const QString &folder)
+{
+    if (isCanceled())
+        return;
+    QDir dir(folder);
+    if (mSearchSubfolders) {
+        // symlinks are skipped, so there can't be cycles
+        foreach(const QFileInfo& entry, dir.entryInfoList(QDir::NoSymLinks | QDir::Dirs | QDir::NoDotAndDotDot)) {
+            mPool->start(new FolderScanTask(this, entry.absoluteFilePath()));
+        }
+    }
+    QDir::Filters filterOptions=QDir::Files | QDir::NoSymLinks;
+    if (PATH_SENSITIVITY==Qt::CaseSensitive)
+        filterOptions |= QDir::CaseSensitive;
+    QList<FileSearchTarget> targets;
+    foreach(const QFileInfo& entry, dir.entryInfoList(mFilters, filterOptions)) {
+        FileSearchTarget target;
+        target.filename = entry.absoluteFilePath();
+        target.encoding = ENCODING_AUTO_DETECT;
+        targets.append(target);
+    }
+    QMutexLocker locker(&mScanMutex);
+    mScannedFiles.append(targets);
+}
+
+void FileSearcher::searchFile(int index)
+{
+    if (isCanceled())
+        return;
+    const FileSearchTarget& target = mFiles[index];
+    QString filename = QFileInfo(target.filename).absoluteFilePath();
+    auto it = mOpenedFileContents.constFind(filename);
+    if (it!=mOpenedFileContents.constEnd()) {
+        finishFile(index, searchLines(target.filename, it.value()));
+        return;
+    }
+    if (!fileExists(filename)) {
+        finishFile(index, nullptr);
+        return;
+    }
+    // font is never used, lines are only measured when painted
+    QSynedit::Document document(QFont{});
+    QByteArray realEncoding;
+    try {
+        document.loadFromFile(filename, target.encoding, realEncoding);
+    } catch (QSynedit::BinaryFileError e) {
+        finishFile(index, nullptr);
+        return;
+    } catch (FileError e) {
+        finishFile(index, nullptr);
+        return;
+    }
+    finishFile(index, searchLines(target.filename, document.contents()));
+}
+
+PSearchResultTreeItem FileSearcher::searchLines(const QString &filename, const QStringList &lines)
+{
+    QSynedit::PSynSearchBase searchEngine;
+    if (mOptions.testFlag(QSynedit::ssoRegExp))
+        searchEngine = std::make_shared<QSynedit::RegexSearcher>();
+    else
+        searchEngine = std::make_shared<QSynedit::BasicSearcher>();
+    searchEngine->setOptions(mOptions);
+    searchEngine->setPattern(mKeyword);
+
+    PSearchResultTreeItem parentItem = std::make_shared<SearchResultTreeItem>();
+    parentItem->filename = filename;
+    parentItem->parent = nullptr;
+    for (int i=0;i<lines.count();i++) {
+        if (isCanceled())
+            return nullptr;
+        int n = searchEngine->findAll(lines[i]);
+        for (int j=0;j<n;j++) {
+            PSearchResultTreeItem item = std::make_shared<SearchResultTreeItem>();
+            item->filename = filename;
+            item->line = i+1;
+            item->start = searchEngine->result(j)+1;
+            item->len = searchEngine->length(j);
+            item->parent = parentItem.get();
+            item->text = lines[i];
+            item->text.replace('\t',' ');
+            parentItem->results.append(item);
+        }
+    }
+    if (parentItem->results.isEmpty())
+        return nullptr;
+    return parentItem;
+}
+
+void FileSearcher::finishFile(int index, PSearchResultTreeItem item)
+{
+    bool notify = false;
+    {
+        QMutexLocker locker(&mResultsMutex);
+        mFileResults[index] = item;
+        mFileDone[index] = true;
+        // only notify once until the pending results are taken
+        bool hadResults = !mResults.isEmpty();
+        while (mNextFile<mFileDone.count() && mFileDone[mNextFile]) {
+            if (mFileResults[mNextFile])
+                mResults.append(mFileResults[mNextFile]);
+            mFileResults[mNextFile].reset();
+            mNextFile++;
+        }
+        notify = !hadResults && !mResults.isEmpty();
+    }
+    if (notify)
+        emit resultsAvailable();
+}
+
+void FileSearcher::run()
+{
+    QThreadPool pool;
+    mPool = &pool;
+    if (mSearchFolder) {
+        pool.start(new FolderScanTask(this, mFolder));
+        // folder scan tasks queue their subtasks before they finish,
+        // so the pool is only done when all folders are scanned
+        pool.waitForDone();
+        // subfolders are scanned in parallel, sort to get a stable order
+        mFiles = mScannedFiles;
+        mScannedFiles.clear();
+        std::sort(mFiles.begin(), mFiles.end(),
+                  [](const FileSearchTarget& t1, const FileSearchTarget& t2){
+            return QString::compare(t1.filename, t2.filename, PATH_SENSITIVITY) < 0;
+        });
+    }
+    mFileResults.fill(nullptr, mFiles.count());
+    mFileDone.fill(false, mFiles.count());
+    mNextFile = 0;
+    for (int i=0;i<mFiles.count();i++) {
+        if (isCanceled())
+            break;
+        pool.start(new FileSearchTask(this, i));
+    }
+    pool.waitForDone();
+    mPool = nullptr;
+}
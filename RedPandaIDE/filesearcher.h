@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef FILESEARCHER_H
+#define FILESEARCHER_H
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+#include <qsynedit/searcher/baseseacher.h>
+#include "widgets/searchresultview.h"
+
+class QThreadPool;
+
+struct FileSearchTarget {
+    QString filename;
+    QByteArray encoding;
+};
+
+/*
+ * Searches files for a keyword in a thread pool.
+ * Files are loaded into a bare Document (no editor widget is created).
+ * Results are queued in the order of the files (sorted by path when searching
+ * a folder), as soon as a file and all files before it are done.
+ */
+class FileSearcher : public QThread
+{
+    Q_OBJECT
+public:
+    explicit FileSearcher(const QString& keyword, QSynedit::SearchOptions options,
+                          QObject* parent = nullptr);
+    ~FileSearcher();
+    void setFiles(const QList<FileSearchTarget>& files);
+    void setFolder(const QString& folder, const QStringList& filters, bool searchSubfolders);
+    // contents of the files opened in editors, which may not be saved yet
+    void setOpenedFileContents(const QHash<QString, QStringList>& contents);
+
+    void cancel();
+    bool isCanceled() const;
+    // results found since the last call, in the order of the files
+    SearchResultTreeItemList takeResults();
+
+signals:
+    void resultsAvailable();
+
+private:
+    friend class FolderScanTask;
+    friend class FileSearchTask;
+    void scanFolder(const QString& folder);
+    void searchFile(int index);
+    PSearchResultTreeItem searchLines(const QString& filename, const QStringList& lines);
+    void finishFile(int index, PSearchResultTreeItem item);
+
+private:
+    QString mKeyword;
+    QSynedit::SearchOptions mOptions;
+    QList<FileSearchTarget> mFiles;
+    QString mFolder;
+    QStringList mFilters;
+    bool mSearchFolder;
+    bool mSearchSubfolders;
+    QHash<QString, QStringList> mOpenedFileContents;
+    QThreadPool* mPool;
+
+    QAtomicInt mCanceled;
+
+    QMutex mScanMutex;
+    QList<FileSearchTarget> mScannedFiles;
+
+    QMutex mResultsMutex;
+    SearchResultTreeItemList mResults;
+    // results of the files done out of order, by file index
+    QVector<PSearchResultTreeItem> mFileResults;
+    QVector<bool> mFileDone;
+    int mNextFile;
+
+    // QThread interface
+protected:
+    void run() override;
+};
+
+#endif // FILESEARCHER_H
@@ -497,6 +497,7 @@ int main(int argc, char *argv[])
             QString configDir = pSettings->dirs().config();
             settings.release();
             delete pSettings;
+            // also removes the precompiled headers of syntax checks (DEV_SYNTAX_CHECK_PCH_DIR)
             QDir dir(configDir);
             dir.removeRecursively();
         }
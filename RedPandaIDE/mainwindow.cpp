@@ -112,6 +112,9 @@
 #include <windows.h>
 #endif
 
+// ms to wait for more edits before a background syntax check is started
+#define SYNTAX_CHECK_DELAY 300
+
 static int findTabIndex(QTabWidget* tabWidget , QWidget* w) {
     for (int i=0;i<tabWidget->count();i++) {
         if (w==tabWidget->widget(i))
@@ -343,7 +346,13 @@ MainWindow::MainWindow(QWidget *parent)
     delete m;
     connect(mSearchResultTreeModel.get() , &QAbstractItemModel::modelReset,
             ui->searchView,&QTreeView::expandAll);
+    connect(mSearchResultTreeModel.get() , &QAbstractItemModel::rowsInserted,
+            this, [this](const QModelIndex& parent, int first, int last){
+        for (int i=first;i<=last;i++)
+            ui->searchView->expand(mSearchResultTreeModel->index(i,0,parent));
+    });
     ui->replacePanel->setVisible(false);
+    ui->btnStopSearch->setVisible(false);
     ui->tabProblem->setEnabled(false);
 
     //problem set
@@ -439,6 +448,11 @@ MainWindow::MainWindow(QWidget *parent)
             this, &MainWindow::onAutoSaveTimeout);
     resetAutoSaveTimer();
 
+    mSyntaxCheckTimer.setSingleShot(true);
+    mSyntaxCheckTimer.setInterval(SYNTAX_CHECK_DELAY);
+    connect(&mSyntaxCheckTimer, &QTimer::timeout,
+            this, &MainWindow::onSyntaxCheckTimeout);
+
     connect(ui->menuFile, &QMenu::aboutToShow,
             this,&MainWindow::rebuildOpenedFileHisotryMenu);
 
@@ -1362,6 +1376,8 @@ void MainWindow::prepareSearchInFilesDialog()
 {
     if (mSearchInFilesDialog==nullptr) {
         mSearchInFilesDialog = new SearchInFileDialog(this);
+        connect(mSearchInFilesDialog, &SearchInFileDialog::searchStateChanged,
+                this, &MainWindow::onSearchInFilesStateChanged);
     }
 }
 
@@ -1916,6 +1932,8 @@ void MainWindow::changeOptions(const QString &widgetName, const QString &groupNa
     settingsDialog->exec();
     if (settingsDialog->appShouldQuit()) {
         mShouldRemoveAllSettings = true;
+        // stop the precompiled header build before the config folder is removed
+        removeSyntaxCheckPrecompiledHeaders();
         close();
         return;
     }
@@ -1955,6 +1973,11 @@ void MainWindow::updateCompilerSet()
     updateCompilerSet(mEditorList->getEditor());
 }
 
+void MainWindow::removeSyntaxCheckPrecompiledHeaders()
+{
+    mCompilerManager->removePrecompiledHeaders();
+}
+
 void MainWindow::updateCompilerSet(const Editor *e)
 {
     mCompilerSet->blockSignals(true);
@@ -2217,12 +2240,33 @@ void MainWindow::checkSyntaxInBack(Editor *e)
             && fileType != FileType::GAS
             )
         return;
+    if (mCompilerManager->compiling())
+        return;
+
+    // requests in a short time are coalesced, the check is started by the timer
+    mSyntaxCheckPendingFile = e->filename();
+    // the running check is outdated, the pending one is started when it's stopped
     if (mCompilerManager->backgroundSyntaxChecking())
+        mCompilerManager->stopCheckSyntax(false);
+    mSyntaxCheckTimer.start();
+}
+
+void MainWindow::onSyntaxCheckTimeout()
+{
+    if (mSyntaxCheckPendingFile.isEmpty())
         return;
-    if (mCompilerManager->compiling())
+    // restarted in onCompileFinished()
+    if (mCompilerManager->backgroundSyntaxChecking())
         return;
     if (mCheckSyntaxInBack)
         return;
+    QString filename = mSyntaxCheckPendingFile;
+    mSyntaxCheckPendingFile.clear();
+    if (mCompilerManager->compiling())
+        return;
+    Editor * e = mEditorList->getOpenedEditorByFilename(filename);
+    if (e==nullptr)
+        return;
 
     if (mCompileIssuesState==CompileIssuesState::ProjectCompilationResultFilled
             || mCompileIssuesState==CompileIssuesState::ProjectCompiling) {
@@ -2232,21 +2276,21 @@ void MainWindow::checkSyntaxInBack(Editor *e)
         }
     }
 
-    mCheckSyntaxInBack=true;
-    clearIssues();
     CompileTarget target =getCompileTarget();
+    Settings::PCompilerSet set;
     if (target ==CompileTarget::Project) {
         int index = mProject->options().compilerSet;
-        Settings::PCompilerSet set = pSettings->compilerSets().getSet(index);
-        if (!set || !CompilerInfoManager::supportSyntaxCheck(set->compilerType()))
-            return;
-        mCompilerManager->checkSyntax(e->filename(), e->fileEncoding(), e->text(), mProject);
+        set = pSettings->compilerSets().getSet(index);
     } else {
-        Settings::PCompilerSet set = pSettings->compilerSets().defaultSet();
-        if (!set || !CompilerInfoManager::supportSyntaxCheck(set->compilerType()))
-            return;
-        mCompilerManager->checkSyntax(e->filename(),e->fileEncoding(),e->text(), nullptr);
+        set = pSettings->compilerSets().defaultSet();
     }
+    if (!set || !CompilerInfoManager::supportSyntaxCheck(set->compilerType()))
+        return;
+
+    mCheckSyntaxInBack=true;
+    clearIssues();
+    mCompilerManager->checkSyntax(e->filename(), e->fileEncoding(), e->text(),
+                                  target ==CompileTarget::Project ? mProject : nullptr);
 }
 
 bool MainWindow::parsing()
@@ -5785,6 +5829,7 @@ void MainWindow::closeEvent(QCloseEvent *event) {
     mCCHandler.stop();
     mCompilerManager->stopAllRunners();
     mCompilerManager->stopCompile();
+    mCompilerManager->stopCheckSyntax();
     mCompilerManager->stopRun();
     if (!mShouldRemoveAllSettings)
         mSymbolUsageManager->save();
@@ -5977,6 +6022,15 @@ void MainWindow::onCompileFinished(QString filename, bool isCheckSyntax)
         return;
     }
 
+    if (isCheckSyntax && !mSyntaxCheckPendingFile.isEmpty()) {
+        // the result is outdated, remove its issues and check the latest text instead
+        clearIssues();
+        mCheckSyntaxInBack = false;
+        updateCompileActions();
+        mSyntaxCheckTimer.start();
+        return;
+    }
+
     // Update tab caption
     int i = ui->tabMessages->indexOf(ui->tabIssues);
     if (i!=-1) {
@@ -6183,7 +6237,7 @@ void MainWindow::onRunProblemFinished()
     updateAppTitle();
 }
 
-void MainWindow::onOJProblemCaseStarted(const QString& id,int current, int total)
+void MainWindow::onOJProblemCaseStarted(const QString& id,int current, int total, bool parallel)
 {
     ui->pbProblemCases->setVisible(true);
     ui->pbProblemCases->setMaximum(total);
@@ -6193,6 +6247,9 @@ void MainWindow::onOJProblemCaseStarted(const QString& id,int current, int total
         POJProblemCase problemCase = mOJProblemModel.getCase(row);
         problemCase->testState = ProblemCaseTestState::Testing;
         mOJProblemModel.update(row);
+        // parallel cases start together, so the selected case is kept
+        if (parallel)
+            return;
         QModelIndex idx = ui->tblProblemCases->currentIndex();
         if (!idx.isValid() || row != idx.row()) {
             ui->tblProblemCases->setCurrentIndex(mOJProblemModel.index(row,0));
@@ -6213,8 +6270,11 @@ void MainWindow::onOJProblemCaseFinished(const QString& id, int current, int tot
         problemCase->testState = validator.validate(problemCase,pSettings->executor().problemCaseValidateType())?
                     ProblemCaseTestState::Passed:
                     ProblemCaseTestState::Failed;
+        if (problemCase->exitTimer.isValid())
+            problemCase->exitToResultTime = problemCase->exitTimer.nsecsElapsed() / 1000;
         mOJProblemModel.update(row);
-        updateProblemCaseOutput(problemCase);
+        if (row == ui->tblProblemCases->currentIndex().row())
+            updateProblemCaseOutput(problemCase);
     }
     ui->pbProblemCases->setMaximum(total);
     ui->pbProblemCases->setValue(current);
@@ -6226,8 +6286,13 @@ void MainWindow::onOJProblemCaseNewOutputGetted(const QString &/* id */, const Q
     ui->txtProblemCaseOutput->appendPlainText(line);
 }
 
-void MainWindow::onOJProblemCaseResetOutput(const QString &/* id */, const QString &line)
+void MainWindow::onOJProblemCaseResetOutput(const QString &id, const QString &line)
 {
+    // cases running in parallel report the output when they finish,
+    // only the selected one is shown
+    int row = mOJProblemModel.getCaseIndexById(id);
+    if (row>=0 && row != ui->tblProblemCases->currentIndex().row())
+        return;
     ui->txtProblemCaseOutput->clearAll();
     ui->txtProblemCaseOutput->setPlainText(line);
 }
@@ -8457,6 +8522,20 @@ void MainWindow::on_btnCancelReplace_clicked()
     showSearchReplacePanel(false);
 }
 
+void MainWindow::on_btnStopSearch_clicked()
+{
+    if (mSearchInFilesDialog)
+        mSearchInFilesDialog->cancelSearch();
+}
+
+void MainWindow::onSearchInFilesStateChanged(bool searching)
+{
+    ui->btnStopSearch->setVisible(searching);
+    ui->btnSearchAgain->setVisible(!searching);
+    // replace only after all matches are found
+    ui->btnReplace->setEnabled(!searching);
+}
+
 void MainWindow::on_actionPrint_triggered()
 {
     Editor * editor = mEditorList->getEditor();
@@ -139,6 +139,7 @@ public:
     void updateEditorColorSchemes();
     void updateCompilerSet();
     void updateCompilerSet(const Editor* e);
+    void removeSyntaxCheckPrecompiledHeaders();
     void updateDebuggerSettings();
     void updateActionIcons();
     void checkSyntaxInBack(Editor* e);
@@ -252,7 +253,7 @@ public slots:
     void onRunFinished();
     void onRunPausingForFinish();
     void onRunProblemFinished();
-    void onOJProblemCaseStarted(const QString& id, int current, int total);
+    void onOJProblemCaseStarted(const QString& id, int current, int total, bool parallel);
     void onOJProblemCaseFinished(const QString& id, int current, int total);
     void onOJProblemCaseNewOutputGetted(const QString& id, const QString& line);
     void onOJProblemCaseResetOutput(const QString& id, const QString& line);
@@ -355,6 +356,7 @@ private slots:
     void invalidateProjectProxyModel();
     void onEditorRenamed(const QString &oldFilename, const QString &newFilename, bool firstSave);
     void onAutoSaveTimeout();
+    void onSyntaxCheckTimeout();
     void onFileChanged(const QString &path);
     void onDirChanged(const QString &path);
     void onFilesViewPathChanged();
@@ -621,6 +623,9 @@ private slots:
 
     void on_btnCancelReplace_clicked();
 
+    void on_btnStopSearch_clicked();
+    void onSearchInFilesStateChanged(bool searching);
+
     void on_actionPrint_triggered();
 
     void on_actionExport_As_RTF_triggered();
@@ -930,6 +935,9 @@ private:
     QString mFilesViewNewCreatedFile;
 
     bool mCheckSyntaxInBack;
+    // file waiting for the syntax check timer, the latest text is checked when it's timeout
+    QString mSyntaxCheckPendingFile;
+    QTimer mSyntaxCheckTimer;
     bool mShouldRemoveAllSettings;
     PCompileSuccessionTask mCompileSuccessionTask;
 
@@ -20,15 +20,206 @@
 #include "qsynedit/syntaxer/cpp.h"
 
 #include <QApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
 #include <QDate>
+#include <QDir>
+#include <QFileInfo>
 #include <QHash>
 #include <QQueue>
 #include <QRegularExpression>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QSemaphore>
 #include <QThread>
+#include <QThreadPool>
+#include <QVarLengthArray>
 #include <QTime>
 
 static QAtomicInt cppParserCount(0);
 
+// set REDPANDA_MEASURE_PARSING environment variable to log the memory used by the statements of each parse
+static bool measureParsing()
+{
+    static bool measure = qEnvironmentVariableIsSet("REDPANDA_MEASURE_PARSING");
+    return measure;
+}
+
+static const quint32 SymbolCacheMagic = 0x52505343; // "RPSC"
+static const quint32 SymbolCacheVersion = 2;
+static const int MaxSymbolCacheFiles = 32;
+static const int MaxLookupMemoSize = 50000;
+// each worker of a parallel parse keeps a copy of the statements of the shared headers
+static const int MaxParallelParseWorkers = 4;
+
+/**
+ * @brief Result of prescanning a single file in a worker thread
+ */
+struct CppIncludeScan {
+    QString fileName;
+    QSet<QString> includes; // local files (directly or indirectly) included by the file
+    QHash<QString,QStringList> buffers; // local files loaded (with comments removed)
+    QAtomicInt scanned;
+};
+
+using PCppIncludeScan = std::shared_ptr<CppIncludeScan>;
+
+class CppIncludeScanner : public QRunnable {
+public:
+    CppIncludeScanner(const CppPreprocessor& options,
+                      const PCppIncludeScan& scan,
+                      QSemaphore* scannedCount):
+        mScan{scan},
+        mScannedCount{scannedCount} {
+        mPreprocessor.copyOptionsFrom(options);
+        //we only use local include relations
+        mPreprocessor.setScanOptions(false, true);
+        mPreprocessor.setCollectFileBuffers(true);
+    }
+
+    void run() override {
+        mPreprocessor.preprocess(mScan->fileName);
+        mPreprocessor.clearTempResults();
+        PParsedFileInfo fileInfo = mPreprocessor.findFileInfo(mScan->fileName);
+        if (fileInfo)
+            mScan->includes = fileInfo->includes();
+        mScan->buffers = mPreprocessor.collectedFileBuffers();
+        mScan->scanned.storeRelease(1);
+        mScannedCount->release();
+    }
+private:
+    CppPreprocessor mPreprocessor;
+    PCppIncludeScan mScan;
+    QSemaphore* mScannedCount;
+};
+
+/**
+ * @brief Statements parsed for a single file by a worker parser
+ *
+ * Statements are copied, so the worker can go on parsing other files.
+ * Statements of other files are copied too if the owned statements refer to them.
+ * Workers are seeded with copies of the main parser's statements, so these are
+ * mapped back to the main parser's statements by identity when merging.
+ */
+struct CppFileShard {
+    QString fileName;
+    QSet<QString> files; // new files parsed for the file, not owned by other shards before it
+    QList<PStatement> statements; // parents before children
+    QSet<const Statement*> ownedStatements; // declared in the files
+    QList<PClassInheritanceInfo> inheritances; // of the owned classes, not handled
+    QList<PParsedFileInfo> fileInfos;
+    QHash<QString,PDefineMap> fileDefines;
+    QHash<QString,PDefineMap> fileUndefines;
+    QSet<QString> inlineNamespaces;
+    QHash<const Statement*,PStatement> originals; // statements copied from the main parser's -> the originals
+    QAtomicInt parsed;
+
+    void clear() {
+        statements.clear();
+        ownedStatements.clear();
+        originals.clear();
+        inheritances.clear();
+        fileInfos.clear();
+        fileDefines.clear();
+        fileUndefines.clear();
+    }
+};
+
+using PCppFileShard = std::shared_ptr<CppFileShard>;
+
+/**
+ * @brief States shared by the workers of a parallel parse
+ */
+struct CppParallelParse {
+    const CppParser* mainParser; // not changed until all workers are seeded from it
+    QVector<PCppFileShard> shards; // in the order they are merged
+    QSet<QString> knownFiles; // files parsed by the main parser before
+    QAtomicInt nextShard;
+    QSemaphore seededCount;
+    QSemaphore parsedCount;
+    QMutex ownersMutex;
+    QHash<QString,int> owners; // file name -> index of the shard it's copied to
+
+    // a file parsed by several workers is only copied to the first shard
+    bool takeOwnership(const QString& fileName, int index) {
+        QMutexLocker locker(&ownersMutex);
+        auto it = owners.find(fileName);
+        if (it!=owners.end() && it.value()<=index)
+            return false;
+        owners.insert(fileName,index);
+        return true;
+    }
+};
+
+class CppFileShardParser : public QRunnable {
+public:
+    CppFileShardParser(CppParser* parser, CppParallelParse* state):
+        mParser{parser},
+        mState{state} {
+    }
+
+    void run() override {
+        mParser->seedFrom(*mState->mainParser);
+        mState->seededCount.release();
+        while (true) {
+            int index = mState->nextShard.fetchAndAddRelaxed(1);
+            if (index>=mState->shards.count())
+                break;
+            const PCppFileShard& shard = mState->shards.at(index);
+            mParser->parseFileShard(*shard, index, *mState);
+            shard->parsed.storeRelease(1);
+            mState->parsedCount.release();
+        }
+    }
+private:
+    CppParser* mParser;
+    CppParallelParse* mState;
+};
+
+// copy of the file info, using the statements mapped from the original ones
+static PParsedFileInfo copyFileInfo(const ParsedFileInfo& fileInfo, const QHash<const Statement*,PStatement>& statementMap)
+{
+    PParsedFileInfo result = std::make_shared<ParsedFileInfo>(fileInfo.fileName());
+    result->addIncludes(fileInfo);
+    foreach (const QString& include, fileInfo.directIncludes())
+        result->addDirectInclude(include);
+    foreach (const QString& usingName, fileInfo.usings())
+        result->addUsing(usingName);
+    for (auto it=fileInfo.branches().begin();it!=fileInfo.branches().end();++it)
+        result->insertBranch(it.key(),it.value());
+    foreach (const PStatement& statement, fileInfo.statements()) {
+        PStatement mapped = statementMap.value(statement.get());
+        if (mapped)
+            result->addStatement(mapped);
+    }
+    foreach (const PCppScope& scope, fileInfo.scopes()) {
+        result->addScope(scope->startLine,
+                         scope->statement?statementMap.value(scope->statement.get()):PStatement());
+    }
+    //handled inheritances are added again when they are handled by the new owner
+    return result;
+}
+
+// children in the order they are added.
+// Overloads with the same name are iterated newest first in the map,
+// so adding the statements in the iteration order would reverse them.
+static QList<PStatement> childrenInAddedOrder(const StatementMap& children)
+{
+    QList<PStatement> result;
+    result.reserve(children.count());
+    auto it = children.begin();
+    while (it!=children.end()) {
+        auto groupEnd = children.upperBound(it.key());
+        auto groupIt = groupEnd;
+        while (groupIt!=it) {
+            --groupIt;
+            result.append(groupIt.value());
+        }
+        it = groupEnd;
+    }
+    return result;
+}
+
 static QString calcFullname(const QString& parentName, const QString& name) {
     QString s;
     s.reserve(parentName.size()+2+name.size());
@@ -39,13 +230,14 @@ static QString calcFullname(const QString& parentName, const QString& name) {
 }
 
 CppParser::CppParser(QObject *parent) : QObject(parent),
-    mMutex()
+    mLock()
 {
     mParserId = cppParserCount.fetchAndAddRelaxed(1);
     mLanguage = ParserLanguage::CPlusPlus;
     mSerialCount = 0;
     updateSerialId();
     mUniqId = 0;
+    mUniqIdStep = 1;
     mParsing = false;
     //mStatementList ; // owns the objects
     //mFilesToScan;
@@ -57,6 +249,7 @@ CppParser::CppParser(QObject *parent) : QObject(parent),
     //mSkipList;
     mParseLocalHeaders = true;
     mParseGlobalHeaders = true;
+    mParallelParsing = true;
     mLockCount = 0;
     mIsSystemHeader = false;
     mIsHeader = false;
@@ -68,6 +261,9 @@ CppParser::CppParser(QObject *parent) : QObject(parent),
 
     internalClear();
 
+    connect(this, &CppParser::onEndParsing,
+            this, &CppParser::watchHeaderSearchDirs);
+
     //mNamespaces;
     //mBlockBeginSkips;
     //mBlockEndSkips;
@@ -80,7 +276,7 @@ CppParser::~CppParser()
     while (true) {
         //wait for all methods finishes running
         {
-            QMutexLocker locker(&mMutex);
+            WriteLocker locker(this);
             if (!mParsing && (mLockCount == 0)) {
               mParsing = true;
               break;
@@ -94,25 +290,98 @@ CppParser::~CppParser()
     //qDebug()<<"-------- parser deleted ------------";
 }
 
+// Parser locks held by the current thread.
+// QReadWriteLock can't be locked recursively in a different mode, so nested
+// lockers check this list instead of locking again.
+struct HeldParserLock {
+    const CppParser* parser;
+    bool forWrite;
+    int depth;
+};
+static thread_local QVarLengthArray<HeldParserLock, 4> heldParserLocks;
+
+static HeldParserLock* findHeldParserLock(const CppParser* parser)
+{
+    for (HeldParserLock& held : heldParserLocks) {
+        if (held.parser == parser)
+            return &held;
+    }
+    return nullptr;
+}
+
+static bool releaseParserLock(const CppParser* parser)
+{
+    for (int i=0;i<heldParserLocks.count();i++) {
+        if (heldParserLocks[i].parser == parser) {
+            if (--heldParserLocks[i].depth > 0)
+                return false;
+            heldParserLocks.remove(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+CppParser::QueryLocker::QueryLocker(const CppParser *parser):
+    mParser{parser}
+{
+    // read or write locked by this thread
+    HeldParserLock* held = findHeldParserLock(mParser);
+    if (held) {
+        held->depth++;
+        return;
+    }
+    mParser->mLock.lockForRead();
+    heldParserLocks.append({mParser, false, 1});
+}
+
+CppParser::QueryLocker::~QueryLocker()
+{
+    if (releaseParserLock(mParser))
+        mParser->mLock.unlock();
+}
+
+CppParser::WriteLocker::WriteLocker(const CppParser *parser):
+    mParser{parser}
+{
+    HeldParserLock* held = findHeldParserLock(mParser);
+    if (held && held->forWrite) {
+        held->depth++;
+        return;
+    }
+    // a read lock can't be upgraded, and no query changes the parser's state
+    Q_ASSERT_X(!held, "CppParser::WriteLocker", "write lock taken inside a query");
+    mParser->mLock.lockForWrite();
+    heldParserLocks.append({mParser, true, 1});
+}
+
+CppParser::WriteLocker::~WriteLocker()
+{
+    if (releaseParserLock(mParser))
+        mParser->mLock.unlock();
+}
+
 void CppParser::addHardDefineByLine(const QString &line)
 {
-    QMutexLocker  locker(&mMutex);
+    WriteLocker locker(this);
     if (line.startsWith('#')) {
         mPreprocessor.addHardDefineByLine(line.mid(1).trimmed());
     } else {
         mPreprocessor.addHardDefineByLine(line);
     }
+    //lookups may have found the old define
+    clearLookupMemo();
 }
 
 void CppParser::addIncludePath(const QString &value)
 {
-    QMutexLocker  locker(&mMutex);
+    WriteLocker locker(this);
     mPreprocessor.addIncludePath(value);
 }
 
 void CppParser::removeProjectFile(const QString &value)
 {
-    QMutexLocker locker(&mMutex);
+    WriteLocker locker(this);
 
     mProjectFiles.remove(value);
     mFilesToScan.remove(value);
@@ -120,31 +389,31 @@ void CppParser::removeProjectFile(const QString &value)
 
 void CppParser::addProjectIncludePath(const QString &value)
 {
-    QMutexLocker  locker(&mMutex);
+    WriteLocker locker(this);
     mPreprocessor.addProjectIncludePath(value);
 }
 
 void CppParser::clearIncludePaths()
 {
-    QMutexLocker  locker(&mMutex);
+    WriteLocker locker(this);
     mPreprocessor.clearIncludePaths();
 }
 
 void CppParser::clearProjectIncludePaths()
 {
-    QMutexLocker  locker(&mMutex);
+    WriteLocker locker(this);
     mPreprocessor.clearProjectIncludePaths();
 }
 
 void CppParser::clearProjectFiles()
 {
-    QMutexLocker  locker(&mMutex);
+    WriteLocker locker(this);
     mProjectFiles.clear();
 }
 
 QList<PStatement> CppParser::getListOfFunctions(const QString &fileName, const QString &phrase, int line) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
     QList<PStatement> result;
     if (mParsing)
         return result;
@@ -187,7 +456,7 @@ QList<PStatement> CppParser::getListOfFunctions(const QString &fileName, const Q
 
 PStatement CppParser::findScopeStatement(const QString &filename, int line) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
     if (mParsing) {
         return PStatement();
     }
@@ -205,13 +474,13 @@ PStatement CppParser::doFindScopeStatement(const QString &filename, int line) co
 
 PParsedFileInfo CppParser::findFileInfo(const QString &filename) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
     PParsedFileInfo fileInfo = mPreprocessor.findFileInfo(filename);
     return fileInfo;
 }
 QString CppParser::findFirstTemplateParamOf(const QString &fileName, const QString &phrase, const PStatement& currentScope) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
     if (mParsing)
         return "";
     return doFindFirstTemplateParamOf(fileName,phrase,currentScope);
@@ -219,7 +488,7 @@ QString CppParser::findFirstTemplateParamOf(const QString &fileName, const QStri
 
 QString CppParser::findTemplateParamOf(const QString &fileName, const QString &phrase, int index, const PStatement &currentScope) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
     if (mParsing)
         return "";
     return doFindTemplateParamOf(fileName,phrase,index,currentScope);
@@ -227,7 +496,9 @@ QString CppParser::findTemplateParamOf(const QString &fileName, const QString &p
 
 PStatement CppParser::findFunctionAt(const QString &fileName, int line) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
+    if (mParsing)
+        return PStatement();
     PParsedFileInfo fileInfo = mPreprocessor.findFileInfo(fileName);
     if (!fileInfo)
         return PStatement();
@@ -264,7 +535,9 @@ int CppParser::findLastOperator(const QString &phrase) const
 
 PStatementList CppParser::findNamespace(const QString &name) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
+    if (mParsing)
+        return PStatementList();
     return doFindNamespace(name);
 }
 
@@ -276,11 +549,27 @@ PStatementList CppParser::doFindNamespace(const QString &name) const
 
 PStatement CppParser::findStatement(const QString &fullname) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
+    if (mParsing)
+        return PStatement();
     return doFindStatement(fullname);
 }
 
 PStatement CppParser::doFindStatement(const QString &fullname) const
+{
+    // statements are being changed while parsing
+    if (mParsing)
+        return lookupStatement(fullname);
+    QString key = lookupMemoKey('f', QString(), fullname, PStatement());
+    PStatement statement;
+    if (!findInLookupMemo(key, PStatement(), statement)) {
+        statement = lookupStatement(fullname);
+        addToLookupMemo(key, PStatement(), statement);
+    }
+    return statement;
+}
+
+PStatement CppParser::lookupStatement(const QString &fullname) const
 {
     if (fullname.isEmpty())
         return PStatement();
@@ -311,7 +600,7 @@ PStatement CppParser::doFindStatement(const QString &fullname) const
 
 PStatement CppParser::findStatementOf(const QString &fileName, const QString &phrase, int line) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
     if (mParsing)
         return PStatement();
     return doFindStatementOf(fileName,phrase,line);
@@ -326,7 +615,7 @@ PStatement CppParser::findStatementOf(const QString &fileName,
                                       const PStatement& currentScope,
                                       PStatement &parentScopeType) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
     if (mParsing)
         return PStatement();
     return doFindStatementOf(fileName,phrase,currentScope,parentScopeType);
@@ -497,7 +786,7 @@ PEvalStatement CppParser::evalExpression(
         QStringList &phraseExpression,
         const PStatement &currentScope) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
     if (mParsing)
         return PEvalStatement();
 //    qDebug()<<phraseExpression;
@@ -520,7 +809,7 @@ PStatement CppParser::doFindStatementOf(const QString &fileName, const QString &
 
 PStatement CppParser::findStatementOf(const QString &fileName, const QStringList &expression, const PStatement &currentScope) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
     if (mParsing)
         return PStatement();
     return doFindStatementOf(fileName,expression,currentScope);
@@ -590,7 +879,7 @@ PStatement CppParser::doFindStatementOf(const QString &fileName, const QStringLi
 
 PStatement CppParser::findStatementOf(const QString &fileName, const QStringList &expression, int line) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
     if (mParsing)
         return PStatement();
     return doFindStatementOf(fileName,expression,line);
@@ -612,7 +901,7 @@ PStatement CppParser::doFindStatementOf(const QString &fileName, const QStringLi
 
 PStatement CppParser::findAliasedStatement(const PStatement &statement) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
     if (mParsing)
         return PStatement();
     return doFindAliasedStatement(statement);
@@ -620,7 +909,7 @@ PStatement CppParser::findAliasedStatement(const PStatement &statement) const
 
 QList<PStatement> CppParser::listTypeStatements(const QString &fileName, int line) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
     if (mParsing)
         return QList<PStatement>();
     return doListTypeStatements(fileName,line);
@@ -728,6 +1017,19 @@ QList<PStatement> CppParser::doListTypeStatements(const QString &fileName, int l
 }
 
 PStatement CppParser::findStatementStartingFrom(const QString &fileName, const QString &phrase, const PStatement& startScope) const
+{
+    if (mParsing)
+        return lookupStatementStartingFrom(fileName, phrase, startScope);
+    QString key = lookupMemoKey('s', fileName, phrase, startScope);
+    PStatement statement;
+    if (!findInLookupMemo(key, startScope, statement)) {
+        statement = lookupStatementStartingFrom(fileName, phrase, startScope);
+        addToLookupMemo(key, startScope, statement);
+    }
+    return statement;
+}
+
+PStatement CppParser::lookupStatementStartingFrom(const QString &fileName, const QString &phrase, const PStatement& startScope) const
 {
     PStatement scopeStatement = startScope;
 
@@ -766,7 +1068,7 @@ PStatement CppParser::findStatementStartingFrom(const QString &fileName, const Q
 
 PStatement CppParser::findTypeDefinitionOf(const QString &fileName, const QString &aType, const PStatement& currentClass) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
 
     if (mParsing)
         return PStatement();
@@ -776,7 +1078,7 @@ PStatement CppParser::findTypeDefinitionOf(const QString &fileName, const QStrin
 
 PStatement CppParser::findTypeDef(const PStatement &statement, const QString &fileName) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
 
     if (mParsing)
         return PStatement();
@@ -785,7 +1087,7 @@ PStatement CppParser::findTypeDef(const PStatement &statement, const QString &fi
 
 bool CppParser::freeze()
 {
-    QMutexLocker locker(&mMutex);
+    WriteLocker locker(this);
     if (mParsing)
         return false;
     mLockCount++;
@@ -794,7 +1096,7 @@ bool CppParser::freeze()
 
 bool CppParser::freeze(const QString &serialId)
 {
-    QMutexLocker locker(&mMutex);
+    WriteLocker locker(this);
     if (mParsing)
         return false;
     if (mSerialId!=serialId)
@@ -805,7 +1107,7 @@ bool CppParser::freeze(const QString &serialId)
 
 QStringList CppParser::getClassesList() const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
 
     QStringList list;
     return list;
@@ -827,7 +1129,7 @@ QStringList CppParser::getClassesList() const
 
 QStringList CppParser::getFileDirectIncludes(const QString &filename) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
     if (mParsing)
         return QStringList();
     if (filename.isEmpty())
@@ -851,26 +1153,42 @@ QSet<QString> CppParser::internalGetIncludedFiles(const QString &filename) const
     PParsedFileInfo fileInfo = mPreprocessor.findFileInfo(filename);
 
     if (fileInfo) {
-        foreach (const QString& file, fileInfo->includes()) {
+        fileInfo->forEachInclude([&list](const QString& file) {
             list.insert(file);
-        }
+        });
     }
     return list;
 }
 
 QSet<QString> CppParser::getIncludedFiles(const QString &filename) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
     return internalGetIncludedFiles(filename);
 }
 
 QSet<QString> CppParser::getFileUsings(const QString &filename) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
     return internalGetFileUsings(filename);
 }
 
 QSet<QString> CppParser::internalGetFileUsings(const QString &filename) const
+{
+    if (mParsing)
+        return lookupFileUsings(filename);
+    {
+        QMutexLocker locker(&mLookupMemoMutex);
+        auto it = mFileUsingsMemo.constFind(filename);
+        if (it!=mFileUsingsMemo.constEnd())
+            return it.value();
+    }
+    QSet<QString> result = lookupFileUsings(filename);
+    QMutexLocker locker(&mLookupMemoMutex);
+    mFileUsingsMemo.insert(filename, result);
+    return result;
+}
+
+QSet<QString> CppParser::lookupFileUsings(const QString &filename) const
 {
     QSet<QString> result;
     if (filename.isEmpty())
@@ -882,21 +1200,21 @@ QSet<QString> CppParser::internalGetFileUsings(const QString &filename) const
         foreach (const QString& usingName, fileInfo->usings()) {
             result.insert(usingName);
         }
-        foreach (const QString& subFile,fileInfo->includes()){
+        fileInfo->forEachInclude([this,&result](const QString& subFile) {
             PParsedFileInfo subIncludes = mPreprocessor.findFileInfo(subFile);
             if (subIncludes) {
                 foreach (const QString& usingName, subIncludes->usings()) {
                     result.insert(usingName);
                 }
             }
-        }
+        });
     }
     return result;
 }
 
 QString CppParser::getHeaderFileName(const QString &relativeTo, const QString &headerName, bool fromNext) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
     QString currentDir = extractFileDir(relativeTo);
     QStringList includes;
     QStringList projectIncludes;
@@ -929,7 +1247,7 @@ QString CppParser::getHeaderFileName(const QString &relativeTo, const QString &h
 
 bool CppParser::isLineVisible(const QString &fileName, int line) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
     if (mParsing) {
         return true;
     }
@@ -944,7 +1262,7 @@ void CppParser::invalidateFile(const QString &fileName)
     if (!mEnabled)
         return;
     {
-        QMutexLocker locker(&mMutex);
+        WriteLocker locker(this);
         if (mParsing || mLockCount>0)
             return;
         updateSerialId();
@@ -952,6 +1270,7 @@ void CppParser::invalidateFile(const QString &fileName)
     }
     QSet<QString> files = calculateFilesToBeReparsed(fileName);
     internalInvalidateFiles(files);
+    StringPool::purge();
     mParsing = false;
 }
 
@@ -979,13 +1298,13 @@ bool CppParser::isIncludeNextLine(const QString &line) const
 
 bool CppParser::isProjectHeaderFile(const QString &fileName) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
     return ::isSystemHeaderFile(fileName,mPreprocessor.projectIncludePaths());
 }
 
 bool CppParser::isSystemHeaderFile(const QString &fileName) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
     return ::isSystemHeaderFile(fileName,mPreprocessor.includePaths());
 }
 
@@ -994,7 +1313,7 @@ void CppParser::parseFile(const QString &fileName, bool inProject, bool onlyIfNo
     if (!mEnabled)
         return;
     {
-        QMutexLocker locker(&mMutex);
+        WriteLocker locker(this);
         if (mParsing) {
             mLastParseFileCommand = std::make_unique<ParseFileCommand>();
             mLastParseFileCommand->fileName = fileName;
@@ -1014,7 +1333,7 @@ void CppParser::parseFile(const QString &fileName, bool inProject, bool onlyIfNo
     }
     {
         auto action = finally([&,this]{
-            QMutexLocker locker(&mMutex);
+            WriteLocker locker(this);
             if (updateView)
                 emit onEndParsing(mFilesScannedCount,1);
             else
@@ -1028,27 +1347,35 @@ void CppParser::parseFile(const QString &fileName, bool inProject, bool onlyIfNo
                             mLastParseFileCommand->updateView);
                 mLastParseFileCommand = nullptr;
             }
+            mPreprocessor.clearPreloadedFileBuffers();
+            //release pooled strings of the replaced statements
+            StringPool::purge();
             mParsing = false;
         });
         QString fName = fileName;
         if (onlyIfNotParsed && mPreprocessor.fileScanned(fName))
             return;
 
+        // only reparse the function body if the changes are all in it
+        QStringList buffer = mPreprocessor.loadFile(fileName);
+        if (reparseChangedFunctionBody(fileName, buffer)) {
+            mFilesToScanCount = 1;
+            mFilesScannedCount = 1;
+            emit onProgress(fileName,mFilesToScanCount,mFilesScannedCount);
+            return;
+        }
+        mPreprocessor.addPreloadedFileBuffer(fileName, buffer);
+
         if (inProject) {
             QSet<QString> filesToReparsed = calculateFilesToBeReparsed(fileName);
-            QStringList files = sortFilesByIncludeRelations(filesToReparsed);
+            QHash<QString,QSet<QString>> includesMap;
+            QStringList files = sortFilesByIncludeRelations(filesToReparsed, includesMap);
             internalInvalidateFiles(filesToReparsed);
 
             mFilesToScanCount = files.count();
             mFilesScannedCount = 0;
 
-            foreach (const QString& file,files) {
-                mFilesScannedCount++;
-                emit onProgress(file,mFilesToScanCount,mFilesScannedCount);
-                if (!mPreprocessor.fileScanned(file)) {
-                    internalParse(file);
-                }
-            }
+            parseFiles(files, includesMap);
         } else {
             internalInvalidateFile(fileName);
             mFilesToScanCount = 1;
@@ -1058,6 +1385,7 @@ void CppParser::parseFile(const QString &fileName, bool inProject, bool onlyIfNo
             emit onProgress(fileName,mFilesToScanCount,mFilesScannedCount);
             internalParse(fileName);
         }
+        rememberParsedBuffer(fileName, buffer);
     }
 }
 
@@ -1066,7 +1394,7 @@ void CppParser::parseFileList(bool updateView)
     if (!mEnabled)
         return;
     {
-        QMutexLocker locker(&mMutex);
+        WriteLocker locker(this);
         if (mParsing || mLockCount>0)
             return;
         updateSerialId();
@@ -1077,6 +1405,8 @@ void CppParser::parseFileList(bool updateView)
     }
     {
         auto action = finally([&,this]{
+            mPreprocessor.clearPreloadedFileBuffers();
+            StringPool::purge();
             mParsing = false;
             if (updateView)
                 emit onEndParsing(mFilesScannedCount,1);
@@ -1087,22 +1417,17 @@ void CppParser::parseFileList(bool updateView)
         mFilesScannedCount = 0;
         mFilesToScanCount = mFilesToScan.count();
 
-        QStringList files = sortFilesByIncludeRelations(mFilesToScan);
+        QHash<QString,QSet<QString>> includesMap;
+        QStringList files = sortFilesByIncludeRelations(mFilesToScan, includesMap);
         // parse header files in the first parse
-        foreach (const QString& file, files) {
-            mFilesScannedCount++;
-            emit onProgress(mCurrentFile,mFilesToScanCount,mFilesScannedCount);
-            if (!mPreprocessor.fileScanned(file)) {
-                internalParse(file);
-            }
-        }
+        parseFiles(files, includesMap);
         mFilesToScan.clear();
     }
 }
 
 void CppParser::parseHardDefines()
 {
-    QMutexLocker locker(&mMutex);
+    WriteLocker locker(this);
     if (mParsing)
         return;
     int oldIsSystemHeader = mIsSystemHeader;
@@ -1129,6 +1454,7 @@ void CppParser::parseHardDefines()
                         StatementProperty::HasDefinition);
         }
     }
+    clearLookupMemo();
 }
 
 bool CppParser::parsing() const
@@ -1140,7 +1466,7 @@ void CppParser::resetParser()
 {
     while (true) {
         {
-            QMutexLocker locker(&mMutex);
+            WriteLocker locker(this);
             if (!mParsing && mLockCount ==0) {
                 mParsing = true;
                 break;
@@ -1177,20 +1503,26 @@ void CppParser::resetParser()
         mNamespaces.clear();  // namespace and the statements in its scope
         mInlineNamespaces.clear();
         mClassInheritances.clear();
+        mLastParsedFile.clear();
+        mLastParsedBuffer.clear();
+        mLastParsedFileInfo.reset();
         mPreprocessor.clear();
         mTokenizer.clear();
+        clearLookupMemo();
     }
+    //release pooled strings of the cleared statements
+    StringPool::purge();
 }
 
 void CppParser::unFreeze()
 {
-    QMutexLocker locker(&mMutex);
+    WriteLocker locker(this);
     mLockCount--;
 }
 
 bool CppParser::fileScanned(const QString &fileName) const
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
     if (mParsing)
         return false;
     return mPreprocessor.fileScanned(fileName);
@@ -1345,7 +1677,7 @@ int CppParser::getTemplateParamEnd(const QString &s, int startAt) const {
 
 void CppParser::addProjectFile(const QString &fileName, bool needScan)
 {
-    QMutexLocker locker(&mMutex);
+    WriteLocker locker(this);
     //value.replace('/','\\'); // only accept full file names
 
     // Update project listing
@@ -1456,7 +1788,7 @@ PStatement CppParser::addStatement(const PStatement& parent,
     if (!newCommand.isEmpty())
         result->command = newCommand;
     else {
-        mUniqId++;
+        mUniqId+=mUniqIdStep;
         result->command = QString("__STATEMENT__%1").arg(mUniqId);
     }
     result->args = args;
@@ -1517,7 +1849,7 @@ PStatement CppParser::addStatement(const PStatement &parent,
                                    const StatementAccessibility &classScope,
                                    StatementProperties properties)
 {
-    Q_ASSERT(mTokenizer[argStart]->text=='(');
+    Q_ASSERT(mTokenizer[argStart].text=='(');
     QString args;
     QString noNameArgs;
 
@@ -1526,12 +1858,12 @@ PStatement CppParser::addStatement(const PStatement &parent,
     int braceLevel=0;
     QString word;
     for (int i=start;i<argEnd;i++) {
-        QChar ch=mTokenizer[i]->text[0];
+        QChar ch=mTokenizer[i].text[0];
         if (this->isIdentChar(ch)) {
             QString spaces=(i>argStart)?" ":"";
             if (args.length()>0 && (isWordChar(args.back()) || args.back()=='>'))
                 args+=spaces;
-            word += mTokenizer[i]->text;
+            word += mTokenizer[i].text;
             if (!typeGetted) {
                 if (noNameArgs.length()>0 && isWordChar(noNameArgs.back()))
                     noNameArgs+=spaces;
@@ -1545,9 +1877,9 @@ PStatement CppParser::addStatement(const PStatement &parent,
             }
             word="";
         } else if (this->isDigitChar(ch)) {
-        } else if (mTokenizer[i]->text=="::") {
+        } else if (mTokenizer[i].text=="::") {
             if (braceLevel==0) {
-                noNameArgs+= mTokenizer[i]->text;
+                noNameArgs+= mTokenizer[i].text;
                 typeGetted = false;
             }
         } else {
@@ -1555,7 +1887,7 @@ PStatement CppParser::addStatement(const PStatement &parent,
             case ',':
                 if (braceLevel==0) {
                     typeGetted=false;
-                    noNameArgs+= mTokenizer[i]->text;
+                    noNameArgs+= mTokenizer[i].text;
                 }
                 break;
             case '{':
@@ -1574,12 +1906,12 @@ PStatement CppParser::addStatement(const PStatement &parent,
             case '*':
             case '&':
                 if (braceLevel==0) {
-                    noNameArgs+= mTokenizer[i]->text;
+                    noNameArgs+= mTokenizer[i].text;
                 }
                 break;
             }
         }
-        args+=mTokenizer[i]->text;
+        args+=mTokenizer[i].text;
     }
     if (!word.isEmpty()) {
         noNameArgs.append(word);
@@ -1636,15 +1968,15 @@ void CppParser::setInheritance(int index, const PStatement& classStatement, bool
     StatementAccessibility lastInheritScopeType = StatementAccessibility::None;
     // Assemble a list of statements in text form we inherit from
     while (true) {
-        QString currentText = mTokenizer[index]->text;
+        QString currentText = mTokenizer[index].text;
         if (currentText=='(') {
             //skip to matching ')'
-            index=mTokenizer[index]->matchIndex;
+            index=mTokenizer[index].matchIndex;
         } else if (currentText=="::"
                    || (isIdentChar(currentText[0]))) {
             KeywordType keywordType = mCppKeywords.value(currentText, KeywordType::None);
             if (keywordType!=KeywordType::None) {
-                StatementAccessibility inheritScopeType = getClassMemberAccessibility(mTokenizer[index]->text);
+                StatementAccessibility inheritScopeType = getClassMemberAccessibility(mTokenizer[index].text);
                 if (inheritScopeType != StatementAccessibility::None) {
                     lastInheritScopeType = inheritScopeType;
                 }
@@ -1653,11 +1985,11 @@ void CppParser::setInheritance(int index, const PStatement& classStatement, bool
                 bool isGlobal = false;
                 index++;
                 if (basename=="::") {
-                    if (index>=maxIndex || !isIdentChar(mTokenizer[index]->text[0])) {
+                    if (index>=maxIndex || !isIdentChar(mTokenizer[index].text[0])) {
                         return;
                     }
                     isGlobal=true;
-                    basename=mTokenizer[index]->text;
+                    basename=mTokenizer[index].text;
                     index++;
                 }
 
@@ -1669,9 +2001,9 @@ void CppParser::setInheritance(int index, const PStatement& classStatement, bool
                 }
 
                 while (index+1<maxIndex
-                       && mTokenizer[index]->text=="::"
-                       && isIdentChar(mTokenizer[index+1]->text[0])){
-                    basename += "::" + mTokenizer[index+1]->text;
+                       && mTokenizer[index].text=="::"
+                       && isIdentChar(mTokenizer[index+1].text[0])){
+                    basename += "::" + mTokenizer[index+1].text;
                     index+=2;
                     //remove template staff
                     if (basename.endsWith('>')) {
@@ -1700,8 +2032,8 @@ void CppParser::setInheritance(int index, const PStatement& classStatement, bool
         index++;
         if (index >= maxIndex)
             break;
-        if (mTokenizer[index]->text.front() == '{'
-                || mTokenizer[index]->text.front() == ';')
+        if (mTokenizer[index].text.front() == '{'
+                || mTokenizer[index].text.front() == ';')
             break;
     }
 }
@@ -1813,6 +2145,11 @@ void CppParser::removeScopeLevel(int line, int maxIndex)
     }
 }
 
+void CppParser::watchHeaderSearchDirs()
+{
+    mPreprocessor.headerLookupCache()->watchNewSearchedDirs();
+}
+
 void CppParser::internalClear()
 {
     mCurrentScope.clear();
@@ -1824,35 +2161,50 @@ void CppParser::internalClear()
     mInlineNamespaceEndSkips.clear();
 }
 
-QStringList CppParser::sortFilesByIncludeRelations(const QSet<QString> &files)
+QStringList CppParser::sortFilesByIncludeRelations(const QSet<QString> &files,
+                                                   QHash<QString,QSet<QString>> &includesMap)
 {
     QStringList result;
-    QSet<QString> saveScannedFiles{mPreprocessor.scannedFiles()};
+    includesMap.clear();
 
-    //rebuild file include relations
-    foreach(const QString& file, files) {
-        if (mPreprocessor.fileScanned(file))
-            continue;
-        //already removed in interalInvalidateFiles
-        //mPreprocessor.removeScannedFile(file);
-        //we only use local include relations
-        mPreprocessor.setScanOptions(false, true);
-        mPreprocessor.preprocess(file);
-        mPreprocessor.clearTempResults();
+    if (mParallelParsing && files.count()>1) {
+        includesMap = scanIncludeRelationsInParallel(files);
+    } else {
+        QSet<QString> saveScannedFiles{mPreprocessor.scannedFiles()};
+
+        //rebuild file include relations
+        foreach(const QString& file, files) {
+            if (mPreprocessor.fileScanned(file))
+                continue;
+            //already removed in interalInvalidateFiles
+            //mPreprocessor.removeScannedFile(file);
+            //we only use local include relations
+            mPreprocessor.setScanOptions(false, true);
+            mPreprocessor.preprocess(file);
+            mPreprocessor.clearTempResults();
+        }
+        foreach(const QString& file, files) {
+            PParsedFileInfo fileInfo = mPreprocessor.findFileInfo(file);
+            if (fileInfo)
+                includesMap.insert(file, fileInfo->includes());
+        }
+
+        QSet<QString> newScannedFiles{mPreprocessor.scannedFiles()};
+        foreach(const QString& file, newScannedFiles) {
+            if (!saveScannedFiles.contains(file))
+                mPreprocessor.removeScannedFile(file);
+        }
     }
 
     QSet<QString> fileSet=files;
     while (!fileSet.isEmpty()) {
         bool found=false;
         foreach (const QString& file,fileSet) {
-            PParsedFileInfo fileInfo = mPreprocessor.findFileInfo(file);
             bool hasInclude=false;
-            if (fileInfo) {
-                foreach(const QString& inc,fileInfo->includes()) {
-                    if (fileSet.contains(inc)) {
-                        hasInclude=true;
-                        break;
-                    }
+            foreach(const QString& inc,includesMap.value(file)) {
+                if (fileSet.contains(inc)) {
+                    hasInclude=true;
+                    break;
                 }
             }
             if (!hasInclude) {
@@ -1869,14 +2221,426 @@ QStringList CppParser::sortFilesByIncludeRelations(const QSet<QString> &files)
             }
         }
     }
-    QSet<QString> newScannedFiles{mPreprocessor.scannedFiles()};
-    foreach(const QString& file, newScannedFiles) {
-        if (!saveScannedFiles.contains(file))
-            mPreprocessor.removeScannedFile(file);
+    return result;
+}
+
+QHash<QString, QSet<QString> > CppParser::scanIncludeRelationsInParallel(const QSet<QString> &files)
+{
+    QHash<QString,QSet<QString>> result;
+    QVector<PCppIncludeScan> scans;
+    foreach(const QString& file, files) {
+        if (mPreprocessor.fileScanned(file)) {
+            PParsedFileInfo fileInfo = mPreprocessor.findFileInfo(file);
+            if (fileInfo)
+                result.insert(file, fileInfo->includes());
+            continue;
+        }
+        PCppIncludeScan scan = std::make_shared<CppIncludeScan>();
+        scan->fileName = file;
+        scans.append(scan);
+    }
+    if (scans.isEmpty())
+        return result;
+
+    //each worker uses its own preprocessor, so the shared parse states are not touched
+    QThreadPool pool;
+    pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount()));
+    QSemaphore scannedCount;
+    foreach (const PCppIncludeScan& scan, scans) {
+        pool.start(new CppIncludeScanner(mPreprocessor, scan, &scannedCount));
     }
+
+    //merge results in order, progress is reported in this thread
+    for (int i=0;i<scans.count();i++) {
+        const PCppIncludeScan& scan = scans.at(i);
+        while (!scan->scanned.loadAcquire())
+            scannedCount.acquire();
+        emit onProgress(scan->fileName,scans.count(),i+1);
+        result.insert(scan->fileName, scan->includes);
+        for (auto it=scan->buffers.begin();it!=scan->buffers.end();++it) {
+            mPreprocessor.addPreloadedFileBuffer(it.key(),it.value());
+        }
+    }
+    pool.waitForDone();
     return result;
 }
 
+void CppParser::copyOptionsFrom(const CppParser &other)
+{
+    setLanguage(other.mLanguage);
+    mEnabled = other.mEnabled;
+    mParseLocalHeaders = other.mParseLocalHeaders;
+    mParseGlobalHeaders = other.mParseGlobalHeaders;
+    mSymbolCacheDir = other.mSymbolCacheDir;
+    mProjectFiles = other.mProjectFiles;
+    mPreprocessor.copyOptionsFrom(other.mPreprocessor);
+}
+
+void CppParser::seedFrom(const CppParser &other)
+{
+    //statements, parents before children, and overloads in the order they are added
+    QHash<const Statement*,PStatement> copies;
+    QQueue<PStatement> queue;
+    queue.enqueue(PStatement());
+    while (!queue.isEmpty()) {
+        PStatement parent = queue.dequeue();
+        PStatement parentCopy = parent?copies.value(parent.get()):PStatement();
+        foreach (const PStatement& statement, childrenInAddedOrder(other.mStatementList.childrenStatements(parent))) {
+            PStatement copy = std::make_shared<Statement>(*statement);
+            copy->parentScope = parentCopy;
+            copy->children.clear();
+            mStatementList.add(copy);
+            copies.insert(statement.get(), copy);
+            mSeedOriginals.insert(copy.get(), statement);
+            if (!statement->children.isEmpty())
+                queue.enqueue(statement);
+        }
+    }
+    for (auto it=other.mNamespaces.begin();it!=other.mNamespaces.end();++it) {
+        PStatementList namespaceList = std::make_shared<StatementList>();
+        foreach (const PStatement& statement, *it.value()) {
+            PStatement copy = copies.value(statement.get());
+            if (copy)
+                namespaceList->append(copy);
+        }
+        mNamespaces.insert(it.key(), namespaceList);
+    }
+    foreach (const PClassInheritanceInfo& info, other.mClassInheritances) {
+        PStatement derived = info->derivedClass.lock();
+        PStatement derivedCopy = derived?copies.value(derived.get()):PStatement();
+        if (!derivedCopy)
+            continue;
+        PClassInheritanceInfo copy = std::make_shared<ClassInheritanceInfo>(*info);
+        copy->derivedClass = derivedCopy;
+        mClassInheritances.append(copy);
+    }
+    //defines of the files are not changed after they are parsed, so they are shared
+    foreach (const QString& file, other.mPreprocessor.scannedFiles()) {
+        PParsedFileInfo fileInfo = other.mPreprocessor.findFileInfo(file);
+        if (!fileInfo)
+            continue;
+        mPreprocessor.addScannedFile(copyFileInfo(*fileInfo, copies),
+                                     other.mPreprocessor.fileDefines(file),
+                                     other.mPreprocessor.fileUndefines(file));
+    }
+    mInlineNamespaces = other.mInlineNamespaces;
+}
+
+void CppParser::parseFiles(const QStringList &files, const QHash<QString,QSet<QString>> &includesMap)
+{
+    if (mParallelParsing && files.count()>1) {
+        parseFilesInParallel(files, includesMap);
+        return;
+    }
+    foreach (const QString& file, files) {
+        mFilesScannedCount++;
+        emit onProgress(file,mFilesToScanCount,mFilesScannedCount);
+        if (!mPreprocessor.fileScanned(file)) {
+            internalParse(file);
+        }
+    }
+}
+
+void CppParser::parseFilesInParallel(const QStringList &files, const QHash<QString,QSet<QString>> &includesMap)
+{
+    //headers included by several files are parsed once in this parser, by the first file
+    //including them, as the serial parse does. The first file is parsed here too, so the
+    //system headers it shares with the other files are parsed once.
+    QHash<QString,int> includerCounts;
+    foreach (const QString& file, files) {
+        foreach (const QString& include, includesMap.value(file))
+            includerCounts[include]++;
+    }
+    QSet<QString> sharedFilesParsed;
+    QSet<QString> filesParsedHere;
+    foreach (const QString& file, files) {
+        if (mPreprocessor.fileScanned(file))
+            continue;
+        bool parseHere = filesParsedHere.isEmpty();
+        const QSet<QString> includes = includesMap.value(file);
+        foreach (const QString& include, includes) {
+            if (includerCounts.value(include)>1 && !sharedFilesParsed.contains(include)) {
+                parseHere = true;
+                break;
+            }
+        }
+        if (!parseHere)
+            continue;
+        sharedFilesParsed.unite(includes);
+        filesParsedHere.insert(file);
+        mFilesScannedCount++;
+        emit onProgress(file,mFilesToScanCount,mFilesScannedCount);
+        internalParse(file);
+    }
+
+    CppParallelParse state;
+    state.mainParser = this;
+    state.knownFiles = mPreprocessor.scannedFiles();
+    foreach (const QString& file, files) {
+        if (state.knownFiles.contains(file))
+            continue;
+        PCppFileShard shard = std::make_shared<CppFileShard>();
+        shard->fileName = file;
+        state.shards.append(shard);
+    }
+
+    int workerCount = std::min(std::min(QThread::idealThreadCount(), MaxParallelParseWorkers),
+                               (int)state.shards.count());
+    if (workerCount<2) {
+        //not worth copying the statements
+        foreach (const QString& file, files) {
+            if (filesParsedHere.contains(file))
+                continue;
+            mFilesScannedCount++;
+            emit onProgress(file,mFilesToScanCount,mFilesScannedCount);
+            if (!mPreprocessor.fileScanned(file))
+                internalParse(file);
+        }
+        return;
+    }
+    QList<PCppParser> workers;
+    for (int i=0;i<workerCount;i++) {
+        PCppParser worker = std::make_shared<CppParser>();
+        worker->copyOptionsFrom(*this);
+        worker->mPreprocessor.setPreloadedFileBuffers(mPreprocessor.preloadedFileBuffers());
+        //this parser uses the id sequence 0, workers use 1..workerCount
+        worker->mUniqId = mUniqId + i + 1;
+        worker->mUniqIdStep = workerCount + 1;
+        //don't use lookup memos of the statements being changed
+        worker->mParsing = true;
+        //progress is only reported by this parser, in its own thread
+        worker->blockSignals(true);
+        workers.append(worker);
+    }
+    int uniqIdStep = mUniqIdStep;
+    mUniqIdStep = workerCount + 1;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(workerCount);
+    foreach (const PCppParser& worker, workers) {
+        pool.start(new CppFileShardParser(worker.get(), &state));
+    }
+    //workers copy the statements of this parser before parsing, don't change them meanwhile
+    state.seededCount.acquire(workerCount);
+
+    //merge shards in the order of the files, progress is reported in this thread
+    int shardIndex = 0;
+    foreach (const QString& file, files) {
+        if (filesParsedHere.contains(file))
+            continue;
+        mFilesScannedCount++;
+        emit onProgress(file,mFilesToScanCount,mFilesScannedCount);
+        if (state.knownFiles.contains(file))
+            continue;
+        const PCppFileShard& shard = state.shards.at(shardIndex);
+        shardIndex++;
+        while (!shard->parsed.loadAcquire())
+            state.parsedCount.acquire();
+        if (!mPreprocessor.fileScanned(file) && !mergeFileShard(*shard)) {
+            //statements it refers to are not parsed by this parser before the workers started,
+            //parse it again in this parser
+            internalParse(file);
+        }
+        shard->clear();
+    }
+    pool.waitForDone();
+
+    mUniqIdStep = uniqIdStep;
+    foreach (const PCppParser& worker, workers) {
+        mUniqId = std::max(mUniqId, worker->mUniqId);
+        worker->mParsing = false;
+    }
+}
+
+void CppParser::parseFileShard(CppFileShard &shard, int index, CppParallelParse &state)
+{
+    QSet<QString> scannedFiles = mPreprocessor.scannedFiles();
+    if (!mPreprocessor.fileScanned(shard.fileName))
+        internalParse(shard.fileName);
+    foreach (const QString& file, mPreprocessor.scannedFiles()) {
+        if (!scannedFiles.contains(file)
+                && !state.knownFiles.contains(file)
+                && state.takeOwnership(file, index))
+            shard.files.insert(file);
+    }
+    if (!shard.files.isEmpty())
+        buildFileShard(shard);
+}
+
+void CppParser::buildFileShard(CppFileShard &shard) const
+{
+    //statements declared in the files, with their children
+    QSet<const Statement*> ownedStatements;
+    QList<PStatement> statementsToCopy;
+    QQueue<PStatement> queue;
+    queue.enqueue(PStatement());
+    while (!queue.isEmpty()) {
+        PStatement parent = queue.dequeue();
+        bool parentOwned = parent && ownedStatements.contains(parent.get());
+        foreach (const PStatement& statement, mStatementList.childrenStatements(parent)) {
+            //inherited members are added again when the inheritances are handled
+            if (statement->isInherited())
+                continue;
+            if (parentOwned || shard.files.contains(statement->fileName)) {
+                ownedStatements.insert(statement.get());
+                statementsToCopy.append(statement);
+            }
+            if (!statement->children.isEmpty())
+                queue.enqueue(statement);
+        }
+    }
+
+    //and the statements they refer to (definitions and scopes in the files), with all parents
+    foreach (const QString& file, shard.files) {
+        PParsedFileInfo fileInfo = mPreprocessor.findFileInfo(file);
+        if (!fileInfo)
+            continue;
+        foreach (const PStatement& statement, fileInfo->statements()) {
+            if (!statement->isInherited())
+                statementsToCopy.append(statement);
+        }
+        foreach (const PCppScope& scope, fileInfo->scopes()) {
+            if (scope->statement)
+                statementsToCopy.append(scope->statement);
+        }
+    }
+    QSet<const Statement*> copiedStatements;
+    foreach (const PStatement& toCopy, statementsToCopy) {
+        PStatement statement = toCopy;
+        while (statement && !copiedStatements.contains(statement.get())) {
+            copiedStatements.insert(statement.get());
+            statement = statement->parentScope.lock();
+        }
+    }
+
+    //copy them, parents before children, and overloads in the order they are added
+    QHash<const Statement*,PStatement> copies;
+    queue.enqueue(PStatement());
+    while (!queue.isEmpty()) {
+        PStatement parent = queue.dequeue();
+        PStatement parentCopy = parent?copies.value(parent.get()):PStatement();
+        foreach (const PStatement& statement, childrenInAddedOrder(mStatementList.childrenStatements(parent))) {
+            if (!copiedStatements.contains(statement.get()))
+                continue;
+            PStatement copy = std::make_shared<Statement>(*statement);
+            copy->parentScope = parentCopy;
+            copy->children.clear();
+            copies.insert(statement.get(), copy);
+            shard.statements.append(copy);
+            PStatement original = mSeedOriginals.value(statement.get());
+            if (original)
+                shard.originals.insert(copy.get(), original);
+            if (ownedStatements.contains(statement.get()))
+                shard.ownedStatements.insert(copy.get());
+            queue.enqueue(statement);
+        }
+    }
+
+    foreach (const PClassInheritanceInfo& info, mClassInheritances) {
+        PStatement derived = info->derivedClass.lock();
+        if (!derived || !ownedStatements.contains(derived.get()))
+            continue;
+        PClassInheritanceInfo copy = std::make_shared<ClassInheritanceInfo>(*info);
+        copy->derivedClass = copies.value(derived.get());
+        copy->handled = false;
+        shard.inheritances.append(copy);
+    }
+    foreach (const QString& file, shard.files) {
+        PParsedFileInfo fileInfo = mPreprocessor.findFileInfo(file);
+        if (fileInfo)
+            shard.fileInfos.append(copyFileInfo(*fileInfo, copies));
+        PDefineMap defines = mPreprocessor.fileDefines(file);
+        if (defines)
+            shard.fileDefines.insert(file, std::make_shared<DefineMap>(*defines));
+        PDefineMap undefines = mPreprocessor.fileUndefines(file);
+        if (undefines)
+            shard.fileUndefines.insert(file, std::make_shared<DefineMap>(*undefines));
+    }
+    shard.inlineNamespaces = mInlineNamespaces;
+}
+
+bool CppParser::mergeFileShard(const CppFileShard &shard)
+{
+    QSet<QString> newFiles;
+    foreach (const QString& file, shard.files) {
+        if (!mPreprocessor.fileScanned(file))
+            newFiles.insert(file);
+    }
+    if (!newFiles.contains(shard.fileName))
+        return false;
+
+    //statements of this parser for the shard statements, nothing is changed if any of them is not found
+    QHash<const Statement*,PStatement> statementMap;
+    QSet<const Statement*> addedStatements;
+    foreach (const PStatement& statement, shard.statements) {
+        PStatement parent = statement->parentScope.lock();
+        bool parentAdded = parent && addedStatements.contains(parent.get());
+        if (shard.ownedStatements.contains(statement.get())
+                && (parentAdded || newFiles.contains(statement->fileName))) {
+            addedStatements.insert(statement.get());
+            statementMap.insert(statement.get(), statement);
+            continue;
+        }
+        if (parentAdded)
+            return false;
+        //statements copied from this parser's map to the ones they are copied from,
+        //the ones parsed by other workers can't be mapped
+        PStatement original = shard.originals.value(statement.get());
+        if (!original)
+            return false;
+        statementMap.insert(statement.get(), original);
+    }
+
+    foreach (const PStatement& statement, shard.statements) {
+        if (addedStatements.contains(statement.get())) {
+            PStatement parent = statement->parentScope.lock();
+            if (parent)
+                statement->parentScope = statementMap.value(parent.get());
+            mStatementList.add(statement);
+            if (statement->kind == StatementKind::Namespace) {
+                PStatementList namespaceList = doFindNamespace(statement->fullName);
+                if (!namespaceList) {
+                    namespaceList=std::make_shared<StatementList>();
+                    mNamespaces.insert(statement->fullName,namespaceList);
+                }
+                namespaceList->append(statement);
+            }
+        } else if (statement->hasDefinition()
+                   && newFiles.contains(statement->definitionFileName)) {
+            //defined in the new files
+            PStatement mapped = statementMap.value(statement.get());
+            if (!mapped->hasDefinition()) {
+                mapped->setHasDefinition(true);
+                mapped->definitionLine = statement->definitionLine;
+                mapped->definitionFileName = statement->definitionFileName;
+            }
+        }
+    }
+    foreach (const PParsedFileInfo& fileInfo, shard.fileInfos) {
+        QString file = fileInfo->fileName();
+        if (!newFiles.contains(file))
+            continue;
+        mPreprocessor.addScannedFile(copyFileInfo(*fileInfo, statementMap),
+                                     shard.fileDefines.value(file),
+                                     shard.fileUndefines.value(file));
+    }
+    foreach (const PClassInheritanceInfo& info, shard.inheritances) {
+        PStatement derived = info->derivedClass.lock();
+        if (derived && addedStatements.contains(derived.get()))
+            mClassInheritances.append(info);
+    }
+    mInlineNamespaces.unite(shard.inlineNamespaces);
+    handleInheritances();
+    return true;
+}
+
+void CppParser::reserveUniqIds(int usedId)
+{
+    //skip used ids, but keep in the parser's own id sequence
+    if (mUniqId < usedId)
+        mUniqId += (usedId - mUniqId + mUniqIdStep - 1) / mUniqIdStep * mUniqIdStep;
+}
+
 int CppParser::evaluateConstExpr(int endIndex, bool &ok)
 {
     int result = 0;
@@ -1901,13 +2665,13 @@ int CppParser::evaluateAdditionConstExpr(int endIndex, bool &ok)
     if (!ok)
         return result;
     while (mIndex<endIndex) {
-        if (mTokenizer[mIndex]->text=='+') {
+        if (mTokenizer[mIndex].text=='+') {
             mIndex++;
             int temp = evaluateMultiplyConstExpr(endIndex,ok);
             if (!ok)
                 return result;
             result+=temp;
-        } else if (mTokenizer[mIndex]->text=='-') {
+        } else if (mTokenizer[mIndex].text=='-') {
             mIndex++;
             int temp = evaluateMultiplyConstExpr(endIndex,ok);
             if (!ok)
@@ -1930,19 +2694,19 @@ int CppParser::evaluateMultiplyConstExpr(int endIndex, bool &ok)
     if (!ok)
         return result;
     while (mIndex<endIndex) {
-        if (mTokenizer[mIndex]->text=='*') {
+        if (mTokenizer[mIndex].text=='*') {
             mIndex++;
             int temp = evaluateConstExprTerm(endIndex,ok);
             if (!ok)
                 return result;
             result*=temp;
-        } else if (mTokenizer[mIndex]->text=='/') {
+        } else if (mTokenizer[mIndex].text=='/') {
             mIndex++;
             int temp = evaluateConstExprTerm(endIndex,ok);
             if (!ok)
                 return result;
             result/=temp;
-        } else if (mTokenizer[mIndex]->text=='%') {
+        } else if (mTokenizer[mIndex].text=='%') {
             mIndex++;
             int temp = evaluateConstExprTerm(endIndex,ok);
             if (!ok)
@@ -1961,31 +2725,31 @@ int CppParser::evaluateConstExprTerm(int endIndex, bool &ok)
         ok=false;
         return 0;
     }
-    if (mTokenizer[mIndex]->text=="(") {
+    if (mTokenizer[mIndex].text=="(") {
         mIndex++;
         result = evaluateConstExpr(endIndex, ok);
-        if (mIndex>=endIndex || mTokenizer[mIndex]->text!=')')
+        if (mIndex>=endIndex || mTokenizer[mIndex].text!=')')
             ok=false;
         mIndex++;
-    } else if (isIdentChar(mTokenizer[mIndex]->text[0])
-               || mTokenizer[mIndex]->text=="::") {
-        QString s = mTokenizer[mIndex]->text;
+    } else if (isIdentChar(mTokenizer[mIndex].text[0])
+               || mTokenizer[mIndex].text=="::") {
+        QString s = mTokenizer[mIndex].text;
         QSet<QString> searched;
         bool isGlobal = false;
         mIndex++;
         if (s=="::") {
-            if (mIndex>=endIndex || !isIdentChar(mTokenizer[mIndex]->text[0])) {
+            if (mIndex>=endIndex || !isIdentChar(mTokenizer[mIndex].text[0])) {
                 ok=false;
                 return result;
             }
             isGlobal = true;
-            s+=mTokenizer[mIndex]->text;
+            s+=mTokenizer[mIndex].text;
             mIndex++;
         }
         while (mIndex+1<endIndex
-               && mTokenizer[mIndex]->text=="::"
-               && isIdentChar(mTokenizer[mIndex+1]->text[0])){
-            s += "::" + mTokenizer[mIndex+1]->text;
+               && mTokenizer[mIndex].text=="::"
+               && isIdentChar(mTokenizer[mIndex+1].text[0])){
+            s += "::" + mTokenizer[mIndex+1].text;
             mIndex+=2;
         }
         while (true){
@@ -2027,22 +2791,22 @@ int CppParser::evaluateLiteralNumber(int endIndex, bool &ok)
         ok=false;
         return 0;
     }
-    if (mTokenizer[mIndex]->text.startsWith("0x")
-          || mTokenizer[mIndex]->text.startsWith("0X"))
-        result = mTokenizer[mIndex]->text.mid(2).toInt(&ok,16);
-    else if (mTokenizer[mIndex]->text.startsWith("0b")
-          || mTokenizer[mIndex]->text.startsWith("0B"))
-        result = mTokenizer[mIndex]->text.mid(2).toInt(&ok,2);
-    else if (mTokenizer[mIndex]->text.startsWith("0"))
-        result = mTokenizer[mIndex]->text.toInt(&ok,8);
+    if (mTokenizer[mIndex].text.startsWith("0x")
+          || mTokenizer[mIndex].text.startsWith("0X"))
+        result = mTokenizer[mIndex].text.mid(2).toInt(&ok,16);
+    else if (mTokenizer[mIndex].text.startsWith("0b")
+          || mTokenizer[mIndex].text.startsWith("0B"))
+        result = mTokenizer[mIndex].text.mid(2).toInt(&ok,2);
+    else if (mTokenizer[mIndex].text.startsWith("0"))
+        result = mTokenizer[mIndex].text.toInt(&ok,8);
     else
-        result = mTokenizer[mIndex]->text.toInt(&ok);
+        result = mTokenizer[mIndex].text.toInt(&ok);
     return result;
 }
 
 bool CppParser::checkForKeyword(KeywordType& keywordType)
 {
-    keywordType = mCppKeywords.value(mTokenizer[mIndex]->text,KeywordType::NotKeyword);
+    keywordType = mCppKeywords.value(mTokenizer[mIndex].text,KeywordType::NotKeyword);
     switch(keywordType) {
     case KeywordType::Catch:
     case KeywordType::For:
@@ -2075,13 +2839,13 @@ bool CppParser::checkForNamespace(KeywordType keywordType, int maxIndex)
             || (
                 keywordType==KeywordType::Inline
                 && (mIndex+1 < maxIndex-1)
-                &&mTokenizer[mIndex+1]->text == "namespace"
+                &&mTokenizer[mIndex+1].text == "namespace"
             );
 }
 
 bool CppParser::checkForPreprocessor()
 {
-    return (mTokenizer[mIndex]->text.startsWith('#'));
+    return (mTokenizer[mIndex].text.startsWith('#'));
 }
 
 bool CppParser::checkForAccessibilitySpecifiers(KeywordType keywordType)
@@ -2108,7 +2872,7 @@ bool CppParser::checkForStructs(KeywordType keywordType, int maxIndex)
             mIndex++;
             return false;
         }
-        result = (mCppKeywords.value(mTokenizer[mIndex+dis]->text,KeywordType::None)==KeywordType::Struct);
+        result = (mCppKeywords.value(mTokenizer[mIndex+dis].text,KeywordType::None)==KeywordType::Struct);
     } else {
         result = (keywordType==KeywordType::Struct);
     }
@@ -2116,7 +2880,7 @@ bool CppParser::checkForStructs(KeywordType keywordType, int maxIndex)
     if (result) {
         if (mIndex >= maxIndex - 2 - dis)
             return false;
-        if (mTokenizer[mIndex + 2+dis]->text[0] != ';') { // not: class something;
+        if (mTokenizer[mIndex + 2+dis].text[0] != ';') { // not: class something;
             int i = mIndex+dis +1;
             // the check for ']' was added because of this example:
             // struct option long_options[] = {
@@ -2125,7 +2889,7 @@ bool CppParser::checkForStructs(KeywordType keywordType, int maxIndex)
             //    ...
             // };
             while (i < maxIndex) {
-                QChar ch = mTokenizer[i]->text.back();
+                QChar ch = mTokenizer[i].text.back();
                 if (ch=='{' || ch == ':')
                     break;
                 switch(ch.unicode()) {
@@ -2158,7 +2922,7 @@ bool CppParser::checkForTypedefEnum(int maxIndex)
     //we assume that typedef is the current index, so we check the next
     //should call CheckForTypedef first!!!
     return (mIndex+1 < maxIndex ) &&
-            (mTokenizer[mIndex + 1]->text == "enum");
+            (mTokenizer[mIndex + 1].text == "enum");
 }
 
 bool CppParser::checkForTypedefStruct(int maxIndex)
@@ -2167,7 +2931,7 @@ bool CppParser::checkForTypedefStruct(int maxIndex)
     //should call CheckForTypedef first!!!
     if (mIndex+1 >= maxIndex)
         return false;
-    return (mCppKeywords.value(mTokenizer[mIndex+1]->text,KeywordType::None)==KeywordType::Struct);
+    return (mCppKeywords.value(mTokenizer[mIndex+1].text,KeywordType::None)==KeywordType::Struct);
 
 }
 
@@ -2182,14 +2946,14 @@ void CppParser::checkAndHandleMethodOrVar(KeywordType keywordType, int maxIndex)
         mIndex+=2; // let's finish;
         return;
     }
-    QString currentText=mTokenizer[mIndex]->text;
+    QString currentText=mTokenizer[mIndex].text;
     if (keywordType==KeywordType::DeclType) {
-        if (mTokenizer[mIndex+1]->text=='(') {
+        if (mTokenizer[mIndex+1].text=='(') {
             currentText="auto";
-            mIndex=mTokenizer[mIndex+1]->matchIndex+1;
+            mIndex=mTokenizer[mIndex+1].matchIndex+1;
 
         } else {
-            currentText=mTokenizer[mIndex+1]->text;
+            currentText=mTokenizer[mIndex+1].text;
             mIndex+=2;
         }
     } else {
@@ -2203,17 +2967,17 @@ void CppParser::checkAndHandleMethodOrVar(KeywordType keywordType, int maxIndex)
         mIndex++;
     }
     //next token must be */&/word/(/{
-    if (mTokenizer[mIndex]->text=='(') {
-        int indexAfterParentheis=mTokenizer[mIndex]->matchIndex+1;
+    if (mTokenizer[mIndex].text=='(') {
+        int indexAfterParentheis=mTokenizer[mIndex].matchIndex+1;
         if (indexAfterParentheis>=maxIndex) {
             //error
             mIndex=indexAfterParentheis;
-        } else if (mTokenizer[indexAfterParentheis]->text=='(') {
+        } else if (mTokenizer[indexAfterParentheis].text=='(') {
             // operator overloading like (operator int)
-            if (mTokenizer[mIndex+1]->text=="operator") {
+            if (mTokenizer[mIndex+1].text=="operator") {
                 mIndex=indexAfterParentheis;
                 handleMethod(StatementKind::Function,"",
-                             mergeArgs(mIndex+1,mTokenizer[mIndex]->matchIndex-1),
+                             mergeArgs(mIndex+1,mTokenizer[mIndex].matchIndex-1),
                              indexAfterParentheis,false,false,true, maxIndex);
             } else {
                 handleVar(currentText,false,false, maxIndex);
@@ -2262,10 +3026,10 @@ void CppParser::checkAndHandleMethodOrVar(KeywordType keywordType, int maxIndex)
             // function call, skip it
             mIndex=moveToEndOfStatement(mIndex,true, maxIndex);
         }
-    } else if (mTokenizer[mIndex]->text == "*"
-               || mTokenizer[mIndex]->text == "&"
-               || mTokenizer[mIndex]->text=="::"
-               || tokenIsIdentifier(mTokenizer[mIndex]->text)
+    } else if (mTokenizer[mIndex].text == "*"
+               || mTokenizer[mIndex].text == "&"
+               || mTokenizer[mIndex].text=="::"
+               || tokenIsIdentifier(mTokenizer[mIndex].text)
                    ) {
         // it should be function/var
 
@@ -2275,7 +3039,7 @@ void CppParser::checkAndHandleMethodOrVar(KeywordType keywordType, int maxIndex)
 
         QString sType; // should contain type "int"
         QString sName; // should contain function name "foo::function"
-        if (mTokenizer[mIndex]->text=="::") {
+        if (mTokenizer[mIndex].text=="::") {
             mIndex--;
         } else {
             if (currentText=="::") {
@@ -2293,45 +3057,45 @@ void CppParser::checkAndHandleMethodOrVar(KeywordType keywordType, int maxIndex)
 
         // Gather data for the string parts
         while (mIndex+1 < maxIndex) {
-            if (mTokenizer[mIndex]->text=="operator") {
+            if (mTokenizer[mIndex].text=="operator") {
                 handleOperatorOverloading(sType,
                                       //sName,
                                       mIndex,
                                       isStatic, maxIndex);
                 return;
-            } else if (mTokenizer[mIndex + 1]->text == '(') {
+            } else if (mTokenizer[mIndex + 1].text == '(') {
 #ifdef ENABLE_SDCC
-                if (mLanguage==ParserLanguage::SDCC && mTokenizer[mIndex]->text=="__at") {
+                if (mLanguage==ParserLanguage::SDCC && mTokenizer[mIndex].text=="__at") {
                     if (!sName.isEmpty()) {
                         sType = sType+" "+sName;
                         sName = "";
                     }
                     sType+=" __at";
                     mIndex++;
-                    int idx= mTokenizer[mIndex]->matchIndex;
+                    int idx= mTokenizer[mIndex].matchIndex;
                     if (idx<maxIndex) {
                         for (int i=mIndex;i<=idx;i++) {
-                            sType+=mTokenizer[i]->text;
+                            sType+=mTokenizer[i].text;
                         }
                     }
                     mIndex=idx+1;
                     continue;
                 }
 #endif
-                if (mIndex+2<maxIndex && mTokenizer[mIndex+2]->text == '*') {
+                if (mIndex+2<maxIndex && mTokenizer[mIndex+2].text == '*') {
                     //foo(*blabla), it's a function pointer var
                     handleVar(sType+" "+sName,isExtern,isStatic, maxIndex);
                     return;
                 }
 
-                int indexAfter=mTokenizer[mIndex + 1]->matchIndex+1;
+                int indexAfter=mTokenizer[mIndex + 1].matchIndex+1;
                 if (indexAfter>=maxIndex) {
                     //error
                     mIndex=indexAfter;
                     return;
                 }
                 //if it's like: foo(...)(...)
-                if (mTokenizer[indexAfter]->text=='(') {
+                if (mTokenizer[indexAfter].text=='(') {
                     //foo(...)(...), it's a function pointer var
                     handleVar(sType+" "+sName,isExtern,isStatic, maxIndex);
                     //Won't implement: ignore function decl like int (text)(int x) { };
@@ -2339,7 +3103,7 @@ void CppParser::checkAndHandleMethodOrVar(KeywordType keywordType, int maxIndex)
                 }
 
                 //it's not a function define
-                if (mTokenizer[indexAfter]->text == ',') {
+                if (mTokenizer[indexAfter].text == ',') {
                     // var decl with init
                     handleVar(sType+" "+sName,isExtern,isStatic, maxIndex);
                     return;
@@ -2371,16 +3135,16 @@ void CppParser::checkAndHandleMethodOrVar(KeywordType keywordType, int maxIndex)
                 bool isDestructor = false;
                 if (!sName.isEmpty()) {
                     if (sName.endsWith("::"))
-                        sName+=mTokenizer[mIndex]->text;
+                        sName+=mTokenizer[mIndex].text;
                     else if (sName.endsWith("~")) {
                         isDestructor=true;
-                        sName+=mTokenizer[mIndex]->text;
+                        sName+=mTokenizer[mIndex].text;
                     } else {
                         sType += " "+sName;
-                        sName = mTokenizer[mIndex]->text;
+                        sName = mTokenizer[mIndex].text;
                     }
                 } else
-                    sName = mTokenizer[mIndex]->text;
+                    sName = mTokenizer[mIndex].text;
                 mIndex++;
 
                 if (isDestructor)
@@ -2398,26 +3162,26 @@ void CppParser::checkAndHandleMethodOrVar(KeywordType keywordType, int maxIndex)
 
                 return;
             } else if (
-                       mTokenizer[mIndex + 1]->text == ','
-                       ||mTokenizer[mIndex + 1]->text == ';'
-                       ||mTokenizer[mIndex + 1]->text == ':'
-                       ||mTokenizer[mIndex + 1]->text == '{'
-                       || mTokenizer[mIndex + 1]->text == '=') {
-                if (mTokenizer[mIndex]->text.startsWith("[")
+                       mTokenizer[mIndex + 1].text == ','
+                       ||mTokenizer[mIndex + 1].text == ';'
+                       ||mTokenizer[mIndex + 1].text == ':'
+                       ||mTokenizer[mIndex + 1].text == '{'
+                       || mTokenizer[mIndex + 1].text == '=') {
+                if (mTokenizer[mIndex].text.startsWith("[")
                         && AutoTypes.contains(sType)) {
                     handleStructredBinding(sType,maxIndex);
                     return;
                 }
                 handleVar(sType+" "+sName,isExtern,isStatic, maxIndex);
                 return;
-            } else if ( mTokenizer[mIndex + 1]->text == "::") {
-                sName = sName + mTokenizer[mIndex]->text+ "::";
+            } else if ( mTokenizer[mIndex + 1].text == "::") {
+                sName = sName + mTokenizer[mIndex].text+ "::";
                 mIndex+=2;
-            } else if (mTokenizer[mIndex]->text == "~") {
+            } else if (mTokenizer[mIndex].text == "~") {
                 sName = sName + "~";
                 mIndex++;
             } else {
-                QString s = mTokenizer[mIndex]->text;
+                QString s = mTokenizer[mIndex].text;
                 if (!isWordChar(s.front())) {
                     mIndex = indexOfNextPeriodOrSemicolon(mIndex, maxIndex);
                     return;
@@ -2446,6 +3210,19 @@ void CppParser::checkAndHandleMethodOrVar(KeywordType keywordType, int maxIndex)
 }
 
 PStatement CppParser::doFindTypeDefinitionOf(const QString &fileName, const QString &aType, const PStatement &currentClass) const
+{
+    if (mParsing)
+        return lookupTypeDefinitionOf(fileName, aType, currentClass);
+    QString key = lookupMemoKey('t', fileName, aType, currentClass);
+    PStatement statement;
+    if (!findInLookupMemo(key, currentClass, statement)) {
+        statement = lookupTypeDefinitionOf(fileName, aType, currentClass);
+        addToLookupMemo(key, currentClass, statement);
+    }
+    return statement;
+}
+
+PStatement CppParser::lookupTypeDefinitionOf(const QString &fileName, const QString &aType, const PStatement &currentClass) const
 {
     if (aType.isEmpty())
         return PStatement();
@@ -2651,7 +3428,7 @@ void CppParser::doAddVar(const QString &name, const QString &type, bool isConst,
                 "",
                 "",
                 "",
-                mTokenizer[mIndex]->line,
+                mTokenizer[mIndex].line,
                 StatementKind::Variable,
                 getScope(),
                 mCurrentMemberAccessibility,
@@ -2664,8 +3441,8 @@ void CppParser::handleConcept(int maxIndex)
     // just skip it;
     mIndex = indexOfNextSemicolonOrLeftBrace(mIndex, maxIndex);
     if (mIndex<maxIndex) {
-        if (mTokenizer[mIndex]->text=='{')
-            mIndex = mTokenizer[mIndex]->matchIndex+1; // skip '}'
+        if (mTokenizer[mIndex].text=='{')
+            mIndex = mTokenizer[mIndex].matchIndex+1; // skip '}'
         else
             mIndex++; // skip ;
     }
@@ -2675,12 +3452,12 @@ void CppParser::handleEnum(bool isTypedef, int maxIndex)
 {
     QString enumName = "";
     bool isEnumClass = false;
-    int startLine = mTokenizer[mIndex]->line;
+    int startLine = mTokenizer[mIndex].line;
     mIndex++; //skip 'enum'
 
     if (mIndex < maxIndex &&
-            (mTokenizer[mIndex]->text == "class"
-             || mTokenizer[mIndex]->text == "struct")) {
+            (mTokenizer[mIndex].text == "class"
+             || mTokenizer[mIndex].text == "struct")) {
         //enum class
         isEnumClass = true;
         mIndex++; //skip class
@@ -2688,12 +3465,12 @@ void CppParser::handleEnum(bool isTypedef, int maxIndex)
     bool isAdhocVar=false;
     bool isNonameEnum=false;
     int definitionEndIndex=-1;
-    if ((mIndex< maxIndex) && mTokenizer[mIndex]->text.startsWith('{')) { // enum {...} NAME
+    if ((mIndex< maxIndex) && mTokenizer[mIndex].text.startsWith('{')) { // enum {...} NAME
         // Skip to the closing brace
         int i = indexOfMatchingBrace(mIndex);
         // Have we found the name?
         if (i + 1 < maxIndex) {
-            enumName = mTokenizer[i + 1]->text.trimmed();
+            enumName = mTokenizer[i + 1].text.trimmed();
             if (!isIdentifierOrPointer(enumName)) {
                 if (isTypedef || isEnumClass) {
                     //not a valid enum, skip to j
@@ -2714,11 +3491,11 @@ void CppParser::handleEnum(bool isTypedef, int maxIndex)
             }
         }
         definitionEndIndex=i+1;
-    } else if (mIndex+1< maxIndex && mTokenizer[mIndex+1]->text.startsWith('{')){ // enum NAME {...};
-        enumName = mTokenizer[mIndex]->text;
+    } else if (mIndex+1< maxIndex && mTokenizer[mIndex+1].text.startsWith('{')){ // enum NAME {...};
+        enumName = mTokenizer[mIndex].text;
         mIndex++;
-    } else if (mIndex+1< maxIndex && mTokenizer[mIndex+1]->text.startsWith(':')){ // enum NAME:int {...};
-        enumName = mTokenizer[mIndex]->text;
+    } else if (mIndex+1< maxIndex && mTokenizer[mIndex+1].text.startsWith(':')){ // enum NAME:int {...};
+        enumName = mTokenizer[mIndex].text;
         //skip :
         mIndex = indexOfNextLeftBrace(mIndex, maxIndex);
         if (mIndex>maxIndex)
@@ -2769,7 +3546,7 @@ void CppParser::handleEnum(bool isTypedef, int maxIndex)
         int i = indexOfMatchingBrace(mIndex)+1;
         QString typeSuffix="";
         while (i<maxIndex) {
-            QString name=mTokenizer[i]->text;
+            QString name=mTokenizer[i].text;
             if (isIdentifierOrPointer(name)) {
                 QString suffix;
                 QString args;
@@ -2779,11 +3556,11 @@ void CppParser::handleEnum(bool isTypedef, int maxIndex)
                                 getCurrentScope(),
                                 mCurrentFile,
                                 enumName+suffix,
-                                mTokenizer[i]->text,
+                                mTokenizer[i].text,
                                 args,
                                 "",
                                 "",
-                                mTokenizer[i]->line,
+                                mTokenizer[i].line,
                                 StatementKind::Variable,
                                 getScope(),
                                 mCurrentMemberAccessibility,
@@ -2810,12 +3587,12 @@ void CppParser::handleEnum(bool isTypedef, int maxIndex)
     int value=0;
     bool canCalcValue=true;
     while ((mIndex < maxIndex) &&
-                     mTokenizer[mIndex]->text!='}') {
-        if (tokenIsIdentifier(mTokenizer[mIndex]->text)) {
-            cmd = mTokenizer[mIndex]->text;
+                     mTokenizer[mIndex].text!='}') {
+        if (tokenIsIdentifier(mTokenizer[mIndex].text)) {
+            cmd = mTokenizer[mIndex].text;
             args = "";
             if (mIndex+1<maxIndex &&
-                    mTokenizer[mIndex+1]->text=="=") {
+                    mTokenizer[mIndex+1].text=="=") {
                 mIndex+=2;
                 if (mIndex<maxIndex) {
                     int tempIndex = indexOfNextPeriodOrSemicolon(mIndex, maxIndex);
@@ -2833,7 +3610,7 @@ void CppParser::handleEnum(bool isTypedef, int maxIndex)
                       args,
                       "",
                       canCalcValue?QString("%1").arg(value):"",
-                      mTokenizer[mIndex]->line,
+                      mTokenizer[mIndex].line,
                       StatementKind::Enum,
                       getScope(),
                       mCurrentMemberAccessibility,
@@ -2850,7 +3627,7 @@ void CppParser::handleEnum(bool isTypedef, int maxIndex)
                       args,
                       "",
                       strValue,
-                      mTokenizer[mIndex]->line,
+                      mTokenizer[mIndex].line,
                       StatementKind::Enum,
                       getScope(),
                       mCurrentMemberAccessibility,
@@ -2864,7 +3641,7 @@ void CppParser::handleEnum(bool isTypedef, int maxIndex)
                             "",
                             "",
                             strValue,
-                            mTokenizer[mIndex]->line,
+                            mTokenizer[mIndex].line,
                             StatementKind::Enum,
                             getScope(),
                             mCurrentMemberAccessibility,
@@ -2884,21 +3661,21 @@ void CppParser::handleForBlock(int maxIndex)
     mIndex++; // skip for/catch;
     if (mIndex >= maxIndex)
         return;
-    if (mTokenizer[mIndex]->text!='(')
+    if (mTokenizer[mIndex].text!='(')
         return;
-    int i=mTokenizer[mIndex]->matchIndex; //")"
+    int i=mTokenizer[mIndex].matchIndex; //")"
     int i2 = i+1;
     if (i2>=maxIndex)
         return;
-    if (mTokenizer[i2]->text=='{') {
-        mTokenizer[mIndex]->text="{";
-        mTokenizer[mIndex]->matchIndex = mTokenizer[i2]->matchIndex;
-        mTokenizer[mTokenizer[mIndex]->matchIndex]->matchIndex = mIndex;
-        mTokenizer[i]->text=";";
-        mTokenizer[i2]->text=";";
+    if (mTokenizer[i2].text=='{') {
+        mTokenizer[mIndex].text="{";
+        mTokenizer[mIndex].matchIndex = mTokenizer[i2].matchIndex;
+        mTokenizer[mTokenizer[mIndex].matchIndex].matchIndex = mIndex;
+        mTokenizer[i].text=";";
+        mTokenizer[i2].text=";";
     } else {
-        mTokenizer[mIndex]->text=";";
-        mTokenizer[i]->text=";";
+        mTokenizer[mIndex].text=";";
+        mTokenizer[i].text=";";
         mIndex++; //skip ';'
     }
 }
@@ -2938,23 +3715,23 @@ void CppParser::handleKeyword(KeywordType skipType, int maxIndex)
 
 void CppParser::handleLambda(int index, int maxIndex)
 {
-    Q_ASSERT(mTokenizer[index]->text.startsWith('['));
+    Q_ASSERT(mTokenizer[index].text.startsWith('['));
     QSet<QString> captures = parseLambdaCaptures(index);
-    int startLine=mTokenizer[index]->line;
+    int startLine=mTokenizer[index].line;
     int argStart=index+1;
     int argEnd, bodyStart;
-    if (mTokenizer[argStart]->text == '(' ) {
-        argEnd = mTokenizer[argStart]->matchIndex;
+    if (mTokenizer[argStart].text == '(' ) {
+        argEnd = mTokenizer[argStart].matchIndex;
         bodyStart=indexOfNextLeftBrace(argEnd+1, maxIndex);
         if (bodyStart>=maxIndex) {
             return;
         }
-    } else if (mTokenizer[argStart]->text == '{') {
+    } else if (mTokenizer[argStart].text == '{') {
         argEnd = argStart;
         bodyStart = argStart;
     } else
         return;
-    int bodyEnd = mTokenizer[bodyStart]->matchIndex;
+    int bodyEnd = mTokenizer[bodyStart].matchIndex;
     if (bodyEnd>maxIndex) {
         return;
     }
@@ -2974,13 +3751,13 @@ void CppParser::handleLambda(int index, int maxIndex)
     lambdaBlock->lambdaCaptures = captures;
     if (argEnd > argStart)
         scanMethodArgs(lambdaBlock,argStart);
-    addSoloScopeLevel(lambdaBlock,mTokenizer[bodyStart]->line);
+    addSoloScopeLevel(lambdaBlock,mTokenizer[bodyStart].line);
     int oldIndex = mIndex;
     mIndex = bodyStart+1;
     while (handleStatement(bodyEnd));
     Q_ASSERT(mIndex == bodyEnd);
     mIndex = oldIndex;
-    removeScopeLevel(mTokenizer[bodyEnd]->line, maxIndex);
+    removeScopeLevel(mTokenizer[bodyEnd].line, maxIndex);
 }
 
 void CppParser::handleOperatorOverloading(const QString &sType,
@@ -2993,30 +3770,30 @@ void CppParser::handleOperatorOverloading(const QString &sType,
         mIndex=index;
         return;
     }
-    if (mTokenizer[index]->text=="(") {
+    if (mTokenizer[index].text=="(") {
         op="()";
-        index=mTokenizer[index]->matchIndex+1;
-    } else if (mTokenizer[index]->text=="new"
-               || mTokenizer[index]->text=="delete") {
-            op=mTokenizer[index]->text;
+        index=mTokenizer[index].matchIndex+1;
+    } else if (mTokenizer[index].text=="new"
+               || mTokenizer[index].text=="delete") {
+            op=mTokenizer[index].text;
             index++;
             if (index<maxIndex
-                    && mTokenizer[index]->text=="[]") {
+                    && mTokenizer[index].text=="[]") {
                 op+="[]";
                 index++;
             }
     } else {
-        op=mTokenizer[index]->text;
+        op=mTokenizer[index].text;
         index++;
         while (index<maxIndex
-               && mTokenizer[index]->text != "(")
+               && mTokenizer[index].text != "(")
             index++;
     }
     while (index<maxIndex
-           && mTokenizer[index]->text == ")")
+           && mTokenizer[index].text == ")")
         index++;
     if (index>=maxIndex
-            || mTokenizer[index]->text!="(") {
+            || mTokenizer[index].text!="(") {
         mIndex=index;
         return;
     }
@@ -3046,8 +3823,8 @@ void CppParser::handleMethod(StatementKind functionKind,const QString &sType, co
 {
     bool isValid = true;
     bool isDeclaration = false; // assume it's not a prototype
-    int startLine = mTokenizer[mIndex]->line;
-    int argEnd = mTokenizer[argStart]->matchIndex;
+    int startLine = mTokenizer[mIndex].line;
+    int argEnd = mTokenizer[argStart].matchIndex;
 
     if (mIndex >= maxIndex) // not finished define, just skip it;
         return;
@@ -3057,10 +3834,10 @@ void CppParser::handleMethod(StatementKind functionKind,const QString &sType, co
     //find start of the function body;
     bool foundColon=false;
     mIndex=argEnd+1;
-    while ((mIndex < maxIndex) && !isblockChar(mTokenizer[mIndex]->text.front())) {
-        if (mTokenizer[mIndex]->text=='(') {
-            mIndex=mTokenizer[mIndex]->matchIndex+1;
-        }else if (mTokenizer[mIndex]->text==':') {
+    while ((mIndex < maxIndex) && !isblockChar(mTokenizer[mIndex].text.front())) {
+        if (mTokenizer[mIndex].text=='(') {
+            mIndex=mTokenizer[mIndex].matchIndex+1;
+        }else if (mTokenizer[mIndex].text==':') {
             foundColon=true;
             break;
         } else
@@ -3068,14 +3845,14 @@ void CppParser::handleMethod(StatementKind functionKind,const QString &sType, co
     }
     if (foundColon) {
         mIndex++;
-        while ((mIndex < maxIndex) && !isblockChar(mTokenizer[mIndex]->text.front())) {
-            if (isWordChar(mTokenizer[mIndex]->text[0])
+        while ((mIndex < maxIndex) && !isblockChar(mTokenizer[mIndex].text.front())) {
+            if (isWordChar(mTokenizer[mIndex].text[0])
                     && mIndex+1< maxIndex
-                    && mTokenizer[mIndex+1]->text=='{') {
+                    && mTokenizer[mIndex+1].text=='{') {
                 //skip parent {}intializer
-                mIndex=mTokenizer[mIndex+1]->matchIndex+1;
-            } else if (mTokenizer[mIndex]->text=='(') {
-                mIndex=mTokenizer[mIndex]->matchIndex+1;
+                mIndex=mTokenizer[mIndex+1].matchIndex+1;
+            } else if (mTokenizer[mIndex].text=='(') {
+                mIndex=mTokenizer[mIndex].matchIndex+1;
             } else
                 mIndex++;
         }
@@ -3085,8 +3862,8 @@ void CppParser::handleMethod(StatementKind functionKind,const QString &sType, co
         return;
 
     // Check if this is a prototype
-    if (mTokenizer[mIndex]->text.startsWith(';')
-            || mTokenizer[mIndex]->text.startsWith('}')) {// prototype
+    if (mTokenizer[mIndex].text.startsWith(';')
+            || mTokenizer[mIndex].text.startsWith('}')) {// prototype
         isDeclaration = true;
     }
 
@@ -3189,13 +3966,13 @@ void CppParser::handleMethod(StatementKind functionKind,const QString &sType, co
 
     }
 
-    if ((mIndex < maxIndex) && mTokenizer[mIndex]->text.startsWith('{')) {
+    if ((mIndex < maxIndex) && mTokenizer[mIndex].text.startsWith('{')) {
         addSoloScopeLevel(functionStatement,startLine);
         mIndex++; //skip '{'
-    } else if ((mIndex < maxIndex) && mTokenizer[mIndex]->text.startsWith(';')) {
+    } else if ((mIndex < maxIndex) && mTokenizer[mIndex].text.startsWith(';')) {
         addSoloScopeLevel(functionStatement,startLine);
-        if (mTokenizer[mIndex]->line != startLine)
-            removeScopeLevel(mTokenizer[mIndex]->line+1, maxIndex);
+        if (mTokenizer[mIndex].line != startLine)
+            removeScopeLevel(mTokenizer[mIndex].line+1, maxIndex);
         else
             removeScopeLevel(startLine+1, maxIndex);
         mIndex++;
@@ -3205,7 +3982,7 @@ void CppParser::handleMethod(StatementKind functionKind,const QString &sType, co
 void CppParser::handleNamespace(KeywordType skipType, int maxIndex)
 {
     bool isInline=false;
-    int startLine = mTokenizer[mIndex]->line;
+    int startLine = mTokenizer[mIndex].line;
 
     if (skipType==KeywordType::Inline) {
         isInline = true;
@@ -3214,10 +3991,10 @@ void CppParser::handleNamespace(KeywordType skipType, int maxIndex)
 
     mIndex++; //skip 'namespace'
 
-//    if (!tokenIsIdentifier(mTokenizer[mIndex]->text))
+//    if (!tokenIsIdentifier(mTokenizer[mIndex].text))
 //        //wrong namespace define, stop handling
 //        return;
-    QString command = mTokenizer[mIndex]->text;
+    QString command = mTokenizer[mIndex].text;
 
     QString fullName = getFullStatementName(command,getCurrentScope());
     if (isInline) {
@@ -3231,16 +4008,16 @@ void CppParser::handleNamespace(KeywordType skipType, int maxIndex)
     if (mIndex>=maxIndex)
         return;
     QString aliasName;
-    if ((mIndex+2<maxIndex) && (mTokenizer[mIndex]->text == '=')) {
-        aliasName=mTokenizer[mIndex+1]->text;
+    if ((mIndex+2<maxIndex) && (mTokenizer[mIndex].text == '=')) {
+        aliasName=mTokenizer[mIndex+1].text;
         mIndex+=2;
         if (aliasName == "::" && mIndex<maxIndex) {
-            aliasName += mTokenizer[mIndex]->text;
+            aliasName += mTokenizer[mIndex].text;
             mIndex++;
         }
-        while(mIndex+1<maxIndex && mTokenizer[mIndex]->text == "::") {
+        while(mIndex+1<maxIndex && mTokenizer[mIndex].text == "::") {
             aliasName+="::";
-            aliasName+=mTokenizer[mIndex+1]->text;
+            aliasName+=mTokenizer[mIndex+1].text;
             mIndex+=2;
         }
         //qDebug()<<command<<aliasName;
@@ -3267,7 +4044,7 @@ void CppParser::handleNamespace(KeywordType skipType, int maxIndex)
     } else if (isInline) {
         //inline namespace , just skip it
         // Skip to '{'
-        while ((mIndex<maxIndex) && (mTokenizer[mIndex]->text != '{'))
+        while ((mIndex<maxIndex) && (mTokenizer[mIndex].text != '{'))
             mIndex++;
         int i =indexOfMatchingBrace(mIndex); //skip '}'
         if (i==mIndex)
@@ -3293,7 +4070,7 @@ void CppParser::handleNamespace(KeywordType skipType, int maxIndex)
 
         // find next '{' or ';'
         mIndex = indexOfNextSemicolonOrLeftBrace(mIndex, maxIndex);
-        if (mIndex<maxIndex && mTokenizer[mIndex]->text=='{')
+        if (mIndex<maxIndex && mTokenizer[mIndex].text=='{')
             addSoloScopeLevel(namespaceStatement,startLine);
         //skip it
         mIndex++;
@@ -3302,22 +4079,22 @@ void CppParser::handleNamespace(KeywordType skipType, int maxIndex)
 
 void CppParser::handleOtherTypedefs(int maxIndex)
 {
-    int startLine = mTokenizer[mIndex]->line;
+    int startLine = mTokenizer[mIndex].line;
     // Skip typedef word
     mIndex++;
 
     if (mIndex>=maxIndex)
         return;
 
-    if (mTokenizer[mIndex]->text == '('
-            || mTokenizer[mIndex]->text == ','
-            || mTokenizer[mIndex]->text == ';') { // error typedef
+    if (mTokenizer[mIndex].text == '('
+            || mTokenizer[mIndex].text == ','
+            || mTokenizer[mIndex].text == ';') { // error typedef
         //skip over next ;
         mIndex=indexOfNextSemicolon(mIndex, maxIndex)+1;
         return;
     }
     if ((mIndex+1<maxIndex)
-            && (mTokenizer[mIndex+1]->text == ';')) {
+            && (mTokenizer[mIndex+1].text == ';')) {
         //no old type, not valid
         mIndex+=2; //skip ;
         return;
@@ -3328,14 +4105,14 @@ void CppParser::handleOtherTypedefs(int maxIndex)
     // Walk up to first new word (before first comma or ;)
     while(true) {
         if (oldType.endsWith("::"))
-            oldType += mTokenizer[mIndex]->text;
-        else if (mTokenizer[mIndex]->text=="::")
+            oldType += mTokenizer[mIndex].text;
+        else if (mTokenizer[mIndex].text=="::")
             oldType += "::";
-        else if (mTokenizer[mIndex]->text=="*"
-                 || mTokenizer[mIndex]->text=="&")
-            tempType += mTokenizer[mIndex]->text;
+        else if (mTokenizer[mIndex].text=="*"
+                 || mTokenizer[mIndex].text=="&")
+            tempType += mTokenizer[mIndex].text;
         else {
-            oldType += tempType + ' ' + mTokenizer[mIndex]->text;
+            oldType += tempType + ' ' + mTokenizer[mIndex].text;
             tempType="";
         }
         mIndex++;
@@ -3343,11 +4120,11 @@ void CppParser::handleOtherTypedefs(int maxIndex)
             //not valid, just exit
             return;
         }
-        if  (mTokenizer[mIndex]->text=='(') {
+        if  (mTokenizer[mIndex].text=='(') {
             break;
         }
-        if (mTokenizer[mIndex + 1]->text.front() == ','
-                  || mTokenizer[mIndex + 1]->text == ';')
+        if (mTokenizer[mIndex + 1].text.front() == ','
+                  || mTokenizer[mIndex + 1].text == ';')
             break;
         //typedef function pointer
 
@@ -3360,14 +4137,14 @@ void CppParser::handleOtherTypedefs(int maxIndex)
     }
     QString newType;
     while(mIndex+1<maxIndex) {
-        if (mTokenizer[mIndex]->text == ',' ) {
+        if (mTokenizer[mIndex].text == ',' ) {
             mIndex++;
-        } else if (mTokenizer[mIndex]->text == ';' ) {
+        } else if (mTokenizer[mIndex].text == ';' ) {
             break;
-        } else if (mTokenizer[mIndex]->text == '(') {
-            int paramStart=mTokenizer[mIndex]->matchIndex+1;
+        } else if (mTokenizer[mIndex].text == '(') {
+            int paramStart=mTokenizer[mIndex].matchIndex+1;
             if (paramStart>=maxIndex
-                    || mTokenizer[paramStart]->text!='(') {
+                    || mTokenizer[paramStart].text!='(') {
                 //not valid function pointer (no args)
                 //skip over next ;
                 mIndex=indexOfNextSemicolon(paramStart, maxIndex)+1;
@@ -3380,7 +4157,7 @@ void CppParser::handleOtherTypedefs(int maxIndex)
                         mCurrentFile,
                         oldType+tempType,
                         newType,
-                        mergeArgs(paramStart,mTokenizer[paramStart]->matchIndex),
+                        mergeArgs(paramStart,mTokenizer[paramStart].matchIndex),
                         "",
                         "",
                         startLine,
@@ -3390,10 +4167,10 @@ void CppParser::handleOtherTypedefs(int maxIndex)
                         StatementProperty::HasDefinition);
                 tempType="";
             }
-            mIndex = mTokenizer[paramStart]->matchIndex+1;
-        } else if (mTokenizer[mIndex+1]->text.front() ==','
-                       || mTokenizer[mIndex+1]->text.front() ==';') {
-                newType += mTokenizer[mIndex]->text;
+            mIndex = mTokenizer[paramStart].matchIndex+1;
+        } else if (mTokenizer[mIndex+1].text.front() ==','
+                       || mTokenizer[mIndex+1].text.front() ==';') {
+                newType += mTokenizer[mIndex].text;
                 QString suffix;
                 QString args;
                 parseCommandTypeAndArgs(newType,suffix,args);
@@ -3415,7 +4192,7 @@ void CppParser::handleOtherTypedefs(int maxIndex)
                 newType = "";
                 mIndex++;
         } else {
-            newType += mTokenizer[mIndex]->text;
+            newType += mTokenizer[mIndex].text;
             mIndex++;
         }
     }
@@ -3426,7 +4203,7 @@ void CppParser::handleOtherTypedefs(int maxIndex)
 
 void CppParser::handlePreprocessor()
 {
-    QString text = mTokenizer[mIndex]->text.mid(1).trimmed();
+    QString text = mTokenizer[mIndex].text.mid(1).trimmed();
     if (text.startsWith("include")) { // start of new file
         // format: #include fullfilename:line
         // Strip keyword
@@ -3435,7 +4212,7 @@ void CppParser::handlePreprocessor()
             goto handlePreprocessorEnd;
         int delimPos = s.lastIndexOf(':');
         if (delimPos>=0) {
-//            qDebug()<<mCurrentScope.size()<<mCurrentFile<<mTokenizer[mIndex]->line<<s.mid(0,delimPos).trimmed();
+//            qDebug()<<mCurrentScope.size()<<mCurrentFile<<mTokenizer[mIndex].line<<s.mid(0,delimPos).trimmed();
             mCurrentFile = s.mid(0,delimPos).trimmed();
             PParsedFileInfo fileInfo = mPreprocessor.findFileInfo(mCurrentFile);
             if (fileInfo) {
@@ -3475,7 +4252,7 @@ void CppParser::handlePreprocessor()
                   args,
                   "",// noname args
                   value,
-                  mTokenizer[mIndex]->line,
+                  mTokenizer[mIndex].line,
                   StatementKind::Preprocessor,
                   StatementScope::Global,
                   StatementAccessibility::None,
@@ -3510,7 +4287,7 @@ void CppParser::handleAccessibilitySpecifiers(KeywordType keywordType, int maxIn
     mIndex++;
 
     if (mIndex < maxIndex
-            && mTokenizer[mIndex]->text == ':')
+            && mTokenizer[mIndex].text == ':')
         mIndex++;   // skip ':'
 }
 
@@ -3532,7 +4309,7 @@ bool CppParser::handleStatement(int maxIndex)
         mInlineNamespaceEndSkips.pop_back();
         if (mIndex == idx3)
             mIndex++;
-    } else if (mTokenizer[mIndex]->text.startsWith('{')) {
+    } else if (mTokenizer[mIndex].text.startsWith('{')) {
         PStatement block = addStatement(
                     getCurrentScope(),
                     mCurrentFile,
@@ -3542,43 +4319,43 @@ bool CppParser::handleStatement(int maxIndex)
                     "",
                     "",
                     //mTokenizer[mIndex]^.Line,
-                    mTokenizer[mIndex]->line,
+                    mTokenizer[mIndex].line,
                     StatementKind::Block,
                     getScope(),
                     mCurrentMemberAccessibility,
                     StatementProperty::HasDefinition);
-        addSoloScopeLevel(block,mTokenizer[mIndex]->line,true);
+        addSoloScopeLevel(block,mTokenizer[mIndex].line,true);
         mIndex++;
-    } else if (mTokenizer[mIndex]->text[0] == '}') {
-        removeScopeLevel(mTokenizer[mIndex]->line, maxIndex);
+    } else if (mTokenizer[mIndex].text[0] == '}') {
+        removeScopeLevel(mTokenizer[mIndex].line, maxIndex);
         mIndex++;
     } else if (checkForPreprocessor()) {
         handlePreprocessor();
 //    } else if (checkForLambda()) { // is lambda
 //        handleLambda();
-    } else if (mTokenizer[mIndex]->text=='(') {
+    } else if (mTokenizer[mIndex].text=='(') {
         if (mIndex+1<maxIndex &&
-                mTokenizer[mIndex+1]->text=="operator") {
+                mTokenizer[mIndex+1].text=="operator") {
             // things like (operator int)
             mIndex++; //just skip '('
         } else
             skipParenthesis(mIndex, maxIndex);
-    } else if (mTokenizer[mIndex]->text==')') {
+    } else if (mTokenizer[mIndex].text==')') {
         mIndex++;
-    } else if (mTokenizer[mIndex]->text.startsWith('~')) {
+    } else if (mTokenizer[mIndex].text.startsWith('~')) {
         //it should be a destructor
         if (mIndex+2<maxIndex
-                && isIdentChar(mTokenizer[mIndex+1]->text[0])
-                && mTokenizer[mIndex+2]->text=='(') {
+                && isIdentChar(mTokenizer[mIndex+1].text[0])
+                && mTokenizer[mIndex+2].text=='(') {
             //dont further check to speed up
-            handleMethod(StatementKind::Destructor, "", '~'+mTokenizer[mIndex+1]->text, mIndex+2, false, false, false, maxIndex);
+            handleMethod(StatementKind::Destructor, "", '~'+mTokenizer[mIndex+1].text, mIndex+2, false, false, false, maxIndex);
         } else {
             //error
             mIndex=moveToEndOfStatement(mIndex,false, maxIndex);
         }
-    } else if (mTokenizer[mIndex]->text=="::") {
+    } else if (mTokenizer[mIndex].text=="::") {
         checkAndHandleMethodOrVar(KeywordType::None, maxIndex);
-    } else if (!isIdentChar(mTokenizer[mIndex]->text[0])) {
+    } else if (!isIdentChar(mTokenizer[mIndex].text[0])) {
         mIndex=moveToEndOfStatement(mIndex,true, maxIndex);
     } else if (checkForKeyword(keywordType)) { // includes template now
         handleKeyword(keywordType, maxIndex);
@@ -3615,7 +4392,7 @@ bool CppParser::handleStatement(int maxIndex)
     }else {
         if (keywordType == KeywordType::Extern) {
             if (mIndex+1<maxIndex) {
-                if (mTokenizer[mIndex+1]->text=="template") {
+                if (mTokenizer[mIndex+1].text=="template") {
                     //extern template, skit to ;
                     //see https://en.cppreference.com/w/cpp/language/class_template#Class_template_instantiation
                     skipNextSemicolon(mIndex, maxIndex);
@@ -3635,15 +4412,15 @@ _exit:
 void CppParser::handleStructs(bool isTypedef, int maxIndex)
 {
     bool isFriend = false;
-    QString prefix = mTokenizer[mIndex]->text;
+    QString prefix = mTokenizer[mIndex].text;
     if (prefix == "friend") {
         isFriend = true;
         mIndex++;
     }
     // Check if were dealing with a struct or union
-    prefix = mTokenizer[mIndex]->text;
+    prefix = mTokenizer[mIndex].text;
     bool isStruct = ("class" != prefix); //struct/union
-    int startLine = mTokenizer[mIndex]->line;
+    int startLine = mTokenizer[mIndex].line;
 
     mIndex++; //skip struct/class/union
 
@@ -3658,17 +4435,17 @@ void CppParser::handleStructs(bool isTypedef, int maxIndex)
         return;
     }
     // Forward class/struct decl *or* typedef, e.g. typedef struct some_struct synonym1, synonym2;
-    if (mTokenizer[i]->text == ";") {
+    if (mTokenizer[i].text == ";") {
         // typdef struct Foo Bar
         if (isTypedef) {
-            QString structTypeName = mTokenizer[mIndex]->text;
+            QString structTypeName = mTokenizer[mIndex].text;
             QString tempType = "";
             mIndex++; // skip struct/class name
             while(mIndex+1 < maxIndex) {
                 // Add definition statement for the synonym
-                if ( (mTokenizer[mIndex + 1]->text==","
-                            || mTokenizer[mIndex + 1]->text==";")) {
-                    QString newType = mTokenizer[mIndex]->text;
+                if ( (mTokenizer[mIndex + 1].text==","
+                            || mTokenizer[mIndex + 1].text==";")) {
+                    QString newType = mTokenizer[mIndex].text;
                     QString suffix,tempArgs;
                     parseCommandTypeAndArgs(newType,suffix,tempArgs);
                     addStatement(
@@ -3679,24 +4456,24 @@ void CppParser::handleStructs(bool isTypedef, int maxIndex)
                                 tempArgs, // args
                                 "", // noname args
                                 "", // values
-                                mTokenizer[mIndex]->line,
+                                mTokenizer[mIndex].line,
                                 StatementKind::Typedef,
                                 getScope(),
                                 mCurrentMemberAccessibility,
                                 StatementProperty::HasDefinition);
                     tempType="";
                     mIndex++; //skip , ;
-                    if (mTokenizer[mIndex]->text.front() == ';')
+                    if (mTokenizer[mIndex].text.front() == ';')
                         break;
                 } else
-                    tempType+= mTokenizer[mIndex]->text;
+                    tempType+= mTokenizer[mIndex].text;
                 mIndex++;
             }
         } else {
             if (isFriend) { // friend class
                 PStatement parentStatement = getCurrentScope();
                 if (parentStatement) {
-                    parentStatement->friends.insert(mTokenizer[mIndex]->text);
+                    parentStatement->friends.insert(mTokenizer[mIndex].text);
                 }
             } else {
             // todo: Forward declaration, struct Foo. Don't mention in class browser
@@ -3709,18 +4486,18 @@ void CppParser::handleStructs(bool isTypedef, int maxIndex)
     } else {
         PStatement firstSynonym;
         // Add class/struct name BEFORE opening brace
-        if (mTokenizer[mIndex]->text != "{") {
+        if (mTokenizer[mIndex].text != "{") {
             while(mIndex < maxIndex) {
-                if (mTokenizer[mIndex]->text == ":"
-                        || mTokenizer[mIndex]->text == "{"
-                        || mTokenizer[mIndex]->text == ";") {
+                if (mTokenizer[mIndex].text == ":"
+                        || mTokenizer[mIndex].text == "{"
+                        || mTokenizer[mIndex].text == ";") {
                     break;
                 } else if ((mIndex + 1 < maxIndex)
-                  && (mTokenizer[mIndex + 1]->text == ","
-                      || mTokenizer[mIndex + 1]->text == ";"
-                      || mTokenizer[mIndex + 1]->text == "{"
-                      || mTokenizer[mIndex + 1]->text == ":")) {
-                    QString command = mTokenizer[mIndex]->text;
+                  && (mTokenizer[mIndex + 1].text == ","
+                      || mTokenizer[mIndex + 1].text == ";"
+                      || mTokenizer[mIndex + 1].text == "{"
+                      || mTokenizer[mIndex + 1].text == ":")) {
+                    QString command = mTokenizer[mIndex].text;
 
                     PStatement scopeStatement=getCurrentScope();
                     QString scopelessName;
@@ -3740,7 +4517,7 @@ void CppParser::handleStructs(bool isTypedef, int maxIndex)
                                     "", // args
                                     "", // no name args,
                                     "", // values
-                                    mTokenizer[mIndex]->line,
+                                    mTokenizer[mIndex].line,
                                     //startLine,
                                     StatementKind::Class,
                                     getScope(),
@@ -3751,11 +4528,11 @@ void CppParser::handleStructs(bool isTypedef, int maxIndex)
                     mIndex++;
                     break;
                 } else if ((mIndex + 2 < maxIndex)
-                           && (mTokenizer[mIndex + 1]->text == "final")
-                           && (mTokenizer[mIndex + 2]->text==","
-                               || mTokenizer[mIndex + 2]->text==":"
-                               || isblockChar(mTokenizer[mIndex + 2]->text.front()))) {
-                    QString command = mTokenizer[mIndex]->text;
+                           && (mTokenizer[mIndex + 1].text == "final")
+                           && (mTokenizer[mIndex + 2].text==","
+                               || mTokenizer[mIndex + 2].text==":"
+                               || isblockChar(mTokenizer[mIndex + 2].text.front()))) {
+                    QString command = mTokenizer[mIndex].text;
                     if (!command.isEmpty()) {
                         firstSynonym = addStatement(
                                     getCurrentScope(),
@@ -3765,7 +4542,7 @@ void CppParser::handleStructs(bool isTypedef, int maxIndex)
                                     "", // args
                                     "", // no name args
                                     "", // values
-                                    mTokenizer[mIndex]->line,
+                                    mTokenizer[mIndex].line,
                                     //startLine,
                                     StatementKind::Class,
                                     getScope(),
@@ -3781,7 +4558,7 @@ void CppParser::handleStructs(bool isTypedef, int maxIndex)
         }
 
         // Walk to opening brace if we encountered inheritance statements
-        if ((mIndex < maxIndex) && (mTokenizer[mIndex]->text == ":")) {
+        if ((mIndex < maxIndex) && (mTokenizer[mIndex].text == ":")) {
             if (firstSynonym)
                 setInheritance(mIndex, firstSynonym, isStruct, maxIndex); // set the _InheritanceList value
             mIndex=indexOfNextLeftBrace(mIndex, maxIndex);
@@ -3793,8 +4570,8 @@ void CppParser::handleStructs(bool isTypedef, int maxIndex)
         i = indexOfMatchingBrace(mIndex); // step onto closing brace
 
         if ((i + 1 < maxIndex) && !(
-                    mTokenizer[i + 1]->text.front() == ';'
-                    || mTokenizer[i + 1]->text.front() ==  '}')) {
+                    mTokenizer[i + 1].text.front() == ';'
+                    || mTokenizer[i + 1].text.front() ==  '}')) {
             // When encountering names again after struct body scanning, skip it
             QString command = "";
             QString args = "";
@@ -3802,21 +4579,21 @@ void CppParser::handleStructs(bool isTypedef, int maxIndex)
             // Add synonym before opening brace
             while(true) {
                 i++;
-                if (mTokenizer[i]->text=='('
-                        || mTokenizer[i]->text==')') {
+                if (mTokenizer[i].text=='('
+                        || mTokenizer[i].text==')') {
                     //skip
-                } else if (!(mTokenizer[i]->text == '{'
-                      || mTokenizer[i]->text == ','
-                      || mTokenizer[i]->text == ';')) {
-                    if (mTokenizer[i]->text.endsWith(']')) { // cut-off array brackets
-                        int pos = mTokenizer[i]->text.indexOf('[');
-                        command += mTokenizer[i]->text.mid(0,pos) + ' ';
-                        args =  mTokenizer[i]->text.mid(pos);
-                    } else if (mTokenizer[i]->text == "*"
-                               || mTokenizer[i]->text == "&") { // do not add spaces after pointer operator
-                        command += mTokenizer[i]->text;
+                } else if (!(mTokenizer[i].text == '{'
+                      || mTokenizer[i].text == ','
+                      || mTokenizer[i].text == ';')) {
+                    if (mTokenizer[i].text.endsWith(']')) { // cut-off array brackets
+                        int pos = mTokenizer[i].text.indexOf('[');
+                        command += mTokenizer[i].text.mid(0,pos) + ' ';
+                        args =  mTokenizer[i].text.mid(pos);
+                    } else if (mTokenizer[i].text == "*"
+                               || mTokenizer[i].text == "&") { // do not add spaces after pointer operator
+                        command += mTokenizer[i].text;
                     } else {
-                        command += mTokenizer[i]->text + ' ';
+                        command += mTokenizer[i].text + ' ';
                     }
                 } else {
                     command = command.trimmed();
@@ -3835,7 +4612,7 @@ void CppParser::handleStructs(bool isTypedef, int maxIndex)
                                         "",
                                         "",
                                         "",
-                                        mTokenizer[i]->line,
+                                        mTokenizer[i].line,
                                         //startLine,
                                         StatementKind::Class,
                                         getScope(),
@@ -3852,7 +4629,7 @@ void CppParser::handleStructs(bool isTypedef, int maxIndex)
                                         args+tempArgs,
                                         "",
                                         "",
-                                        mTokenizer[mIndex]->line,
+                                        mTokenizer[mIndex].line,
                                         StatementKind::Typedef,
                                         getScope(),
                                         mCurrentMemberAccessibility,
@@ -3867,7 +4644,7 @@ void CppParser::handleStructs(bool isTypedef, int maxIndex)
                               args+tempArgs,
                               "",
                               "",
-                              mTokenizer[i]->line,
+                              mTokenizer[i].line,
                               StatementKind::Variable,
                               getScope(),
                               mCurrentMemberAccessibility,
@@ -3878,8 +4655,8 @@ void CppParser::handleStructs(bool isTypedef, int maxIndex)
                 }
                 if (i >= maxIndex - 1)
                     break;
-                if (mTokenizer[i]->text=='{'
-                      || mTokenizer[i]->text== ';')
+                if (mTokenizer[i].text=='{'
+                      || mTokenizer[i].text== ';')
                     break;
             }
 
@@ -3889,9 +4666,9 @@ void CppParser::handleStructs(bool isTypedef, int maxIndex)
         if (!firstSynonym) {
             PStatement scope = getCurrentScope();
             if (scope && scope->kind == StatementKind::Class
-                    && mIndex<maxIndex && mTokenizer[mIndex]->text=="{") {
+                    && mIndex<maxIndex && mTokenizer[mIndex].text=="{") {
                 //C11 anonymous union/struct
-                addSoloScopeLevel(scope, mTokenizer[mIndex]->line);
+                addSoloScopeLevel(scope, mTokenizer[mIndex].line);
                 //skip {
                 mIndex++;
                 return;
@@ -3905,7 +4682,7 @@ void CppParser::handleStructs(bool isTypedef, int maxIndex)
                           "",
                           "",
                           "",
-                          mTokenizer[mIndex]->line,
+                          mTokenizer[mIndex].line,
                           StatementKind::Block,
                           getScope(),
                           mCurrentMemberAccessibility,
@@ -3913,12 +4690,12 @@ void CppParser::handleStructs(bool isTypedef, int maxIndex)
             }
         }
         if (mIndex < maxIndex)
-            addSoloScopeLevel(firstSynonym,mTokenizer[mIndex]->line);
+            addSoloScopeLevel(firstSynonym,mTokenizer[mIndex].line);
         else
             addSoloScopeLevel(firstSynonym,startLine);
 
         // Step over {
-        if ((mIndex < maxIndex) && (mTokenizer[mIndex]->text == "{"))
+        if ((mIndex < maxIndex) && (mTokenizer[mIndex].text == "{"))
             mIndex++;
     }
 }
@@ -3926,14 +4703,14 @@ void CppParser::handleStructs(bool isTypedef, int maxIndex)
 void CppParser::handleStructredBinding(const QString &sType, int maxIndex)
 {
     if (mIndex+1 < maxIndex
-            && ((mTokenizer[mIndex+1]->text == ":")
-                || (mTokenizer[mIndex+1]->text == "="))) {
+            && ((mTokenizer[mIndex+1].text == ":")
+                || (mTokenizer[mIndex+1].text == "="))) {
         QString typeName;
         QString templateParams;
         int endIndex = indexOfNextSemicolon(mIndex+2, maxIndex);
         QString expressionText;
         for (int i=mIndex+2;i<endIndex;i++) {
-            expressionText+=mTokenizer[i]->text+" ";
+            expressionText+=mTokenizer[i].text+" ";
         }
         QStringList phraseExpression = splitExpression(expressionText);
         int pos = 0;
@@ -3944,7 +4721,7 @@ void CppParser::handleStructredBinding(const QString &sType, int maxIndex)
                                 PEvalStatement(),
                                 true,false);
         if(aliasStatement && aliasStatement->effectiveTypeStatement) {
-            if ( mTokenizer[mIndex+1]->text == ":" ) {
+            if ( mTokenizer[mIndex+1].text == ":" ) {
                 if (STLMaps.contains(aliasStatement->effectiveTypeStatement->fullName)) {
                     typeName = "std::pair";
                     templateParams = aliasStatement->templateParams;
@@ -3955,7 +4732,7 @@ void CppParser::handleStructredBinding(const QString &sType, int maxIndex)
                                                                                   getCurrentScope());
                 QString secondType = doFindTemplateParamOf(mCurrentFile,aliasStatement->templateParams,1,
                                                                                   getCurrentScope());
-                QString s = mTokenizer[mIndex]->text;
+                QString s = mTokenizer[mIndex].text;
                 s = s.mid(1,s.length()-2);
                 QStringList lst = s.split(",");
                 if (lst.length()==2) {
@@ -3976,7 +4753,7 @@ void CppParser::handleStructredBinding(const QString &sType, int maxIndex)
 
 void CppParser::handleUsing(int maxIndex)
 {
-    int startLine = mTokenizer[mIndex]->line;
+    int startLine = mTokenizer[mIndex].line;
     if (mCurrentFile.isEmpty()) {
         //skip pass next ;
         mIndex=indexOfNextSemicolon(mIndex, maxIndex)+1;
@@ -3987,13 +4764,13 @@ void CppParser::handleUsing(int maxIndex)
 
     //handle things like 'using vec = std::vector; '
     if (mIndex+1 < maxIndex
-            && mTokenizer[mIndex+1]->text == "=") {
-        QString fullName = mTokenizer[mIndex]->text;
+            && mTokenizer[mIndex+1].text == "=") {
+        QString fullName = mTokenizer[mIndex].text;
         QString aliasName;
         mIndex+=2;
         while (mIndex<maxIndex &&
-               mTokenizer[mIndex]->text!=';') {
-            aliasName += mTokenizer[mIndex]->text;
+               mTokenizer[mIndex].text!=';') {
+            aliasName += mTokenizer[mIndex].text;
             mIndex++;
         }
         addStatement(
@@ -4015,20 +4792,20 @@ void CppParser::handleUsing(int maxIndex)
     }
     //handle things like 'using std::vector;'
     if ((mIndex+2>=maxIndex)
-            || (mTokenizer[mIndex]->text != "namespace")) {
+            || (mTokenizer[mIndex].text != "namespace")) {
         QString fullName;
         QString usingName;
         bool appendUsingName = false;
         while (mIndex<maxIndex &&
-               mTokenizer[mIndex]->text!=';') {
-            fullName += mTokenizer[mIndex]->text;
+               mTokenizer[mIndex].text!=';') {
+            fullName += mTokenizer[mIndex].text;
             if (!appendUsingName) {
-                usingName = mTokenizer[mIndex]->text;
+                usingName = mTokenizer[mIndex].text;
                 if (usingName == "operator") {
                     appendUsingName=true;
                 }
             } else {
-                usingName += mTokenizer[mIndex]->text;
+                usingName += mTokenizer[mIndex].text;
             }
             mIndex++;
         }
@@ -4056,8 +4833,8 @@ void CppParser::handleUsing(int maxIndex)
 
     QString usingName;
     while (mIndex<maxIndex &&
-           mTokenizer[mIndex]->text!=';') {
-        usingName += mTokenizer[mIndex]->text;
+           mTokenizer[mIndex].text!=';') {
+        usingName += mTokenizer[mIndex].text;
         mIndex++;
     }
 
@@ -4104,11 +4881,11 @@ void CppParser::handleVar(const QString& typePrefix,bool isExtern,bool isStatic,
     }
 
     while(mIndex<maxIndex) {
-        switch(mTokenizer[mIndex]->text[0].unicode()) {
+        switch(mTokenizer[mIndex].text[0].unicode()) {
         case ':':
-            if (mTokenizer[mIndex]->text.length()>1) {
+            if (mTokenizer[mIndex].text.length()>1) {
                 //handle '::'
-                tempType+=mTokenizer[mIndex]->text;
+                tempType+=mTokenizer[mIndex].text;
                 mIndex++;
             } else {
                 // Skip bit identifiers,
@@ -4118,8 +4895,8 @@ void CppParser::handleVar(const QString& typePrefix,bool isExtern,bool isStatic,
                 // as
                 // unsigned short bAppReturnCode,reserved,fBusy,fAck
                 if (mIndex+1<maxIndex
-                        && isIdentChar(mTokenizer[mIndex+1]->text.front())
-                        && (isIdentChar(mTokenizer[mIndex+1]->text.back()) || isDigitChar(mTokenizer[mIndex+1]->text.back()))
+                        && isIdentChar(mTokenizer[mIndex+1].text.front())
+                        && (isIdentChar(mTokenizer[mIndex+1].text.back()) || isDigitChar(mTokenizer[mIndex+1].text.back()))
                         && addedVar
                         && !(addedVar->properties & StatementProperty::FunctionPointer)
                         && AutoTypes.contains(addedVar->type)) {
@@ -4128,7 +4905,7 @@ void CppParser::handleVar(const QString& typePrefix,bool isExtern,bool isStatic,
                     int endIndex = indexOfNextSemicolon(mIndex+1, maxIndex);
                     QString expressionText;
                     for (int i=mIndex+1;i<endIndex;i++) {
-                        expressionText+=mTokenizer[i]->text+" ";
+                        expressionText+=mTokenizer[i].text+" ";
                     }
                     QStringList phraseExpression = splitExpression(expressionText);
                     int pos = 0;
@@ -4153,7 +4930,7 @@ void CppParser::handleVar(const QString& typePrefix,bool isExtern,bool isStatic,
                 addedVar.reset();
                 bool should_exit=false;
                 while (mIndex < maxIndex) {
-                    switch(mTokenizer[mIndex]->text[0].unicode()) {
+                    switch(mTokenizer[mIndex].text[0].unicode()) {
                     case ',':
                     case ';':
                     case '=':
@@ -4163,7 +4940,7 @@ void CppParser::handleVar(const QString& typePrefix,bool isExtern,bool isStatic,
                         mIndex++;
                         return;
                     case '(':
-                        mIndex=mTokenizer[mIndex]->matchIndex+1;
+                        mIndex=mTokenizer[mIndex].matchIndex+1;
                         break;
                     default:
                         mIndex++;
@@ -4178,7 +4955,7 @@ void CppParser::handleVar(const QString& typePrefix,bool isExtern,bool isStatic,
             return;
         case '=':
             if (mIndex+1<maxIndex
-                    && mTokenizer[mIndex+1]->text!="{"
+                    && mTokenizer[mIndex+1].text!="{"
                     && addedVar
                     && !(addedVar->properties & StatementProperty::FunctionPointer)
                     && AutoTypes.contains(addedVar->type)) {
@@ -4188,7 +4965,7 @@ void CppParser::handleVar(const QString& typePrefix,bool isExtern,bool isStatic,
                 int endIndex = skipAssignment(mIndex, maxIndex);
                 QString expressionText;
                 for (int i=mIndex+1;i<endIndex;i++) {
-                    expressionText.append(mTokenizer[i]->text);
+                    expressionText.append(mTokenizer[i].text);
                     expressionText.append(" ");
                 }
                 QStringList phraseExpression = splitExpression(expressionText);
@@ -4237,7 +5014,7 @@ void CppParser::handleVar(const QString& typePrefix,bool isExtern,bool isStatic,
             break;
         case '*':
         case '&':
-            tempType+=mTokenizer[mIndex]->text;
+            tempType+=mTokenizer[mIndex].text;
             mIndex++;
             break;
         case ',':
@@ -4245,12 +5022,12 @@ void CppParser::handleVar(const QString& typePrefix,bool isExtern,bool isStatic,
             mIndex++;
             break;
         case '(':
-            if (mTokenizer[mIndex]->matchIndex+1<maxIndex
-                    && mTokenizer[mTokenizer[mIndex]->matchIndex+1]->text=='(') {
+            if (mTokenizer[mIndex].matchIndex+1<maxIndex
+                    && mTokenizer[mTokenizer[mIndex].matchIndex+1].text=='(') {
                         //function pointer
                 QString cmd = findFunctionPointerName(mIndex);
-                int argStart=mTokenizer[mIndex]->matchIndex+1;
-                int argEnd=mTokenizer[argStart]->matchIndex;
+                int argStart=mTokenizer[mIndex].matchIndex+1;
+                int argEnd=mTokenizer[argStart].matchIndex;
 
                 if (!cmd.isEmpty()) {
                     QString type=lastType;
@@ -4267,7 +5044,7 @@ void CppParser::handleVar(const QString& typePrefix,bool isExtern,bool isStatic,
                                 mergeArgs(argStart,argEnd),
                                 "",
                                 "",
-                                mTokenizer[mIndex]->line,
+                                mTokenizer[mIndex].line,
                                 StatementKind::Variable,
                                 getScope(),
                                 mCurrentMemberAccessibility,
@@ -4285,15 +5062,15 @@ void CppParser::handleVar(const QString& typePrefix,bool isExtern,bool isStatic,
         case '{':
             tempType="";
             if (mIndex+1<maxIndex
-                    && isIdentifier(mTokenizer[mIndex+1]->text)
+                    && isIdentifier(mTokenizer[mIndex+1].text)
                     && addedVar
                     && !(addedVar->properties & StatementProperty::FunctionPointer)
                     && AutoTypes.contains(addedVar->type)) {
                 int pos = 0;
-                int endIndex = mTokenizer[mIndex]->matchIndex;
+                int endIndex = mTokenizer[mIndex].matchIndex;
                 QString expressionText;
                 for (int i=mIndex+1;i<endIndex;i++) {
-                    expressionText.append(mTokenizer[i]->text);
+                    expressionText.append(mTokenizer[i].text);
                     expressionText.append(" ");
                 }
                 QStringList phraseExpression = splitExpression(expressionText);
@@ -4325,15 +5102,15 @@ void CppParser::handleVar(const QString& typePrefix,bool isExtern,bool isStatic,
                         addedVar->type += QString(aliasStatement->pointerLevel,'*');
                 }
             }
-            mIndex=mTokenizer[mIndex]->matchIndex+1;
+            mIndex=mTokenizer[mIndex].matchIndex+1;
             addedVar.reset();
             //If there are multiple var define in the same line, the next token should be ','
-            if (mIndex>=maxIndex || mTokenizer[mIndex]->text != ",")
+            if (mIndex>=maxIndex || mTokenizer[mIndex].text != ",")
                 return;
             break;
         default:
-            if (isIdentChar(mTokenizer[mIndex]->text[0])) {
-                QString cmd=mTokenizer[mIndex]->text;
+            if (isIdentChar(mTokenizer[mIndex].text[0])) {
+                QString cmd=mTokenizer[mIndex].text;
                 //normal var
                 if (cmd=="const") {
                     if (tempType.isEmpty()) {
@@ -4346,7 +5123,7 @@ void CppParser::handleVar(const QString& typePrefix,bool isExtern,bool isStatic,
                 } else {
                     QString suffix;
                     QString args;
-                    cmd=mTokenizer[mIndex]->text;
+                    cmd=mTokenizer[mIndex].text;
                     parseCommandTypeAndArgs(cmd,suffix,args);
                     if (!cmd.isEmpty() && !isKeyword(cmd)) {
                         addedVar = addChildStatement(
@@ -4357,7 +5134,7 @@ void CppParser::handleVar(const QString& typePrefix,bool isExtern,bool isStatic,
                                     args,
                                     "",
                                     "",
-                                    mTokenizer[mIndex]->line,
+                                    mTokenizer[mIndex].line,
                                     StatementKind::Variable,
                                     getScope(),
                                     mCurrentMemberAccessibility,
@@ -4425,31 +5202,31 @@ void CppParser::skipRequires(int maxIndex)
 
     while (mIndex < maxIndex) { // ||
         while (mIndex < maxIndex) { // &&
-            if (mTokenizer[mIndex]->text=='(') {
+            if (mTokenizer[mIndex].text=='(') {
                 //skip parenthesized expression
-                mIndex = mTokenizer[mIndex]->matchIndex+1;
-            } else if (isIdentifier(mTokenizer[mIndex]->text)) {
+                mIndex = mTokenizer[mIndex].matchIndex+1;
+            } else if (isIdentifier(mTokenizer[mIndex].text)) {
                 // skip foo<T> or foo::boo::ttt<T>
                 while (mIndex < maxIndex) {
-                    if (!isIdentifier(mTokenizer[mIndex]->text))
+                    if (!isIdentifier(mTokenizer[mIndex].text))
                         return;
                     mIndex++;
                     if (mIndex>=maxIndex)
                         return;
-                    if (mTokenizer[mIndex]->text!="::")
+                    if (mTokenizer[mIndex].text!="::")
                         break;
                     mIndex++; // skip '::';
                 }
             }
             if (mIndex+1>=maxIndex)
                 return;
-            if (mTokenizer[mIndex]->text!="&" || mTokenizer[mIndex+1]->text!="&")
+            if (mTokenizer[mIndex].text!="&" || mTokenizer[mIndex+1].text!="&")
                 break;
             mIndex+=2; // skip '&&';
         }
         if (mIndex+1>=maxIndex)
             return;
-        if (mTokenizer[mIndex]->text!="|" || mTokenizer[mIndex+1]->text!="|")
+        if (mTokenizer[mIndex].text!="|" || mTokenizer[mIndex+1].text!="|")
             break;
         mIndex+=2; // skip '||';
     }
@@ -4468,7 +5245,21 @@ void CppParser::internalParse(const QString &fileName)
     auto action = finally([this]{
         mTokenizer.clear();
     });
-    //timer.start();
+    // Use cached symbols of the system headers included at the beginning of the file
+    QString symbolCacheKey;
+    QStringList headersToCache;
+    QSet<QString> scannedFilesBeforeParse;
+    if (!mSymbolCacheDir.isEmpty() && mParseGlobalHeaders) {
+        QStringList includeLines;
+        QStringList headers = findLeadingSystemHeaders(fileName, includeLines);
+        if (!headers.isEmpty()) {
+            symbolCacheKey = calcSymbolCacheKey(includeLines);
+            if (!loadSymbolCache(symbolCacheKey, headers)) {
+                headersToCache = headers;
+                scannedFilesBeforeParse = mPreprocessor.scannedFiles();
+            }
+        }
+    }
     // Let the preprocessor augment the include records
     mPreprocessor.setScanOptions(mParseGlobalHeaders, mParseLocalHeaders);
     mPreprocessor.preprocess(fileName);
@@ -4485,12 +5276,10 @@ void CppParser::internalParse(const QString &fileName)
     mPreprocessor.clearTempResults();
     //qDebug()<<"preprocess clean"<<timer.elapsed();
 
-    //timer.restart();
     // Tokenize the preprocessed buffer file
     mTokenizer.tokenize(preprocessResult);
     //reduce memory usage
     preprocessResult.clear();
-    //qDebug()<<"tokenize"<<timer.elapsed();
     if (mTokenizer.tokenCount() == 0)
         return;
 #ifdef QT_DEBUG
@@ -4510,7 +5299,26 @@ void CppParser::internalParse(const QString &fileName)
        // mTokenizer.dumpTokens(QString("z:\\tokens-after-%1.txt").arg(extractFileName(fileName)));
 #endif
     handleInheritances();
-    //    qDebug()<<"parse"<<timer.elapsed();
+    if (measureParsing()) {
+        StatementMemoryUsage usage = mStatementList.memoryUsage();
+        qDebug()<<"statements of"<<fileName<<":"
+                <<usage.statementCount<<"statements"<<usage.statements/1024<<"KB,"
+                <<usage.stringCount<<"strings"<<usage.strings/1024<<"KB,"
+                <<"children maps"<<usage.children/1024<<"KB,"
+                <<"sets"<<usage.sets/1024<<"KB,"
+                <<"total"<<usage.total()/1024<<"KB";
+    }
+    if (!headersToCache.isEmpty()) {
+        bool scannedBefore = false;
+        foreach (const QString& header, headersToCache) {
+            if (scannedFilesBeforeParse.contains(header)) {
+                scannedBefore = true;
+                break;
+            }
+        }
+        if (!scannedBefore)
+            saveSymbolCache(symbolCacheKey, headersToCache);
+    }
 #ifdef QT_DEBUG
        // mStatementList.dumpAll(QString("z:\\all-stats-%1.txt").arg(extractFileName(fileName)));
        // mStatementList.dump(QString("z:\\stats-%1.txt").arg(extractFileName(fileName)));
@@ -4519,6 +5327,614 @@ void CppParser::internalParse(const QString &fileName)
     internalClear();
 }
 
+QStringList CppParser::findLeadingSystemHeaders(const QString &fileName, QStringList &includeLines) const
+{
+    //system headers included before any other code (so they are not affected by the file's own macros)
+    QStringList headers;
+    QStringList buffer = mPreprocessor.loadFile(fileName);
+    foreach (const QString& rawLine, buffer) {
+        QString line = rawLine.trimmed();
+        if (line.isEmpty())
+            continue;
+        if (!line.startsWith('#'))
+            break;
+        QString s = line.mid(1).trimmed();
+        if (s.startsWith("pragma"))
+            continue;
+        if (!s.startsWith("include") || s.startsWith("include_next"))
+            break;
+        constexpr int INCLUDE_LEN = 7; // length of include
+        QString name = s.mid(INCLUDE_LEN).trimmed();
+        if (!name.startsWith('<'))
+            break;
+        QString header = ::getHeaderFilename(fileName, name,
+                                             mPreprocessor.includePathList(),
+                                             mPreprocessor.projectIncludePathList());
+        if (header.isEmpty() || mPreprocessor.fileScanned(header))
+            break;
+        includeLines.append(name);
+        headers.append(header);
+    }
+    return headers;
+}
+
+QString CppParser::calcSymbolCacheKey(const QStringList &includeLines) const
+{
+    static const QByteArray lineBreak("\n");
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray::number(SymbolCacheVersion));
+    hash.addData(QByteArray::number((int)mLanguage));
+    foreach (const QString& path, mPreprocessor.includePathList()) {
+        hash.addData(path.toUtf8());
+        hash.addData(lineBreak);
+    }
+    foreach (const QString& path, mPreprocessor.projectIncludePathList()) {
+        hash.addData(path.toUtf8());
+        hash.addData(lineBreak);
+    }
+    QStringList defines;
+    foreach (const PDefine& define, mPreprocessor.hardDefines()) {
+        defines.append(define->name+define->args+" "+define->value);
+    }
+    defines.sort();
+    foreach (const QString& define, defines) {
+        hash.addData(define.toUtf8());
+        hash.addData(lineBreak);
+    }
+    foreach (const QString& line, includeLines) {
+        hash.addData(line.toUtf8());
+        hash.addData(lineBreak);
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+bool CppParser::loadSymbolCache(const QString &key, const QStringList &headers)
+{
+    QFile file(includeTrailingPathDelimiter(mSymbolCacheDir)+key+".symbols");
+    if (!file.open(QFile::ReadOnly))
+        return false;
+    uchar* data = file.map(0, file.size());
+    if (!data)
+        return false;
+    auto action = finally([&file,data]{
+        file.unmap(data);
+    });
+    QByteArray buffer = QByteArray::fromRawData((const char*)data, file.size());
+    QDataStream in(buffer);
+    in.setVersion(QDataStream::Qt_5_12);
+
+    quint32 magic;
+    quint32 version;
+    QString savedKey;
+    in>>magic>>version>>savedKey;
+    if (magic!=SymbolCacheMagic || version!=SymbolCacheVersion || savedKey!=key)
+        return false;
+    qint32 uniqId;
+    in>>uniqId;
+
+    //files, check if they are modified
+    qint32 fileCount;
+    in>>fileCount;
+    if (in.status()!=QDataStream::Ok || fileCount<=0)
+        return false;
+    QStringList files;
+    for (int i=0;i<fileCount;i++) {
+        QString fileName;
+        qint64 size;
+        qint64 lastModified;
+        in>>fileName>>size>>lastModified;
+        if (in.status()!=QDataStream::Ok)
+            return false;
+        QFileInfo info(fileName);
+        if (!info.exists() || info.size()!=size
+                || info.lastModified().toMSecsSinceEpoch()!=lastModified)
+            return false;
+        if (mPreprocessor.fileScanned(fileName))
+            return false;
+        files.append(fileName);
+    }
+    foreach (const QString& header, headers) {
+        if (!files.contains(header))
+            return false;
+    }
+
+    //statements, parents are always saved before their children
+    qint32 statementCount;
+    in>>statementCount;
+    if (in.status()!=QDataStream::Ok || statementCount<0)
+        return false;
+    QVector<PStatement> statements;
+    statements.reserve(statementCount);
+    for (int i=0;i<statementCount;i++) {
+        PStatement statement = std::make_shared<Statement>();
+        qint32 parentIndex, kind, scope, accessibility, line, fileIndex,
+                definitionLine, definitionFileIndex, properties;
+        in>>parentIndex>>statement->type>>statement->command>>statement->args
+          >>statement->value>>statement->templateSpecializationParams
+          >>kind>>scope>>accessibility>>line>>fileIndex
+          >>definitionLine>>definitionFileIndex
+          >>statement->friends>>statement->fullName>>statement->usingList
+          >>statement->noNameArgs>>statement->lambdaCaptures>>properties;
+        if (in.status()!=QDataStream::Ok
+                || parentIndex<-1 || parentIndex>=i
+                || fileIndex<0 || fileIndex>=fileCount
+                || definitionFileIndex<0 || definitionFileIndex>=fileCount)
+            return false;
+        //enums are cast from the file, so a corrupted value would be out of their ranges
+        if (kind<(int)StatementKind::Unknown || kind>(int)StatementKind::Alias
+                || scope<(int)StatementScope::Global || scope>(int)StatementScope::ClassLocal
+                || accessibility<(int)StatementAccessibility::None
+                || accessibility>(int)StatementAccessibility::Public
+                || (properties & ~((int)StatementProperty::DummyStatement*2-1))!=0)
+            return false;
+        if (parentIndex>=0)
+            statement->parentScope = statements[parentIndex];
+        statement->kind = (StatementKind)kind;
+        statement->scope = (StatementScope)scope;
+        statement->accessibility = (StatementAccessibility)accessibility;
+        statement->line = line;
+        statement->fileName = files[fileIndex];
+        statement->definitionLine = definitionLine;
+        statement->definitionFileName = files[definitionFileIndex];
+        statement->properties = StatementProperties(properties);
+        statement->usageCount = -1;
+        statements.append(statement);
+    }
+
+    //class inheritances
+    qint32 inheritanceCount;
+    in>>inheritanceCount;
+    if (in.status()!=QDataStream::Ok || inheritanceCount<0)
+        return false;
+    QList<PClassInheritanceInfo> inheritances;
+    for (int i=0;i<inheritanceCount;i++) {
+        PClassInheritanceInfo info = std::make_shared<ClassInheritanceInfo>();
+        qint32 derivedIndex, fileIndex, visibility;
+        in>>derivedIndex>>fileIndex>>info->parentClassName>>info->isGlobal
+          >>info->isStruct>>visibility>>info->handled;
+        if (in.status()!=QDataStream::Ok
+                || derivedIndex<0 || derivedIndex>=statementCount
+                || fileIndex<0 || fileIndex>=fileCount
+                || visibility<(int)StatementAccessibility::None
+                || visibility>(int)StatementAccessibility::Public)
+            return false;
+        info->derivedClass = statements[derivedIndex];
+        info->file = files[fileIndex];
+        info->visibility = (StatementAccessibility)visibility;
+        inheritances.append(info);
+    }
+
+    //file infos
+    QList<PParsedFileInfo> fileInfos;
+    foreach (const QString& fileName, files) {
+        bool hasFileInfo;
+        in>>hasFileInfo;
+        if (in.status()!=QDataStream::Ok)
+            return false;
+        if (!hasFileInfo)
+            continue;
+        PParsedFileInfo fileInfo = std::make_shared<ParsedFileInfo>(fileName);
+        QSet<QString> includes;
+        QStringList directIncludes;
+        QSet<QString> usings;
+        QMap<int,bool> branches;
+        QList<qint32> statementIndice;
+        QList<qint32> scopeLines;
+        QList<qint32> scopeIndice;
+        QList<qint32> inheritanceIndice;
+        in>>includes>>directIncludes>>usings>>branches>>statementIndice
+          >>scopeLines>>scopeIndice>>inheritanceIndice;
+        if (in.status()!=QDataStream::Ok || scopeLines.count()!=scopeIndice.count())
+            return false;
+        foreach (const QString& include, includes)
+            fileInfo->addInclude(include);
+        foreach (const QString& include, directIncludes)
+            fileInfo->addDirectInclude(include);
+        foreach (const QString& usingName, usings)
+            fileInfo->addUsing(usingName);
+        for (auto it=branches.begin();it!=branches.end();++it)
+            fileInfo->insertBranch(it.key(),it.value());
+        foreach (qint32 index, statementIndice) {
+            if (index<0 || index>=statementCount)
+                return false;
+            fileInfo->addStatement(statements[index]);
+        }
+        for (int i=0;i<scopeLines.count();i++) {
+            qint32 index = scopeIndice[i];
+            if (index>=statementCount)
+                return false;
+            fileInfo->addScope(scopeLines[i], index>=0?statements[index]:PStatement());
+        }
+        foreach (qint32 index, inheritanceIndice) {
+            if (index<0 || index>=inheritanceCount)
+                return false;
+            fileInfo->addHandledInheritances(inheritances[index]);
+        }
+        fileInfos.append(fileInfo);
+    }
+
+    QSet<QString> inlineNamespaces;
+    in>>inlineNamespaces;
+    if (in.status()!=QDataStream::Ok)
+        return false;
+    if (!mPreprocessor.loadFileDefines(in, files))
+        return false;
+
+    //everything is read, add them to the parser
+    foreach (const PStatement& statement, statements) {
+        mStatementList.add(statement);
+        if (statement->kind == StatementKind::Namespace) {
+            PStatementList namespaceList = doFindNamespace(statement->fullName);
+            if (!namespaceList) {
+                namespaceList=std::make_shared<StatementList>();
+                mNamespaces.insert(statement->fullName,namespaceList);
+            }
+            namespaceList->append(statement);
+        }
+    }
+    foreach (const PParsedFileInfo& fileInfo, fileInfos) {
+        mPreprocessor.addScannedFile(fileInfo);
+    }
+    mClassInheritances.append(inheritances);
+    mInlineNamespaces.unite(inlineNamespaces);
+    reserveUniqIds(uniqId);
+    return true;
+}
+
+void CppParser::saveSymbolCache(const QString &key, const QStringList &headers)
+{
+    //the headers and all files included by them
+    QSet<QString> fileSet;
+    foreach (const QString& header, headers) {
+        PParsedFileInfo fileInfo = mPreprocessor.findFileInfo(header);
+        if (!fileInfo)
+            return;
+        fileSet.insert(header);
+        fileSet.unite(fileInfo->includes());
+    }
+    QStringList files = fileSet.values();
+    QHash<QString,int> fileIndice;
+    for (int i=0;i<files.count();i++)
+        fileIndice.insert(files[i],i);
+
+    //statements declared in the files, parents before children,
+    //and children in the order they are added
+    QVector<PStatement> statements;
+    QHash<Statement*,int> statementIndice;
+    QQueue<PStatement> queue;
+    queue.enqueue(PStatement());
+    while (!queue.isEmpty()) {
+        PStatement parent = queue.dequeue();
+        foreach (const PStatement& statement, childrenInAddedOrder(mStatementList.childrenStatements(parent))) {
+            if (!fileIndice.contains(statement->fileName))
+                continue;
+            statementIndice.insert(statement.get(),statements.count());
+            statements.append(statement);
+            if (!statement->children.isEmpty())
+                queue.enqueue(statement);
+        }
+    }
+
+    QDir dir(mSymbolCacheDir);
+    if (!dir.exists() && !dir.mkpath(mSymbolCacheDir))
+        return;
+    QSaveFile file(includeTrailingPathDelimiter(mSymbolCacheDir)+key+".symbols");
+    if (!file.open(QFile::WriteOnly))
+        return;
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_12);
+    out<<SymbolCacheMagic<<SymbolCacheVersion<<key;
+    out<<(qint32)mUniqId;
+
+    out<<(qint32)files.count();
+    foreach (const QString& fileName, files) {
+        QFileInfo info(fileName);
+        out<<fileName<<(qint64)info.size()<<(qint64)info.lastModified().toMSecsSinceEpoch();
+    }
+
+    out<<(qint32)statements.count();
+    foreach (const PStatement& statement, statements) {
+        PStatement parent = statement->parentScope.lock();
+        qint32 parentIndex = parent?statementIndice.value(parent.get(),-1):-1;
+        qint32 fileIndex = fileIndice.value(statement->fileName);
+        // definitions in other files (like the file including the headers) are not cached
+        bool definitionCached = fileIndice.contains(statement->definitionFileName);
+        StatementProperties properties = statement->properties;
+        if (!definitionCached)
+            properties.setFlag(StatementProperty::HasDefinition,false);
+        out<<parentIndex<<statement->type<<statement->command<<statement->args
+          <<statement->value<<statement->templateSpecializationParams
+          <<(qint32)statement->kind<<(qint32)statement->scope
+          <<(qint32)statement->accessibility<<(qint32)statement->line<<fileIndex
+          <<(qint32)(definitionCached?statement->definitionLine:statement->line)
+          <<(qint32)(definitionCached?fileIndice.value(statement->definitionFileName):fileIndex)
+          <<statement->friends<<statement->fullName<<statement->usingList
+          <<statement->noNameArgs<<statement->lambdaCaptures<<(qint32)properties;
+    }
+
+    QList<PClassInheritanceInfo> inheritances;
+    QHash<ClassInheritanceInfo*,int> inheritanceIndice;
+    foreach (const PClassInheritanceInfo& info, mClassInheritances) {
+        PStatement derived = info->derivedClass.lock();
+        if (!derived || !statementIndice.contains(derived.get()) || !fileIndice.contains(info->file))
+            continue;
+        inheritanceIndice.insert(info.get(),inheritances.count());
+        inheritances.append(info);
+    }
+    out<<(qint32)inheritances.count();
+    foreach (const PClassInheritanceInfo& info, inheritances) {
+        out<<(qint32)statementIndice.value(info->derivedClass.lock().get())
+          <<(qint32)fileIndice.value(info->file)<<info->parentClassName
+          <<info->isGlobal<<info->isStruct<<(qint32)info->visibility<<info->handled;
+    }
+
+    foreach (const QString& fileName, files) {
+        PParsedFileInfo fileInfo = mPreprocessor.findFileInfo(fileName);
+        out<<(fileInfo!=nullptr);
+        if (!fileInfo)
+            continue;
+        QList<qint32> fileStatementIndice;
+        foreach (const PStatement& statement, fileInfo->statements()) {
+            qint32 index = statementIndice.value(statement.get(),-1);
+            if (index>=0)
+                fileStatementIndice.append(index);
+        }
+        QList<qint32> scopeLines;
+        QList<qint32> scopeIndice;
+        foreach (const PCppScope& scope, fileInfo->scopes()) {
+            scopeLines.append(scope->startLine);
+            scopeIndice.append(scope->statement?statementIndice.value(scope->statement.get(),-1):-1);
+        }
+        QList<qint32> fileInheritanceIndice;
+        foreach (const std::weak_ptr<ClassInheritanceInfo>& weakInfo, fileInfo->handledInheritances()) {
+            PClassInheritanceInfo info = weakInfo.lock();
+            qint32 index = info?inheritanceIndice.value(info.get(),-1):-1;
+            if (index>=0)
+                fileInheritanceIndice.append(index);
+        }
+        out<<fileInfo->includes()<<fileInfo->directIncludes()<<fileInfo->usings()
+          <<fileInfo->branches()<<fileStatementIndice<<scopeLines<<scopeIndice
+          <<fileInheritanceIndice;
+    }
+
+    out<<mInlineNamespaces;
+    mPreprocessor.saveFileDefines(out, files);
+    if (out.status()!=QDataStream::Ok) {
+        file.cancelWriting();
+        return;
+    }
+    file.commit();
+
+    //only keep the most recently used caches
+    QFileInfoList cacheFiles = dir.entryInfoList(QStringList{"*.symbols"}, QDir::Files, QDir::Time);
+    for (int i=MaxSymbolCacheFiles;i<cacheFiles.count();i++) {
+        QFile::remove(cacheFiles[i].absoluteFilePath());
+    }
+}
+
+bool CppParser::reparseChangedFunctionBody(const QString &fileName, const QStringList &buffer)
+{
+    if (fileName!=mLastParsedFile)
+        return false;
+    PParsedFileInfo fileInfo = mPreprocessor.findFileInfo(fileName);
+    if (!fileInfo || fileInfo!=mLastParsedFileInfo.lock() || !mPreprocessor.fileScanned(fileName))
+        return false;
+
+    //find changed lines: [prefix+1, oldLastLine] in the old buffer, [prefix+1, newLastLine] in the new buffer
+    const QStringList& oldBuffer = mLastParsedBuffer;
+    int minCount = std::min(oldBuffer.count(), buffer.count());
+    int prefix = 0;
+    while (prefix<minCount && oldBuffer[prefix]==buffer[prefix])
+        prefix++;
+    int suffix = 0;
+    while (suffix<minCount-prefix
+           && oldBuffer[oldBuffer.count()-1-suffix]==buffer[buffer.count()-1-suffix])
+        suffix++;
+    int oldLastLine = oldBuffer.count()-suffix;
+    int newLastLine = buffer.count()-suffix;
+    int delta = newLastLine - oldLastLine;
+    // nothing changed: do a full reparse, since included headers may have changed
+    if (oldLastLine==prefix && newLastLine==prefix)
+        return false;
+    if (prefix==0)
+        return false;
+
+    //the function whose body contains all changes
+    //Changes in class bodies are not handled here: members are declarations that other
+    //files and the member definitions after the class are linked to, so they need a full reparse.
+    PStatement function = fileInfo->findScopeAtLine(oldLastLine>prefix?prefix+1:prefix);
+    while (function && !isFunctionKind(function->kind))
+        function = function->parentScope.lock();
+    if (!function || function->definitionFileName!=fileName)
+        return false;
+    const QVector<PCppScope>& scopes = fileInfo->scopes();
+    int startIndex = -1;
+    for (int i=0;i<scopes.count();i++) {
+        if (scopes[i]->statement==function) {
+            startIndex = i;
+            break;
+        }
+    }
+    if (startIndex<0 || scopes[startIndex]->startLine!=function->definitionLine)
+        return false;
+    int endIndex = startIndex+1;
+    while (endIndex<scopes.count()) {
+        PStatement scope = scopes[endIndex]->statement;
+        while (scope && scope!=function)
+            scope = scope->parentScope.lock();
+        if (!scope)
+            break;
+        endIndex++;
+    }
+    if (endIndex>=scopes.count())
+        return false;
+    int startLine = function->definitionLine;
+    int endLine = scopes[endIndex]->startLine; // line of the closing '}'
+    if (prefix<startLine || oldLastLine>=endLine)
+        return false;
+    int newEndLine = endLine+delta;
+
+    //preprocessor directives may change everything after it
+    for (int i=prefix;i<oldLastLine;i++) {
+        if (oldBuffer[i].trimmed().startsWith('#'))
+            return false;
+    }
+    for (int i=startLine-1;i<newEndLine;i++) {
+        if (buffer[i].trimmed().startsWith('#'))
+            return false;
+    }
+
+    //tokenize the function (lines not in it are kept empty, so token lines are correct)
+    QStringList bodyBuffer = mPreprocessor.expandMacrosInLines(
+                fileName, buffer.mid(startLine-1, newEndLine-startLine+1));
+    QStringList tokenBuffer;
+    tokenBuffer.reserve(newEndLine+1);
+    for (int i=1;i<startLine;i++)
+        tokenBuffer.append(QString());
+    tokenBuffer.append(bodyBuffer);
+    tokenBuffer.append(";"); // braces not matched are closed after this line
+    mTokenizer.tokenize(tokenBuffer);
+    int bodyStart = findFunctionBodyStart(prefix, newEndLine);
+    if (bodyStart<0) {
+        mTokenizer.clear();
+        return false;
+    }
+    int bodyEnd = mTokenizer[bodyStart].matchIndex;
+
+    //remove old statements in the body
+    QList<PStatement> children = function->children.values();
+    foreach (const PStatement& child, children) {
+        if (child->kind == StatementKind::Parameter
+                || child->command == "this"
+                || child->command == "__func__")
+            continue;
+        removeFunctionBodyStatement(fileInfo, child);
+    }
+    function->usingList.clear();
+
+    //move things after the changed lines
+    QVector<PCppScope> scopesAfter = scopes.mid(endIndex);
+    fileInfo->truncateScopes(startIndex+1);
+    if (delta!=0) {
+        shiftStatementLines(fileInfo, oldLastLine, delta);
+        fileInfo->shiftBranches(oldLastLine, delta);
+    }
+
+    //parse the new body
+    mCurrentFile = fileName;
+    mIsSystemHeader = isSystemHeaderFile(mCurrentFile) || isProjectHeaderFile(mCurrentFile);
+    mIsProjectFile = mProjectFiles.contains(mCurrentFile);
+    mIsHeader = isHFile(mCurrentFile);
+    mCurrentMemberAccessibility = StatementAccessibility::Public;
+    mCurrentScope.append(function);
+    mMemberAccessibilities.push_back(mCurrentMemberAccessibility);
+    mIndex = bodyStart+1;
+    while (mTokenizer.lambdasCount()>0 && mTokenizer.indexOfFirstLambda()<mIndex)
+        mTokenizer.removeFirstLambda();
+#ifdef QT_DEBUG
+    mLastIndex = -1;
+#endif
+    while (mIndex<bodyEnd) {
+        if (!handleStatement(bodyEnd))
+            break;
+    }
+    while (mCurrentScope.count()>1)
+        removeScopeLevel(mTokenizer[bodyEnd].line, bodyEnd);
+    foreach (const PCppScope& scope, scopesAfter) {
+        fileInfo->addScope(scope->startLine+delta, scope->statement);
+    }
+    handleInheritances();
+    internalClear();
+    mTokenizer.clear();
+
+    mLastParsedBuffer = buffer;
+    return true;
+}
+
+int CppParser::findFunctionBodyStart(int lastLine, int endLine) const
+{
+    //the first top level '{' before lastLine, which is matched by a '}' at endLine.
+    //It must follow the parameter list, a qualifier, a constructor initializer list
+    //or a trailing return type; any other header is left to the full reparse.
+    bool initializerList = false;
+    bool trailingReturn = false;
+    int i=0;
+    while (i<mTokenizer.tokenCount()) {
+        const CppTokenizer::Token& token = mTokenizer[i];
+        if (token.line>lastLine)
+            break;
+        if (token.text=='(' || token.text=='[') {
+            if (token.matchIndex<=i)
+                return -1;
+            i = token.matchIndex+1;
+            continue;
+        }
+        if (token.text=="->") {
+            trailingReturn = true;
+        } else if (token.text==':' && i>0 && mTokenizer[i-1].text==')') {
+            initializerList = true;
+        } else if (token.text=='{') {
+            if (token.matchIndex<=i || i==0)
+                return -1;
+            const QString& prev = mTokenizer[i-1].text;
+            bool afterHeader = (prev==')' || prev=='}' || prev=="...");
+            if (initializerList && !afterHeader) {
+                //braced member initializer, like "mValue{value}"
+                i = token.matchIndex+1;
+                continue;
+            }
+            if (mTokenizer[token.matchIndex].line!=endLine)
+                return -1;
+            if (afterHeader || trailingReturn
+                    || prev=="const" || prev=="noexcept"
+                    || prev=="override" || prev=="final" || prev=="volatile"
+                    || prev=="&" || prev=="&&")
+                return i;
+            return -1;
+        }
+        i++;
+    }
+    return -1;
+}
+
+void CppParser::removeFunctionBodyStatement(const PParsedFileInfo &fileInfo, const PStatement &statement)
+{
+    QList<PStatement> children = statement->children.values();
+    foreach (const PStatement& child, children) {
+        removeFunctionBodyStatement(fileInfo, child);
+    }
+    fileInfo->removeStatement(statement);
+    mStatementList.deleteStatement(statement);
+}
+
+void CppParser::shiftStatementLines(const PParsedFileInfo &fileInfo, int afterLine, int delta)
+{
+    QSet<Statement*> shifted;
+    foreach (const PStatement& statement, fileInfo->statements()) {
+        if (shifted.contains(statement.get()))
+            continue;
+        shifted.insert(statement.get());
+        if (statement->fileName==fileInfo->fileName() && statement->line>afterLine)
+            statement->line+=delta;
+        if (statement->definitionFileName==fileInfo->fileName() && statement->definitionLine>afterLine)
+            statement->definitionLine+=delta;
+    }
+}
+
+void CppParser::rememberParsedBuffer(const QString &fileName, const QStringList &buffer)
+{
+    PParsedFileInfo fileInfo = mPreprocessor.findFileInfo(fileName);
+    if (fileInfo) {
+        mLastParsedFile = fileName;
+        mLastParsedBuffer = buffer;
+        mLastParsedFileInfo = fileInfo;
+    } else {
+        mLastParsedFile.clear();
+        mLastParsedBuffer.clear();
+        mLastParsedFileInfo.reset();
+    }
+}
+
 void CppParser::inheritClassStatement(const PStatement& derived, bool isStruct,
                                       const PStatement& base, StatementAccessibility access)
 {
@@ -5881,12 +7297,12 @@ void CppParser::doSkipInExpression(const QStringList &expression, int &pos, cons
 
 QString CppParser::findFunctionPointerName(int startIdx)
 {
-    Q_ASSERT(mTokenizer[startIdx]->text=="(");
+    Q_ASSERT(mTokenizer[startIdx].text=="(");
     int i=startIdx+1;
-    int endIdx = mTokenizer[startIdx]->matchIndex;
+    int endIdx = mTokenizer[startIdx].matchIndex;
     while (i<endIdx) {
-        if (isIdentChar(mTokenizer[i]->text[0])) {
-            return mTokenizer[i]->text;
+        if (isIdentChar(mTokenizer[i].text[0])) {
+            return mTokenizer[i].text;
         }
         i++;
     }
@@ -6107,9 +7523,12 @@ QSet<QString> CppParser::calculateFilesToBeReparsed(const QString &fileName)
         return QSet<QString>();
     QSet<QString> result;
     result.insert(fileName);
+    int fileId = FileIdPool::find(fileName);
+    if (fileId<0)
+        return result;
     foreach (const QString& file, mPreprocessor.scannedFiles()) {
         PParsedFileInfo fileInfo = mPreprocessor.findFileInfo(file);
-        if (fileInfo && fileInfo->including(fileName)) {
+        if (fileInfo && fileInfo->including(fileId)) {
             result.insert(file);
         }
     }
@@ -6128,19 +7547,19 @@ QSet<QString> CppParser::calculateFilesToBeReparsed(const QString &fileName)
 
 void CppParser::scanMethodArgs(const PStatement& functionStatement, int argStart)
 {
-    Q_ASSERT(mTokenizer[argStart]->text=='(');
-    int argEnd=mTokenizer[argStart]->matchIndex;
+    Q_ASSERT(mTokenizer[argStart].text=='(');
+    int argEnd=mTokenizer[argStart].matchIndex;
     int paramStart = argStart+1;
     int i = paramStart ; // assume it starts with ( and ends with )
     // Keep going and stop on top of the variable name
     QStringList words;
     while (i < argEnd) {
-        if (mTokenizer[i]->text=='('
-                && mTokenizer[i]->matchIndex+1<argEnd
-                && mTokenizer[mTokenizer[i]->matchIndex+1]->text=='(') {
+        if (mTokenizer[i].text=='('
+                && mTokenizer[i].matchIndex+1<argEnd
+                && mTokenizer[mTokenizer[i].matchIndex+1].text=='(') {
             //function pointer
-            int argStart=mTokenizer[i]->matchIndex+1;
-            int argEnd=mTokenizer[argStart]->matchIndex;
+            int argStart=mTokenizer[i].matchIndex+1;
+            int argEnd=mTokenizer[argStart].matchIndex;
             QString cmd=findFunctionPointerName(i);
             QString args=mergeArgs(argStart,argEnd);
             if (!cmd.isEmpty()) {
@@ -6152,7 +7571,7 @@ void CppParser::scanMethodArgs(const PStatement& functionStatement, int argStart
                             args,
                             "",
                             "",
-                            mTokenizer[i+1]->line,
+                            mTokenizer[i+1].line,
                             StatementKind::Parameter,
                             StatementScope::Local,
                             StatementAccessibility::None,
@@ -6160,50 +7579,50 @@ void CppParser::scanMethodArgs(const PStatement& functionStatement, int argStart
             }
             i=argEnd+1;
             words.clear();
-        } else if (mTokenizer[i]->text=='{') {
-            i=mTokenizer[i]->matchIndex+1;
-        } else if (mTokenizer[i]->text.endsWith('=')) {
-            addMethodParameterStatement(words,mTokenizer[i]->line,functionStatement);
+        } else if (mTokenizer[i].text=='{') {
+            i=mTokenizer[i].matchIndex+1;
+        } else if (mTokenizer[i].text.endsWith('=')) {
+            addMethodParameterStatement(words,mTokenizer[i].line,functionStatement);
             i=skipAssignment(i,argEnd);
-        } else if (mTokenizer[i]->text=="::") {
+        } else if (mTokenizer[i].text=="::") {
             int lastIdx=words.count()-1;
             if (lastIdx>=0 && words[lastIdx]!="const") {
-                words[lastIdx]=words[lastIdx]+mTokenizer[i]->text;
+                words[lastIdx]=words[lastIdx]+mTokenizer[i].text;
             } else
-                words.append(mTokenizer[i]->text);
+                words.append(mTokenizer[i].text);
             i++;
-        } else if (mTokenizer[i]->text==',') {
-           addMethodParameterStatement(words,mTokenizer[i]->line,functionStatement);
+        } else if (mTokenizer[i].text==',') {
+           addMethodParameterStatement(words,mTokenizer[i].line,functionStatement);
            i++;
            words.clear();
-        } else if (isIdentChar(mTokenizer[i]->text[0])) {
+        } else if (isIdentChar(mTokenizer[i].text[0])) {
             // identifier
             int lastIdx=words.count()-1;
             if (lastIdx>=0 && words[lastIdx].endsWith("::")) {
-                words[lastIdx]=words[lastIdx]+mTokenizer[i]->text;
+                words[lastIdx]=words[lastIdx]+mTokenizer[i].text;
             } else
-                words.append(mTokenizer[i]->text);
+                words.append(mTokenizer[i].text);
             i++;
-        } else if (isWordChar(mTokenizer[i]->text[0])) {
+        } else if (isWordChar(mTokenizer[i].text[0])) {
             // * &
-            words.append(mTokenizer[i]->text);
+            words.append(mTokenizer[i].text);
             i++;
-        } else if (mTokenizer[i]->text.startsWith("[")) {
+        } else if (mTokenizer[i].text.startsWith("[")) {
             if (!words.isEmpty()) {
                 int lastIdx=words.count()-1;
-                words[lastIdx]=words[lastIdx]+mTokenizer[i]->text;
+                words[lastIdx]=words[lastIdx]+mTokenizer[i].text;
             }
             i++;
         } else {
             i++;
         }
     }
-    addMethodParameterStatement(words,mTokenizer[i-1]->line,functionStatement);
+    addMethodParameterStatement(words,mTokenizer[i-1].line,functionStatement);
 }
 
 QSet<QString> CppParser::parseLambdaCaptures(int index)
 {
-    QString s = mTokenizer[index]->text;
+    QString s = mTokenizer[index].text;
     QString word;
     QSet<QString> result;
     //skip '[' ']'
@@ -6356,8 +7775,8 @@ bool CppParser::splitLastMember(const QString &token, QString &lastMember, QStri
 
 bool CppParser::isNotFuncArgs(int startIndex)
 {
-    Q_ASSERT(mTokenizer[startIndex]->text=='(');
-    int endIndex=mTokenizer[startIndex]->matchIndex;
+    Q_ASSERT(mTokenizer[startIndex].text=='(');
+    int endIndex=mTokenizer[startIndex].matchIndex;
     //no args, it must be a function
     if (endIndex-startIndex==1)
         return false;
@@ -6365,7 +7784,7 @@ bool CppParser::isNotFuncArgs(int startIndex)
     int endPos = endIndex;
     QString word = "";
     while (i<endPos) {
-        QChar ch=mTokenizer[i]->text[0];
+        QChar ch=mTokenizer[i].text[0];
         switch(ch.unicode()) {
         // args contains a string/char, can't be a func define
         case '"':
@@ -6378,20 +7797,20 @@ bool CppParser::isNotFuncArgs(int startIndex)
         case '{':
             return true;
         case '[': // function args like int f[10]
-            i=mTokenizer[i]->matchIndex+1;
+            i=mTokenizer[i].matchIndex+1;
             if (i<endPos &&
-                    (mTokenizer[i]->text=='('
-                     || mTokenizer[i]->text=='{')) //lambda
+                    (mTokenizer[i].text=='('
+                     || mTokenizer[i].text=='{')) //lambda
                 return true;
             continue;
         }
         if (isDigitChar(ch))
             return true;
         if (isIdentChar(ch)) {
-            QString currentText=mTokenizer[i]->text;
-//            if (mTokenizer[i]->text.endsWith('.'))
+            QString currentText=mTokenizer[i].text;
+//            if (mTokenizer[i].text.endsWith('.'))
 //                return true;
-//            if (mTokenizer[i]->text.endsWith("->"))
+//            if (mTokenizer[i].text.endsWith("->"))
 //                return true;
             if (!mCppTypeKeywords.contains(currentText)) {
                 if (currentText=="true" || currentText=="false" || currentText=="nullptr" ||
@@ -6448,17 +7867,63 @@ bool CppParser::isTypeStatement(StatementKind kind) const
 
 void CppParser::updateSerialId()
 {
+    mSerialCount++;
     mSerialId = QString("%1 %2").arg(mParserId).arg(mSerialCount);
+    clearLookupMemo();
+}
+
+QString CppParser::lookupMemoKey(QChar kind, const QString &fileName, const QString &phrase, const PStatement &scope)
+{
+    QString key;
+    key.reserve(fileName.length()+phrase.length()+24);
+    key += kind;
+    key += fileName;
+    key += '\n';
+    key += phrase;
+    key += '\n';
+    key += QString::number((quintptr)scope.get(), 16);
+    return key;
+}
+
+bool CppParser::findInLookupMemo(const QString &key, const PStatement &scope, PStatement &statement) const
+{
+    QMutexLocker locker(&mLookupMemoMutex);
+    auto it = mLookupMemo.constFind(key);
+    if (it==mLookupMemo.constEnd())
+        return false;
+    // the key has the address of the scope, which may be reused by a new statement
+    if (it.value().scope.lock()!=scope)
+        return false;
+    statement = it.value().statement;
+    return true;
+}
+
+void CppParser::addToLookupMemo(const QString &key, const PStatement &scope, const PStatement &statement) const
+{
+    QMutexLocker locker(&mLookupMemoMutex);
+    if (mLookupMemo.count()>=MaxLookupMemoSize)
+        mLookupMemo.clear();
+    LookupMemoEntry entry;
+    entry.scope = scope;
+    entry.statement = statement;
+    mLookupMemo.insert(key, entry);
+}
+
+void CppParser::clearLookupMemo()
+{
+    QMutexLocker locker(&mLookupMemoMutex);
+    mLookupMemo.clear();
+    mFileUsingsMemo.clear();
 }
 
 int CppParser::indexOfNextSemicolon(int index, int maxIndex)
 {
     while (index<maxIndex) {
-        switch(mTokenizer[index]->text[0].unicode()) {
+        switch(mTokenizer[index].text[0].unicode()) {
         case ';':
             return index;
         case '(':
-            index = mTokenizer[index]->matchIndex+1;
+            index = mTokenizer[index].matchIndex+1;
             break;
         default:
             index++;
@@ -6470,14 +7935,14 @@ int CppParser::indexOfNextSemicolon(int index, int maxIndex)
 int CppParser::indexOfNextPeriodOrSemicolon(int index, int maxIndex)
 {
     while (index<maxIndex) {
-        switch(mTokenizer[index]->text[0].unicode()) {
+        switch(mTokenizer[index].text[0].unicode()) {
         case ';':
         case ',':
         case '}':
         case ')':
             return index;
         case '(':
-            index = mTokenizer[index]->matchIndex+1;
+            index = mTokenizer[index].matchIndex+1;
             break;
         default:
             index++;
@@ -6489,12 +7954,12 @@ int CppParser::indexOfNextPeriodOrSemicolon(int index, int maxIndex)
 int CppParser::indexOfNextSemicolonOrLeftBrace(int index, int maxIndex)
 {
     while (index<maxIndex) {
-        switch(mTokenizer[index]->text[0].unicode()) {
+        switch(mTokenizer[index].text[0].unicode()) {
         case ';':
         case '{':
             return index;
         case '(':
-            index = mTokenizer[index]->matchIndex+1;
+            index = mTokenizer[index].matchIndex+1;
             break;
         default:
             index++;
@@ -6506,7 +7971,7 @@ int CppParser::indexOfNextSemicolonOrLeftBrace(int index, int maxIndex)
 int CppParser::indexOfNextColon(int index, int maxIndex)
 {
     while (index<maxIndex) {
-        QString s =mTokenizer[index]->text;
+        QString s =mTokenizer[index].text;
         switch(s[0].unicode()) {
         case ':':
             if (s.length()==1)
@@ -6515,7 +7980,7 @@ int CppParser::indexOfNextColon(int index, int maxIndex)
                 index++;
             break;
         case '(':
-            index = mTokenizer[index]->matchIndex+1;
+            index = mTokenizer[index].matchIndex+1;
             break;
         default:
             index++;
@@ -6527,11 +7992,11 @@ int CppParser::indexOfNextColon(int index, int maxIndex)
 int CppParser::indexOfNextLeftBrace(int index, int maxIndex)
 {
     while (index<maxIndex) {
-        switch(mTokenizer[index]->text[0].unicode()) {
+        switch(mTokenizer[index].text[0].unicode()) {
         case '{':
             return index;
         case '(':
-            index = mTokenizer[index]->matchIndex+1;
+            index = mTokenizer[index].matchIndex+1;
             break;
         default:
             index++;
@@ -6543,8 +8008,8 @@ int CppParser::indexOfNextLeftBrace(int index, int maxIndex)
 int CppParser::indexPassParenthesis(int index, int maxIndex)
 {
     while (index<maxIndex) {
-        if (mTokenizer[index]->text=='(') {
-            return mTokenizer[index]->matchIndex+1;
+        if (mTokenizer[index].text=='(') {
+            return mTokenizer[index].matchIndex+1;
         }
         index++;
     }
@@ -6554,12 +8019,12 @@ int CppParser::indexPassParenthesis(int index, int maxIndex)
 int CppParser::indexOfNextRightParenthesis(int index, int maxIndex)
 {
     while (index<maxIndex) {
-        QString s =mTokenizer[index]->text;
+        QString s =mTokenizer[index].text;
         switch(s[0].unicode()) {
         case ')':
             return index;
         case '(':
-            index = mTokenizer[index]->matchIndex+1;
+            index = mTokenizer[index].matchIndex+1;
             break;
         default:
             index++;
@@ -6572,15 +8037,15 @@ void CppParser::skipNextSemicolon(int index, int endIndex)
 {
     mIndex=index;
     while (mIndex<endIndex) {
-        switch(mTokenizer[mIndex]->text[0].unicode()) {
+        switch(mTokenizer[mIndex].text[0].unicode()) {
         case ';':
             mIndex++;
             return;
         case '{':
-            mIndex = mTokenizer[mIndex]->matchIndex+1;
+            mIndex = mTokenizer[mIndex].matchIndex+1;
             break;
         case '(':
-            mIndex = mTokenizer[mIndex]->matchIndex+1;
+            mIndex = mTokenizer[mIndex].matchIndex+1;
             break;
         default:
             mIndex++;
@@ -6600,7 +8065,7 @@ int CppParser::moveToEndOfStatement(int index, bool checkLambda, int maxIndex)
         index++;
         bool stop = false;
         while (index<maxIndex && !stop) {
-            switch(mTokenizer[index]->text[0].unicode()) {
+            switch(mTokenizer[index].text[0].unicode()) {
             case ';':
                 stop=true;
                 break;
@@ -6613,17 +8078,17 @@ int CppParser::moveToEndOfStatement(int index, bool checkLambda, int maxIndex)
                 break;
             case '{':
                 //move to '}'
-                index=mTokenizer[index]->matchIndex;
+                index=mTokenizer[index].matchIndex;
                 stop=true;
                 break;
             case '(':
-                index = mTokenizer[index]->matchIndex+1;
+                index = mTokenizer[index].matchIndex+1;
                 break;
             default:
                 index++;
             }
         }
-    } while (index<maxIndex && mTokenizer[index]->text=='=');
+    } while (index<maxIndex && mTokenizer[index].text=='=');
     if (index<maxIndex && checkLambda) {
         while (mTokenizer.lambdasCount()>0 && mTokenizer.indexOfFirstLambda()<index) {
             int i=mTokenizer.indexOfFirstLambda();
@@ -6642,8 +8107,8 @@ void CppParser::skipParenthesis(int index, int maxIndex)
 {
     mIndex=index;
     while (mIndex<maxIndex) {
-        if (mTokenizer[mIndex]->text=='(') {
-            mIndex=mTokenizer[mIndex]->matchIndex+1;
+        if (mTokenizer[mIndex].text=='(') {
+            mIndex=mTokenizer[mIndex].matchIndex+1;
             return;
         }
         mIndex++;
@@ -6655,7 +8120,7 @@ int CppParser::skipAssignment(int index, int maxIndex)
     int startIndex=index;
     bool stop=false;
     while (index<maxIndex && !stop) {
-        switch(mTokenizer[index]->text[0].unicode()) {
+        switch(mTokenizer[index].text[0].unicode()) {
         case ';':
         case ',':
         case '}':
@@ -6664,7 +8129,7 @@ int CppParser::skipAssignment(int index, int maxIndex)
             break;
         case '{':
         case '(':
-            index = mTokenizer[index]->matchIndex+1;
+            index = mTokenizer[index].matchIndex+1;
             break;
         default:
             index++;
@@ -6688,7 +8153,7 @@ QString CppParser::mergeArgs(int startIndex, int endIndex)
     for (int i=startIndex;i<=endIndex;i++) {
         if (i>startIndex)
             result+=' ';
-        result+=mTokenizer[i]->text;
+        result+=mTokenizer[i].text;
     }
     return result;
 }
@@ -6717,8 +8182,7 @@ void CppParser::parseCommandTypeAndArgs(QString &command, QString &typeSuffix, Q
 
 QString CppParser::expandMacro(const QString &text) const
 {
-    QSet<QString> usedMacros;
-    return mPreprocessor.expandMacros(text, usedMacros);
+    return mPreprocessor.expandMacros(text);
 }
 
 QStringList CppParser::splitExpression(const QString &expr)
@@ -6755,7 +8219,9 @@ const QSet<QString> &CppParser::projectFiles() const
 
 QList<QString> CppParser::namespaces()
 {
-    QMutexLocker locker(&mMutex);
+    QueryLocker locker(this);
+    if (mParsing)
+        return QList<QString>();
     return mNamespaces.keys();
 }
 
@@ -6806,6 +8272,26 @@ const QSet<QString> &CppParser::projectIncludePaths()
     return mPreprocessor.projectIncludePaths();
 }
 
+bool CppParser::parallelParsing() const
+{
+    return mParallelParsing;
+}
+
+void CppParser::setParallelParsing(bool newParallelParsing)
+{
+    mParallelParsing = newParallelParsing;
+}
+
+const QString &CppParser::symbolCacheDir() const
+{
+    return mSymbolCacheDir;
+}
+
+void CppParser::setSymbolCacheDir(const QString &newSymbolCacheDir)
+{
+    mSymbolCacheDir = newSymbolCacheDir;
+}
+
 bool CppParser::parseLocalHeaders() const
 {
     return mParseLocalHeaders;
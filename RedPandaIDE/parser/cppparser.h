@@ -19,15 +19,20 @@
 
 #include <QMutex>
 #include <QObject>
+#include <QReadWriteLock>
 #include <QThread>
 #include <QVector>
 #include "statementmodel.h"
 #include "cpptokenizer.h"
 #include "cpppreprocessor.h"
 
+struct CppFileShard;
+struct CppParallelParse;
+
 class CppParser : public QObject
 {
     Q_OBJECT
+    friend class CppFileShardParser;
 
 public:
 
@@ -40,6 +45,7 @@ public:
     };
 
     using PParseFileCommand = std::unique_ptr<ParseFileCommand>;
+
     explicit CppParser(QObject *parent = nullptr);
     CppParser(const CppParser&)=delete;
     CppParser& operator=(const CppParser)=delete;
@@ -151,6 +157,12 @@ public:
     bool parseGlobalHeaders() const;
     void setParseGlobalHeaders(bool newParseGlobalHeaders);
 
+    bool parallelParsing() const;
+    void setParallelParsing(bool newParallelParsing);
+
+    const QString &symbolCacheDir() const;
+    void setSymbolCacheDir(const QString &newSymbolCacheDir);
+
     const QSet<QString>& includePaths();
     const QSet<QString>& projectIncludePaths();
 
@@ -168,7 +180,39 @@ signals:
     void onBusy();
     void onStartParsing();
     void onEndParsing(int total, int updateView);
+private slots:
+    void watchHeaderSearchDirs();
 private:
+    /**
+     * @brief Read lock for queries. Queries run concurrently with each other,
+     * only statements changes (parse start/end, options changes) are exclusive.
+     * It's a no-op if the thread already holds the parser's lock.
+     */
+    class QueryLocker {
+    public:
+        explicit QueryLocker(const CppParser* parser);
+        QueryLocker(const QueryLocker&)=delete;
+        QueryLocker& operator=(const QueryLocker&)=delete;
+        ~QueryLocker();
+    private:
+        const CppParser* mParser;
+    };
+
+    /**
+     * @brief Write lock for statements changes.
+     * It's reentrant, and signals emitted while it's held may call queries directly.
+     * It must not be taken inside a query: a read lock can't be upgraded.
+     */
+    class WriteLocker {
+    public:
+        explicit WriteLocker(const CppParser* parser);
+        WriteLocker(const WriteLocker&)=delete;
+        WriteLocker& operator=(const WriteLocker&)=delete;
+        ~WriteLocker();
+    private:
+        const CppParser* mParser;
+    };
+
     PStatement addInheritedStatement(
             const PStatement& derived,
             const PStatement& inherit,
@@ -221,12 +265,28 @@ private:
     void removeScopeLevel(int line, int maxIndex); // removes level
 
     int indexOfMatchingBrace(int startAt) const {
-        return mTokenizer[startAt]->matchIndex;
+        return mTokenizer[startAt].matchIndex;
     }
 
     void internalClear();
 
-    QStringList sortFilesByIncludeRelations(const QSet<QString> &files);
+    // includesMap is set to the local files included by each file
+    QStringList sortFilesByIncludeRelations(const QSet<QString> &files,
+                                            QHash<QString,QSet<QString>> &includesMap);
+    QHash<QString,QSet<QString>> scanIncludeRelationsInParallel(const QSet<QString> &files);
+
+    void copyOptionsFrom(const CppParser& other);
+    // copy statements and parsed files of the other parser, which is not changed meanwhile
+    void seedFrom(const CppParser& other);
+    // parse files sorted by include relations
+    void parseFiles(const QStringList& files, const QHash<QString,QSet<QString>> &includesMap);
+    void parseFilesInParallel(const QStringList& files, const QHash<QString,QSet<QString>> &includesMap);
+    // called in the worker threads, parse the file and copy statements of the new files into the shard
+    void parseFileShard(CppFileShard& shard, int index, CppParallelParse& state);
+    void buildFileShard(CppFileShard& shard) const;
+    // add statements of the shard, false if any statement it refers to is not found
+    bool mergeFileShard(const CppFileShard& shard);
+    void reserveUniqIds(int usedId);
 
     int evaluateConstExpr(int endIndex, bool &ok);
     int evaluateAdditionConstExpr(int endIndex, bool &ok);
@@ -249,11 +309,13 @@ private:
     void checkAndHandleMethodOrVar(KeywordType keywordType, int maxIndex);
 
     QSet<QString> internalGetFileUsings(const QString& filename) const;
+    QSet<QString> lookupFileUsings(const QString& filename) const;
 
     PStatement doFindScopeStatement(const QString& filename, int line) const;
 
     PStatementList doFindNamespace(const QString& name) const; // return a list of PSTATEMENTS (of the namespace)
     PStatement doFindStatement(const QString& fullname) const;
+    PStatement lookupStatement(const QString& fullname) const;
     PStatement doFindStatementOf(const QString& fileName,
                                const QString& phrase,
                                int line) const;
@@ -280,6 +342,9 @@ private:
     PStatement doFindTypeDefinitionOf(const QString& fileName,
                                     const QString& aType,
                                     const PStatement& currentClass) const;
+    PStatement lookupTypeDefinitionOf(const QString& fileName,
+                                    const QString& aType,
+                                    const PStatement& currentClass) const;
     QString doFindFirstTemplateParamOf(const QString& fileName,
                                      const QString& phrase,
                                      const PStatement& currentScope) const;
@@ -317,6 +382,16 @@ private:
     PStatement findStatementStartingFrom(const QString& fileName,
                                          const QString& phrase,
                                          const PStatement& startScope) const;
+    PStatement lookupStatementStartingFrom(const QString& fileName,
+                                         const QString& phrase,
+                                         const PStatement& startScope) const;
+
+    // lookups are memoized until statements are changed (the serial id is updated)
+    static QString lookupMemoKey(QChar kind, const QString& fileName,
+                                 const QString& phrase, const PStatement& scope);
+    bool findInLookupMemo(const QString& key, const PStatement& scope, PStatement& statement) const;
+    void addToLookupMemo(const QString& key, const PStatement& scope, const PStatement& statement) const;
+    void clearLookupMemo();
 
     /**
      * @brief evaluate the expression (starting from pos) in the scope
@@ -540,6 +615,15 @@ private:
     void handleInheritances();
     void skipRequires(int maxIndex);
     void internalParse(const QString& fileName);
+    QStringList findLeadingSystemHeaders(const QString& fileName, QStringList& includeLines) const;
+    QString calcSymbolCacheKey(const QStringList& includeLines) const;
+    bool loadSymbolCache(const QString& key, const QStringList& headers);
+    void saveSymbolCache(const QString& key, const QStringList& headers);
+    bool reparseChangedFunctionBody(const QString& fileName, const QStringList& buffer);
+    int findFunctionBodyStart(int lastLine, int endLine) const;
+    void removeFunctionBodyStatement(const PParsedFileInfo& fileInfo, const PStatement& statement);
+    void shiftStatementLines(const PParsedFileInfo& fileInfo, int afterLine, int delta);
+    void rememberParsedBuffer(const QString& fileName, const QStringList& buffer);
 //    function FindMacroDefine(const Command: AnsiString): PStatement;
     void inheritClassStatement(
             const PStatement& derived,
@@ -707,7 +791,15 @@ private:
     ParserLanguage mLanguage;
     int mSerialCount;
     QString mSerialId;
+    mutable QMutex mLookupMemoMutex; // queries run concurrently
+    struct LookupMemoEntry {
+        std::weak_ptr<Statement> scope; // a hit only if the scope is still alive
+        PStatement statement;
+    };
+    mutable QHash<QString,LookupMemoEntry> mLookupMemo;
+    mutable QHash<QString,QSet<QString>> mFileUsingsMemo;
     int mUniqId;
+    int mUniqIdStep; // parallel workers use different id sequences, so anonymous statements are not named the same
     bool mEnabled;
     int mIndex;
     bool mIsHeader;
@@ -733,6 +825,9 @@ private:
     int mFilesToScanCount; // count of files and files included in files that have to be scanned
     bool mParseLocalHeaders;
     bool mParseGlobalHeaders;
+    bool mParallelParsing; // parse files using a worker pool, and merge their statements
+    QHash<const Statement*,PStatement> mSeedOriginals; // statements copied by seedFrom -> the originals
+    QString mSymbolCacheDir; // where symbols of system headers are cached, empty to disable
     bool mIsProjectFile;
     int mLockCount; // lock(don't reparse) when we need to find statements in a batch
     bool mParsing;
@@ -742,11 +837,16 @@ private:
 #ifdef QT_DEBUG
     int mLastIndex;
 #endif
-    mutable QRecursiveMutex mMutex;
+    mutable QReadWriteLock mLock;
     QMap<QString,KeywordType> mCppKeywords;
     QSet<QString> mCppTypeKeywords;
 
     PParseFileCommand mLastParseFileCommand;
+
+    // content of the last parsed file, used to only reparse the function body changed in it
+    QString mLastParsedFile;
+    QStringList mLastParsedBuffer;
+    std::weak_ptr<ParsedFileInfo> mLastParsedFileInfo;
 };
 using PCppParser = std::shared_ptr<CppParser>;
 
@@ -16,13 +16,20 @@
  */
 #include "cpppreprocessor.h"
 
+#include <QCoreApplication>
+#include <QDataStream>
 #include <QFile>
+#include <QFileSystemWatcher>
 #include <QDebug>
 #include <QMessageBox>
 #include "../utils.h"
 
-CppPreprocessor::CppPreprocessor()
+CppPreprocessor::CppPreprocessor():
+    mParseSystem{true},
+    mParseLocal{true},
+    mCollectFileBuffers{false}
 {
+    mHeaderLookupCache = std::make_shared<HeaderLookupCache>();
 }
 
 void CppPreprocessor::clear()
@@ -48,6 +55,10 @@ void CppPreprocessor::clear()
     mProjectIncludePathList.clear();
     //{ List of current compiler set's include path}
     mIncludePaths.clear();
+    mHeaderLookupCache->clear();
+
+    mCollectedFileBuffers.clear();
+    mPreloadedFileBuffers.clear();
 }
 
 void CppPreprocessor::clearTempResults()
@@ -63,6 +74,20 @@ void CppPreprocessor::clearTempResults()
     mProcessed.clear(); // dictionary to save filename already processed
 }
 
+void CppPreprocessor::copyOptionsFrom(const CppPreprocessor &other)
+{
+    mHardDefines = other.mHardDefines;
+    mDefines = other.mHardDefines;
+    mIncludePaths = other.mIncludePaths;
+    mIncludePathList = other.mIncludePathList;
+    mProjectIncludePaths = other.mProjectIncludePaths;
+    mProjectIncludePathList = other.mProjectIncludePathList;
+    mHeaderLookupCache = other.mHeaderLookupCache;
+    mParseSystem = other.mParseSystem;
+    mParseLocal = other.mParseLocal;
+    mOnGetFileStream = other.mOnGetFileStream;
+}
+
 void CppPreprocessor::addDefineByParts(const QString &name, const QString &args, const QString &value, bool hardCoded)
 {
     // Check for duplicates
@@ -160,6 +185,101 @@ void CppPreprocessor::preprocess(const QString &fileName)
     preprocessBuffer();
 }
 
+QStringList CppPreprocessor::loadFile(const QString &fileName) const
+{
+    QStringList bufferedText;
+    if (mOnGetFileStream && mOnGetFileStream(fileName,bufferedText)) {
+        return removeComments(bufferedText);
+    }
+    return removeComments(readFileToLines(fileName));
+}
+
+static void writeDefineMap(QDataStream& out, const PDefineMap& defineMap)
+{
+    if (!defineMap) {
+        out<<(qint32)0;
+        return;
+    }
+    out<<(qint32)defineMap->count();
+    foreach (const PDefine& define, *defineMap) {
+        out<<define->name<<define->args<<define->value<<define->filename
+          <<define->hardCoded<<define->argUsed<<(qint32)define->varArgIndex
+          <<define->formatValue;
+    }
+}
+
+static PDefineMap readDefineMap(QDataStream& in)
+{
+    qint32 count;
+    in>>count;
+    if (count<=0)
+        return PDefineMap();
+    PDefineMap defineMap = std::make_shared<DefineMap>();
+    for (int i=0;i<count && in.status()==QDataStream::Ok;i++) {
+        PDefine define = std::make_shared<Define>();
+        qint32 varArgIndex;
+        in>>define->name>>define->args>>define->value>>define->filename
+          >>define->hardCoded>>define->argUsed>>varArgIndex
+          >>define->formatValue;
+        define->varArgIndex = varArgIndex;
+        defineMap->insert(define->name,define);
+    }
+    return defineMap;
+}
+
+void CppPreprocessor::rebuildValueParts(const PDefineMap &defineMap)
+{
+    // value parts are not saved in the symbol cache
+    foreach (const PDefine& define, *defineMap) {
+        if (!define->args.isEmpty()) {
+            define->argUsed.clear();
+            parseArgs(define);
+        }
+    }
+}
+
+void CppPreprocessor::saveFileDefines(QDataStream &out, const QStringList &files) const
+{
+    foreach (const QString& file, files) {
+        writeDefineMap(out, mFileDefines.value(file));
+        writeDefineMap(out, mFileUndefines.value(file));
+    }
+}
+
+bool CppPreprocessor::loadFileDefines(QDataStream &in, const QStringList &files)
+{
+    QHash<QString, PDefineMap> fileDefines;
+    QHash<QString, PDefineMap> fileUndefines;
+    foreach (const QString& file, files) {
+        PDefineMap defineMap = readDefineMap(in);
+        PDefineMap undefineMap = readDefineMap(in);
+        if (in.status()!=QDataStream::Ok)
+            return false;
+        if (defineMap) {
+            rebuildValueParts(defineMap);
+            fileDefines.insert(file,defineMap);
+        }
+        if (undefineMap) {
+            rebuildValueParts(undefineMap);
+            fileUndefines.insert(file,undefineMap);
+        }
+    }
+    for (auto it=fileDefines.begin();it!=fileDefines.end();++it)
+        mFileDefines.insert(it.key(),it.value());
+    for (auto it=fileUndefines.begin();it!=fileUndefines.end();++it)
+        mFileUndefines.insert(it.key(),it.value());
+    return true;
+}
+
+void CppPreprocessor::addScannedFile(const PParsedFileInfo &fileInfo, const PDefineMap &defines, const PDefineMap &undefines)
+{
+    addScannedFile(fileInfo);
+    if (defines)
+        mFileDefines.insert(fileInfo->fileName(),defines);
+    if (undefines)
+        mFileUndefines.insert(fileInfo->fileName(),undefines);
+}
+
 void CppPreprocessor::invalidDefinesInFile(const QString &fileName)
 {
     //remove all defines defined in this file
@@ -219,6 +339,7 @@ void CppPreprocessor::addIncludePath(const QString &fileName)
     if (!mIncludePaths.contains(fileName)) {
         mIncludePaths.insert(fileName);
         mIncludePathList.append(fileName);
+        mHeaderLookupCache->clear();
     }
 }
 
@@ -227,9 +348,100 @@ void CppPreprocessor::addProjectIncludePath(const QString &fileName)
     if (!mProjectIncludePaths.contains(fileName)) {
         mProjectIncludePaths.insert(fileName);
         mProjectIncludePathList.append(fileName);
+        mHeaderLookupCache->clear();
     }
 }
 
+namespace {
+struct HeaderLookupCaches {
+    QMutex mutex;
+    QSet<HeaderLookupCache*> caches;
+    QFileSystemWatcher* watcher{nullptr}; // shared by all parsers, to save inotify instances
+};
+}
+
+Q_GLOBAL_STATIC(HeaderLookupCaches, headerLookupCaches)
+
+HeaderLookupCache::HeaderLookupCache()
+{
+    QMutexLocker locker(&headerLookupCaches->mutex);
+    headerLookupCaches->caches.insert(this);
+}
+
+HeaderLookupCache::~HeaderLookupCache()
+{
+    if (headerLookupCaches.isDestroyed())
+        return;
+    QMutexLocker locker(&headerLookupCaches->mutex);
+    headerLookupCaches->caches.remove(this);
+}
+
+bool HeaderLookupCache::find(const QString &key, QString &fileName) const
+{
+    QMutexLocker locker(&mMutex);
+    auto it = mFileNames.constFind(key);
+    if (it == mFileNames.constEnd())
+        return false;
+    fileName = it.value();
+    return true;
+}
+
+void HeaderLookupCache::insert(const QString &key, const QString &fileName, const QStringList &searchedDirs)
+{
+    QMutexLocker locker(&mMutex);
+    mFileNames.insert(key, fileName);
+    foreach (const QString& dir, searchedDirs) {
+        if (!mSearchedDirs.contains(dir)) {
+            mSearchedDirs.insert(dir);
+            mNewSearchedDirs.append(dir);
+        }
+    }
+}
+
+void HeaderLookupCache::clear()
+{
+    QMutexLocker locker(&mMutex);
+    mFileNames.clear();
+}
+
+QStringList HeaderLookupCache::takeNewSearchedDirs()
+{
+    QMutexLocker locker(&mMutex);
+    QStringList dirs;
+    dirs.swap(mNewSearchedDirs);
+    return dirs;
+}
+
+void HeaderLookupCache::watchNewSearchedDirs()
+{
+    // only the searched dirs are watched, headers added to their sub dirs are not noticed
+    QStringList dirs;
+    foreach (const QString& dir, takeNewSearchedDirs()) {
+        if (directoryExists(dir))
+            dirs.append(dir);
+    }
+    if (dirs.isEmpty())
+        return;
+    HeaderLookupCaches *caches = headerLookupCaches;
+    if (!caches->watcher) {
+        caches->watcher = new QFileSystemWatcher(QCoreApplication::instance());
+        QObject::connect(caches->watcher, &QFileSystemWatcher::directoryChanged,
+                         [caches]() {
+            QMutexLocker locker(&caches->mutex);
+            foreach (HeaderLookupCache* cache, caches->caches)
+                cache->clear();
+        });
+    }
+    QStringList watchedDirs = caches->watcher->directories();
+    QStringList newDirs;
+    foreach (const QString& dir, dirs) {
+        if (!watchedDirs.contains(dir))
+            newDirs.append(dir);
+    }
+    if (!newDirs.isEmpty())
+        caches->watcher->addPaths(newDirs);
+}
+
 void CppPreprocessor::removeScannedFile(const QString &filename)
 {
     invalidDefinesInFile(filename);
@@ -394,14 +606,27 @@ void CppPreprocessor::handleInclude(const QString &line, bool fromNext)
     if (i>=line.length())
         return;
     QString s=line.mid(i);
-    QSet<QString> usedMacros;
-    s = expandMacros(s, usedMacros);
-
-    fileName = getHeaderFilename(
-                file->fileName,
-                s,
-                includes,
-                projectIncludes);
+    s = expandMacros(s);
+
+    // the result only depends on the current dir for "" includes and for #include_next
+    bool localInclude = !s.contains('<');
+    QString key = QString("%1|%2|%3").arg(
+                fromNext?"n":"",
+                (localInclude || fromNext)?currentDir:QString(),
+                s);
+    if (!mHeaderLookupCache->find(key, fileName)) {
+        fileName = getHeaderFilename(
+                    file->fileName,
+                    s,
+                    includes,
+                    projectIncludes);
+        QStringList searchedDirs = projectIncludes + includes;
+        if (localInclude)
+            searchedDirs.append(currentDir);
+        if (!fileName.isEmpty())
+            searchedDirs.append(includeTrailingPathDelimiter(extractFileDir(fileName)));
+        mHeaderLookupCache->insert(key, fileName, searchedDirs);
+    }
 
     if (fileName.isEmpty())
         return;
@@ -467,88 +692,189 @@ void CppPreprocessor::handleUndefine(const QString &line)
     }
 }
 
-QString CppPreprocessor::expandMacros(const QString &text, QSet<QString> usedMacros) const
+QString CppPreprocessor::expandMacros(const QString &text) const
+{
+    QString output;
+    output.reserve(text.length());
+    MacroHideSet hiddenMacros;
+    expandMacros(text, output, hiddenMacros);
+    return output;
+}
+
+void CppPreprocessor::expandMacros(const QString &text, QString &output, MacroHideSet &hiddenMacros) const
 {
-    QString word;
-    QString newLine;
     int lenLine = text.length();
     int i=0;
     while (i< lenLine) {
-        QChar ch=text[i];
-        if (isWordChar(ch)) {
-            word += ch;
-        } else {
-            if (!word.isEmpty()) {
-                expandMacro(text,newLine,word,i,usedMacros);
-            }
-            word = "";
-            if (i< lenLine) {
-                newLine += text[i];
-            }
+        if (!isWordChar(text[i])) {
+            output += text[i];
+            i++;
+            continue;
         }
-        i++;
+        int wordStart = i;
+        while (i<lenLine && isWordChar(text[i]))
+            i++;
+        expandMacro(text, output, wordStart, i, hiddenMacros);
     }
-    if (!word.isEmpty()) {
-        expandMacro(text,newLine,word,i, usedMacros);
+}
+
+QStringList CppPreprocessor::expandMacrosInLines(const QString &fileName, const QStringList &lines)
+{
+    DefineMap oldDefines = mDefines;
+    clearTempResults();
+    auto action = finally([this,&oldDefines]{
+        clearTempResults();
+        mDefines = oldDefines;
+    });
+    addDefinesInFile(fileName);
+    mBuffer = lines;
+    for (mIndex=0;mIndex<mBuffer.count();mIndex++) {
+        int startIndex = mIndex;
+        QString expanded = expandMacros();
+        mResult.append(expanded);
+        for (int i=startIndex;i<mIndex;i++) {
+            mResult.append("");
+        }
     }
-    return newLine;
+    QStringList result = mResult;
+    return result;
 }
 
 QString CppPreprocessor::expandMacros()
 {
-    //prevent infinit recursion
-    QString word;
     QString newLine;
-    QString line = mBuffer[mIndex];
-    QSet<QString> usedMacros;
+    //prevent infinit recursion
+    MacroHideSet hiddenMacros;
     int i=0;
-    while (mIndex < mBuffer.size() && i<line.length()) {
-        QChar ch=line[i];
-        if (isWordChar(ch)) {
-            word += ch;
-        } else {
-            if (!word.isEmpty()) {
-                expandMacro(newLine,word,i,usedMacros);
-                if (mIndex>=mBuffer.length())
-                    return newLine;
-                line = mBuffer[mIndex];
-            }
-            word = "";
-            if (i< line.length()) {
-                newLine += line[i];
-            }
+    while (mIndex < mBuffer.size() && i<mBuffer.at(mIndex).length()) {
+        const QString& line = mBuffer.at(mIndex);
+        if (!isWordChar(line[i])) {
+            newLine += line[i];
+            i++;
+            continue;
         }
-        i++;
-    }
-    if (!word.isEmpty()) {
-        expandMacro(newLine,word,i,usedMacros);
+        int wordStart = i;
+        while (i<line.length() && isWordChar(line[i]))
+            i++;
+        // may move mIndex to the line where the macro arguments end
+        expandMacro(newLine, wordStart, i, hiddenMacros);
     }
     return newLine;
 }
 
-void CppPreprocessor::expandMacro(const QString &text, QString &newText, const QString &word, int &i, QSet<QString> usedMacros) const
+const Define *CppPreprocessor::findDefine(const QChar *name, int length) const
 {
-    if (usedMacros.contains(word))
+    // raw data avoids copying each word just to look it up
+    auto it = mDefines.constFind(QString::fromRawData(name, length));
+    if (it == mDefines.constEnd())
+        return nullptr;
+    return it.value().get();
+}
+
+void CppPreprocessor::expandMacro(const QString &text, QString &output, int wordStart, int &i, MacroHideSet &hiddenMacros) const
+{
+    const Define* define = findDefine(text.constData()+wordStart, i-wordStart);
+    if (!define || hiddenMacros.contains(define)) {
+        output.append(text.constData()+wordStart, i-wordStart);
+        return;
+    }
+    if (define->args.isEmpty()) {
+        hiddenMacros.append(define);
+        expandMacros(define->value, output, hiddenMacros);
+        hiddenMacros.removeLast();
         return;
+    }
     int lenLine = text.length();
-    PDefine define = getDefine(word);
-    if (define && define->args=="" ) {
-        usedMacros.insert(word);
-        if (define->value != word ) {
-            newText += expandMacros(define->value,usedMacros);
-        } else
-            newText += word;
-    } else if (define && (define->args!="")) {
-        while ((i<lenLine) && (text[i] == ' ' || text[i]=='\t'))
+    int pos = i;
+    while ((pos<lenLine) && (text[pos] == ' ' || text[pos]=='\t'))
+        pos++;
+    if ((pos>=lenLine) || (text[pos]!='(')) {
+        // not a macro call
+        output.append(text.constData()+wordStart, i-wordStart);
+        return;
+    }
+    int argStart = pos+1;
+    int level=0;
+    bool inString=false;
+    while (pos<lenLine) {
+        switch(text[pos].unicode()) {
+        case '\\':
+            if (inString)
+                pos++;
+        break;
+        case '"':
+            inString = !inString;
+        break;
+        case '(':
+            if (!inString)
+                level++;
+        break;
+        case ')':
+            if (!inString)
+                level--;
+        }
+        pos++;
+        if (level==0)
+            break;
+    }
+    if (level!=0) {
+        output.append(text.constData()+wordStart, i-wordStart);
+        return;
+    }
+    int argEnd = pos-2;
+    i = pos;
+    QString args = text.mid(argStart,argEnd-argStart+1).trimmed();
+    QString formattedValue = expandFunction(define,args);
+    hiddenMacros.append(define);
+    expandMacros(formattedValue, output, hiddenMacros);
+    hiddenMacros.removeLast();
+}
+
+void CppPreprocessor::expandMacro(QString &newLine, int wordStart, int &i, MacroHideSet &hiddenMacros)
+{
+    const Define* define = findDefine(mBuffer.at(mIndex).constData()+wordStart, i-wordStart);
+    if (!define || hiddenMacros.contains(define)) {
+        newLine.append(mBuffer.at(mIndex).constData()+wordStart, i-wordStart);
+        return;
+    }
+    if (define->args.isEmpty()) {
+        hiddenMacros.append(define);
+        expandMacros(define->value, newLine, hiddenMacros);
+        hiddenMacros.removeLast();
+        return;
+    }
+    int origI=i;
+    int origIndex=mIndex;
+    auto notCalled = [&]() {
+        i=origI;
+        mIndex=origIndex;
+        newLine.append(mBuffer.at(mIndex).constData()+wordStart, i-wordStart);
+    };
+    QString line = mBuffer.at(mIndex);
+    while(true) {
+        while ((i<line.length()) && (line[i] == ' ' || line[i]=='\t'))
             i++;
-        int argStart=-1;
-        int argEnd=-1;
-        if ((i<lenLine) && (text[i]=='(')) {
-            argStart =i+1;
-            int level=0;
-            bool inString=false;
-            while (i<lenLine) {
-                switch(text[i].unicode()) {
+        if (i<line.length())
+            break;
+        mIndex++;
+        if (mIndex>=mBuffer.length()) {
+            notCalled();
+            return;
+        }
+        line = mBuffer.at(mIndex);
+        i=0;
+    }
+    if (line[i]!='(') {
+        notCalled();
+        return;
+    }
+    int argStart =i+1;
+    int argLineStart=mIndex;
+    int level=0;
+    bool inString=false;
+    while (true) {
+        while (i<line.length()) {
+            switch(line[i].unicode()) {
                 case '\\':
                     if (inString)
                         i++;
@@ -563,119 +889,43 @@ void CppPreprocessor::expandMacro(const QString &text, QString &newText, const Q
                 case ')':
                     if (!inString)
                         level--;
-                }
-                i++;
-                if (level==0)
-                    break;
-            }
-            if (level==0) {
-                argEnd = i-2;
-                QString args = text.mid(argStart,argEnd-argStart+1).trimmed();
-                QString formattedValue = expandFunction(define,args);
-                usedMacros.insert(word);
-                newText += expandMacros(formattedValue,usedMacros);
+                break;
             }
-        }
-    } else {
-        newText += word;
-    }
-    //    }
-}
-
-void CppPreprocessor::expandMacro(QString &newLine, const QString &word, int &i, QSet<QString> usedMacros)
-{
-    if (usedMacros.contains(word))
-        return;
-    QString line = mBuffer[mIndex];
-    PDefine define = getDefine(word);
-    if (define && define->args=="" ) {
-        usedMacros.insert(word);
-        if (define->value != word )
-            newLine += expandMacros(define->value,usedMacros);
-        else
-            newLine += word;
-    } else if (define && (define->args!="")) {
-        int origI=i;
-        int origIndex=mIndex;
-        while(true) {
-            while ((i<line.length()) && (line[i] == ' ' || line[i]=='\t'))
-                i++;
-            if (i<line.length())
+            i++;
+            if (level==0)
                 break;
-            mIndex++;
-            if (mIndex>=mBuffer.length())
-                return;
-            line = mBuffer[mIndex];
-            i=0;
         }
-        int argStart=-1;
-        int argEnd=-1;
-        int argLineStart=mIndex;
-        int argLineEnd=mIndex;
-        if ((i<line.length()) && (line[i]=='(')) {
-            argStart =i+1;
-            int level=0;
-            bool inString=false;
-            while (true) {
-                while (i<line.length()) {
-                    switch(line[i].unicode()) {
-                        case '\\':
-                            if (inString)
-                                i++;
-                        break;
-                        case '"':
-                            inString = !inString;
-                        break;
-                        case '(':
-                            if (!inString)
-                                level++;
-                        break;
-                        case ')':
-                            if (!inString)
-                                level--;
-                        break;
-                    }
-                    i++;
-                    if (level==0)
-                        break;
-                }
-                if (level==0)
-                    break;
-                mIndex++;
-                i=0;
-                if (mIndex>=mBuffer.length())
-                    break;
-                line = mBuffer[mIndex];
-                if (!inString && line.startsWith('#')) {
-                    break;
-                }
-            } ;
-            if (level==0) {
-                argEnd = i-1;
-                argLineEnd = mIndex;
-                QString args;
-                if (argLineStart==argLineEnd) {
-                    args = line.mid(argStart,argEnd-argStart).trimmed();
-                    //qDebug()<<"--"<<args;
-                } else {
-                    args = mBuffer[argLineStart].mid(argStart);
-                    for (int i=argLineStart+1;i<argLineEnd;i++) {
-                        args += mBuffer[i];
-                    }
-                    args += mBuffer[argLineEnd].left(argEnd);
-                }
-                QString formattedValue = expandFunction(define,args);
-                usedMacros.insert(word);
-                newLine += expandMacros(formattedValue,usedMacros);
-            }
-        } else {
-            newLine+=word;
-            i=origI;
-            mIndex=origIndex;
+        if (level==0)
+            break;
+        mIndex++;
+        i=0;
+        if (mIndex>=mBuffer.length())
+            break;
+        line = mBuffer.at(mIndex);
+        if (!inString && line.startsWith('#')) {
+            break;
         }
+    }
+    if (level!=0) {
+        notCalled();
+        return;
+    }
+    int argEnd = i-1;
+    int argLineEnd = mIndex;
+    QString args;
+    if (argLineStart==argLineEnd) {
+        args = line.mid(argStart,argEnd-argStart).trimmed();
     } else {
-        newLine += word;
+        args = mBuffer.at(argLineStart).mid(argStart);
+        for (int i=argLineStart+1;i<argLineEnd;i++) {
+            args += mBuffer.at(i);
+        }
+        args += mBuffer.at(argLineEnd).left(argEnd);
     }
+    QString formattedValue = expandFunction(define,args);
+    hiddenMacros.append(define);
+    expandMacros(formattedValue, newLine, hiddenMacros);
+    hiddenMacros.removeLast();
 }
 
 QString CppPreprocessor::removeGCCAttributes(const QString &line)
@@ -740,14 +990,13 @@ void CppPreprocessor::openInclude(QString fileName)
     }
     if (mIncludeStack.size()>0) {
         bool alreadyIncluded = false;
+        int fileId = fileInfo->id();
         for (PParsedFile& parsedFile:mIncludeStack) {
-            if (parsedFile->fileInfo->including(fileName)) {
+            if (parsedFile->fileInfo->including(fileId)) {
                 alreadyIncluded = true;
             }
-            parsedFile->fileInfo->addInclude(fileName);
-            foreach (const QString& includedFileName,fileInfo->includes()) {
-                parsedFile->fileInfo->addInclude(includedFileName);
-            }
+            parsedFile->fileInfo->addInclude(fileId);
+            parsedFile->fileInfo->addIncludes(*fileInfo);
         }
         PParsedFile innerMostFile = mIncludeStack.back();
         innerMostFile->fileInfo->addDirectInclude(fileName);
@@ -781,12 +1030,15 @@ void CppPreprocessor::openInclude(QString fileName)
         // Only load up the file if we are allowed to parse it
         bool isSystemFile = isSystemHeaderFile(fileName, mIncludePaths) || isSystemHeaderFile(fileName, mProjectIncludePaths);
         if ((mParseSystem && isSystemFile) || (mParseLocal && !isSystemFile)) {
-            QStringList bufferedText;
-            if (mOnGetFileStream && mOnGetFileStream(fileName,bufferedText)) {
-                parsedFile->buffer  = bufferedText;
+            auto it = mPreloadedFileBuffers.find(fileName);
+            if (it != mPreloadedFileBuffers.end()) {
+                parsedFile->buffer = it.value();
+                mPreloadedFileBuffers.erase(it);
             } else {
-                parsedFile->buffer = readFileToLines(fileName);
+                parsedFile->buffer = loadFile(fileName);
             }
+            if (mCollectFileBuffers && !isSystemFile)
+                mCollectedFileBuffers.insert(fileName, parsedFile->buffer);
         }
     } else {
         //add defines of already parsed including headers;
@@ -797,7 +1049,6 @@ void CppPreprocessor::openInclude(QString fileName)
     // Process it
     mIndex = parsedFile->index;
     mFileName = parsedFile->fileName;
-    parsedFile->buffer = removeComments(parsedFile->buffer);
     mBuffer = parsedFile->buffer;
 
 //    for (int i=0;i<mBuffer.count();i++) {
@@ -871,18 +1122,29 @@ void CppPreprocessor::addDefinesInFile(const QString &fileName)
 
     PParsedFileInfo fileInfo = findFileInfo(fileName);
     if (fileInfo) {
-        foreach (const QString& file, fileInfo->includes()) {
+        fileInfo->forEachInclude([this](const QString& file) {
             addDefinesInFile(file);
-        }
+        });
     }
 }
 
+static void appendDefineValueText(QVector<DefineValuePart>& parts, const QString& text)
+{
+    if (!parts.isEmpty() && parts.last().argIndex<0)
+        parts.last().text += text;
+    else
+        parts.append(DefineValuePart{text, -1, false});
+}
+
 void CppPreprocessor::parseArgs(PDefine define)
 {
     QString args=define->args.mid(1,define->args.length()-2).trimmed(); // remove '(' ')'
 
-    if(args=="")
+    define->valueParts.clear();
+    if(args=="") {
+        appendDefineValueText(define->valueParts, define->value);
         return ;
+    }
     QStringList argList = args.split(',');
     for (int i=0;i<argList.size();i++) {
         argList[i]=argList[i].trimmed();
@@ -904,7 +1166,9 @@ void CppPreprocessor::parseArgs(PDefine define)
             }
             if (index>=0) {
                 define->argUsed[index] = true;
-                if (lastTokenType == DefineArgTokenType::Sharp) {
+                bool stringify = (lastTokenType == DefineArgTokenType::Sharp);
+                define->valueParts.append(DefineValuePart{QString(), index, stringify});
+                if (stringify) {
                     formatStr+= "\"%"+QString("%1").arg(index+1)+"\"";
                     break;
                 } else {
@@ -913,6 +1177,7 @@ void CppPreprocessor::parseArgs(PDefine define)
                 }
             }
             formatStr += token->value;
+            appendDefineValueText(define->valueParts, token->value);
             break;
         case DefineArgTokenType::DSharp:
         case DefineArgTokenType::Sharp:
@@ -920,6 +1185,7 @@ void CppPreprocessor::parseArgs(PDefine define)
         case DefineArgTokenType::Space:
         case DefineArgTokenType::Symbol:
             formatStr+=token->value;
+            appendDefineValueText(define->valueParts, token->value);
             break;
         default:
             break;
@@ -1006,7 +1272,7 @@ QList<PDefineArgToken> CppPreprocessor::tokenizeValue(const QString &value)
     return tokens;
 }
 
-QStringList CppPreprocessor::removeComments(const QStringList &text)
+QStringList CppPreprocessor::removeComments(const QStringList &text) const
 {
     QStringList result;
     ContentType currentType = ContentType::Other;
@@ -1277,7 +1543,7 @@ QString CppPreprocessor::expandDefines(QString line)
                                 insertValue = "0";
                             } else {
                                 QString args = line.mid(head+1,tail-head-1);
-                                insertValue = expandFunction(define,args);
+                                insertValue = expandFunction(define.get(),args);
                             }
                             nameEnd = tail+1;
                         } else {
@@ -1319,22 +1585,14 @@ bool CppPreprocessor::skipParenthesis(const QString &line, int &index, int step)
     return false;
 }
 
-QString CppPreprocessor::expandFunction(PDefine define, const QString &args)
+QString CppPreprocessor::expandFunction(const Define* define, const QString &args)
 {
-    // Replace function by this string
-    QString result = define->formatValue;
-//    if (args.startsWith('(') && args.endsWith(')')) {
-//        qDebug()<<define->name<<args;
-//        args = args.mid(1,args.length()-2);
-//    }
-
+    QStringList argValues;
     if (define->argUsed.length()==0) {
         // do nothing
     } else if (define->argUsed.length()==1) {
-        if (define->argUsed[0])
-            result=result.arg(args);
+        argValues.append(args);
     } else {
-        QStringList argValues;
         int i=0;
         bool inString = false;
         bool inChar = false;
@@ -1366,14 +1624,14 @@ QString CppPreprocessor::expandFunction(PDefine define, const QString &args)
                 break;
             case ',':
                 if (!inString && !inChar && level == 0) {
-                    argValues.append(args.mid(lastSplit,i-lastSplit));
+                    argValues.append(args.mid(lastSplit,i-lastSplit).trimmed());
                     lastSplit=i+1;
                 }
             break;
             }
             i++;
         }
-        argValues.append(args.mid(lastSplit,i-lastSplit));
+        argValues.append(args.mid(lastSplit,i-lastSplit).trimmed());
 #ifdef QT_DEBUG
         if (
                 (define->varArgIndex==-1 && argValues.length() != define->argUsed.length())
@@ -1386,26 +1644,28 @@ QString CppPreprocessor::expandFunction(PDefine define, const QString &args)
             qDebug()<<"**********";
         }
 #endif
-        if (argValues.length() >= define->argUsed.length()
-                && argValues.length()>0) {
-            QStringList varArgs;
-            for (int i=0;i<argValues.length();i++) {
-                if (define->varArgIndex != -1
-                     && i >= define->varArgIndex ) {
-                    varArgs.append(argValues[i].trimmed());
-                } else if (i<define->argUsed.length()
-                            && define->argUsed[i]) {
-                    QString argValue = argValues[i];
-                    result=result.arg(argValue.trimmed());
-                }
-            }
-            if (!varArgs.isEmpty() && define->varArgIndex != -1) {
-                result=result.arg(varArgs.join(","));
-            }
+        if (define->varArgIndex != -1 && define->varArgIndex < argValues.length()) {
+            QStringList varArgs = argValues.mid(define->varArgIndex);
+            argValues.erase(argValues.begin()+define->varArgIndex, argValues.end());
+            argValues.append(varArgs.join(","));
         }
     }
-    result.replace("%%","%");
 
+    // Replace function by this string
+    QString result;
+    foreach (const DefineValuePart& part, define->valueParts) {
+        if (part.argIndex<0) {
+            result += part.text;
+            continue;
+        }
+        // missing arguments (e.g. empty variable arguments) are expanded to nothing
+        if (part.stringify)
+            result += '"';
+        if (part.argIndex<argValues.length())
+            result += argValues[part.argIndex];
+        if (part.stringify)
+            result += '"';
+    }
     return result;
 }
 
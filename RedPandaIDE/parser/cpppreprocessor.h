@@ -17,10 +17,14 @@
 #ifndef CPPPREPROCESSOR_H
 #define CPPPREPROCESSOR_H
 
+#include <QMutex>
 #include <QObject>
 #include <QTextStream>
+#include <QVarLengthArray>
 #include "parserutils.h"
 
+class QDataStream;
+
 #define MAX_DEFINE_EXPAND_DEPTH 20
 enum class DefineArgTokenType{
     Symbol,
@@ -46,6 +50,37 @@ struct ParsedFile {
 
 using PParsedFile = std::shared_ptr<ParsedFile>;
 
+// macros being expanded, which are not expanded again in their own expansions
+using MacroHideSet = QVarLengthArray<const Define*, MAX_DEFINE_EXPAND_DEPTH>;
+
+/*
+ * Header files found for #include lines, shared by the preprocessors copying options from each other.
+ * Failed lookups are cached too. The owner should watch the searched dirs,
+ * and clear the cache when any of them is changed.
+ */
+class HeaderLookupCache {
+public:
+    HeaderLookupCache();
+    ~HeaderLookupCache();
+    HeaderLookupCache(const HeaderLookupCache&)=delete;
+    HeaderLookupCache& operator=(const HeaderLookupCache&)=delete;
+    bool find(const QString& key, QString& fileName) const;
+    void insert(const QString& key, const QString& fileName, const QStringList& searchedDirs);
+    void clear();
+    // dirs searched since the last call
+    QStringList takeNewSearchedDirs();
+    // watch the newly searched dirs, all caches are cleared when headers are added/removed in them.
+    // One watcher is shared by all caches, so it must be called in the gui thread.
+    void watchNewSearchedDirs();
+private:
+    mutable QMutex mMutex;
+    QHash<QString, QString> mFileNames;
+    QSet<QString> mSearchedDirs;
+    QStringList mNewSearchedDirs;
+};
+
+using PHeaderLookupCache = std::shared_ptr<HeaderLookupCache>;
+
 class CppPreprocessor
 {
     enum class ContentType {
@@ -68,6 +103,7 @@ public:
     void clear();
 
     void clearTempResults();
+    void copyOptionsFrom(const CppPreprocessor& other);
     void getDefineParts(const QString& input, QString &name, QString &args, QString &value);
     void addHardDefineByLine(const QString& line) { addDefineByLine(line,true); }
     void setScanOptions(bool parseSystem, bool parseLocal) {
@@ -75,6 +111,7 @@ public:
         mParseLocal=parseLocal;
     }
     void preprocess(const QString& fileName);
+    QStringList loadFile(const QString& fileName) const;
 
     void dumpDefinesTo(const QString& fileName) const;
     void dumpIncludesListTo(const QString& fileName) const;
@@ -83,10 +120,12 @@ public:
     void clearIncludePaths() {
         mIncludePaths.clear();
         mIncludePathList.clear();
+        mHeaderLookupCache->clear();
     }
     void clearProjectIncludePaths() {
         mProjectIncludePaths.clear();
         mProjectIncludePathList.clear();
+        mHeaderLookupCache->clear();
     }
     void removeScannedFile(const QString& filename);
 
@@ -94,8 +133,11 @@ public:
         return mDefines.value(name,PDefine());
     }
 
-    QString expandMacros(const QString& text, QSet<QString> usedMacros) const;
-    void expandMacro(const QString &text, QString &newText, const QString &word, int &i, QSet<QString> usedMacros) const;
+    QString expandMacros(const QString& text) const;
+    //expand macros in text and append the result to output
+    void expandMacros(const QString& text, QString& output, MacroHideSet& hiddenMacros) const;
+    //expand macros in lines of a scanned file, which must not contain preprocessor directives
+    QStringList expandMacrosInLines(const QString& fileName, const QStringList& lines);
 
     const QStringList& result() const{
         return mResult;
@@ -109,6 +151,23 @@ public:
         mFileInfos.remove(fileName);
     }
 
+    void addScannedFile(const PParsedFileInfo& fileInfo) {
+        mFileInfos.insert(fileInfo->fileName(), fileInfo);
+        mScannedFiles.insert(fileInfo->fileName());
+    }
+    //add the file scanned by another preprocessor, with the defines/undefines in it
+    void addScannedFile(const PParsedFileInfo& fileInfo, const PDefineMap& defines, const PDefineMap& undefines);
+
+    PDefineMap fileDefines(const QString& fileName) const {
+        return mFileDefines.value(fileName);
+    }
+    PDefineMap fileUndefines(const QString& fileName) const {
+        return mFileUndefines.value(fileName);
+    }
+
+    void saveFileDefines(QDataStream& out, const QStringList& files) const;
+    bool loadFileDefines(QDataStream& in, const QStringList& files);
+
     bool fileScanned(const QString& fileName) const {
         return mScannedFiles.contains(fileName);
     }
@@ -130,8 +189,21 @@ public:
     const QList<QString> &includePathList() const { return mIncludePathList; }
 
     const QList<QString> &projectIncludePathList() const { return mProjectIncludePathList; }
+
+    const PHeaderLookupCache &headerLookupCache() const { return mHeaderLookupCache; }
     void setOnGetFileStream(const GetFileStreamCallBack &newOnGetFileStream) { mOnGetFileStream = newOnGetFileStream; }
 
+    //buffers (comments removed) of local files loaded while preprocessing, used by parallel prescans
+    void setCollectFileBuffers(bool newCollectFileBuffers) { mCollectFileBuffers = newCollectFileBuffers; }
+    const QHash<QString, QStringList> &collectedFileBuffers() const { return mCollectedFileBuffers; }
+    //buffers (comments removed) loaded by parallel prescans, used instead of reading the file again
+    void addPreloadedFileBuffer(const QString& fileName, const QStringList& buffer) {
+        mPreloadedFileBuffers.insert(fileName, buffer);
+    }
+    const QHash<QString, QStringList> &preloadedFileBuffers() const { return mPreloadedFileBuffers; }
+    void setPreloadedFileBuffers(const QHash<QString, QStringList> &buffers) { mPreloadedFileBuffers = buffers; }
+    void clearPreloadedFileBuffers() { mPreloadedFileBuffers.clear(); }
+
     static QList<PDefineArgToken> tokenizeValue(const QString& value);
 
 private:
@@ -143,7 +215,7 @@ private:
         parentIsFalse
     };
 
-    static QString expandFunction(PDefine define,const QString &args);
+    static QString expandFunction(const Define* define,const QString &args);
     void preprocessBuffer();
     void skipToEndOfPreprocessor();
     void skipToPreprocessor();
@@ -154,7 +226,11 @@ private:
     void handlePreprocessor(const QString& value);
     void handleUndefine(const QString& line);
     QString expandMacros();
-    void expandMacro(QString &newLine, const QString &word, int& i, QSet<QString> usedMacros);
+    // the word to expand is text[wordStart..i), i is moved past the macro arguments
+    void expandMacro(const QString &text, QString &output, int wordStart, int &i, MacroHideSet& hiddenMacros) const;
+    // the word to expand is mBuffer[mIndex][wordStart..i), arguments may span several lines
+    void expandMacro(QString &newLine, int wordStart, int& i, MacroHideSet& hiddenMacros);
+    const Define* findDefine(const QChar* name, int length) const;
     QString removeGCCAttributes(const QString& line);
     void removeGCCAttribute(const QString&line, QString& newLine, int &i, const QString& word);
 
@@ -202,8 +278,9 @@ private:
     void invalidDefinesInFile(const QString& fileName);
 
     void parseArgs(PDefine define);
+    void rebuildValueParts(const PDefineMap& defineMap);
 
-    QStringList removeComments(const QStringList& text);
+    QStringList removeComments(const QStringList& text) const;
     /*
      * '_','a'..'z','A'..'Z','0'..'9'
      */
@@ -298,10 +375,15 @@ private:
     QList<QString> mProjectIncludePathList;
     //{ List of current compiler set's include path}
     QSet<QString> mIncludePaths;
+    PHeaderLookupCache mHeaderLookupCache; // cleared when include paths are changed
 
     bool mParseSystem;
     bool mParseLocal;
 
+    bool mCollectFileBuffers;
+    QHash<QString, QStringList> mCollectedFileBuffers;
+    QHash<QString, QStringList> mPreloadedFileBuffers;
+
     GetFileStreamCallBack mOnGetFileStream;
 };
 
@@ -35,13 +35,14 @@ class CppTokenizer
     };
 
 public:
+    // Tokens are stored by value. Texts of the tokens are interned,
+    // so tokens with the same text share one string.
     struct Token {
       QString text;
       int line;
       int matchIndex;
     };
-    using PToken = std::shared_ptr<Token>;
-    using TokenList = QVector<PToken>;
+    using TokenList = QVector<Token>;
     explicit CppTokenizer();
     CppTokenizer(const CppTokenizer&)=delete;
     CppTokenizer& operator=(const CppTokenizer&)=delete;
@@ -49,8 +50,10 @@ public:
     void clear();
     void tokenize(const QStringList& buffer);
     void dumpTokens(const QString& fileName);
-    const PToken& operator[](int i) const { return mTokenList[i]; }
+    const Token& operator[](int i) const { return mTokenList[i]; }
+    Token& operator[](int i) { return mTokenList[i]; }
     int tokenCount() const { return mTokenList.count(); }
+    int tokenTextCount() const { return mTokenTexts.count(); }
     static bool isIdentChar(const QChar& ch) { return ch=='_' || ch.isLetter(); }
     int lambdasCount() const { return mLambdas.count(); }
 
@@ -152,6 +155,7 @@ private:
     int mCurrentLine;
     QString mLastToken;
     TokenList mTokenList;
+    QSet<QString> mTokenTexts; // interned texts of the tokens
     QList<int> mLambdas;
     QVector<int> mUnmatchedBraces; // stack of indices for unmatched '{'
     QVector<int> mUnmatchedBrackets; // stack of indices for unmatched '['
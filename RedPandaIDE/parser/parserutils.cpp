@@ -21,6 +21,7 @@
 #include <QFileInfo>
 #include <QDebug>
 #include <QGlobalStatic>
+#include <QReadWriteLock>
 #include "../systemconsts.h"
 #include "../utils.h"
 
@@ -754,6 +755,163 @@ bool isTypeKind(StatementKind kind)
     }
 }
 
+bool isFunctionKind(StatementKind kind)
+{
+    switch(kind) {
+    case StatementKind::Function:
+    case StatementKind::Constructor:
+    case StatementKind::Destructor:
+        return true;
+    default:
+        return false;
+    }
+}
+
+namespace {
+struct Strings {
+    QReadWriteLock lock;
+    QSet<QString> strings;
+};
+}
+
+Q_GLOBAL_STATIC(Strings, stringPool)
+
+QString StringPool::intern(const QString &s)
+{
+    if (s.isEmpty())
+        return s;
+    {
+        QReadLocker locker(&stringPool->lock);
+        auto it = stringPool->strings.constFind(s);
+        if (it!=stringPool->strings.constEnd())
+            return *it;
+    }
+    QWriteLocker locker(&stringPool->lock);
+    auto it = stringPool->strings.constFind(s);
+    if (it!=stringPool->strings.constEnd())
+        return *it;
+    QString pooled = s;
+    //don't keep the extra capacity of strings built by appending
+    pooled.squeeze();
+    stringPool->strings.insert(pooled);
+    return pooled;
+}
+
+void StringPool::purge()
+{
+    QWriteLocker locker(&stringPool->lock);
+    for (auto it=stringPool->strings.begin();it!=stringPool->strings.end();) {
+        //no one else holds it, and no one can get it without the lock
+        if (it->isDetached())
+            it = stringPool->strings.erase(it);
+        else
+            ++it;
+    }
+}
+
+int StringPool::count()
+{
+    QReadLocker locker(&stringPool->lock);
+    return stringPool->strings.count();
+}
+
+qint64 StringPool::memoryUsage()
+{
+    QReadLocker locker(&stringPool->lock);
+    qint64 size = 0;
+    foreach (const QString& s, stringPool->strings)
+        size += sizeof(QArrayData) + s.capacity()*sizeof(QChar);
+    return size;
+}
+
+namespace {
+struct FileIds {
+    QReadWriteLock lock;
+    QHash<QString,int> ids;
+    QStringList fileNames;
+};
+}
+
+Q_GLOBAL_STATIC(FileIds, fileIds)
+
+int FileIdPool::id(const QString &fileName)
+{
+    {
+        QReadLocker locker(&fileIds->lock);
+        auto it = fileIds->ids.constFind(fileName);
+        if (it!=fileIds->ids.constEnd())
+            return it.value();
+    }
+    QWriteLocker locker(&fileIds->lock);
+    auto it = fileIds->ids.constFind(fileName);
+    if (it!=fileIds->ids.constEnd())
+        return it.value();
+    int id = fileIds->fileNames.count();
+    fileIds->fileNames.append(fileName);
+    fileIds->ids.insert(fileName, id);
+    return id;
+}
+
+int FileIdPool::find(const QString &fileName)
+{
+    QReadLocker locker(&fileIds->lock);
+    return fileIds->ids.value(fileName, -1);
+}
+
+QString FileIdPool::fileName(int id)
+{
+    QReadLocker locker(&fileIds->lock);
+    return fileIds->fileNames.value(id);
+}
+
+QSet<QString> FileIdPool::fileNames(const QBitArray &ids)
+{
+    QSet<QString> result;
+    QReadLocker locker(&fileIds->lock);
+    for (int i=0;i<ids.size();i++) {
+        if (ids.testBit(i))
+            result.insert(fileIds->fileNames.value(i));
+    }
+    return result;
+}
+
+QStringList FileIdPool::fileNameList(const QBitArray &ids)
+{
+    QStringList result;
+    QReadLocker locker(&fileIds->lock);
+    for (int i=0;i<ids.size();i++) {
+        if (ids.testBit(i))
+            result.append(fileIds->fileNames.value(i));
+    }
+    return result;
+}
+
+void ParsedFileInfo::addInclude(int fileId)
+{
+    if (fileId>=mIncludes.size()) {
+        //grow by 64 bits to avoid resizing for each new file
+        mIncludes.resize((fileId/64+1)*64);
+    }
+    mIncludes.setBit(fileId);
+}
+
+QSet<QString> ParsedFileInfo::includes() const
+{
+    return FileIdPool::fileNames(mIncludes);
+}
+
+void ParsedFileInfo::shiftBranches(int afterLine, int delta)
+{
+    QMap<int,bool> branches;
+    for(auto it=mBranches.begin();it!=mBranches.end();++it) {
+        if (it.key()>afterLine)
+            branches.insert(it.key()+delta,it.value());
+        else
+            branches.insert(it.key(),it.value());
+    }
+    mBranches = branches;
+}
+
 bool ParsedFileInfo::isLineVisible(int line) const
 {
     int lastI=-1;
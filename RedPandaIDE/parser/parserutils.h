@@ -16,6 +16,7 @@
  */
 #ifndef PARSER_UTILS_H
 #define PARSER_UTILS_H
+#include <QBitArray>
 #include <QMap>
 #include <QObject>
 #include <QSet>
@@ -48,6 +49,12 @@ struct CodeSnippet {
 using PCodeSnippet = std::shared_ptr<CodeSnippet>;
 
 // preprocess/ macro define
+struct DefineValuePart {
+    QString text; // literal text
+    int argIndex; // index of the argument to insert, -1 if it's literal text
+    bool stringify; // the argument is quoted by '#'
+};
+
 struct Define {
     QString name;
     QString args;
@@ -57,6 +64,7 @@ struct Define {
     QList<bool> argUsed;
     int varArgIndex;
     QString formatValue; // format template to format values
+    QVector<DefineValuePart> valueParts; // value of function-like macros, split at the arguments
 };
 
 using PDefine = std::shared_ptr<Define>;
@@ -116,6 +124,7 @@ enum class StatementKind  {
     Keyword, // keywords
     KeywordType, //keywords for type (for color management)
     Alias, // using alias
+    // loadSymbolCache() checks kinds up to the last one
 };
 
 inline uint qHash(const StatementKind& value, uint seed) {
@@ -174,8 +183,6 @@ Q_DECLARE_FLAGS(StatementProperties, StatementProperty)
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(StatementProperties)
 
-using PStatementMathPosition = std::shared_ptr<StatementMatchPosition>;
-
 struct Statement;
 using PStatement = std::shared_ptr<Statement>;
 using StatementList = QList<PStatement>;
@@ -205,11 +212,6 @@ struct Statement {
 
     // fields for code completion
     int usageCount; //Usage Count
-    uint16_t matchPosTotal; // total of matched positions
-    uint16_t matchPosSpan; // distance between the first match pos and the last match pos;
-    uint16_t firstMatchLength; // length of first match;
-    uint16_t caseMatched; // if match with case
-    QList<PStatementMathPosition> matchPositions;
 
     // definiton line/filename is valid
     bool hasDefinition() {
@@ -302,6 +304,8 @@ public:
             mScopes.pop_back();
     }
     void clear() { mScopes.clear(); }
+    void truncate(int count) { mScopes.resize(std::min(count, (int)mScopes.size())); }
+    const QVector<PCppScope>& scopes() const { return mScopes; }
 private:
     QVector<PCppScope> mScopes;
 };
@@ -319,36 +323,95 @@ struct ClassInheritanceInfo {
 
 using PClassInheritanceInfo = std::shared_ptr<ClassInheritanceInfo>;
 
+/**
+ * @brief Shared copies of the strings stored in statements
+ *
+ * Type names, identifiers and file names are repeated in many statements,
+ * and statements of the same headers are created by each parser.
+ * It's thread safe.
+ */
+class StringPool {
+public:
+    // get the shared copy of the string, it's added to the pool if not found
+    static QString intern(const QString& s);
+    // remove the strings only referenced by the pool
+    static void purge();
+    static int count();
+    // bytes used by the strings in the pool
+    static qint64 memoryUsage();
+};
+
+/**
+ * @brief Ids of the file names used by the parsers
+ *
+ * Ids are shared by all parsers and never released, so sets of files can be stored as bitsets.
+ * It's thread safe.
+ */
+class FileIdPool {
+public:
+    // get the id of the file name, a new id is created if the name is not added
+    static int id(const QString& fileName);
+    // -1 if the file name is not added
+    static int find(const QString& fileName);
+    static QString fileName(int id);
+    // names of the files whose ids are set in the bitset
+    static QSet<QString> fileNames(const QBitArray& ids);
+    // same as fileNames(), in the order of the ids
+    static QStringList fileNameList(const QBitArray& ids);
+};
+
 class ParsedFileInfo {
 public:
-    ParsedFileInfo(const QString& fileName): mFileName {fileName} { }
+    ParsedFileInfo(const QString& fileName): mFileName {fileName}, mId{FileIdPool::id(fileName)} { }
     ParsedFileInfo(const ParsedFileInfo&)=delete;
     ParsedFileInfo& operator=(const ParsedFileInfo&)=delete;
     void insertBranch(int level, bool branchTrue) { mBranches.insert(level, branchTrue); }
     bool isLineVisible(int line) const;
-    void addInclude(const QString &fileName) { mIncludes.insert(fileName); }
+    void addInclude(const QString &fileName) { addInclude(FileIdPool::id(fileName)); }
+    void addInclude(int fileId);
+    // add all files included by the other file
+    void addIncludes(const ParsedFileInfo& other) { mIncludes |= other.mIncludes; }
     void addDirectInclude(const QString &fileName) { mDirectIncludes.append(fileName); }
-    bool including(const QString &fileName) const { return mIncludes.contains(fileName); }
+    bool including(const QString &fileName) const { return including(FileIdPool::find(fileName)); }
+    bool including(int fileId) const {
+        return fileId>=0 && fileId<mIncludes.size() && mIncludes.testBit(fileId);
+    }
     PStatement findScopeAtLine(int line) const { return mScopes.findScopeAtLine(line); }
     void addStatement(const PStatement &statement) { mStatements.insert(statement->fullName,statement); }
+    void removeStatement(const PStatement &statement) { mStatements.remove(statement->fullName,statement); }
     void clearStatements() { mStatements.clear(); }
     void addScope(int line, const PStatement &scope) { mScopes.addScope(line,scope); }
     void removeLastScope() { mScopes.removeLastScope(); }
+    void truncateScopes(int count) { mScopes.truncate(count); }
+    void shiftBranches(int afterLine, int delta);
     PStatement lastScope() const { return mScopes.lastScope(); }
     void addUsing(const QString &usingSymbol) { mUsings.insert(usingSymbol); }
     void addHandledInheritances(std::weak_ptr<ClassInheritanceInfo> classInheritanceInfo) { mHandledInheritances.append(classInheritanceInfo); }
     void clearHandledInheritances() { mHandledInheritances.clear(); }
 
     QString fileName() const { return mFileName; }
+    int id() const { return mId; }
     const StatementMap& statements() const { return mStatements; }
     const QSet<QString>& usings() const { return mUsings; }
     const QStringList& directIncludes() const { return mDirectIncludes; }
-    const QSet<QString>& includes() const { return mIncludes; }
+    // all files included directly or indirectly
+    QSet<QString> includes() const;
+    // call the callback with the name of each file included directly or indirectly,
+    // without building a set of the names.
+    // The pool is locked once for all names; callbacks run after it's unlocked, so they can add ids
+    template<typename Callback>
+    void forEachInclude(Callback callback) const {
+        foreach (const QString& fileName, FileIdPool::fileNameList(mIncludes))
+            callback(fileName);
+    }
     const QList<std::weak_ptr<ClassInheritanceInfo> >& handledInheritances() const { return mHandledInheritances; }
+    const QVector<PCppScope>& scopes() const { return mScopes.scopes(); }
+    const QMap<int,bool>& branches() const { return mBranches; }
 
 private:
     QString mFileName;
-    QSet<QString> mIncludes;
+    int mId;
+    QBitArray mIncludes; // ids of the included files
     QStringList mDirectIncludes; //We need order here.
     QSet<QString> mUsings; // namespaces it usings
     StatementMap mStatements; // but we don't save temporary statements (full name as key)
@@ -394,6 +457,7 @@ bool isCppKeyword(const QString& word);
 bool isCppControlKeyword(const QString& word);
 bool isScopeTypeKind(StatementKind kind);
 bool isTypeKind(StatementKind kind);
+bool isFunctionKind(StatementKind kind);
 MemberOperatorType getOperatorType(const QString& phrase, int index);
 QStringList getOwnerExpressionAndMember(
         const QStringList expression,
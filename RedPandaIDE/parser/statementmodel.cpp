@@ -29,6 +29,7 @@ void StatementModel::add(const PStatement& statement)
     if (!statement) {
         return ;
     }
+    internStrings(statement.get());
     PStatement parent = statement->parentScope.lock();
     if (parent) {
         addMember(parent->children,statement);
@@ -60,6 +61,38 @@ void StatementModel::deleteStatement(const PStatement& statement)
 
 }
 
+StatementMemoryUsage StatementModel::memoryUsage() const
+{
+    StatementMemoryUsage usage;
+    usage.statementCount = 0;
+    usage.statements = 0;
+    usage.stringCount = 0;
+    usage.sharedStringCount = 0;
+    usage.strings = 0;
+    usage.children = 0;
+    usage.sets = 0;
+    QSet<const void*> countedStrings;
+    calcMemoryUsage(mGlobalStatements, usage, countedStrings);
+    return usage;
+}
+
+void StatementModel::dumpMemoryUsage(const QString &logFile) const
+{
+    QFile file(logFile);
+    if (file.open(QFile::WriteOnly | QFile::Truncate)) {
+        QTextStream out(&file);
+        StatementMemoryUsage usage = memoryUsage();
+        out<<"statements: "<<usage.statementCount<<", "<<usage.statements<<" bytes"<<Qt::endl;
+        out<<"strings: "<<usage.stringCount<<" buffers ("
+          <<usage.sharedStringCount<<" shared fields), "<<usage.strings<<" bytes"<<Qt::endl;
+        out<<"children maps: "<<usage.children<<" bytes"<<Qt::endl;
+        out<<"friends/usings/captures: "<<usage.sets<<" bytes"<<Qt::endl;
+        out<<"total: "<<usage.total()<<" bytes"<<Qt::endl;
+        out<<"string pool (all parsers): "<<StringPool::count()<<" strings, "
+          <<StringPool::memoryUsage()<<" bytes"<<Qt::endl;
+    }
+}
+
 #ifdef QT_DEBUG
 void StatementModel::dump(const QString &logFile)
 {
@@ -90,6 +123,63 @@ void StatementModel::dumpAll(const QString &logFile)
 }
 #endif
 
+void StatementModel::internStrings(Statement *statement)
+{
+    // these are repeated in many statements, other fields are mostly unique
+    statement->type = StringPool::intern(statement->type);
+    statement->command = StringPool::intern(statement->command);
+    statement->noNameArgs = StringPool::intern(statement->noNameArgs);
+    statement->fileName = StringPool::intern(statement->fileName);
+    statement->definitionFileName = StringPool::intern(statement->definitionFileName);
+}
+
+static void addStringUsage(const QString& s, StatementMemoryUsage& usage, QSet<const void*>& countedStrings)
+{
+    if (s.isEmpty())
+        return;
+    if (countedStrings.contains(s.constData())) {
+        usage.sharedStringCount++;
+        return;
+    }
+    countedStrings.insert(s.constData());
+    usage.stringCount++;
+    usage.strings += sizeof(QArrayData) + s.capacity()*sizeof(QChar);
+}
+
+static qint64 stringSetUsage(const QSet<QString>& set)
+{
+    // a hash node (next, hash, key) for each item
+    qint64 size = set.count()*(sizeof(void*)*2+sizeof(QString));
+    foreach (const QString& s, set)
+        size += sizeof(QArrayData) + s.capacity()*sizeof(QChar);
+    return size;
+}
+
+void StatementModel::calcMemoryUsage(const StatementMap &map, StatementMemoryUsage &usage, QSet<const void *> &countedStrings) const
+{
+    // a tree node (parent, left, right) for each child
+    usage.children += map.count()*(sizeof(void*)*3+sizeof(QString)+sizeof(PStatement));
+    foreach (const PStatement& statement, map) {
+        usage.statementCount++;
+        // std::make_shared puts the control block (two counters and a vtable) with the object
+        usage.statements += sizeof(Statement) + sizeof(void*)*2;
+        addStringUsage(statement->type, usage, countedStrings);
+        addStringUsage(statement->command, usage, countedStrings);
+        addStringUsage(statement->args, usage, countedStrings);
+        addStringUsage(statement->value, usage, countedStrings);
+        addStringUsage(statement->templateSpecializationParams, usage, countedStrings);
+        addStringUsage(statement->fileName, usage, countedStrings);
+        addStringUsage(statement->definitionFileName, usage, countedStrings);
+        addStringUsage(statement->fullName, usage, countedStrings);
+        addStringUsage(statement->noNameArgs, usage, countedStrings);
+        usage.sets += stringSetUsage(statement->friends);
+        usage.sets += stringSetUsage(statement->usingList);
+        usage.sets += stringSetUsage(statement->lambdaCaptures);
+        if (!statement->children.isEmpty())
+            calcMemoryUsage(statement->children, usage, countedStrings);
+    }
+}
+
 void StatementModel::addMember(StatementMap &map, const PStatement& statement)
 {
     if (!statement)
@@ -21,6 +21,17 @@
 #include <QTextStream>
 #include "parserutils.h"
 
+struct StatementMemoryUsage {
+    int statementCount;
+    qint64 statements; // statement structs, with their shared_ptr control blocks
+    int stringCount; // string buffers, shared ones are counted once
+    int sharedStringCount; // string fields sharing a buffer counted before
+    qint64 strings; // string buffers
+    qint64 children; // children maps
+    qint64 sets; // friends, usings and lambda captures
+    qint64 total() const { return statements + strings + children + sets; }
+};
+
 class StatementModel : public QObject
 {
     Q_OBJECT
@@ -47,11 +58,17 @@ public:
 #endif
     }
     int count() const { return mCount; }
+    // estimated memory used by the statements, walks all statements
+    StatementMemoryUsage memoryUsage() const;
+    // write memoryUsage() and the size of the string pool to the file
+    void dumpMemoryUsage(const QString& logFile) const;
 #ifdef QT_DEBUG
     void dump(const QString& logFile);
     void dumpAll(const QString& logFile);
 #endif
 private:
+    void internStrings(Statement* statement);
+    void calcMemoryUsage(const StatementMap& map, StatementMemoryUsage& usage, QSet<const void*>& countedStrings) const;
     void addMember(StatementMap& map, const PStatement& statement);
     int deleteMember(StatementMap& map, const PStatement& statement);
     void dumpStatementMap(StatementMap& map, QTextStream& out, int level);
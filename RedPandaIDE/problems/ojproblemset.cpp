@@ -20,6 +20,10 @@
 
 OJProblemCase::OJProblemCase():
     testState(ProblemCaseTestState::NotTested),
+    runningTime(0),
+    runningCpuTime(0),
+    runningMemory(0),
+    exitToResultTime(0),
     firstDiffLine(-1),
     outputLineCounts(0),
     expectedLineCounts(0)
@@ -16,6 +16,7 @@
  */
 #ifndef OJPROBLEMSET_H
 #define OJPROBLEMSET_H
+#include <QElapsedTimer>
 #include <QString>
 #include <memory>
 #include <QVector>
@@ -47,8 +48,11 @@ struct OJProblemCase {
     QString expectedOutputFileName;
     ProblemCaseTestState testState; // no persistence
     QString output; // no persistence
-    qulonglong runningTime; // no persistence
+    qulonglong runningTime; // wall time, no persistence
+    qulonglong runningCpuTime; // no persistence
     qulonglong runningMemory; // no persistence;
+    QElapsedTimer exitTimer; // started when the program exits, no persistence
+    qint64 exitToResultTime; // microseconds from the exit until the result is shown, no persistence
     int firstDiffLine; // no persistence
     int outputLineCounts; // no persistence
     int expectedLineCounts;
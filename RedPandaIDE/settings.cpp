@@ -693,6 +693,16 @@ void Settings::Editor::setMouseSelectionScrollSpeed(int newMouseSelectionScrollS
     mMouseSelectionScrollSpeed = newMouseSelectionScrollSpeed;
 }
 
+int Settings::Editor::maxUndoMemoryUsage() const
+{
+    return mMaxUndoMemoryUsage;
+}
+
+void Settings::Editor::setMaxUndoMemoryUsage(int newMaxUndoMemoryUsage)
+{
+    mMaxUndoMemoryUsage = newMaxUndoMemoryUsage;
+}
+
 bool Settings::Editor::autoDetectFileEncoding() const
 {
     return mAutoDetectFileEncoding;
@@ -1300,6 +1310,9 @@ void Settings::Editor::doSave()
     saveValue("mouse_wheel_scroll_speed", mMouseWheelScrollSpeed);
     saveValue("mouse_drag_scroll_speed",mMouseSelectionScrollSpeed);
 
+    //undo
+    saveValue("max_undo_memory_usage",mMaxUndoMemoryUsage);
+
     //right edge
     saveValue("show_right_edge_line",mShowRightEdgeLine);
     saveValue("right_edge_width",mRightEdgeWidth);
@@ -1429,6 +1442,9 @@ void Settings::Editor::doLoad()
     mMouseWheelScrollSpeed = intValue("mouse_wheel_scroll_speed", 3);
     mMouseSelectionScrollSpeed = intValue("mouse_drag_scroll_speed",10);
 
+    //undo
+    mMaxUndoMemoryUsage = intValue("max_undo_memory_usage",50);
+
 
     //right edge
     mShowRightEdgeLine = boolValue("show_right_edge_line",false);
@@ -4228,6 +4244,16 @@ void Settings::Executor::setCaseMemoryLimit(size_t newCaseMemoryLimit)
     mCaseMemoryLimit = newCaseMemoryLimit;
 }
 
+int Settings::Executor::parallelCaseCount() const
+{
+    return mParallelCaseCount;
+}
+
+void Settings::Executor::setParallelCaseCount(int newParallelCaseCount)
+{
+    mParallelCaseCount = newParallelCaseCount;
+}
+
 bool Settings::Executor::convertHTMLToTextForExpected() const
 {
     return mConvertHTMLToTextForExpected;
@@ -4352,6 +4378,7 @@ void Settings::Executor::doSave()
     saveValue("case_editor_font_only_monospaced",mCaseEditorFontOnlyMonospaced);
     saveValue("case_timeout_ms", mCaseTimeout);
     saveValue("case_memory_limit",mCaseMemoryLimit);
+    saveValue("parallel_case_count",mParallelCaseCount);
     remove("case_timeout");
     saveValue("enable_case_limit", mEnableCaseLimit);
 }
@@ -4395,6 +4422,7 @@ void Settings::Executor::doLoad()
     else
         mCaseTimeout = uintValue("case_timeout_ms", 2000); //2000ms
     mCaseMemoryLimit = uintValue("case_memory_limit",0); // kb
+    mParallelCaseCount = intValue("parallel_case_count",0);
 
     mEnableCaseLimit = boolValue("enable_case_limit", true);
     //compatibility
@@ -4709,6 +4737,26 @@ void Settings::CodeCompletion::setShareParser(bool newShareParser)
     mShareParser = newShareParser;
 }
 
+bool Settings::CodeCompletion::parseInParallel() const
+{
+    return mParseInParallel;
+}
+
+void Settings::CodeCompletion::setParseInParallel(bool newParseInParallel)
+{
+    mParseInParallel = newParseInParallel;
+}
+
+bool Settings::CodeCompletion::cacheSystemHeaderSymbols() const
+{
+    return mCacheSystemHeaderSymbols;
+}
+
+void Settings::CodeCompletion::setCacheSystemHeaderSymbols(bool newCacheSystemHeaderSymbols)
+{
+    mCacheSystemHeaderSymbols = newCacheSystemHeaderSymbols;
+}
+
 bool Settings::CodeCompletion::hideSymbolsStartsWithUnderLine() const
 {
     return mHideSymbolsStartsWithUnderLine;
@@ -4848,6 +4896,8 @@ void Settings::CodeCompletion::doSave()
     saveValue("hide_symbols_start_with_two_underline", mHideSymbolsStartsWithTwoUnderLine);
     saveValue("hide_symbols_start_with_underline", mHideSymbolsStartsWithUnderLine);
     saveValue("share_parser",mShareParser);
+    saveValue("parse_in_parallel",mParseInParallel);
+    saveValue("cache_system_header_symbols",mCacheSystemHeaderSymbols);
 }
 
 
@@ -4900,6 +4950,8 @@ void Settings::CodeCompletion::doLoad()
 //#endif
     //mClearWhenEditorHidden = boolValue("clear_when_editor_hidden",doClear);
     mShareParser = boolValue("share_parser",shouldShare);
+    mParseInParallel = boolValue("parse_in_parallel",true);
+    mCacheSystemHeaderSymbols = boolValue("cache_system_header_symbols",true);
 }
 
 Settings::CodeFormatter::CodeFormatter(Settings *settings):
@@ -350,6 +350,9 @@ public:
         int mouseSelectionScrollSpeed() const;
         void setMouseSelectionScrollSpeed(int newMouseSelectionScrollSpeed);
 
+        int maxUndoMemoryUsage() const;
+        void setMaxUndoMemoryUsage(int newMaxUndoMemoryUsage);
+
         bool autoDetectFileEncoding() const;
         void setAutoDetectFileEncoding(bool newAutoDetectFileEncoding);
 
@@ -429,6 +432,9 @@ public:
         int mMouseWheelScrollSpeed;
         int mMouseSelectionScrollSpeed;
 
+        //undo
+        int mMaxUndoMemoryUsage; // in MB
+
         //right margin
         bool mShowRightEdgeLine;
         int mRightEdgeWidth;
@@ -679,6 +685,12 @@ public:
         bool shareParser();
         void setShareParser(bool newShareParser);
 
+        bool parseInParallel() const;
+        void setParseInParallel(bool newParseInParallel);
+
+        bool cacheSystemHeaderSymbols() const;
+        void setCacheSystemHeaderSymbols(bool newCacheSystemHeaderSymbols);
+
     private:
         int mWidthInColumns;
         int mHeightInLines;
@@ -697,6 +709,8 @@ public:
         bool mHideSymbolsStartsWithUnderLine;
         //bool mClearWhenEditorHidden;
         bool mShareParser;
+        bool mParseInParallel;
+        bool mCacheSystemHeaderSymbols;
 
         // _Base interface
     protected:
@@ -942,6 +956,10 @@ public:
         size_t caseMemoryLimit() const;
         void setCaseMemoryLimit(size_t newCaseMemoryLimit);
 
+        // 0 means one case for each cpu core
+        int parallelCaseCount() const;
+        void setParallelCaseCount(int newParallelCaseCount);
+
         bool convertHTMLToTextForInput() const;
         void setConvertHTMLToTextForInput(bool newConvertHTMLToTextForInput);
 
@@ -981,6 +999,7 @@ public:
         bool mEnableCaseLimit;
         qulonglong mCaseTimeout; //ms
         qulonglong mCaseMemoryLimit; //kb
+        int mParallelCaseCount;
 
     protected:
         void doSave() override;
@@ -205,6 +205,7 @@ void CompilerSetOptionWidget::doSave()
     //update default index timestamp
     pSettings->compilerSets().setDefaultIndex(pSettings->compilerSets().defaultIndex());
     pSettings->compilerSets().saveSets();
+    pMainWindow->removeSyntaxCheckPrecompiledHeaders();
     pMainWindow->updateCompilerSet();
 }
 
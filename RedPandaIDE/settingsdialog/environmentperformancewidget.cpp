@@ -17,6 +17,7 @@
 #include "environmentperformancewidget.h"
 #include "ui_environmentperformancewidget.h"
 #include "../settings.h"
+#include "../mainwindow.h"
 
 EnvironmentPerformanceWidget::EnvironmentPerformanceWidget(const QString& name, const QString& group, QWidget *parent) :
     SettingsWidget(name,group,parent),
@@ -54,13 +55,20 @@ void EnvironmentPerformanceWidget::doLoad()
 //    }
 //#endif
     ui->chkEditorsShareParser->setChecked(pSettings->codeCompletion().shareParser());
+    ui->spinMaxUndoMemoryUsage->setValue(pSettings->editor().maxUndoMemoryUsage());
+    ui->chkParseInParallel->setChecked(pSettings->codeCompletion().parseInParallel());
+    ui->chkCacheSystemHeaderSymbols->setChecked(pSettings->codeCompletion().cacheSystemHeaderSymbols());
 }
 
 void EnvironmentPerformanceWidget::doSave()
 {
     //pSettings->codeCompletion().setClearWhenEditorHidden(ui->chkClearWhenEditorHidden->isChecked());
     pSettings->codeCompletion().setShareParser(ui->chkEditorsShareParser->isChecked());
+    pSettings->editor().setMaxUndoMemoryUsage(ui->spinMaxUndoMemoryUsage->value());
+    pSettings->codeCompletion().setParseInParallel(ui->chkParseInParallel->isChecked());
+    pSettings->codeCompletion().setCacheSystemHeaderSymbols(ui->chkCacheSystemHeaderSymbols->isChecked());
 
     pSettings->codeCompletion().save();
     pSettings->editor().save();
+    pMainWindow->updateEditorSettings();
 }
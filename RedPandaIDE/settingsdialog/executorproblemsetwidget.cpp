@@ -53,6 +53,7 @@ void ExecutorProblemSetWidget::doLoad()
 
     ui->spinCaseTimeout->setValue(pSettings->executor().caseTimeout());
     ui->spinMemoryLimit->setValue(pSettings->executor().caseMemoryLimit());
+    ui->spinParallelCases->setValue(pSettings->executor().parallelCaseCount());
 }
 
 void ExecutorProblemSetWidget::doSave()
@@ -70,6 +71,7 @@ void ExecutorProblemSetWidget::doSave()
     pSettings->executor().setEnableCaseLimit(ui->grpEnableTimeout->isChecked());
     pSettings->executor().setCaseTimeout(ui->spinCaseTimeout->value());
     pSettings->executor().setCaseMemoryLimit(ui->spinMemoryLimit->value());
+    pSettings->executor().setParallelCaseCount(ui->spinParallelCases->value());
 
     pSettings->executor().save();
     pMainWindow->applySettings();
@@ -72,6 +72,7 @@
 #define RES_EXT "res"
 #define H_EXT "h"
 #define OBJ_EXT "o"
+#define DEP_EXT "d"
 #define LST_EXT "lst"
 #define DEF_EXT "def"
 #define LIB_EXT "a"
@@ -92,6 +93,7 @@
 #define DEV_DEBUGGER_FILE "debugger.json"
 #define DEV_HISTORY_FILE "history.json"
 #define DEV_PROBLEM_SET_FILE "problemset.json"
+#define DEV_SYNTAX_CHECK_PCH_DIR "syntaxcheckpch"
 
 
 #ifdef Q_OS_WIN
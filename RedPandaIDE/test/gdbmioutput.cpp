@@ -0,0 +1,116 @@
+#include <cstdlib>
+
+#include <QByteArray>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QString>
+
+#include "debugger/gdbmiresultparser.h"
+
+// Feeds the output of a simulated debug session through the framing
+// (findOutputEnd() and splitGDBMIRecords()) and parsing used by GDBMIDebuggerClient,
+// and reports the throughput.
+// usage: bench-gdbmi-output [steps] [variables per step]
+
+const int chunkSize = 4096; // a pipe read
+
+int parsedPrompts = 0;
+int parsedStops = 0;
+int parsedVariables = 0;
+
+void fail(const QString& msg)
+{
+    qDebug() << "Error:" << msg;
+    exit(1);
+}
+
+QByteArray stepOutput(int token, int variables)
+{
+    QByteArray output;
+    output += QByteArray::number(token) + "^running\n";
+    output += "*running,thread-id=\"all\"\n";
+    output += "(gdb) \n";
+    output += "*stopped,reason=\"end-stepping-range\",frame={addr=\"0x0000000000401136\","
+              "func=\"main\",args=[],file=\"main.c\",fullname=\"/tmp/main.c\",line=\"12\",arch=\"i386:x86-64\"},"
+              "thread-id=\"1\",stopped-threads=\"all\",core=\"3\"\n";
+    output += "(gdb) \n";
+    output += QByteArray::number(token+1) + "^done,variables=[";
+    for (int i=0;i<variables;i++) {
+        if (i>0)
+            output += ',';
+        output += "{name=\"var" + QByteArray::number(i)
+                + "\",value=\"{x = " + QByteArray::number(i)
+                + ", y = 0x7fffffffe3a0, s = \\\"some text\\\"}\"}";
+    }
+    output += "]\n";
+    output += "(gdb) \n";
+    return output;
+}
+
+void processOutput(QByteArray& buffer, int length, GDBMIResultParser& parser)
+{
+    splitGDBMIRecords(buffer, length, [&parser](const QByteArray&, const QByteArray& line) {
+        if (line.isEmpty())
+            return;
+        if (line.startsWith("(gdb)")) {
+            parsedPrompts++;
+        } else if (line.startsWith("^done,")) {
+            GDBMIResultType type;
+            GDBMIResultParser::ParseObject multiValues;
+            if (!parser.parse(line.mid(6), "-stack-list-variables", type, multiValues))
+                fail("can't parse result record");
+            parsedVariables += multiValues["variables"].array().count();
+        } else if (line.startsWith("*stopped")) {
+            QByteArray result;
+            GDBMIResultParser::ParseObject multiValues;
+            if (!parser.parseAsyncResult(line, result, multiValues))
+                fail("can't parse async record");
+            if (multiValues["frame"].object()["line"].intValue()!=12)
+                fail("wrong frame line");
+            parsedStops++;
+        }
+    });
+}
+
+int main(int argc, char** argv)
+{
+    int steps = argc>1 ? atoi(argv[1]) : 2000;
+    int variables = argc>2 ? atoi(argv[2]) : 500;
+
+    QByteArray output;
+    for (int i=0;i<steps;i++)
+        output += stepOutput(i*2, variables);
+
+    GDBMIResultParser parser;
+    QByteArray buffer;
+    buffer.reserve(64*1024);
+    int scanPos = 0;
+    QElapsedTimer timer;
+    timer.start();
+    for (int pos=0;pos<output.length();pos+=chunkSize) {
+        buffer.append(output.constData()+pos, std::min(chunkSize, (int)output.length()-pos));
+        int outputEnd = GDBMIResultParser::findOutputEnd(buffer, scanPos);
+        if (outputEnd>0) {
+            processOutput(buffer, outputEnd, parser);
+            buffer.remove(0, outputEnd);
+            scanPos -= outputEnd;
+        }
+    }
+    qint64 elapsed = std::max<qint64>(timer.nsecsElapsed(), 1);
+
+    if (!buffer.isEmpty())
+        fail("output left unprocessed");
+    if (parsedPrompts != steps*3)
+        fail(QString("%1 prompts parsed, %2 expected").arg(parsedPrompts).arg(steps*3));
+    if (parsedStops != steps)
+        fail(QString("%1 stops parsed, %2 expected").arg(parsedStops).arg(steps));
+    if (parsedVariables != steps*variables)
+        fail(QString("%1 variables parsed, %2 expected").arg(parsedVariables).arg(steps*variables));
+
+    qDebug() << steps << "steps," << variables << "variables per step,"
+             << output.length()/1024 << "KB of output";
+    qDebug() << "total" << elapsed/1000000 << "ms,"
+             << (double)output.length()*1000/elapsed << "MB/s,"
+             << elapsed/steps/1000 << "us per step";
+    return 0;
+}
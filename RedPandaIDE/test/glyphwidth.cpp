@@ -0,0 +1,107 @@
+#include <cstdlib>
+
+#include <QByteArray>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFontDatabase>
+#include <QFontMetrics>
+#include <QGuiApplication>
+#include <QString>
+#include <QTemporaryDir>
+
+#include "qsynedit/document.h"
+
+// Loads a large generated source file into a QSynedit::Document and calculates
+// the widths of all lines, which is what opening or reflowing the file costs.
+// The uncached QFontMetrics::horizontalAdvance() per glyph is timed as the baseline.
+// usage: bench-glyph-width [lines]
+// Set QT_QPA_PLATFORM=offscreen to run it without a display.
+
+void fail(const QString& msg)
+{
+    qDebug() << "Error:" << msg;
+    exit(1);
+}
+
+QByteArray generateSource(int lines, bool withNonAscii)
+{
+    QByteArray content;
+    content.reserve(lines*48);
+    for (int i=0;i<lines;i++) {
+        switch(i%4) {
+        case 0:
+            content += "static const int table_" + QByteArray::number(i) + "[] = {1, 2, 3, 4};\n";
+            break;
+        case 1:
+            content += "    result += compute(value_" + QByteArray::number(i) + ", 0x7f, \"text\");\n";
+            break;
+        case 2:
+            if (withNonAscii)
+                content += "    // \xe8\xae\xa1\xe7\xae\x97\xe7\xbb\x93\xe6\x9e\x9c " + QByteArray::number(i) + "\n";
+            else
+                content += "    // compute the result " + QByteArray::number(i) + "\n";
+            break;
+        default:
+            content += "\tif (result > limit) return -1;\n";
+        }
+    }
+    return content;
+}
+
+qint64 baselineWidths(const QSynedit::Document& document, const QFont& font)
+{
+    // measure each glyph with QFontMetrics, as it's done without the width cache
+    QFontMetrics metrics(font);
+    qint64 total = 0;
+    for (int i=0;i<document.count();i++) {
+        QString s = document.getLine(i);
+        for (int j=0;j<s.length();j++) {
+            total += metrics.horizontalAdvance(s.mid(j,1));
+        }
+    }
+    return total;
+}
+
+void bench(const QString& name, const QByteArray& content, const QFont& font)
+{
+    QTemporaryDir dir;
+    if (!dir.isValid())
+        fail("can't create temp dir");
+    QString fileName = dir.filePath("generated.c");
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) || file.write(content)!=content.size())
+        fail("can't write the source file");
+    file.close();
+
+    QSynedit::Document document(font);
+    QByteArray realEncoding;
+    QElapsedTimer timer;
+    timer.start();
+    document.loadFromFile(fileName, ENCODING_UTF8, realEncoding);
+    qint64 loadTime = timer.restart();
+    qint64 total = 0;
+    for (int i=0;i<document.count();i++)
+        total += document.lineWidth(i);
+    qint64 widthTime = timer.restart();
+    baselineWidths(document, font);
+    qint64 baselineTime = timer.elapsed();
+    if (total<=0)
+        fail("no width calculated");
+
+    qDebug() << name << ":" << document.count() << "lines,"
+             << "load" << loadTime << "ms,"
+             << "widths" << widthTime << "ms,"
+             << "uncached glyph widths" << baselineTime << "ms";
+}
+
+int main(int argc, char** argv)
+{
+    QGuiApplication app(argc, argv);
+    int lines = argc>1 ? atoi(argv[1]) : 200000;
+    QFont font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+
+    bench("ascii", generateSource(lines, false), font);
+    bench("non-ascii comments", generateSource(lines, true), font);
+    return 0;
+}
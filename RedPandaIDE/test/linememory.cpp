@@ -0,0 +1,136 @@
+#include <cstdlib>
+
+#include <QByteArray>
+#include <QDebug>
+#include <QFile>
+#include <QFontDatabase>
+#include <QGuiApplication>
+#include <QList>
+#include <QString>
+#include <QTemporaryDir>
+#include <QVector>
+
+#include "qsynedit/document.h"
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+
+// Reports the memory used by each line of a QSynedit::Document, when the file
+// is loaded, and after the widths of all lines are calculated (as if all of them
+// were displayed). The glyph start lists every line used to build when loaded
+// are built for all lines at the end, as the baseline.
+// Memory is the resident size of the process, so run it with nothing else loaded.
+// usage: bench-line-memory [lines] [non-ascii]
+// Set QT_QPA_PLATFORM=offscreen to run it without a display.
+
+void fail(const QString& msg)
+{
+    qDebug() << "Error:" << msg;
+    exit(1);
+}
+
+qint64 memoryUsage()
+{
+#ifdef Q_OS_WIN
+    PROCESS_MEMORY_COUNTERS counter;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counter, sizeof(counter)))
+        return counter.WorkingSetSize;
+    return 0;
+#else
+    QFile file("/proc/self/statm");
+    if (!file.open(QFile::ReadOnly))
+        return 0;
+    QList<QByteArray> fields = file.readAll().split(' ');
+    if (fields.count()<2)
+        return 0;
+    return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+#endif
+}
+
+QByteArray generateSource(int lines, bool withNonAscii)
+{
+    QByteArray content;
+    content.reserve(lines*48);
+    for (int i=0;i<lines;i++) {
+        switch(i%4) {
+        case 0:
+            content += "static const int table_" + QByteArray::number(i) + "[] = {1, 2, 3, 4};\n";
+            break;
+        case 1:
+            content += "    result += compute(value_" + QByteArray::number(i) + ", 0x7f, \"text\");\n";
+            break;
+        case 2:
+            if (withNonAscii)
+                content += "    // \xe8\xae\xa1\xe7\xae\x97\xe7\xbb\x93\xe6\x9e\x9c " + QByteArray::number(i) + "\n";
+            else
+                content += "    // compute the result " + QByteArray::number(i) + "\n";
+            break;
+        default:
+            content += "\tif (result > limit) return -1;\n";
+        }
+    }
+    return content;
+}
+
+void report(const QString& stage, qint64 bytes, int lines, qint64 textBytes)
+{
+    qDebug() << stage << ":" << bytes/lines << "bytes per line,"
+             << (bytes-textBytes)/lines << "bytes per line besides the text";
+}
+
+int main(int argc, char** argv)
+{
+    QGuiApplication app(argc, argv);
+    int lines = argc>1 ? atoi(argv[1]) : 500000;
+    bool withNonAscii = argc>2 && QByteArray(argv[2])=="non-ascii";
+    if (lines<=0)
+        fail("the line count must be positive");
+    QFont font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+
+    QTemporaryDir dir;
+    if (!dir.isValid())
+        fail("can't create temp dir");
+    QString fileName = dir.filePath("generated.c");
+    {
+        QByteArray content = generateSource(lines, withNonAscii);
+        QFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly) || file.write(content)!=content.size())
+            fail("can't write the source file");
+    }
+
+    QSynedit::Document document(font);
+    QByteArray realEncoding;
+    qint64 start = memoryUsage();
+    if (start<=0)
+        fail("can't get the memory usage of the process");
+    document.loadFromFile(fileName, ENCODING_UTF8, realEncoding);
+    qint64 loaded = memoryUsage();
+    if (document.count()!=lines)
+        fail(QString("%1 lines are loaded, not %2").arg(document.count()).arg(lines));
+
+    // utf-16 chars held by the QStrings
+    qint64 textBytes = 0;
+    for (int i=0;i<document.count();i++)
+        textBytes += document.getLine(i).length() * (qint64)sizeof(QChar);
+
+    for (int i=0;i<document.count();i++)
+        document.lineWidth(i);
+    qint64 measured = memoryUsage();
+
+    QVector<QList<int>> glyphStartCharLists;
+    glyphStartCharLists.reserve(document.count());
+    for (int i=0;i<document.count();i++)
+        glyphStartCharLists.append(QSynedit::calcGlyphStartCharList(document.getLine(i)));
+    qint64 eager = memoryUsage();
+
+    qDebug() << (withNonAscii ? "non-ascii comments" : "ascii") << ":" << lines << "lines,"
+             << textBytes/lines << "bytes of text per line";
+    report("loaded", loaded-start, lines, textBytes);
+    report("widths calculated", measured-start, lines, textBytes);
+    report("with glyph start lists built for all lines", eager-start, lines, textBytes);
+    return 0;
+}
@@ -0,0 +1,145 @@
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QTemporaryDir>
+
+#include "parser/cppparser.h"
+#include "test/parserbench.h"
+
+// Parses all files of a project with CppParser::parseFileList, serially and in parallel,
+// and reports files/sec of both. Fails if the statements of the two parses differ.
+// If no dir is given, a project of generated source files sharing some headers is parsed.
+// usage: bench-parse-files [dir]
+
+const int generatedHeaders = 20;
+const int generatedSources = 200;
+
+QStringList generateProject(const QString& dir)
+{
+    QStringList files;
+    for (int i=0;i<generatedHeaders;i++) {
+        QByteArray content;
+        content += "#ifndef MODULE_" + QByteArray::number(i) + "_H\n";
+        content += "#define MODULE_" + QByteArray::number(i) + "_H\n";
+        content += "#include <string>\n#include <vector>\n";
+        if (i>0)
+            content += "#include \"module" + QByteArray::number(i-1) + ".h\"\n";
+        content += "namespace module" + QByteArray::number(i) + " {\n";
+        content += "class Item" + QByteArray::number(i);
+        if (i>0)
+            content += ": public module" + QByteArray::number(i-1) + "::Item" + QByteArray::number(i-1);
+        content += " {\npublic:\n";
+        content += "    int value" + QByteArray::number(i) + "() const;\n";
+        content += "    std::string name;\n";
+        content += "};\n";
+        content += "std::vector<Item" + QByteArray::number(i) + "> loadItems" + QByteArray::number(i) + "();\n";
+        content += "}\n#endif\n";
+        QString fileName = QDir(dir).filePath(QString("module%1.h").arg(i));
+        writeFile(fileName, content);
+        files.append(fileName);
+    }
+    for (int i=0;i<generatedSources;i++) {
+        int header = i % generatedHeaders;
+        QByteArray content;
+        content += "#include <map>\n#include \"module" + QByteArray::number(header) + ".h\"\n";
+        content += "namespace module" + QByteArray::number(header) + " {\n";
+        if (i<generatedHeaders) {
+            content += "int Item" + QByteArray::number(header) + "::value"
+                    + QByteArray::number(header) + "() const { return name.length(); }\n";
+        }
+        content += "}\n";
+        content += "struct Record" + QByteArray::number(i) + " {\n";
+        content += "    std::map<std::string, int> counts;\n";
+        content += "    module" + QByteArray::number(header) + "::Item" + QByteArray::number(header) + " item;\n";
+        content += "};\n";
+        content += "int process" + QByteArray::number(i) + "(Record" + QByteArray::number(i) + "& record) {\n";
+        content += "    int total = 0;\n";
+        content += "    for (auto& pair : record.counts) total += pair.second;\n";
+        content += "    return total + record.item.value" + QByteArray::number(header) + "();\n";
+        content += "}\n";
+        QString fileName = QDir(dir).filePath(QString("source%1.cpp").arg(i));
+        writeFile(fileName, content);
+        files.append(fileName);
+    }
+    return files;
+}
+
+QStringList findSourceFiles(const QString& dir)
+{
+    QStringList files;
+    QDirIterator it(dir, {"*.c", "*.cpp", "*.cc", "*.cxx", "*.h", "*.hpp"},
+                    QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext())
+        files.append(QFileInfo(it.next()).absoluteFilePath());
+    return files;
+}
+
+// statements as "fullName kind file:line", sorted.
+// Anonymous statements are numbered by the parser (or worker) which adds them, so the numbers are removed.
+void collectStatements(const StatementModel& model, const PStatement& parent, QStringList& result)
+{
+    static const QRegularExpression anonymousId("__STATEMENT__\\d+");
+    foreach (const PStatement& statement, model.childrenStatements(parent)) {
+        QString s = QString("%1 %2 %3:%4").arg(statement->fullName).arg((int)statement->kind)
+                .arg(statement->fileName).arg(statement->line);
+        s.replace(anonymousId, "__STATEMENT__");
+        result.append(s);
+        collectStatements(model, statement, result);
+    }
+}
+
+QStringList bench(const QString& name, const QStringList& files, bool parallel)
+{
+    CppParser parser;
+    setupParser(parser);
+    parser.setParallelParsing(parallel);
+    foreach (const QString& file, files)
+        parser.addProjectFile(file, true);
+    QElapsedTimer timer;
+    timer.start();
+    parser.parseFileList(false);
+    qint64 elapsed = std::max<qint64>(timer.elapsed(), 1);
+    QStringList statements;
+    collectStatements(parser.statementList(), PStatement(), statements);
+    if (statements.isEmpty())
+        fail(QString("no statement is parsed in %1 mode").arg(name));
+    qDebug() << name << ":" << files.count() << "files in" << elapsed << "ms,"
+             << files.count()*1000.0/elapsed << "files/s,"
+             << statements.count() << "statements";
+    statements.sort();
+    return statements;
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QTemporaryDir dir;
+    QStringList files;
+    if (argc>1) {
+        files = findSourceFiles(QString::fromLocal8Bit(argv[1]));
+    } else {
+        if (!dir.isValid())
+            fail("can't create temp dir");
+        files = generateProject(dir.path());
+    }
+    if (files.isEmpty())
+        fail("no source files found");
+
+    QStringList serialStatements = bench("serial", files, false);
+    QStringList parallelStatements = bench("parallel", files, true);
+    if (serialStatements!=parallelStatements) {
+        int i = 0;
+        while (i<serialStatements.count() && i<parallelStatements.count()
+               && serialStatements[i]==parallelStatements[i])
+            i++;
+        fail(QString("statements differ from the serial parse (%1 vs %2), first difference: %3 / %4")
+             .arg(serialStatements.count()).arg(parallelStatements.count())
+             .arg(serialStatements.value(i), parallelStatements.value(i)));
+    }
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include "parserbench.h"
+
+#include <cstdlib>
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QProcess>
+#include <QProcessEnvironment>
+
+#include "parser/cppparser.h"
+#include "parser/cpppreprocessor.h"
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+static QByteArray runCompiler(const QStringList& arguments)
+{
+    QString compiler = QProcessEnvironment::systemEnvironment().value("CXX", "g++");
+    QProcess process;
+    process.setProcessChannelMode(QProcess::MergedChannels);
+    process.start(compiler, arguments);
+    process.closeWriteChannel();
+    if (!process.waitForFinished(30000) || process.exitCode()!=0)
+        fail(QString("can't run %1").arg(compiler));
+    return process.readAll();
+}
+
+QStringList compilerIncludeDirs()
+{
+    QStringList dirs;
+    QByteArray output = runCompiler({"-E", "-v", "-x", "c++", "-"});
+    bool inList = false;
+    foreach (const QByteArray& line, output.split('\n')) {
+        QString s = QString::fromLocal8Bit(line).trimmed();
+        if (s.startsWith("#include <...> search starts here:")) {
+            inList = true;
+        } else if (s.startsWith("End of search list.")) {
+            break;
+        } else if (inList) {
+            s.remove(" (framework directory)");
+            dirs.append(QDir::cleanPath(s));
+        }
+    }
+    if (dirs.isEmpty())
+        fail("can't find the include dirs of the compiler");
+    return dirs;
+}
+
+QStringList compilerDefines()
+{
+    QStringList defines;
+    QByteArray output = runCompiler({"-dM", "-E", "-x", "c++", "-"});
+    foreach (const QByteArray& line, output.split('\n')) {
+        QString s = QString::fromLocal8Bit(line).trimmed();
+        if (s.startsWith("#define"))
+            defines.append(s);
+    }
+    return defines;
+}
+
+void setupParser(CppParser &parser)
+{
+    parser.setEnabled(true);
+    parser.setParseGlobalHeaders(true);
+    parser.setParseLocalHeaders(true);
+    parser.setSymbolCacheDir(QString());
+    foreach (const QString& dir, compilerIncludeDirs())
+        parser.addIncludePath(dir);
+    foreach (const QString& define, compilerDefines())
+        parser.addHardDefineByLine(define);
+    parser.parseHardDefines();
+}
+
+void setupPreprocessor(CppPreprocessor &preprocessor)
+{
+    preprocessor.setScanOptions(true, true);
+    foreach (const QString& dir, compilerIncludeDirs())
+        preprocessor.addIncludePath(dir);
+    foreach (const QString& define, compilerDefines())
+        preprocessor.addHardDefineByLine(define.mid(1).trimmed());
+}
+
+qint64 peakMemoryUsage()
+{
+#ifdef Q_OS_WIN
+    PROCESS_MEMORY_COUNTERS counter;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counter, sizeof(counter)))
+        return counter.PeakWorkingSetSize;
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage)!=0)
+        return 0;
+#ifdef Q_OS_MACOS
+    return usage.ru_maxrss;
+#else
+    return (qint64)usage.ru_maxrss * 1024; // kb to bytes
+#endif
+#endif
+}
+
+void writeFile(const QString &fileName, const QByteArray &content)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) || file.write(content)!=content.size())
+        fail(QString("can't write %1").arg(fileName));
+}
+
+void fail(const QString &msg)
+{
+    qDebug() << "Error:" << msg;
+    exit(1);
+}
@@ -0,0 +1,25 @@
+#ifndef PARSERBENCH_H
+#define PARSERBENCH_H
+
+#include <QString>
+#include <QStringList>
+
+class CppParser;
+class CppPreprocessor;
+
+// Helpers shared by the parser benchmarks.
+// The compiler is given by the CXX environment variable, g++ by default.
+
+// include dirs searched by the compiler for <> includes
+QStringList compilerIncludeDirs();
+// predefined macros of the compiler, as "#define" lines
+QStringList compilerDefines();
+// configure the parser like the IDE does for the compiler
+void setupParser(CppParser& parser);
+void setupPreprocessor(CppPreprocessor& preprocessor);
+// peak working set of the process in bytes, 0 if unknown
+qint64 peakMemoryUsage();
+void writeFile(const QString& fileName, const QByteArray& content);
+void fail(const QString& msg);
+
+#endif // PARSERBENCH_H
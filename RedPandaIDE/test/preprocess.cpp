@@ -0,0 +1,71 @@
+#include <cstdlib>
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+
+#include "parser/cpppreprocessor.h"
+#include "test/parserbench.h"
+
+// Reports the preprocessing throughput on the system headers,
+// and on a generated header which nests function-like macros.
+// usage: bench-preprocessor [rounds]
+
+const int macroDepth = 15;
+const int macroLines = 5000;
+
+QByteArray generateMacroSource()
+{
+    QByteArray content;
+    content += "#define CAT_0(a,b) a##b\n";
+    for (int i=1;i<macroDepth;i++) {
+        content += "#define CAT_" + QByteArray::number(i) + "(a,b) CAT_"
+                + QByteArray::number(i-1) + "(a,b)\n";
+    }
+    content += "#define PAIR(a,b) CAT_" + QByteArray::number(macroDepth-1) + "(a,b), "
+            "CAT_" + QByteArray::number(macroDepth-1) + "(b,a)\n";
+    for (int i=0;i<macroLines;i++) {
+        content += "int v" + QByteArray::number(i) + "[] = { PAIR(x, "
+                + QByteArray::number(i) + ") };\n";
+    }
+    return content;
+}
+
+void bench(const QString& name, const QString& fileName, int rounds)
+{
+    qint64 elapsed = 0;
+    int lines = 0;
+    for (int i=0;i<rounds;i++) {
+        CppPreprocessor preprocessor;
+        setupPreprocessor(preprocessor);
+        QElapsedTimer timer;
+        timer.start();
+        preprocessor.preprocess(fileName);
+        elapsed += timer.nsecsElapsed();
+        lines = preprocessor.result().count();
+    }
+    if (lines<=2)
+        fail(QString("nothing is preprocessed for %1").arg(name));
+    elapsed = std::max<qint64>(elapsed/rounds, 1);
+    qDebug() << name << ":" << lines << "lines in" << elapsed/1000000 << "ms,"
+             << (qint64)lines*1000000000/elapsed << "lines/s";
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    int rounds = argc>1 ? std::max(atoi(argv[1]), 1) : 5;
+
+    QTemporaryDir dir;
+    if (!dir.isValid())
+        fail("can't create temp dir");
+    QString systemFileName = dir.filePath("system.cpp");
+    writeFile(systemFileName, "#include <bits/stdc++.h>\n");
+    QString macroFileName = dir.filePath("macros.cpp");
+    writeFile(macroFileName, generateMacroSource());
+
+    bench("system headers", systemFileName, rounds);
+    bench("nested macros", macroFileName, rounds);
+    return 0;
+}
@@ -0,0 +1,185 @@
+#include <QCoreApplication>
+#include <QDebug>
+#include <QTemporaryDir>
+
+#include "parser/cppparser.h"
+#include "test/parserbench.h"
+
+// Checks that CppParser::parseFile() only reparses the edited function body
+// when all changes are in it, and that it gives the same symbols as a full reparse.
+// A full reparse creates new statements for the whole file, so it's detected by
+// the statement of class Counter being replaced.
+
+int testIndex = 0;
+QString testName;
+
+const QByteArray source =
+        "class Counter {\n"                                     // 1
+        "public:\n"                                             // 2
+        "    Counter(int value);\n"                             // 3
+        "    auto twice() const -> int;\n"                      // 4
+        "    int sum(int n);\n"                                 // 5
+        "private:\n"                                            // 6
+        "    int mValue;\n"                                     // 7
+        "    int mStep;\n"                                      // 8
+        "};\n"                                                  // 9
+        "Counter::Counter(int value) : mValue{value}, mStep(1) {\n" // 10
+        "    int first = value;\n"                              // 11
+        "}\n"                                                   // 12
+        "auto Counter::twice() const -> int {\n"                // 13
+        "    int doubled = mValue * 2;\n"                       // 14
+        "    return doubled;\n"                                 // 15
+        "}\n"                                                   // 16
+        "int Counter::sum(int n) {\n"                           // 17
+        "    int total = 0;\n"                                  // 18
+        "    for (int i=0;i<n;i++)\n"                           // 19
+        "        total += mStep;\n"                             // 20
+        "    return total;\n"                                   // 21
+        "}\n"                                                   // 22
+        "int after() {\n"                                       // 23
+        "    return 0;\n"                                       // 24
+        "}\n";                                                  // 25
+
+void check(bool condition, const QString& msg)
+{
+    if (!condition)
+        fail(QString("test %1 %2: %3").arg(testIndex).arg(testName, msg));
+}
+
+PStatement findStatement(CppParser& parser, const QString& fullName)
+{
+    PStatement statement = parser.findStatement(fullName);
+    check(statement!=nullptr, QString("%1 is not found").arg(fullName));
+    return statement;
+}
+
+void checkLocal(CppParser& parser, const QString& fileName, const QString& name, int line)
+{
+    PStatement statement = parser.findStatementOf(fileName, name, line);
+    check(statement!=nullptr, QString("%1 is not found at line %2").arg(name).arg(line));
+    check(statement->line==line, QString("%1 is at line %2, not %3")
+          .arg(name).arg(statement->line).arg(line));
+}
+
+void checkLine(CppParser& parser, const QString& fullName, int line)
+{
+    PStatement statement = findStatement(parser, fullName);
+    check(statement->definitionLine==line, QString("%1 is at line %2, not %3")
+          .arg(fullName).arg(statement->definitionLine).arg(line));
+}
+
+// parse the source, edit it and parse it again.
+// Returns whether only a function body is reparsed
+bool reparse(CppParser& parser, const QString& fileName, const QByteArray& newSource)
+{
+    parser.invalidateFile(fileName);
+    writeFile(fileName, source);
+    parser.parseFile(fileName, false, false, false);
+    PStatement counter = findStatement(parser, "Counter");
+    writeFile(fileName, newSource);
+    parser.parseFile(fileName, false, false, false);
+    return findStatement(parser, "Counter")==counter;
+}
+
+void startTest(const QString& name)
+{
+    ++testIndex;
+    testName = name;
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QTemporaryDir dir;
+    if (!dir.isValid())
+        fail("can't create temp dir");
+    QString fileName = dir.filePath("counter.cpp");
+
+    CppParser parser;
+    parser.setEnabled(true);
+    parser.setSymbolCacheDir(QString());
+
+    startTest("add a line in a function body");
+    {
+        QByteArray newSource = source;
+        newSource.replace("    int total = 0;\n", "    int total = 0;\n    int extra = 2;\n");
+        check(reparse(parser, fileName, newSource), "the whole file is reparsed");
+        checkLocal(parser, fileName, "total", 18);
+        checkLocal(parser, fileName, "extra", 19);
+        checkLocal(parser, fileName, "i", 20);
+        checkLine(parser, "after", 24);
+    }
+
+    startTest("remove a line from a function body");
+    {
+        QByteArray newSource = source;
+        newSource.replace("    int total = 0;\n", "");
+        check(reparse(parser, fileName, newSource), "the whole file is reparsed");
+        check(parser.findStatementOf(fileName, "total", 18)==nullptr, "total is not removed");
+        checkLocal(parser, fileName, "i", 18);
+        checkLine(parser, "after", 22);
+    }
+
+    startTest("change a constructor with an initializer list");
+    {
+        QByteArray newSource = source;
+        newSource.replace("    int first = value;\n", "    int second = value;\n");
+        check(reparse(parser, fileName, newSource), "the whole file is reparsed");
+        check(parser.findStatementOf(fileName, "first", 11)==nullptr, "first is not removed");
+        checkLocal(parser, fileName, "second", 11);
+        checkLine(parser, "Counter::twice", 13);
+    }
+
+    startTest("change a function with a trailing return type");
+    {
+        QByteArray newSource = source;
+        newSource.replace("    int doubled = mValue * 2;\n",
+                          "    int base = mValue;\n    int doubled = base * 2;\n");
+        check(reparse(parser, fileName, newSource), "the whole file is reparsed");
+        checkLocal(parser, fileName, "base", 14);
+        checkLocal(parser, fileName, "doubled", 15);
+        checkLine(parser, "Counter::sum", 18);
+    }
+
+    startTest("change outside of function bodies");
+    {
+        QByteArray newSource = source;
+        newSource.replace("int after() {\n", "int global;\nint after() {\n");
+        check(!reparse(parser, fileName, newSource), "only a function body is reparsed");
+        checkLine(parser, "global", 23);
+        checkLine(parser, "after", 24);
+    }
+
+    startTest("change a class body");
+    {
+        QByteArray newSource = source;
+        newSource.replace("    int mStep;\n", "    int mStep;\n    int mLimit;\n");
+        check(!reparse(parser, fileName, newSource), "only a function body is reparsed");
+        findStatement(parser, "Counter::mLimit");
+        checkLine(parser, "Counter::sum", 18);
+    }
+
+    startTest("change a function header");
+    {
+        QByteArray newSource = source;
+        newSource.replace("int Counter::sum(int n) {\n", "int Counter::sum(int count) {\n");
+        check(!reparse(parser, fileName, newSource), "only a function body is reparsed");
+    }
+
+    startTest("add a preprocessor directive in a function body");
+    {
+        QByteArray newSource = source;
+        newSource.replace("    return 0;\n", "#define ZERO 0\n    return ZERO;\n");
+        check(!reparse(parser, fileName, newSource), "only a function body is reparsed");
+    }
+
+    startTest("keep the content unchanged");
+    {
+        check(!reparse(parser, fileName, source), "the file is not reparsed");
+        checkLocal(parser, fileName, "total", 18);
+    }
+
+    qDebug() << testIndex << "tests passed";
+    return 0;
+}
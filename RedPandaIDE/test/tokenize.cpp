@@ -0,0 +1,66 @@
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+
+#include "parser/cppparser.h"
+#include "parser/cpppreprocessor.h"
+#include "parser/cpptokenizer.h"
+#include "test/parserbench.h"
+
+// Tokenizes and parses a file including <bits/stdc++.h>, and reports the time
+// and the peak memory used.
+// The memory used by the statements is written to the log file if it's given.
+// usage: bench-parser [header] [memory usage log]
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    QString header = argc>1 ? QString::fromLocal8Bit(argv[1]) : "bits/stdc++.h";
+
+    QTemporaryDir dir;
+    if (!dir.isValid())
+        fail("can't create temp dir");
+    QString fileName = dir.filePath("main.cpp");
+    writeFile(fileName, QString("#include <%1>\nint main() { return 0; }\n").arg(header).toLocal8Bit());
+
+    QElapsedTimer timer;
+    qint64 preprocessTime, tokenizeTime;
+    int lines, tokens, tokenTexts;
+    {
+        CppPreprocessor preprocessor;
+        setupPreprocessor(preprocessor);
+        timer.start();
+        preprocessor.preprocess(fileName);
+        preprocessTime = timer.restart();
+        lines = preprocessor.result().count();
+        CppTokenizer tokenizer;
+        tokenizer.tokenize(preprocessor.result());
+        tokenizeTime = timer.elapsed();
+        tokens = tokenizer.tokenCount();
+        tokenTexts = tokenizer.tokenTextCount();
+    }
+    if (tokens==0)
+        fail(QString("%1 is not found").arg(header));
+
+    CppParser parser;
+    setupParser(parser);
+    timer.restart();
+    parser.parseFile(fileName, false, false, false);
+    qint64 parseTime = timer.elapsed();
+    if (parser.statementList().count()==0)
+        fail("no statement is parsed");
+
+    qDebug() << header << ":" << lines << "preprocessed lines,"
+             << tokens << "tokens," << tokenTexts << "token texts";
+    qDebug() << "preprocess" << preprocessTime << "ms,"
+             << "tokenize" << tokenizeTime << "ms,"
+             << "preprocess + tokenize + parse" << parseTime << "ms,"
+             << parser.statementList().count() << "statements";
+    qDebug() << "peak memory" << peakMemoryUsage()/1024/1024 << "MB";
+    qDebug() << "string pool" << StringPool::count() << "strings,"
+             << StringPool::memoryUsage()/1024 << "KB";
+    if (argc>2)
+        parser.statementList().dumpMemoryUsage(QString::fromLocal8Bit(argv[2]));
+    return 0;
+}
@@ -265,6 +265,11 @@ void resetCppParser(std::shared_ptr<CppParser> parser, int compilerSetIndex)
     parser->setEnabled(true);
     parser->setParseGlobalHeaders(true);
     parser->setParseLocalHeaders(true);
+    parser->setParallelParsing(pSettings->codeCompletion().parseInParallel());
+    if (pSettings->codeCompletion().cacheSystemHeaderSymbols())
+        parser->setSymbolCacheDir(includeTrailingPathDelimiter(pSettings->dirs().config())+"symbolcache");
+    else
+        parser->setSymbolCacheDir(QString());
 
     // Set options depending on the current compiler set
     if (compilerSetIndex<0) {
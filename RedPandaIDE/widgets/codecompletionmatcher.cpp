@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "codecompletionmatcher.h"
+
+CodeCompletionMatcher::CodeCompletionMatcher():
+    mHasLastMatches{false},
+    mLastIgnoreCase{false},
+    mLastHideTwoUnderline{false},
+    mLastHideUnderline{false}
+{
+}
+
+void CodeCompletionMatcher::setCandidates(const StatementList &statements)
+{
+    clear();
+    mStatements = statements;
+    mFoldedCommands.reserve(statements.count());
+    mCharBags.reserve(statements.count());
+    foreach (const PStatement& statement, statements) {
+        QString folded = foldCase(statement->command);
+        mCharBags.append(calcCharBag(folded));
+        mFoldedCommands.append(folded);
+    }
+    mMatches.reserve(statements.count());
+    mPreviousMatches.reserve(statements.count());
+}
+
+void CodeCompletionMatcher::clear()
+{
+    mStatements.clear();
+    mFoldedCommands.clear();
+    mCharBags.clear();
+    mMatches.clear();
+    mPreviousMatches.clear();
+    mHasLastMatches = false;
+    mLastPhrase.clear();
+}
+
+QVector<CodeCompletionMatch> &CodeCompletionMatcher::match(const QString &phrase, bool ignoreCase, bool hideTwoUnderline, bool hideUnderline)
+{
+    QString foldedPhrase = foldCase(phrase);
+    quint64 phraseBag = calcCharBag(foldedPhrase);
+    CodeCompletionMatch result;
+    if (mHasLastMatches
+            && phrase.startsWith(mLastPhrase)
+            && ignoreCase == mLastIgnoreCase
+            && hideTwoUnderline == mLastHideTwoUnderline
+            && hideUnderline == mLastHideUnderline) {
+        // candidates not matching the last phrase can't match a longer one
+        mPreviousMatches.swap(mMatches);
+        mMatches.clear();
+        foreach (const CodeCompletionMatch& previous, mPreviousMatches) {
+            if ((mCharBags[previous.index] & phraseBag) != phraseBag)
+                continue;
+            if (matchCandidate(previous.index, phrase, foldedPhrase, ignoreCase, result))
+                mMatches.append(result);
+        }
+    } else {
+        mMatches.clear();
+        for (int i=0;i<mStatements.count();i++) {
+            const QString& command = mStatements[i]->command;
+            if (hideTwoUnderline && command.startsWith("__"))
+                continue;
+            if (hideUnderline && command.startsWith("_"))
+                continue;
+            if ((mCharBags[i] & phraseBag) != phraseBag)
+                continue;
+            if (matchCandidate(i, phrase, foldedPhrase, ignoreCase, result))
+                mMatches.append(result);
+        }
+    }
+    mHasLastMatches = true;
+    mLastPhrase = phrase;
+    mLastIgnoreCase = ignoreCase;
+    mLastHideTwoUnderline = hideTwoUnderline;
+    mLastHideUnderline = hideUnderline;
+    return mMatches;
+}
+
+bool CodeCompletionMatcher::matchPositions(const QString &text, const QString &phrase, bool ignoreCase, CodeCompletionMatchPositions &positions)
+{
+    positions.clear();
+    int pos = 0;
+    int lastPos = -10;
+    foreach (const QChar& ch, phrase) {
+        if (ignoreCase) {
+            QChar foldedCh = ch.toCaseFolded();
+            while (pos<text.length() && text[pos].toCaseFolded()!=foldedCh)
+                pos++;
+        } else {
+            while (pos<text.length() && text[pos]!=ch)
+                pos++;
+        }
+        if (pos>=text.length())
+            return false;
+        if (pos == lastPos+1) {
+            positions.last().end++;
+        } else {
+            StatementMatchPosition matchPosition;
+            matchPosition.start = pos;
+            matchPosition.end = pos+1;
+            positions.append(matchPosition);
+        }
+        lastPos = pos;
+        pos++;
+    }
+    return true;
+}
+
+bool CodeCompletionMatcher::matchCandidate(int index, const QString &phrase, const QString &foldedPhrase, bool ignoreCase, CodeCompletionMatch &result) const
+{
+    Statement* statement = mStatements[index].get();
+    const QChar* command = statement->command.constData();
+    const QChar* text = ignoreCase ? mFoldedCommands[index].constData() : command;
+    const QChar* chars = ignoreCase ? foldedPhrase.constData() : phrase.constData();
+    int len = statement->command.length();
+    int phraseLen = phrase.length();
+    if (phraseLen > len)
+        return false;
+    int pos = 0;
+    int lastPos = -10;
+    int firstPos = 0;
+    int firstMatchLength = 0;
+    bool inFirstMatch = true;
+    int totalPos = 0;
+    int caseMatched = 0;
+    for (int i=0;i<phraseLen;i++) {
+        QChar ch = chars[i];
+        while (pos<len && text[pos]!=ch)
+            pos++;
+        if (pos>=len)
+            return false;
+        if (i==0) {
+            firstPos = pos;
+            firstMatchLength = 1;
+        } else if (pos == lastPos+1) {
+            if (inFirstMatch)
+                firstMatchLength++;
+        } else
+            inFirstMatch = false;
+        if (phrase[i]==command[pos])
+            caseMatched++;
+        totalPos += pos;
+        lastPos = pos;
+        pos++;
+    }
+    result.statement = statement;
+    result.index = index;
+    result.caseMatched = caseMatched;
+    result.matchPosTotal = totalPos;
+    result.firstMatchLength = firstMatchLength;
+    result.matchPosSpan = (phraseLen>0) ? lastPos + 1 - firstPos : 0;
+    return true;
+}
+
+quint64 CodeCompletionMatcher::calcCharBag(const QString &text)
+{
+    // one bit for each of 'a'-'z', '0'-'9' and '_', the last bit for all other chars
+    quint64 bag = 0;
+    foreach (const QChar& ch, text) {
+        ushort u = ch.unicode();
+        if (u>='a' && u<='z')
+            bag |= (1ULL << (u-'a'));
+        else if (u>='A' && u<='Z')
+            bag |= (1ULL << (u-'A'));
+        else if (u>='0' && u<='9')
+            bag |= (1ULL << (26+u-'0'));
+        else if (u=='_')
+            bag |= (1ULL << 36);
+        else
+            bag |= (1ULL << 37);
+    }
+    return bag;
+}
+
+QString CodeCompletionMatcher::foldCase(const QString &text)
+{
+    // fold char by char, so positions in the folded text are the same as the original
+    for (int i=0;i<text.length();i++) {
+        if (text[i].toCaseFolded()!=text[i]) {
+            QString result = text;
+            QChar* data = result.data();
+            for (int j=i;j<result.length();j++)
+                data[j] = data[j].toCaseFolded();
+            return result;
+        }
+    }
+    return text;
+}
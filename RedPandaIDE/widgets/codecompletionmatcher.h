@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef CODECOMPLETIONMATCHER_H
+#define CODECOMPLETIONMATCHER_H
+
+#include <QVarLengthArray>
+#include <QVector>
+#include "../parser/parserutils.h"
+
+struct CodeCompletionMatch {
+    Statement* statement;
+    int index; // index of the statement in the candidates
+    int matchPosSpan; // distance between the first match pos and the end of the last match
+    int firstMatchLength; // length of first matched run
+    int matchPosTotal; // total of matched positions
+    int caseMatched; // count of matched chars with the same case
+};
+
+using CodeCompletionMatchPositions = QVarLengthArray<StatementMatchPosition, 16>;
+
+/*
+ * Fuzzy matches the completion candidates against the typed phrase.
+ * Chars of the phrase must appear in the candidate's name in order.
+ */
+class CodeCompletionMatcher
+{
+public:
+    explicit CodeCompletionMatcher();
+    void setCandidates(const StatementList& statements);
+    void clear();
+    const PStatement& candidate(int index) const { return mStatements[index]; }
+    int candidateCount() const { return mStatements.count(); }
+
+    // Matches are not in any order, callers can reorder them freely.
+    // If phrase extends the last matched phrase, only the last matches are checked.
+    QVector<CodeCompletionMatch>& match(const QString& phrase, bool ignoreCase,
+                                        bool hideTwoUnderline, bool hideUnderline);
+
+    static bool matchPositions(const QString& text, const QString& phrase, bool ignoreCase,
+                               CodeCompletionMatchPositions& positions);
+private:
+    bool matchCandidate(int index, const QString& phrase, const QString& foldedPhrase,
+                        bool ignoreCase, CodeCompletionMatch& result) const;
+    static quint64 calcCharBag(const QString& text);
+    static QString foldCase(const QString& text);
+private:
+    StatementList mStatements;
+    QVector<QString> mFoldedCommands;
+    QVector<quint64> mCharBags;
+
+    QVector<CodeCompletionMatch> mMatches;
+    QVector<CodeCompletionMatch> mPreviousMatches; // reused buffer when narrowing the matches
+    bool mHasLastMatches;
+    QString mLastPhrase;
+    bool mLastIgnoreCase;
+    bool mLastHideTwoUnderline;
+    bool mLastHideUnderline;
+};
+
+#endif // CODECOMPLETIONMATCHER_H
@@ -117,6 +117,7 @@ void CodeCompletionPopup::prepareSearch(
         mIncludedFiles = mParser->getIncludedFiles(filename);
         getCompletionFor(ownerExpression,memberOperator,memberExpression, filename,line, customKeywords);
     }
+    mMatcher.setCandidates(mFullCompletionStatementList);
     setCursor(oldCursor);
 }
 
@@ -136,6 +137,8 @@ bool CodeCompletionPopup::search(const QString &memberPhrase, bool autoHideOnSin
 
     // filter fFullCompletionStatementList to fCompletionStatementList
     filterList(memberPhrase);
+    mDelegate->setMatchPhrase(memberPhrase);
+    mDelegate->setIgnoreCase(mIgnoreCase);
 
     //if can't find a destructor, maybe '~' is only an operator
 //    if (mCompletionStatementList.isEmpty() && phrase.startsWith('~')) {
@@ -307,19 +310,21 @@ void CodeCompletionPopup::addStatement(const PStatement& statement, const QStrin
         mFullCompletionStatementList.append(statement);
 }
 
-static bool nameComparator(PStatement statement1,PStatement statement2) {
+static bool nameComparator(const Statement* statement1,const Statement* statement2) {
     return statement1->command < statement2->command;
 }
 
-static bool defaultComparator(PStatement statement1,PStatement statement2) {
-    if (statement1->matchPosSpan!=statement2->matchPosSpan)
-        return statement1->matchPosSpan < statement2->matchPosSpan;
-    if (statement1->firstMatchLength != statement2->firstMatchLength)
-        return statement1->firstMatchLength > statement2->firstMatchLength;
-    if (statement1->matchPosTotal != statement2->matchPosTotal)
-        return statement1->matchPosTotal < statement2->matchPosTotal;
-    if (statement1->caseMatched != statement2->caseMatched)
-        return statement1->caseMatched > statement2->caseMatched;
+static bool defaultComparator(const CodeCompletionMatch& match1, const CodeCompletionMatch& match2) {
+    if (match1.matchPosSpan!=match2.matchPosSpan)
+        return match1.matchPosSpan < match2.matchPosSpan;
+    if (match1.firstMatchLength != match2.firstMatchLength)
+        return match1.firstMatchLength > match2.firstMatchLength;
+    if (match1.matchPosTotal != match2.matchPosTotal)
+        return match1.matchPosTotal < match2.matchPosTotal;
+    if (match1.caseMatched != match2.caseMatched)
+        return match1.caseMatched > match2.caseMatched;
+    Statement* statement1 = match1.statement;
+    Statement* statement2 = match2.statement;
     // Show user template first
     if (statement1->kind == StatementKind::UserCodeSnippet) {
         if (statement2->kind != StatementKind::UserCodeSnippet)
@@ -339,15 +344,17 @@ static bool defaultComparator(PStatement statement1,PStatement statement2) {
         return nameComparator(statement1,statement2);
 }
 
-static bool sortByScopeComparator(PStatement statement1,PStatement statement2){
-    if (statement1->matchPosSpan!=statement2->matchPosSpan)
-        return statement1->matchPosSpan < statement2->matchPosSpan;
-    if (statement1->firstMatchLength != statement2->firstMatchLength)
-        return statement1->firstMatchLength > statement2->firstMatchLength;
-    if (statement1->matchPosTotal != statement2->matchPosTotal)
-        return statement1->matchPosTotal < statement2->matchPosTotal;
-    if (statement1->caseMatched != statement2->caseMatched)
-        return statement1->caseMatched > statement2->caseMatched;
+static bool sortByScopeComparator(const CodeCompletionMatch& match1, const CodeCompletionMatch& match2){
+    if (match1.matchPosSpan!=match2.matchPosSpan)
+        return match1.matchPosSpan < match2.matchPosSpan;
+    if (match1.firstMatchLength != match2.firstMatchLength)
+        return match1.firstMatchLength > match2.firstMatchLength;
+    if (match1.matchPosTotal != match2.matchPosTotal)
+        return match1.matchPosTotal < match2.matchPosTotal;
+    if (match1.caseMatched != match2.caseMatched)
+        return match1.caseMatched > match2.caseMatched;
+    Statement* statement1 = match1.statement;
+    Statement* statement2 = match2.statement;
     // Show user template first
     if (statement1->kind == StatementKind::UserCodeSnippet) {
         if (statement2->kind != StatementKind::UserCodeSnippet)
@@ -383,15 +390,17 @@ static bool sortByScopeComparator(PStatement statement1,PStatement statement2){
         return nameComparator(statement1,statement2);
 }
 
-static bool sortWithUsageComparator(PStatement statement1,PStatement statement2) {
-    if (statement1->matchPosSpan!=statement2->matchPosSpan)
-        return statement1->matchPosSpan < statement2->matchPosSpan;
-    if (statement1->firstMatchLength != statement2->firstMatchLength)
-        return statement1->firstMatchLength > statement2->firstMatchLength;
-    if (statement1->matchPosTotal != statement2->matchPosTotal)
-        return statement1->matchPosTotal < statement2->matchPosTotal;
-    if (statement1->caseMatched != statement2->caseMatched)
-        return statement1->caseMatched > statement2->caseMatched;
+static bool sortWithUsageComparator(const CodeCompletionMatch& match1, const CodeCompletionMatch& match2) {
+    if (match1.matchPosSpan!=match2.matchPosSpan)
+        return match1.matchPosSpan < match2.matchPosSpan;
+    if (match1.firstMatchLength != match2.firstMatchLength)
+        return match1.firstMatchLength > match2.firstMatchLength;
+    if (match1.matchPosTotal != match2.matchPosTotal)
+        return match1.matchPosTotal < match2.matchPosTotal;
+    if (match1.caseMatched != match2.caseMatched)
+        return match1.caseMatched > match2.caseMatched;
+    Statement* statement1 = match1.statement;
+    Statement* statement2 = match2.statement;
     // Show user template first
     if (statement1->kind == StatementKind::UserCodeSnippet) {
         if (statement2->kind != StatementKind::UserCodeSnippet)
@@ -415,15 +424,17 @@ static bool sortWithUsageComparator(PStatement statement1,PStatement statement2)
         return nameComparator(statement1,statement2);
 }
 
-static bool sortByScopeWithUsageComparator(PStatement statement1,PStatement statement2){
-    if (statement1->matchPosSpan!=statement2->matchPosSpan)
-        return statement1->matchPosSpan < statement2->matchPosSpan;
-    if (statement1->firstMatchLength != statement2->firstMatchLength)
-        return statement1->firstMatchLength > statement2->firstMatchLength;
-    if (statement1->matchPosTotal != statement2->matchPosTotal)
-        return statement1->matchPosTotal < statement2->matchPosTotal;
-    if (statement1->caseMatched != statement2->caseMatched)
-        return statement1->caseMatched > statement2->caseMatched;
+static bool sortByScopeWithUsageComparator(const CodeCompletionMatch& match1, const CodeCompletionMatch& match2){
+    if (match1.matchPosSpan!=match2.matchPosSpan)
+        return match1.matchPosSpan < match2.matchPosSpan;
+    if (match1.firstMatchLength != match2.firstMatchLength)
+        return match1.firstMatchLength > match2.firstMatchLength;
+    if (match1.matchPosTotal != match2.matchPosTotal)
+        return match1.matchPosTotal < match2.matchPosTotal;
+    if (match1.caseMatched != match2.caseMatched)
+        return match1.caseMatched > match2.caseMatched;
+    Statement* statement1 = match1.statement;
+    Statement* statement2 = match2.statement;
     // Show user template first
     if (statement1->kind == StatementKind::UserCodeSnippet) {
         if (statement2->kind != StatementKind::UserCodeSnippet)
@@ -475,79 +486,15 @@ void CodeCompletionPopup::filterList(const QString &member)
     //we don't need to freeze here since we use smart pointers
     //  and data have been retrieved from the parser
 
-    mCompletionStatementList.clear();
-    mCompletionStatementList.reserve(mFullCompletionStatementList.size());
     bool hideSymbolsTwoUnderline = mHideSymbolsStartWithTwoUnderline && !member.startsWith("__") ;
     bool hideSymbolsUnderline = mHideSymbolsStartWithUnderline && !member.startsWith("_") ;
-    int len = member.length();
-    foreach (const PStatement& statement, mFullCompletionStatementList) {
-
-        int matched = 0;
-        int caseMatched = 0;
-        QString command = statement->command;
-        int pos = 0;
-        int lastPos = -10;
-        int totalPos = 0;
-        statement->matchPositions.clear();
-        if (hideSymbolsTwoUnderline && statement->command.startsWith("__")) {
-            continue;
-        } else if (hideSymbolsUnderline && statement->command.startsWith("_")) {
-            continue;
-        } else {
-            foreach (const QChar& ch, member) {
-                if (mIgnoreCase)
-                    pos = command.indexOf(ch,pos,Qt::CaseInsensitive);
-                else
-                    pos = command.indexOf(ch,pos,Qt::CaseSensitive);
-                if (pos<0) {
-                    break;
-                }
-                if (pos == lastPos+1) {
-                    statement->matchPositions.last()->end++;
-                } else {
-                    PStatementMathPosition matchPosition=std::make_shared<StatementMatchPosition>();
-                    matchPosition->start = pos;
-                    matchPosition->end = pos+1;
-                    statement->matchPositions.append(matchPosition);
-                }
-                if (ch==command[pos])
-                    caseMatched++;
-                matched++;
-                totalPos += pos;
-                lastPos = pos;
-                pos+=1;
-            }
-        }
-
-        if (mIgnoreCase && matched== len) {
-            statement->caseMatched = caseMatched;
-            statement->matchPosTotal = totalPos;
-            if (member.length()>0) {
-                statement->firstMatchLength = statement->matchPositions.front()->end - statement->matchPositions.front()->start;
-                statement->matchPosSpan = statement->matchPositions.last()->end - statement->matchPositions.front()->start;
-            } else
-                statement->firstMatchLength = 0;
-            mCompletionStatementList.append(statement);
-        } else if (caseMatched == len) {
-            statement->caseMatched = caseMatched;
-            statement->matchPosTotal = totalPos;
-            if (member.length()>0) {
-                statement->firstMatchLength = statement->matchPositions.front()->end - statement->matchPositions.front()->start;
-                statement->matchPosSpan = statement->matchPositions.last()->end - statement->matchPositions.front()->start;
-            } else
-                statement->firstMatchLength = 0;
-            mCompletionStatementList.append(statement);
-        } else {
-            statement->matchPositions.clear();
-            statement->caseMatched = 0;
-            statement->matchPosTotal = 0;
-            statement->firstMatchLength = 0;
-            statement->matchPosSpan = 0;
-        }
-    }
+    QVector<CodeCompletionMatch>& matches = mMatcher.match(
+                member, mIgnoreCase, hideSymbolsTwoUnderline, hideSymbolsUnderline);
+    bool (*comparator)(const CodeCompletionMatch&, const CodeCompletionMatch&);
     if (mRecordUsage) {
         int usageCount;
-        foreach (const PStatement& statement,mCompletionStatementList) {
+        foreach (const CodeCompletionMatch& match,matches) {
+            Statement* statement = match.statement;
             if (statement->usageCount == -1) {
                 PSymbolUsage usage = pMainWindow->symbolUsageManager()->findUsage(statement->fullName);
                 if (usage) {
@@ -558,25 +505,22 @@ void CodeCompletionPopup::filterList(const QString &member)
                 statement->usageCount = usageCount;
             }
         }
-        if (mSortByScope) {
-            std::sort(mCompletionStatementList.begin(),
-                      mCompletionStatementList.end(),
-                      sortByScopeWithUsageComparator);
-        } else {
-            std::sort(mCompletionStatementList.begin(),
-                      mCompletionStatementList.end(),
-                      sortWithUsageComparator);
-        }
+        if (mSortByScope)
+            comparator = sortByScopeWithUsageComparator;
+        else
+            comparator = sortWithUsageComparator;
     } else if (mSortByScope) {
-        std::sort(mCompletionStatementList.begin(),
-                  mCompletionStatementList.end(),
-                  sortByScopeComparator);
+        comparator = sortByScopeComparator;
     } else {
-        std::sort(mCompletionStatementList.begin(),
-                  mCompletionStatementList.end(),
-                  defaultComparator);
+        comparator = defaultComparator;
+    }
+    //only the first mShowCount items need to be sorted
+    int count = std::min(mShowCount, (int)matches.count());
+    std::partial_sort(matches.begin(), matches.begin()+count, matches.end(), comparator);
+    mCompletionStatementList.reserve(count);
+    for (int i=0;i<count;i++) {
+        mCompletionStatementList.append(mMatcher.candidate(matches[i].index));
     }
-    //    }
 }
 
 void CodeCompletionPopup::getKeywordCompletionFor(const QSet<QString> &customKeywords)
@@ -1244,9 +1188,7 @@ void CodeCompletionPopup::hideEvent(QHideEvent *event)
     QMutexLocker locker(&mMutex);
     mListView->setKeypressedCallback(nullptr);
     mCompletionStatementList.clear();
-//    foreach (PStatement statement, mFullCompletionStatementList) {
-//        statement->matchPositions.clear();
-//    }
+    mMatcher.clear();
     mFullCompletionStatementList.clear();
     mIncludedFiles.clear();
     mUsings.clear();
@@ -1349,20 +1291,23 @@ void CodeCompletionListItemDelegate::paint(QPainter *painter, const QStyleOption
         int pos=0;
         int padding = (option.rect.height()-painter->fontMetrics().height())/2;
         int y=option.rect.bottom()-painter->fontMetrics().descent()-padding;
-        foreach (const PStatementMathPosition& matchPosition, statement->matchPositions) {
-            if (pos<matchPosition->start) {
-                QString t = text.mid(pos,matchPosition->start-pos);
+        CodeCompletionMatchPositions matchPositions;
+        //only visible items are painted, so match positions are calculated here instead of being saved
+        CodeCompletionMatcher::matchPositions(text, mMatchPhrase, mIgnoreCase, matchPositions);
+        foreach (const StatementMatchPosition& matchPosition, matchPositions) {
+            if (pos<matchPosition.start) {
+                QString t = text.mid(pos,matchPosition.start-pos);
                 painter->setPen(normalColor);
                 painter->setFont(normalFont);
                 painter->drawText(x,y,t);
                 x+=painter->fontMetrics().horizontalAdvance(t);
             }
-            QString t = text.mid(matchPosition->start, matchPosition->end-matchPosition->start);
+            QString t = text.mid(matchPosition.start, matchPosition.end-matchPosition.start);
             painter->setPen(matchedColor);
             painter->setFont(matchedFont);
             painter->drawText(x,y,t);
             x+=painter->fontMetrics().horizontalAdvance(t);
-            pos=matchPosition->end;
+            pos=matchPosition.end;
         }
         if (pos<text.length()) {
             QString t = text.mid(pos,text.length()-pos);
@@ -1440,4 +1385,25 @@ CodeCompletionListItemDelegate::CodeCompletionListItemDelegate(CodeCompletionLis
     mNormalColor = qApp->palette().color(QPalette::Text);
     mMatchedColor = qApp->palette().color(QPalette::BrightText);
     mLineHeightFactor = 1.0;
+    mIgnoreCase = false;
+}
+
+const QString &CodeCompletionListItemDelegate::matchPhrase() const
+{
+    return mMatchPhrase;
+}
+
+void CodeCompletionListItemDelegate::setMatchPhrase(const QString &newMatchPhrase)
+{
+    mMatchPhrase = newMatchPhrase;
+}
+
+bool CodeCompletionListItemDelegate::ignoreCase() const
+{
+    return mIgnoreCase;
+}
+
+void CodeCompletionListItemDelegate::setIgnoreCase(bool newIgnoreCase)
+{
+    mIgnoreCase = newIgnoreCase;
 }
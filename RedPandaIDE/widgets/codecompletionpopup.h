@@ -22,6 +22,7 @@
 #include <QStyledItemDelegate>
 #include "parser/cppparser.h"
 #include "codecompletionlistview.h"
+#include "codecompletionmatcher.h"
 
 class ColorSchemeItem;
 class CodeCompletionListModel : public QAbstractListModel {
@@ -74,6 +75,12 @@ public:
     QColor currentSelectionColor() const;
     void setCurrentSelectionColor(const QColor &newCurrentSelectionColor);
 
+    const QString &matchPhrase() const;
+    void setMatchPhrase(const QString &newMatchPhrase);
+
+    bool ignoreCase() const;
+    void setIgnoreCase(bool newIgnoreCase);
+
 private:
     CodeCompletionListModel *mModel;
     QColor mNormalColor;
@@ -81,6 +88,8 @@ private:
     QColor mCurrentSelectionColor;
     QFont mFont;
     float mLineHeightFactor;
+    QString mMatchPhrase;
+    bool mIgnoreCase;
 };
 
 class CodeCompletionPopup : public QWidget
@@ -179,6 +188,7 @@ private:
     //QList<PStatement> mCodeInsStatements; //temporary (user code template) statements created when show code suggestion
     StatementList mFullCompletionStatementList;
     StatementList mCompletionStatementList;
+    CodeCompletionMatcher mMatcher;
     QSet<QString> mIncludedFiles;
     QSet<QString> mUsings;
     QSet<QString> mAddedStatements;
@@ -36,6 +36,7 @@ HeaderCompletionPopup::HeaderCompletionPopup(QWidget* parent):QWidget(parent)
     mListView->setModel(mModel);
     delete m;
     mDelegate = new HeaderCompletionListItemDelegate(mModel,this);
+    mDirIndex = new IncludeDirIndex(this);
     mListView->setItemDelegate(mDelegate);
     setLayout(new QVBoxLayout());
     layout()->addWidget(mListView);
@@ -181,100 +182,80 @@ void HeaderCompletionPopup::filterList(const QString &member)
     Qt::CaseSensitivity caseSensitivity=mIgnoreCase?Qt::CaseInsensitive:Qt::CaseSensitive;
     mCompletionList.clear();
     mModel->setMatched(0);
-    if (member.isEmpty()) {
-        foreach (const PHeaderCompletionListItem& item,mFullCompletionList.values()) {
-            mCompletionList.append(item);
-        }
-    } else {
-        foreach (const PHeaderCompletionListItem& item,mFullCompletionList.values()) {
-            if (item->filename.startsWith(member, caseSensitivity)) {
-                mCompletionList.append(item);
-            }
+    // files with the same name in later dirs override the earlier ones
+    QHash<QString, PHeaderCompletionListItem> matched;
+    foreach (const SearchDir& searchDir, mSearchDirs) {
+        int first, last;
+        searchDir.listing->findByPrefix(member, first, last);
+        for (int i=first;i<last;i++) {
+            const IncludeDirEntry& entry = searchDir.listing->entries[i];
+            if (caseSensitivity == Qt::CaseSensitive && !entry.filename.startsWith(member))
+                continue;
+            matched.insert(entry.filename, getItem(searchDir.listing, entry, searchDir.type));
         }
     }
+    foreach (const PHeaderCompletionListItem& item, matched) {
+        mCompletionList.append(item);
+    }
     std::sort(mCompletionList.begin(),mCompletionList.end(), sortByUsage);
     mModel->setMatched(member.length());
 }
 
 
+static QString subDirPath(const QString& baseDirPath, const QString& subDirName)
+{
+    if (subDirName.isEmpty())
+        return baseDirPath;
+    return QDir(baseDirPath).filePath(subDirName);
+}
+
 void HeaderCompletionPopup::getCompletionFor(const QString &phrase)
 {
     int idx = phrase.lastIndexOf('\\');
     if (idx<0) {
         idx = phrase.lastIndexOf('/');
     }
+    mSearchDirs.clear();
     mFullCompletionList.clear();
-    if (idx < 0) { // dont have basedir
-        if (mSearchLocal) {
-            QFileInfo fileInfo(mCurrentFile);
-            addFilesInPath(fileInfo.absolutePath(), HeaderCompletionListItemType::LocalHeader);
-        };
-
-        for (const QString& path: mParser->includePaths()) {
-            addFilesInPath(path, HeaderCompletionListItemType::ProjectHeader);
-        }
-
-        for (const QString& path: mParser->projectIncludePaths()) {
-            addFilesInPath(path, HeaderCompletionListItemType::SystemHeader);
-        }
-    } else {
-        QString current = phrase.mid(0,idx);
-        if (mSearchLocal) {
-            QFileInfo fileInfo(mCurrentFile);
-            addFilesInSubDir(fileInfo.absolutePath(),current, HeaderCompletionListItemType::LocalHeader);
-        }
-        for (const QString& path: mParser->includePaths()) {
-            addFilesInSubDir(path,current, HeaderCompletionListItemType::ProjectHeader);
-        }
+    QString current;
+    if (idx >= 0)
+        current = phrase.mid(0,idx);
+    if (mSearchLocal) {
+        QFileInfo fileInfo(mCurrentFile);
+        addSearchDir(subDirPath(fileInfo.absolutePath(), current), HeaderCompletionListItemType::LocalHeader);
+    }
+    for (const QString& path: mParser->includePaths()) {
+        addSearchDir(subDirPath(path, current), HeaderCompletionListItemType::ProjectHeader);
+    }
 
-        for (const QString& path: mParser->projectIncludePaths()) {
-            addFilesInSubDir(path,current, HeaderCompletionListItemType::SystemHeader);
-        }
+    for (const QString& path: mParser->projectIncludePaths()) {
+        addSearchDir(subDirPath(path, current), HeaderCompletionListItemType::SystemHeader);
     }
 }
 
-void HeaderCompletionPopup::addFilesInPath(const QString &path, HeaderCompletionListItemType type)
+void HeaderCompletionPopup::addSearchDir(const QString &path, HeaderCompletionListItemType type)
 {
-    QDir dir(path);
-    if (!dir.exists())
-        return;
-    foreach (const QFileInfo& fileInfo, dir.entryInfoList()) {
-        if (fileInfo.fileName().startsWith("."))
-            continue;
-        if (fileInfo.isDir()) {
-            addFile(dir, fileInfo, type);
-            continue;
-        }
-        QString suffix = fileInfo.suffix().toLower();
-        if (suffix == "h" || suffix == "hpp" || suffix == "") {
-            addFile(dir, fileInfo, type);
-        }
-    }
+    PIncludeDirListing listing = mDirIndex->listing(path);
+    if (listing)
+        mSearchDirs.append(SearchDir{listing, type});
 }
 
-void HeaderCompletionPopup::addFile(const QDir& dir, const QFileInfo& fileInfo, HeaderCompletionListItemType type)
+PHeaderCompletionListItem HeaderCompletionPopup::getItem(const PIncludeDirListing& listing, const IncludeDirEntry &entry, HeaderCompletionListItemType type)
 {
-    QString fileName = fileInfo.fileName();
-    if (fileName.isEmpty())
-        return;
-    if (fileName.startsWith('.'))
-        return;
-    PHeaderCompletionListItem item = std::make_shared<HeaderCompletionListItem>();
-    item->filename = fileName;
-    item->noSuffixFilename = fileInfo.baseName();
-    item->suffix = fileInfo.suffix();
+    QString fullpath = cleanPath(QDir(listing->path).absoluteFilePath(entry.filename));
+    PHeaderCompletionListItem item = mFullCompletionList.value(fullpath);
+    if (item)
+        return item;
+    item = std::make_shared<HeaderCompletionListItem>();
+    item->filename = entry.filename;
+    item->noSuffixFilename = entry.noSuffixFilename;
+    item->suffix = entry.suffix;
     item->itemType = type;
-    item->fullpath = cleanPath(dir.absoluteFilePath(fileName));
+    item->fullpath = fullpath;
     item->usageCount = mHeaderUsageCounts.value(item->fullpath,0);
-    item->isFolder = fileInfo.isDir();
-    mFullCompletionList.insert(fileName,item);
-}
-
-void HeaderCompletionPopup::addFilesInSubDir(const QString &baseDirPath, const QString &subDirName, HeaderCompletionListItemType type)
-{
-    QDir baseDir(baseDirPath);
-    QString subDirPath = baseDir.filePath(subDirName);
-    addFilesInPath(subDirPath, type);
+    item->isFolder = entry.isFolder;
+    mFullCompletionList.insert(fullpath,item);
+    return item;
 }
 
 bool HeaderCompletionPopup::searchLocal() const
@@ -311,6 +292,7 @@ void HeaderCompletionPopup::hideEvent(QHideEvent *)
 {
     mCompletionList.clear();
     mModel->setMatched(0);
+    mSearchDirs.clear();
     mFullCompletionList.clear();
     mParser = nullptr;
 }
@@ -21,6 +21,7 @@
 #include <QStyledItemDelegate>
 #include <QWidget>
 #include "codecompletionlistview.h"
+#include "includedirindex.h"
 #include "../parser/cppparser.h"
 
 enum class HeaderCompletionListItemType {
@@ -116,13 +117,21 @@ public:
 private:
     void filterList(const QString& member);
     void getCompletionFor(const QString& phrase);
-    void addFilesInPath(const QString& path, HeaderCompletionListItemType type);
-    void addFile(const QDir& dir,  const QFileInfo &fileInfo, HeaderCompletionListItemType type);
-    void addFilesInSubDir(const QString& baseDirPath, const QString& subDirName, HeaderCompletionListItemType type);
+    void addSearchDir(const QString& path, HeaderCompletionListItemType type);
+    PHeaderCompletionListItem getItem(const PIncludeDirListing& listing, const IncludeDirEntry& entry,
+                                      HeaderCompletionListItemType type);
 private:
+    struct SearchDir {
+        PIncludeDirListing listing;
+        HeaderCompletionListItemType type;
+    };
 
     CodeCompletionListView* mListView;
     HeaderCompletionListModel* mModel;
+    IncludeDirIndex* mDirIndex;
+    // directories to search for the current phrase, in the order of priority (the last is the highest)
+    QList<SearchDir> mSearchDirs;
+    // items created for the current search, by full path
     QHash<QString, PHeaderCompletionListItem> mFullCompletionList;
     QList<PHeaderCompletionListItem> mCompletionList;
     QHash<QString,int> mHeaderUsageCounts;
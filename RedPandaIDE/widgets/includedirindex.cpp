@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "includedirindex.h"
+#include <QDir>
+#include <QFileInfo>
+#include <algorithm>
+
+// directories listed and watched at most, the cache is cleared when exceeded
+#define MAX_INDEXED_INCLUDE_DIRS 1024
+
+void IncludeDirListing::findByPrefix(const QString &prefix, int &first, int &last) const
+{
+    QString foldedPrefix = prefix.toCaseFolded();
+    auto it = std::lower_bound(entries.begin(), entries.end(), foldedPrefix,
+                               [](const IncludeDirEntry& entry, const QString& key) {
+        return entry.foldedFilename < key;
+    });
+    first = it - entries.begin();
+    while (it!=entries.end() && it->foldedFilename.startsWith(foldedPrefix))
+        it++;
+    last = it - entries.begin();
+}
+
+bool IncludeDirListing::containsFolder(const QString &name) const
+{
+    int first, last;
+    findByPrefix(name, first, last);
+    for (int i=first;i<last;i++) {
+        const IncludeDirEntry& entry = entries[i];
+#ifdef Q_OS_WIN
+        if (entry.isFolder && entry.filename.compare(name, Qt::CaseInsensitive)==0)
+#else
+        if (entry.isFolder && entry.filename==name)
+#endif
+            return true;
+    }
+    return false;
+}
+
+IncludeDirIndex::IncludeDirIndex(QObject *parent)
+    : QObject{parent}
+{
+    connect(&mWatcher, &QFileSystemWatcher::directoryChanged,
+            this, &IncludeDirIndex::onDirectoryChanged);
+}
+
+PIncludeDirListing IncludeDirIndex::listing(const QString &dirPath)
+{
+    QString path = QDir::cleanPath(dirPath);
+    auto it = mListings.constFind(path);
+    if (it!=mListings.constEnd())
+        return it.value();
+    if (mMissingDirs.contains(path))
+        return PIncludeDirListing();
+    // A directory is looked up in the listing of its parent before touching the disk.
+    // Missing directories can't be watched, but their parent can, so the parent
+    // is listed and cached instead.
+    QString parentPath;
+    QString name;
+    int idx = path.lastIndexOf('/');
+    if (idx>=0) {
+        parentPath = path.left(idx);
+        name = path.mid(idx+1);
+        if (parentPath.isEmpty() || parentPath.endsWith(':'))
+            parentPath += '/';
+    }
+    if (!name.isEmpty() && parentPath!=path) {
+        PIncludeDirListing parentListing = mListings.value(parentPath);
+        if (!parentListing) {
+            if (QDir(path).exists())
+                return addListing(path);
+            parentListing = listing(parentPath);
+            if (!parentListing) {
+                mMissingDirs.insert(path);
+                return parentListing;
+            }
+        }
+        if (!parentListing->containsFolder(name))
+            return PIncludeDirListing();
+    }
+    return addListing(path);
+}
+
+PIncludeDirListing IncludeDirIndex::addListing(const QString &path)
+{
+    PIncludeDirListing listing = listDirectory(path);
+    if (!listing) {
+        mMissingDirs.insert(path);
+        return listing;
+    }
+    if (mListings.count() >= MAX_INDEXED_INCLUDE_DIRS)
+        clear();
+    mListings.insert(path, listing);
+    mWatcher.addPath(path);
+    return listing;
+}
+
+void IncludeDirIndex::clear()
+{
+    mListings.clear();
+    mMissingDirs.clear();
+    QStringList dirs = mWatcher.directories();
+    if (!dirs.isEmpty())
+        mWatcher.removePaths(dirs);
+}
+
+void IncludeDirIndex::onDirectoryChanged(const QString &path)
+{
+    // listed again when it's used next time
+    mListings.remove(path);
+    // a missing directory is created in the nearest existing ancestor, which is watched
+    mMissingDirs.clear();
+    mWatcher.removePath(path);
+}
+
+PIncludeDirListing IncludeDirIndex::listDirectory(const QString &dirPath)
+{
+    QDir dir(dirPath);
+    if (!dir.exists())
+        return PIncludeDirListing();
+    std::shared_ptr<IncludeDirListing> listing = std::make_shared<IncludeDirListing>();
+    listing->path = dirPath;
+    foreach (const QFileInfo& fileInfo, dir.entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot)) {
+        QString fileName = fileInfo.fileName();
+        if (fileName.isEmpty() || fileName.startsWith('.'))
+            continue;
+        bool isFolder = fileInfo.isDir();
+        QString suffix = fileInfo.suffix();
+        if (!isFolder) {
+            QString lowerSuffix = suffix.toLower();
+            if (lowerSuffix != "h" && lowerSuffix != "hpp" && lowerSuffix != "")
+                continue;
+        }
+        IncludeDirEntry entry;
+        entry.filename = fileName;
+        entry.foldedFilename = fileName.toCaseFolded();
+        entry.noSuffixFilename = fileInfo.baseName();
+        entry.suffix = suffix;
+        entry.isFolder = isFolder;
+        listing->entries.append(entry);
+    }
+    std::sort(listing->entries.begin(), listing->entries.end(),
+              [](const IncludeDirEntry& e1, const IncludeDirEntry& e2) {
+        return e1.foldedFilename < e2.foldedFilename;
+    });
+    return listing;
+}
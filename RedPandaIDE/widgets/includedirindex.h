@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2020-2022 Roy Qu (royqh1979@gmail.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef INCLUDEDIRINDEX_H
+#define INCLUDEDIRINDEX_H
+
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QVector>
+#include <memory>
+
+struct IncludeDirEntry {
+    QString filename;
+    QString foldedFilename; // case folded filename, entries are sorted by it
+    QString noSuffixFilename;
+    QString suffix;
+    bool isFolder;
+};
+
+struct IncludeDirListing {
+    QString path;
+    QVector<IncludeDirEntry> entries;
+    // index range [first, last) of the entries whose name starts with prefix, ignoring case
+    void findByPrefix(const QString& prefix, int &first, int &last) const;
+    // whether the sub folder is listed
+    bool containsFolder(const QString& name) const;
+};
+
+using PIncludeDirListing = std::shared_ptr<const IncludeDirListing>;
+
+/*
+ * Listings of the include directories used by header completion.
+ * Each directory is listed when it's first used, and is watched until it's changed,
+ * so listing a directory again doesn't touch the file system.
+ * Sub folders, existing or not, are found in the listing of their parent.
+ */
+class IncludeDirIndex : public QObject
+{
+    Q_OBJECT
+public:
+    explicit IncludeDirIndex(QObject *parent = nullptr);
+    // headers and sub folders in the directory, nullptr if the directory doesn't exist
+    PIncludeDirListing listing(const QString& dirPath);
+    void clear();
+private slots:
+    void onDirectoryChanged(const QString& path);
+private:
+    PIncludeDirListing addListing(const QString& path);
+    PIncludeDirListing listDirectory(const QString& dirPath);
+private:
+    QHash<QString, PIncludeDirListing> mListings;
+    // missing directories that are not resolved through a listed parent
+    QSet<QString> mMissingDirs;
+    QFileSystemWatcher mWatcher;
+};
+
+#endif // INCLUDEDIRINDEX_H
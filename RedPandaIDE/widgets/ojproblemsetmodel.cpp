@@ -501,6 +501,12 @@ QVariant OJProblemModel::data(const QModelIndex &index, int role) const
                  return problemCase->runningTime;
              else
                  return "";
+        } else if (role == Qt::ToolTipRole) {
+             POJProblemCase problemCase = mProblem->cases[index.row()];
+             if (problemCase->testState == ProblemCaseTestState::Passed
+                     || problemCase->testState == ProblemCaseTestState::Failed)
+                 return tr("CPU time: %1 ms").arg(problemCase->runningCpuTime)
+                         + "\n" + tr("Exit to result: %1 ms").arg(problemCase->exitToResultTime / 1000.0);
         }
         break;
 #ifdef Q_OS_WIN
@@ -19,14 +19,13 @@
 #include <QTabBar>
 #include <QMessageBox>
 #include <QDebug>
-#include <QProgressDialog>
 #include <QCompleter>
-#include <QStack>
 #include <QFileDialog>
 #include <qsynedit/document.h>
 #include <qsynedit/searcher/basicsearcher.h>
 #include <qsynedit/searcher/regexsearcher.h>
 #include "../editor.h"
+#include "../filesearcher.h"
 #include "../mainwindow.h"
 #include "../editorlist.h"
 #include "../project.h"
@@ -35,7 +34,8 @@
 
 SearchInFileDialog::SearchInFileDialog(QWidget *parent) :
     QDialog(parent),
-    ui(new Ui::SearchInFileDialog)
+    ui(new Ui::SearchInFileDialog),
+    mSearcher{nullptr}
 {
     setWindowFlag(Qt::WindowContextHelpButtonHint,false);
     ui->setupUi(this);
@@ -48,6 +48,7 @@ SearchInFileDialog::SearchInFileDialog(QWidget *parent) :
 
 SearchInFileDialog::~SearchInFileDialog()
 {
+    delete mSearcher;
     delete ui;
 }
 
@@ -125,6 +126,7 @@ void SearchInFileDialog::doSearch(bool replace)
     mSearchOptions.setFlag(QSynedit::ssoEntireScope);
 
     close();
+    stopSearcher();
 
     int findCount=0;
     int fileSearched = 0;
@@ -161,90 +163,16 @@ void SearchInFileDialog::doSearch(bool replace)
                     SearchFileScope::Folder,
                     ui->txtFolder->text(),
                     ui->txtFilters->text(),
-                    ui->cbSearchSubFolders
+                    ui->cbSearchSubFolders->isChecked()
                     );
         if (ui->txtFilters->text().trimmed().isEmpty()) {
             ui->txtFilters->setText("*.*");
         }
-        QDir rootDir(ui->txtFolder->text());
-        // loop through editors, add results to message control
-        QProgressDialog progressDlg(
-                    tr("Searching..."),
-                    tr("Abort"),
-                    0,
-                    1,
-                    pMainWindow);
-
-        progressDlg.setWindowModality(Qt::WindowModal);
-        QStack<QDir> dirs;
-        QSet<QString> searched;
-        QList<QFileInfo> files;
-        dirs.push(rootDir);
-        QDir::Filters filterOptions=QDir::Files | QDir::NoSymLinks;
-        if (PATH_SENSITIVITY==Qt::CaseSensitive)
-            filterOptions |= QDir::CaseSensitive;
-        while (!dirs.isEmpty()) {
-            QDir dir=dirs.back();
-            dirs.pop_back();
-            foreach(const QFileInfo& entry, dir.entryInfoList(QDir::NoSymLinks | QDir::Dirs)) {
-                if (entry.fileName()==".." || entry.fileName()==".")
-                    continue;
-                if (!searched.contains(entry.absoluteFilePath())) {
-                    dirs.push_back(QDir(entry.absoluteFilePath()));
-                    searched.insert(entry.absoluteFilePath());
-                }
-            }
-            foreach(const QFileInfo& entry, dir.entryInfoList(ui->txtFilters->text().split(";"), filterOptions)) {
-                files.append(entry);
-            }
-        }
-        progressDlg.setMaximum(files.count());
-        int i=0;
-        foreach (const QFileInfo &info, files) {
-            QString curFilename =  info.absoluteFilePath();
-            i++;
-            progressDlg.setValue(i);
-            progressDlg.setLabelText(tr("Searching...")+"<br/>"+curFilename);
-
-            if (progressDlg.wasCanceled())
-                break;
-            Editor * e = pMainWindow->editorList()->getOpenedEditorByFilename(curFilename);
-            if (e) {
-                fileSearched++;
-                PSearchResultTreeItem parentItem = batchFindInEditor(
-                            e,
-                            e->filename(),
-                            keyword);
-                int t = parentItem->results.size();
-                findCount+=t;
-                if (t>0) {
-                    fileHitted++;
-                    results->results.append(parentItem);
-                }
-            } else if (fileExists(curFilename)) {
-                QSynedit::QSynEdit editor;
-                QByteArray realEncoding;
-                try{
-                    editor.document()->loadFromFile(curFilename,ENCODING_AUTO_DETECT, realEncoding);
-                } catch (QSynedit::BinaryFileError e) {
-                    continue;
-                } catch (FileError e) {
-                    continue;
-                }
-                fileSearched++;
-                PSearchResultTreeItem parentItem = batchFindInEditor(
-                            &editor,
-                            curFilename,
-                            keyword);
-                int t = parentItem->results.size();
-                findCount+=t;
-                if (t>0) {
-                    fileHitted++;
-                    results->results.append(parentItem);
-                }
-            }
-        }
-        pMainWindow->searchResultModel()->notifySearchResultsUpdated();
+        FileSearcher* searcher = new FileSearcher(keyword, mSearchOptions);
+        searcher->setFolder(ui->txtFolder->text(),
+                            ui->txtFilters->text().split(";"),
+                            ui->cbSearchSubFolders->isChecked());
+        startSearcher(searcher, results);
     } else if (ui->rbCurrentFile->isChecked()) {
         PSearchResults results = pMainWindow->searchResultModel()->addSearchResults(
                     keyword,
@@ -275,63 +203,18 @@ void SearchInFileDialog::doSearch(bool replace)
                     SearchFileScope::wholeProject
                     );
         QByteArray projectEncoding = pMainWindow->project()->options().encoding;
-        QProgressDialog progressDlg(
-                    tr("Searching..."),
-                    tr("Abort"),
-                    0,
-                    pMainWindow->project()->unitList().count(),
-                    pMainWindow);
-
-        progressDlg.setWindowModality(Qt::WindowModal);
-        int i=0;
+        QList<FileSearchTarget> files;
         foreach (PProjectUnit unit, pMainWindow->project()->unitList()) {
-            i++;
-            progressDlg.setValue(i);
-            progressDlg.setLabelText(tr("Searching...")+"<br/>"+unit->fileName());
-
-            if (progressDlg.wasCanceled())
-                break;
-            Editor * e = pMainWindow->project()->unitEditor(unit);
-            QString curFilename =  unit->fileName();
-            if (e) {
-                fileSearched++;
-                PSearchResultTreeItem parentItem = batchFindInEditor(
-                            e,
-                            e->filename(),
-                            keyword);
-                int t = parentItem->results.size();
-                findCount+=t;
-                if (t>0) {
-                    fileHitted++;
-                    results->results.append(parentItem);
-                }
-            } else if (fileExists(curFilename)) {
-                QSynedit::QSynEdit editor;
-                QByteArray encoding=unit->encoding();
-                if (encoding==ENCODING_PROJECT)
-                    encoding = projectEncoding;
-                QByteArray realEncoding;
-                try {
-                    editor.document()->loadFromFile(curFilename,encoding, realEncoding);
-                } catch (QSynedit::BinaryFileError e) {
-                    continue;
-                } catch (FileError e) {
-                    continue;
-                }
-                fileSearched++;
-                PSearchResultTreeItem parentItem = batchFindInEditor(
-                            &editor,
-                            curFilename,
-                            keyword);
-                int t = parentItem->results.size();
-                findCount+=t;
-                if (t>0) {
-                    fileHitted++;
-                    results->results.append(parentItem);
-                }
-            }
+            FileSearchTarget target;
+            target.filename = unit->fileName();
+            target.encoding = unit->encoding();
+            if (target.encoding==ENCODING_PROJECT)
+                target.encoding = projectEncoding;
+            files.append(target);
         }
-        pMainWindow->searchResultModel()->notifySearchResultsUpdated();
+        FileSearcher* searcher = new FileSearcher(keyword, mSearchOptions);
+        searcher->setFiles(files);
+        startSearcher(searcher, results);
     }
     pMainWindow->showSearchPanel(replace);
 
@@ -404,6 +287,68 @@ std::shared_ptr<SearchResultTreeItem> SearchInFileDialog::batchFindInEditor(QSyn
     return parentItem;
 }
 
+void SearchInFileDialog::startSearcher(FileSearcher *searcher, std::shared_ptr<SearchResults> results)
+{
+    // editors may have unsaved changes, so search their contents instead of the files
+    QHash<QString, QStringList> openedFileContents;
+    for (int i=0;i<pMainWindow->editorList()->pageCount();i++) {
+        Editor * e=pMainWindow->editorList()->operator[](i);
+        if (e!=nullptr)
+            openedFileContents.insert(e->filename(), e->contents());
+    }
+    searcher->setOpenedFileContents(openedFileContents);
+    mSearcher = searcher;
+    mSearcherResults = results;
+    connect(mSearcher, &FileSearcher::resultsAvailable,
+            this, &SearchInFileDialog::onSearcherResultsAvailable);
+    connect(mSearcher, &QThread::finished,
+            this, &SearchInFileDialog::onSearcherFinished);
+    pMainWindow->searchResultModel()->notifySearchResultsUpdated();
+    emit searchStateChanged(true);
+    mSearcher->start();
+}
+
+void SearchInFileDialog::stopSearcher()
+{
+    if (!mSearcher)
+        return;
+    mSearcher->cancel();
+    mSearcher->wait();
+    onSearcherFinished();
+}
+
+void SearchInFileDialog::onSearcherResultsAvailable()
+{
+    if (!mSearcher)
+        return;
+    pMainWindow->searchResultModel()->appendSearchResultItems(
+                mSearcherResults,
+                mSearcher->takeResults());
+}
+
+void SearchInFileDialog::onSearcherFinished()
+{
+    // finished() of a stopped searcher may still be queued
+    if (!mSearcher || !mSearcher->isFinished())
+        return;
+    onSearcherResultsAvailable();
+    mSearcher->deleteLater();
+    mSearcher = nullptr;
+    mSearcherResults.reset();
+    emit searchStateChanged(false);
+}
+
+bool SearchInFileDialog::isSearching() const
+{
+    return mSearcher!=nullptr;
+}
+
+void SearchInFileDialog::cancelSearch()
+{
+    if (mSearcher)
+        mSearcher->cancel();
+}
+
 void SearchInFileDialog::showEvent(QShowEvent *event)
 {
     QDialog::showEvent(event);
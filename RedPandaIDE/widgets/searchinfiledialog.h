@@ -26,8 +26,10 @@ class SearchInFileDialog;
 }
 
 struct SearchResultTreeItem;
+struct SearchResults;
 class QTabBar;
 class Editor;
+class FileSearcher;
 class SearchInFileDialog : public QDialog
 {
     Q_OBJECT
@@ -38,6 +40,11 @@ public:
     void findInFiles(const QString& text);
     void findInFiles(const QString& keyword, SearchFileScope scope, QSynedit::SearchOptions options, const QString& folder, const QString& filters, bool searchSubfolders );
     QSynedit::PSynSearchBase searchEngine() const;
+    bool isSearching() const;
+    void cancelSearch();
+
+signals:
+    void searchStateChanged(bool searching);
 
 private slots:
    void on_cbFind_currentTextChanged(const QString &arg1);
@@ -51,6 +58,9 @@ private slots:
 
    void on_btnChangeFolder_clicked();
 
+   void onSearcherResultsAvailable();
+   void onSearcherFinished();
+
 private:
    void doSearch(bool replace);
    int execute(QSynedit::QSynEdit* editor, const QString& sSearch,
@@ -58,11 +68,15 @@ private:
                QSynedit::SearchMathedProc matchCallback = nullptr,
                QSynedit::SearchConfirmAroundProc confirmAroundCallback = nullptr);
    std::shared_ptr<SearchResultTreeItem> batchFindInEditor(QSynedit::QSynEdit * editor,const QString& filename, const QString& keyword);
+   void startSearcher(FileSearcher* searcher, std::shared_ptr<SearchResults> results);
+   void stopSearcher();
 private:
     Ui::SearchInFileDialog *ui;
     QSynedit::SearchOptions mSearchOptions;
     QSynedit::PSynSearchBase mBasicSearchEngine;
     QSynedit::PSynSearchBase mRegexSearchEngine;
+    FileSearcher* mSearcher;
+    std::shared_ptr<SearchResults> mSearcherResults;
 
     // QWidget interface
 protected:
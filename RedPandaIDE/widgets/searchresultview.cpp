@@ -96,6 +96,20 @@ void SearchResultModel::notifySearchResultsUpdated()
     emit modelChanged();
 }
 
+void SearchResultModel::appendSearchResultItems(PSearchResults results, const SearchResultTreeItemList &items)
+{
+    if (items.isEmpty())
+        return;
+    if (results != currentResults()) {
+        results->results.append(items);
+        return;
+    }
+    int first = results->results.count();
+    emit currentResultItemsAboutToBeAppended(first, first + items.count() - 1);
+    results->results.append(items);
+    emit currentResultItemsAppended();
+}
+
 SearchResultModel::SearchResultModel(QObject* parent):
     QObject(parent),
     mCurrentIndex(-1)
@@ -149,6 +163,10 @@ SearchResultTreeModel::SearchResultTreeModel(SearchResultModel *model, QObject *
             this,&SearchResultTreeModel::onResultModelChanged);
     connect(mSearchResultModel,&SearchResultModel::modelChanged,
             this,&SearchResultTreeModel::onResultModelChanged);
+    connect(mSearchResultModel,&SearchResultModel::currentResultItemsAboutToBeAppended,
+            this,&SearchResultTreeModel::onResultItemsAboutToBeAppended);
+    connect(mSearchResultModel,&SearchResultModel::currentResultItemsAppended,
+            this,&SearchResultTreeModel::onResultItemsAppended);
 }
 
 QModelIndex SearchResultTreeModel::index(int row, int column, const QModelIndex &parent) const
@@ -296,6 +314,16 @@ void SearchResultTreeModel::onResultModelChanged()
     endResetModel();
 }
 
+void SearchResultTreeModel::onResultItemsAboutToBeAppended(int first, int last)
+{
+    beginInsertRows(QModelIndex(), first, last);
+}
+
+void SearchResultTreeModel::onResultItemsAppended()
+{
+    endInsertRows();
+}
+
 Qt::ItemFlags SearchResultTreeModel::flags(const QModelIndex &) const
 {
     Qt::ItemFlags flags=Qt::ItemIsEnabled | Qt::ItemIsSelectable;
@@ -72,6 +72,8 @@ public:
             SearchFileScope scope);
     PSearchResults results(int index);
     void notifySearchResultsUpdated();
+    // append file items to results, without resetting the views
+    void appendSearchResultItems(PSearchResults results, const SearchResultTreeItemList& items);
     int currentIndex() const;
     int resultsCount() const;
     PSearchResults currentResults();
@@ -81,6 +83,8 @@ public:
 signals:
     void modelChanged();
     void currentChanged(int index);
+    void currentResultItemsAboutToBeAppended(int first, int last);
+    void currentResultItemsAppended();
 private:
     QList<PSearchResults> mSearchResults;
     int mCurrentIndex;
@@ -123,6 +127,8 @@ public:
 
 public slots:
     void onResultModelChanged();
+    void onResultItemsAboutToBeAppended(int first, int last);
+    void onResultItemsAppended();
 private:
     SearchResultModel *mSearchResultModel;
     bool mSelectable;
@@ -56,7 +56,9 @@ target("RedPandaIDE")
         "problems/problemcasevalidator.cpp",
         "utils/escape.cpp",
         "utils/font.cpp",
-        "utils/parsearg.cpp")
+        "utils/parsearg.cpp",
+        -- widgets
+        "widgets/codecompletionmatcher.cpp")
 
     add_moc_classes(
         "caretlist",
@@ -64,6 +66,7 @@ target("RedPandaIDE")
         "cpprefacter",
         "editor",
         "editorlist",
+        "filesearcher",
         "iconsmanager",
         "project",
         "projecttemplate",
@@ -78,6 +81,7 @@ target("RedPandaIDE")
         "compiler/executablerunner",
         "compiler/filecompiler",
         "compiler/ojproblemcasesrunner",
+        "compiler/precompiledheaderbuilder",
         "compiler/projectcompiler",
         "compiler/runner",
         "compiler/stdincompiler",
@@ -107,6 +111,7 @@ target("RedPandaIDE")
         "widgets/filenameeditdelegate",
         "widgets/functiontooltipwidget",
         "widgets/headercompletionpopup",
+        "widgets/includedirindex",
         "widgets/issuestable",
         "widgets/labelwithmenu",
         "widgets/lightfusionstyle",
@@ -248,3 +253,126 @@ target("test-escape")
 
     add_files("utils/escape.cpp", "test/escape.cpp")
     add_includedirs(".")
+
+target("test-reparse")
+    set_kind("binary")
+    add_rules("qt.console")
+    add_frameworks("QtGui", "QtWidgets")
+
+    set_default(false)
+    add_tests("test-reparse")
+
+    add_deps("redpanda_qt_utils", "qsynedit")
+    add_files(
+        "parser/cpppreprocessor.cpp",
+        "parser/cpptokenizer.cpp",
+        "parser/parserutils.cpp",
+        "test/parserbench.cpp",
+        "test/reparse.cpp")
+    add_moc_classes(
+        "parser/cppparser",
+        "parser/statementmodel")
+    add_includedirs(".")
+    if is_os("windows") then
+        add_links("psapi")
+    end
+
+target("bench-gdbmi-output")
+    set_kind("binary")
+    add_rules("qt.console")
+
+    set_default(false)
+
+    add_files("debugger/gdbmiresultparser.cpp", "test/gdbmioutput.cpp")
+    add_includedirs(".")
+
+target("bench-glyph-width")
+    set_kind("binary")
+    add_rules("qt.console")
+    add_frameworks("QtGui")
+
+    set_default(false)
+
+    add_deps("redpanda_qt_utils", "qsynedit")
+    add_files("test/glyphwidth.cpp")
+    add_includedirs(".")
+
+target("bench-line-memory")
+    set_kind("binary")
+    add_rules("qt.console")
+    add_frameworks("QtGui")
+
+    set_default(false)
+
+    add_deps("redpanda_qt_utils", "qsynedit")
+    add_files("test/linememory.cpp")
+    add_includedirs(".")
+    if is_os("windows") then
+        add_links("psapi")
+    end
+
+target("bench-parser")
+    set_kind("binary")
+    add_rules("qt.console")
+    add_frameworks("QtGui", "QtWidgets")
+
+    set_default(false)
+
+    add_deps("redpanda_qt_utils", "qsynedit")
+    add_files(
+        "parser/cpppreprocessor.cpp",
+        "parser/cpptokenizer.cpp",
+        "parser/parserutils.cpp",
+        "test/parserbench.cpp",
+        "test/tokenize.cpp")
+    add_moc_classes(
+        "parser/cppparser",
+        "parser/statementmodel")
+    add_includedirs(".")
+    if is_os("windows") then
+        add_links("psapi")
+    end
+
+target("bench-preprocessor")
+    set_kind("binary")
+    add_rules("qt.console")
+    add_frameworks("QtGui", "QtWidgets")
+
+    set_default(false)
+
+    add_deps("redpanda_qt_utils", "qsynedit")
+    add_files(
+        "parser/cpppreprocessor.cpp",
+        "parser/cpptokenizer.cpp",
+        "parser/parserutils.cpp",
+        "test/parserbench.cpp",
+        "test/preprocess.cpp")
+    add_moc_classes(
+        "parser/cppparser",
+        "parser/statementmodel")
+    add_includedirs(".")
+    if is_os("windows") then
+        add_links("psapi")
+    end
+
+target("bench-parse-files")
+    set_kind("binary")
+    add_rules("qt.console")
+    add_frameworks("QtGui", "QtWidgets")
+
+    set_default(false)
+
+    add_deps("redpanda_qt_utils", "qsynedit")
+    add_files(
+        "parser/cpppreprocessor.cpp",
+        "parser/cpptokenizer.cpp",
+        "parser/parserutils.cpp",
+        "test/parserbench.cpp",
+        "test/parsefiles.cpp")
+    add_moc_classes(
+        "parser/cppparser",
+        "parser/statementmodel")
+    add_includedirs(".")
+    if is_os("windows") then
+        add_links("psapi")
+    end
@@ -16,6 +16,7 @@
  */
 #include "codefolding.h"
 #include "constants.h"
+#include <algorithm>
 
 
 namespace QSynedit {
@@ -49,6 +50,8 @@ void CodeFoldingRange::move(int count)
 {
     fromLine += count;
     toLine += count;
+    if (closingLine>=0)
+        closingLine += count;
 }
 
 CodeFoldingRange::CodeFoldingRange(PCodeFoldingRange parent,
@@ -56,6 +59,7 @@ CodeFoldingRange::CodeFoldingRange(PCodeFoldingRange parent,
                                    int toLine):
     fromLine(fromLine),
     toLine(toLine),
+    closingLine(-1),
     linesCollapsed(0),
     collapsed(false),
     parent(parent)
@@ -107,11 +111,34 @@ void CodeFoldingRanges::remove(int index)
     mRanges.remove(index);
 }
 
+void CodeFoldingRanges::replace(int index, int count, const QVector<PCodeFoldingRange> &ranges)
+{
+    int common = std::min(count, ranges.count());
+    for (int i=0;i<common;i++)
+        mRanges[index+i] = ranges[i];
+    if (count > common)
+        mRanges.remove(index+common, count-common);
+    else {
+        mRanges.insert(index+common, ranges.count()-common, PCodeFoldingRange());
+        for (int i=common;i<ranges.count();i++)
+            mRanges[index+i] = ranges[i];
+    }
+}
+
 void CodeFoldingRanges::add(PCodeFoldingRange foldRange)
 {
     mRanges.push_back(foldRange);
 }
 
+int CodeFoldingRanges::findFirstFrom(int fromLine) const
+{
+    auto it = std::lower_bound(mRanges.begin(), mRanges.end(), fromLine,
+                               [](const PCodeFoldingRange& range, int line) {
+        return range->fromLine < line;
+    });
+    return it - mRanges.begin();
+}
+
 PCodeFoldingRange CodeFoldingRanges::operator[](int index) const
 {
     return mRanges[index];
@@ -52,7 +52,11 @@ public:
 
     void insert(int index, PCodeFoldingRange range);
     void remove(int index);
+    // replace count ranges from index with the given ranges
+    void replace(int index, int count, const QVector<PCodeFoldingRange>& ranges);
     void add(PCodeFoldingRange foldRange);
+    // index of the first range whose fromLine >= fromLine, the list must be sorted by fromLine
+    int findFirstFrom(int fromLine) const;
     PCodeFoldingRange operator[](int index) const;
     const QVector<PCodeFoldingRange> &ranges() const;
 
@@ -68,6 +72,7 @@ public:
     CodeFoldingRange& operator=(const CodeFoldingRange&)=delete;
     int fromLine; // Beginning line
     int toLine; // End line
+    int closingLine; // 0-based index of the line closing the fold, -1 if it's not closed
     int linesCollapsed; // Number of collapsed lines
     PCodeFoldingRanges subFoldRanges; // Sub fold ranges
     bool collapsed; // Is collapsed?
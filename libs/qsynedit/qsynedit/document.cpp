@@ -19,15 +19,28 @@
 #include <QDataStream>
 #include <QFile>
 #include <QTextStream>
+#include <QThread>
+#include <QTimer>
 #include <QMutexLocker>
 #include <stdexcept>
 #include <QMessageBox>
 #include <cmath>
 #include <optional>
+#include <limits>
+#include <string.h>
 #include "qt_utils/charsetinfo.h"
 #include <QDateTime>
 #include <QDebug>
 
+// lines whose tokens are cached for painting, all caches are dropped when exceeded
+#define MAX_CACHED_TOKEN_RUNS_LINES 4096
+// utf-8 files larger than this are loaded in stages, when it's requested
+#define STAGED_LOAD_MIN_SIZE (8*1024*1024)
+// bytes of lines shown before loadFromFile() returns
+#define STAGED_LOAD_FIRST_PART_SIZE (64*1024)
+// bytes of lines added each time the event loop is idle
+#define STAGED_LOAD_PART_SIZE (2*1024*1024)
+
 namespace QSynedit {
 
 Document::Document(const QFont& font, QObject *parent):
@@ -41,11 +54,9 @@ Document::Document(const QFont& font, QObject *parent):
     mNewlineType = NewlineType::Windows;
     mIndexOfLongestLine = -1;
     mUpdateCount = 0;
-    mUpdateDocumentLineWidthFunc = std::bind(&GlyphCalculator::calcLineWidth,
-        &mGlyphCalculator,
-        std::placeholders::_1,
-        std::placeholders::_2,
-        std::placeholders::_3);
+    mTokenRunsCount = 0;
+    mPendingPos = 0;
+    mPendingAllAscii = false;
 }
 
 static void listIndexOutOfBounds(int index) {
@@ -56,6 +67,7 @@ static void listIndexOutOfBounds(int index) {
 
 int Document::parenthesisLevel(int line) const
 {
+    requestSyntaxState(line);
     QMutexLocker locker(&mMutex);
     if (line>=0 && line < mLines.size()) {
         return mLines[line]->syntaxState().parenthesisLevel;
@@ -65,6 +77,7 @@ int Document::parenthesisLevel(int line) const
 
 int Document::bracketLevel(int line) const
 {
+    requestSyntaxState(line);
     QMutexLocker locker(&mMutex);
     if (line>=0 && line < mLines.size()) {
         return mLines[line]->syntaxState().bracketLevel;
@@ -74,6 +87,7 @@ int Document::bracketLevel(int line) const
 
 int Document::braceLevel(int line) const
 {
+    requestSyntaxState(line);
     QMutexLocker locker(&mMutex);
     if (line>=0 && line < mLines.size()) {
         return mLines[line]->syntaxState().braceLevel;
@@ -107,6 +121,7 @@ int Document::lineWidth(int line, const QString &newText) const
 
 int Document::blockLevel(int line) const
 {
+    requestSyntaxState(line);
     QMutexLocker locker(&mMutex);
     if (line>=0 && line < mLines.size()) {
         return mLines[line]->syntaxState().blockLevel;
@@ -116,6 +131,7 @@ int Document::blockLevel(int line) const
 
 int Document::blockStarted(int line) const
 {
+    requestSyntaxState(line);
     QMutexLocker locker(&mMutex);
     if (line>=0 && line < mLines.size()) {
         return mLines[line]->syntaxState().blockStarted;
@@ -125,6 +141,7 @@ int Document::blockStarted(int line) const
 
 int Document::blockEnded(int line) const
 {
+    requestSyntaxState(line);
     QMutexLocker locker(&mMutex);
     if (line>=0 && line < mLines.size()) {
         int result = mLines[line]->syntaxState().blockEnded;
@@ -158,8 +175,21 @@ QString Document::lineBreak() const
     return "\n";
 }
 
+void Document::setSyntaxStateRequestProc(const SyntaxStateRequestProc &proc)
+{
+    mSyntaxStateRequestProc = proc;
+}
+
+void Document::requestSyntaxState(int line) const
+{
+    //the syntaxer of the editor can't be used in other threads
+    if (mSyntaxStateRequestProc && QThread::currentThread()==thread())
+        mSyntaxStateRequestProc(line);
+}
+
 SyntaxState Document::getSyntaxState(int line) const
 {
+    requestSyntaxState(line);
     QMutexLocker locker(&mMutex);
     if (line>=0 && line < mLines.size()) {
         return mLines[line]->syntaxState();
@@ -172,8 +202,7 @@ SyntaxState Document::getSyntaxState(int line) const
 void Document::insertItem(int line, const QString &s)
 {
     beginUpdate();
-    PDocumentLine documentLine = std::make_shared<DocumentLine>(
-                mUpdateDocumentLineWidthFunc);
+    PDocumentLine documentLine = std::make_shared<DocumentLine>(&mGlyphCalculator);
     documentLine->setLineText(s);
     mLines.insert(line,documentLine);
     mIndexOfLongestLine = -1;
@@ -183,7 +212,7 @@ void Document::insertItem(int line, const QString &s)
 void Document::addItem(const QString &s)
 {
     beginUpdate();
-    PDocumentLine line = std::make_shared<DocumentLine>(mUpdateDocumentLineWidthFunc);
+    PDocumentLine line = std::make_shared<DocumentLine>(&mGlyphCalculator);
     line->setLineText(s);
     mLines.append(line);
     endUpdate();
@@ -207,7 +236,65 @@ void Document::setSyntaxState(int line, const SyntaxState& state)
     if (line<0 || line>=mLines.count()) {
         listIndexOutOfBounds(line);
     }
-    mLines[line]->setSyntaxState(state);
+    mLines[line]->setSyntaxState(mSyntaxStatePool.intern(state));
+}
+
+bool Document::updateSyntaxState(int line, const SyntaxState &state)
+{
+    QMutexLocker locker(&mMutex);
+    if (line<0 || line>=mLines.count()) {
+        listIndexOutOfBounds(line);
+    }
+    PSyntaxState newState = mSyntaxStatePool.intern(state);
+    if (newState == mLines[line]->syntaxStateHandle())
+        return false;
+    mLines[line]->setSyntaxState(newState);
+    return true;
+}
+
+PLineTokenRuns Document::getTokenRuns(int line, int generation) const
+{
+    QMutexLocker locker(&mMutex);
+    if (line<0 || line>=mLines.count()) {
+        return PLineTokenRuns();
+    }
+    const PLineTokenRuns& tokenRuns = mLines[line]->mTokenRuns;
+    if (!tokenRuns || tokenRuns->generation != generation)
+        return PLineTokenRuns();
+    if (line == 0) {
+        if (tokenRuns->startState)
+            return PLineTokenRuns();
+    } else if (tokenRuns->startState != mLines[line-1]->syntaxStateHandle()) {
+        return PLineTokenRuns();
+    }
+    return tokenRuns;
+}
+
+void Document::setTokenRuns(int line, const PLineTokenRuns &tokenRuns)
+{
+    QMutexLocker locker(&mMutex);
+    if (line<0 || line>=mLines.count()) {
+        listIndexOutOfBounds(line);
+    }
+    //only lines near the visible area are worth caching
+    if (mTokenRunsCount >= MAX_CACHED_TOKEN_RUNS_LINES)
+        clearTokenRuns();
+    if (line == 0)
+        tokenRuns->startState = PSyntaxState();
+    else
+        tokenRuns->startState = mLines[line-1]->syntaxStateHandle();
+    if (!mLines[line]->mTokenRuns)
+        mTokenRunsCount++;
+    mLines[line]->mTokenRuns = tokenRuns;
+}
+
+void Document::clearTokenRuns()
+{
+    QMutexLocker locker(&mMutex);
+    foreach (const PDocumentLine& line, mLines) {
+        line->mTokenRuns.reset();
+    }
+    mTokenRunsCount = 0;
 }
 
 QString Document::getLine(int line) const
@@ -246,6 +333,8 @@ int Document::count() const
 QString Document::text() const
 {
     QMutexLocker locker(&mMutex);
+    // the rest lines of a staged load are part of the text
+    const_cast<Document*>(this)->finishLoading();
     return getTextStr();
 }
 
@@ -277,6 +366,7 @@ void Document::setContents(const QStringList &text)
 QStringList Document::contents() const
 {
     QMutexLocker locker(&mMutex);
+    const_cast<Document*>(this)->finishLoading();
     QStringList result;
     DocumentLines list = mLines;
     foreach (const PDocumentLine& line, list) {
@@ -335,6 +425,7 @@ void Document::addLines(const QStringList &strings)
 int Document::getTextLength() const
 {
     QMutexLocker locker(&mMutex);
+    const_cast<Document*>(this)->finishLoading();
     int Result = 0;
     foreach (const PDocumentLine& line, mLines ) {
         Result += line->glyphsCount();
@@ -489,7 +580,7 @@ void Document::insertLines(int index, int numLines)
     PDocumentLine line;
     mLines.insert(index,numLines,line);
     for (int i=index;i<index+numLines;i++) {
-        line = std::make_shared<DocumentLine>(mUpdateDocumentLineWidthFunc);
+        line = std::make_shared<DocumentLine>(&mGlyphCalculator);
         mLines[i]=line;
     }
     mIndexOfLongestLine = -1;
@@ -497,33 +588,101 @@ void Document::insertLines(int index, int numLines)
 }
 
 
-bool Document::tryLoadFileByEncoding(QByteArray encodingName, QFile& file) {
+bool Document::tryLoadFileByEncoding(QByteArray encodingName, const QByteArray& content) {
     TextDecoder decoder(encodingName);
     if (!decoder.isValid())
         return false;
-    file.reset();
+    auto [ok, text] = decoder.decode(content);
+    if (!ok)
+        return false;
     internalClear();
-    while (true) {
-        if (file.atEnd()){
-            break;
-        }
-        QByteArray line = file.readLine();
-        if (line.endsWith("\r\n")) {
-            line.remove(line.length()-2,2);
-        } else if (line.endsWith("\r")) {
-            line.remove(line.length()-1,1);
-        } else if (line.endsWith("\n")){
-            line.remove(line.length()-1,1);
-        }
-        auto [ok, newLine] = decoder.decode(line);
-        if (!ok) {
-            return false;
-        }
-        addItem(newLine);
+    const QChar* p = text.constData();
+    const QChar* end = p + text.length();
+    while (p<end) {
+        const QChar* lineStart = p;
+        while (p<end && *p!='\n')
+            p++;
+        const QChar* lineEnd = p;
+        if (lineEnd>lineStart && *(lineEnd-1)=='\r')
+            lineEnd--;
+        addItem(QString(lineStart, lineEnd-lineStart));
+        if (p<end)
+            p++;
     }
     return true;
 }
 
+int Document::addContentLines(const QByteArray &content, int start, int maxSize, bool allAscii)
+{
+    const char* p = content.constData() + start;
+    const char* end = content.constData() + content.length();
+    // the line crossing the limit is added whole
+    const char* limit = (maxSize < end-p) ? p+maxSize : end;
+    while (p<limit) {
+        const char* lineStart = p;
+        p = (const char*)memchr(p, '\n', end-p);
+        if (!p)
+            p = end;
+        const char* lineEnd = p;
+        if (lineEnd>lineStart && *(lineEnd-1)=='\r')
+            lineEnd--;
+        // not by addItem(), staged loads don't emit changing() / changed() for each line
+        PDocumentLine line = std::make_shared<DocumentLine>(&mGlyphCalculator);
+        if (allAscii)
+            line->setLineText(QString::fromLatin1(lineStart, lineEnd-lineStart));
+        else
+            line->setLineText(QString::fromUtf8(lineStart, lineEnd-lineStart));
+        mLines.append(line);
+        if (p<end)
+            p++;
+    }
+    return p - content.constData();
+}
+
+void Document::loadPendingLines(int maxSize)
+{
+    int oldCount = mLines.count();
+    beginSetLinesWidth();
+    mPendingPos = addContentLines(mPendingContent, mPendingPos, maxSize, mPendingAllAscii);
+    endSetLinesWidth();
+    qint64 loadedSize = mPendingPos;
+    qint64 totalSize = mPendingContent.length();
+    if (loadedSize >= totalSize) {
+        mPendingContent = QByteArray();
+        mPendingPos = 0;
+    }
+    if (mLines.count()>oldCount)
+        emit inserted(oldCount, mLines.count()-oldCount);
+    emit loadingProgress(loadedSize, totalSize);
+    if (loadedSize >= totalSize)
+        emit loaded();
+}
+
+void Document::loadNextPart()
+{
+    QMutexLocker locker(&mMutex);
+    if (mPendingContent.isEmpty())
+        return;
+    loadPendingLines(STAGED_LOAD_PART_SIZE);
+    if (!mPendingContent.isEmpty())
+        QTimer::singleShot(0, this, &Document::loadNextPart);
+}
+
+bool Document::loading() const
+{
+    QMutexLocker locker(&mMutex);
+    return !mPendingContent.isEmpty();
+}
+
+void Document::finishLoading()
+{
+    QMutexLocker locker(&mMutex);
+    // Called from other threads, the signals are queued to the editor
+    // and the lines are added at once here.
+    if (!mPendingContent.isEmpty())
+        loadPendingLines(mPendingContent.length());
+}
+
 void Document::loadUTF16BOMFile(QFile &file)
 {
     TextDecoder decoder = TextDecoder::decoderForUtf16();
@@ -584,7 +743,87 @@ void Document::setForceMonospace(bool newForceMonospace)
         invalidateAllLineWidth();
 }
 
-void Document::loadFromFile(const QString& filename, const QByteArray& encoding, QByteArray& realEncoding)
+/**
+ * Checks the text in one pass.
+ * Eight bytes are tested at a time while they are ascii,
+ * other bytes are validated as utf-8 sequences.
+ */
+static void checkTextContent(const char* data, qint64 length, bool &hasZero, bool &allAscii, bool &validUtf8)
+{
+    const quint64 highBits = 0x8080808080808080ULL;
+    const quint64 lowBits = 0x0101010101010101ULL;
+    const uchar* p = (const uchar*)data;
+    const uchar* end = p + length;
+    hasZero = false;
+    allAscii = true;
+    validUtf8 = true;
+    while (p<end) {
+        if (end-p>=8) {
+            quint64 v;
+            memcpy(&v, p, 8);
+            if ((v - lowBits) & ~v & highBits) {
+                hasZero = true;
+                return;
+            }
+            if ((v & highBits) == 0) {
+                p += 8;
+                continue;
+            }
+        }
+        uchar ch = *p;
+        if (ch == 0) {
+            hasZero = true;
+            return;
+        }
+        if (ch < 0x80) {
+            p++;
+            continue;
+        }
+        allAscii = false;
+        if (!validUtf8) {
+            // go on to find zero bytes
+            p++;
+            continue;
+        }
+        int n;
+        quint32 codePoint;
+        if (ch>=0xC2 && ch<=0xDF) {
+            n = 1;
+            codePoint = ch & 0x1F;
+        } else if (ch>=0xE0 && ch<=0xEF) {
+            n = 2;
+            codePoint = ch & 0x0F;
+        } else if (ch>=0xF0 && ch<=0xF4) {
+            n = 3;
+            codePoint = ch & 0x07;
+        } else {
+            validUtf8 = false;
+            p++;
+            continue;
+        }
+        if (end-p<=n) {
+            validUtf8 = false;
+            p++;
+            continue;
+        }
+        for (int i=1;i<=n;i++) {
+            if ((p[i] & 0xC0) != 0x80) {
+                validUtf8 = false;
+                break;
+            }
+            codePoint = (codePoint << 6) | (p[i] & 0x3F);
+        }
+        if (validUtf8) {
+            // overlong sequences, surrogates and code points out of range
+            if ((n==2 && (codePoint<0x800 || (codePoint>=0xD800 && codePoint<=0xDFFF)))
+                    || (n==3 && (codePoint<0x10000 || codePoint>0x10FFFF)))
+                validUtf8 = false;
+        }
+        p += validUtf8 ? n+1 : 1;
+    }
+}
+
+void Document::loadFromFile(const QString& filename, const QByteArray& encoding, QByteArray& realEncoding, bool inStages)
 {
     QMutexLocker locker(&mMutex);
     QFile file(filename);
@@ -603,75 +842,65 @@ void Document::loadFromFile(const QString& filename, const QByteArray& encoding,
             realEncoding = ENCODING_ASCII;
             return;
         }
-        QByteArray line = file.readLine();
-        std::optional<TextDecoder> decoder;
-        bool needReread = false;
-        bool allAscii = true;
+        // The file is mapped (or read at once) and checked in one pass,
+        // so it's not decoded line by line and reread when it's not utf-8.
+        QByteArray content;
+        uchar* mappedData = (file.size()<=std::numeric_limits<int>::max())?file.map(0, file.size()):nullptr;
+        if (mappedData)
+            content = QByteArray::fromRawData((const char*)mappedData, file.size());
+        else
+            content = file.readAll();
+        int start = 0;
         //test for BOM
-        if ((line.length()>=3) && ((unsigned char)line[0]==0xEF) && ((unsigned char)line[1]==0xBB) && ((unsigned char)line[2]==0xBF) ) {
+        if ((content.length()>=3) && ((unsigned char)content[0]==0xEF) && ((unsigned char)content[1]==0xBB) && ((unsigned char)content[2]==0xBF) ) {
             realEncoding = ENCODING_UTF8_BOM;
-            line = line.mid(3);
-            decoder = TextDecoder::decoderForUtf8();
-        } else if ((line.length()>=4) && ((unsigned char)line[0]==0xFF) && ((unsigned char)line[1]==0xFE)
-                   && ((unsigned char)line[2]==0x00)
-                   && ((unsigned char)line[3]==0x00)) {
+            start = 3;
+        } else if ((content.length()>=4) && ((unsigned char)content[0]==0xFF) && ((unsigned char)content[1]==0xFE)
+                   && ((unsigned char)content[2]==0x00)
+                   && ((unsigned char)content[3]==0x00)) {
             realEncoding = ENCODING_UTF32_BOM;
             loadUTF32BOMFile(file);
             return;
-        } else if ((line.length()>=2) && ((unsigned char)line[0]==0xFF) && ((unsigned char)line[1]==0xFE)) {
+        } else if ((content.length()>=2) && ((unsigned char)content[0]==0xFF) && ((unsigned char)content[1]==0xFE)) {
             realEncoding = ENCODING_UTF16_BOM;
             loadUTF16BOMFile(file);
             return;
         } else {
             realEncoding = ENCODING_UTF8;
-            decoder = TextDecoder::decoderForUtf8();
         }
-        if (!decoder.has_value())
-            throw FileError(tr("Can't load codec '%1'!").arg(QString(realEncoding)));
-        if (line.endsWith("\r\n")) {
-            mNewlineType = NewlineType::Windows;
-        } else if (line.endsWith("\n")) {
-            mNewlineType = NewlineType::Unix;
-        } else if (line.endsWith("\r")) {
+        const char* firstLineEnd = (const char*)memchr(content.constData()+start, '\n', content.length()-start);
+        if (firstLineEnd) {
+            if (firstLineEnd>content.constData()+start && *(firstLineEnd-1)=='\r')
+                mNewlineType = NewlineType::Windows;
+            else
+                mNewlineType = NewlineType::Unix;
+        } else if (content.endsWith("\r")) {
             mNewlineType = NewlineType::MacOld;
         }
 
-        internalClear();
-        while (true) {
-            if (line.endsWith("\r\n")) {
-                line.remove(line.length()-2,2);
-            } else if (line.endsWith("\r")) {
-                line.remove(line.length()-1,1);
-            } else if (line.endsWith("\n")){
-                line.remove(line.length()-1,1);
-            }
-            if (isBinaryContent(line))
-                throw BinaryFileError(tr("'%1' is a binaray File!").arg(filename));
-            if (allAscii) {
-                allAscii = isTextAllAscii(line);
-            }
-            if (allAscii) {
-                addItem(QString::fromLatin1(line));
+        bool hasZero, allAscii, validUtf8;
+        checkTextContent(content.constData()+start, content.length()-start, hasZero, allAscii, validUtf8);
+        if (hasZero)
+            throw BinaryFileError(tr("'%1' is a binaray File!").arg(filename));
+        if (validUtf8) {
+            internalClear();
+            if (inStages && content.length()-start > STAGED_LOAD_MIN_SIZE) {
+                // the first screen is shown at once, the rest lines are added by loadNextPart()
+                start = addContentLines(content, start, STAGED_LOAD_FIRST_PART_SIZE, allAscii);
+                // the mapping is released when we return, so the rest is copied
+                mPendingContent = QByteArray(content.constData()+start, content.length()-start);
+                mPendingPos = 0;
+                mPendingAllAscii = allAscii;
+                QTimer::singleShot(0, this, &Document::loadNextPart);
             } else {
-                auto [ok, newLine] = decoder->decode(line);
-                if (!ok) {
-                    needReread = true;
-                    break;
-                }
-                addItem(newLine);
-            }
-            if (file.atEnd()){
-                break;
+                addContentLines(content, start, content.length()-start, allAscii);
             }
-            line = file.readLine();
-        }
-        if (!needReread) {
             if (allAscii)
                 realEncoding = ENCODING_ASCII;
             return;
         }
         realEncoding = pCharsetInfoManager->getDefaultSystemEncoding();
-        if (tryLoadFileByEncoding(realEncoding,file)) {
+        if (tryLoadFileByEncoding(realEncoding,content)) {
             return;
         }
         QList<PCharsetInfo> charsets = pCharsetInfoManager->findCharsetByLocale(pCharsetInfoManager->localeName());
@@ -685,7 +914,7 @@ void Document::loadFromFile(const QString& filename, const QByteArray& encoding,
             foreach (const QByteArray& encodingName,encodingSet) {
                 if (encodingName == ENCODING_UTF8)
                     continue;
-                if (tryLoadFileByEncoding(encodingName,file)) {
+                if (tryLoadFileByEncoding(encodingName,content)) {
                     //qDebug()<<encodingName;
                     realEncoding = encodingName;
                     return;
@@ -755,6 +984,7 @@ void Document::saveToFile(QFile &file, const QByteArray& encoding,
     if (!encoder.has_value() || !encoder->isValid())
         throw FileError(tr("Can't load codec '%1'!").arg(codecName));
 
+    finishLoading();
     if (!file.open(QFile::WriteOnly | QFile::Truncate))
         throw FileError(tr("Can't open file '%1' for save!").arg(file.fileName()));
     if (mLines.isEmpty())
@@ -803,8 +1033,7 @@ QString Document::glyphAt(int line, int charPos) const
     QMutexLocker locker(&mMutex);
     if (line<0 || line>=count())
         return QString();
-    QList<int> glyphStartCharList = mLines[line]->glyphStartCharList();
-    int glyphIdx = charToGlyphIndex(mLines[line]->lineText(), glyphStartCharList, charPos);
+    int glyphIdx = mLines[line]->charToGlyphIndex(charPos);
     return mLines[line]->glyph(glyphIdx);
 }
 
@@ -813,8 +1042,7 @@ int Document::charToGlyphStartChar(int line, int charPos) const
     QMutexLocker locker(&mMutex);
     if (line<0 || line>=count())
         return 0;
-    QList<int> glyphStartCharList = mLines[line]->glyphStartCharList();
-    int glyphIdx = charToGlyphIndex(mLines[line]->lineText(), glyphStartCharList, charPos);
+    int glyphIdx = mLines[line]->charToGlyphIndex(charPos);
     return mLines[line]->glyphStartChar(glyphIdx);
 }
 
@@ -826,9 +1054,27 @@ int Document::charToGlyphStartChar(int line, int charPos) const
 //     return mLines[line]->glyphStartColumn(glyphIdx);
 // }
 
+static bool isAsciiText(const QString &text)
+{
+    // branchless, so the compiler can vectorize it
+    const ushort* p = reinterpret_cast<const ushort*>(text.constData());
+    int len = text.length();
+    ushort bits = 0;
+    for (int i=0;i<len;i++)
+        bits |= p[i];
+    return bits < 0x80;
+}
+
 QList<int> calcGlyphStartCharList(const QString &text)
 {
     QList<int> glyphStartCharList;
+    if (isAsciiText(text)) {
+        //each ascii char is a glyph
+        glyphStartCharList.reserve(text.length());
+        for (int i=0;i<text.length();i++)
+            glyphStartCharList.append(i);
+        return glyphStartCharList;
+    }
     //parse mGlyphs
     int i=0;
     bool consecutive = false;
@@ -883,11 +1129,11 @@ int GlyphCalculator::stringWidth(const QString &str, int left) const
     return right - left;
 }
 
-int GlyphCalculator::stringWidth(const QString &str, int left, const QFontMetrics &fontMetrics)
+int GlyphCalculator::stringWidth(const QString &str, int left, const QFont &font)
 {
     QList<int> glyphStartCharList = calcGlyphStartCharList(str);
     int right;
-    calcGlyphPositionList(str, glyphStartCharList, fontMetrics, left, right);
+    calcGlyphPositionList(str, glyphStartCharList, font, left, right);
     return right - left;
 }
 
@@ -936,8 +1182,7 @@ int Document::charToGlyphIndex(int line, int charIdx) const
     QMutexLocker locker(&mMutex);
     if (line<0 || line>=count())
         return 0;
-    QList<int> glyphStartCharList = mLines[line]->glyphStartCharList();
-    return charToGlyphIndex(mLines[line]->lineText(), glyphStartCharList, charIdx);
+    return mLines[line]->charToGlyphIndex(charIdx);
 }
 
 int Document::charToGlyphIndex(const QString& str, QList<int> glyphStartCharList, int charIdx) const
@@ -956,11 +1201,14 @@ int Document::charToGlyphIndex(const QString& str, QList<int> glyphStartCharList
     // return glyphStartCharList.length()-1;
 }
 
-QList<int> GlyphCalculator::calcGlyphPositionList(const QString &lineText, const QList<int> &glyphStartCharList, const QFontMetrics &fontMetrics, int left, int &right) const
+QList<int> GlyphCalculator::calcGlyphPositionList(const QString &lineText, const QList<int> &glyphStartCharList, const QFont &font, int left, int &right) const
 {
+    QMutexLocker locker(&mWidthCacheMutex);
+    GlyphWidthCache* cache = widthCache(font);
     right = std::max(0,left);
     int start,end;
     QList<int> glyphPostionList;
+    glyphPostionList.reserve(glyphStartCharList.length());
     for (int i=0;i<glyphStartCharList.length();i++) {
         start = glyphStartCharList[i];
         if (i+1<glyphStartCharList.length()) {
@@ -968,8 +1216,22 @@ QList<int> GlyphCalculator::calcGlyphPositionList(const QString &lineText, const
         } else {
             end = lineText.length();
         }
-        QString glyph = lineText.mid(start,end-start);
-        int gWidth = glyphWidth(glyph, right, fontMetrics, mForceMonospace);
+        int gWidth = cachedGlyphWidth(lineText, start, end, right, cache, mForceMonospace);
+        glyphPostionList.append(right);
+        right += gWidth;
+    }
+    return glyphPostionList;
+}
+
+QList<int> GlyphCalculator::calcAsciiGlyphPositionList(const QString &lineText, int left, int &right) const
+{
+    QMutexLocker locker(&mWidthCacheMutex);
+    GlyphWidthCache* cache = widthCache(mFont);
+    right = std::max(0,left);
+    QList<int> glyphPostionList;
+    glyphPostionList.reserve(lineText.length());
+    for (int i=0;i<lineText.length();i++) {
+        int gWidth = cachedGlyphWidth(lineText, i, i+1, right, cache, mForceMonospace);
         glyphPostionList.append(right);
         right += gWidth;
     }
@@ -1003,8 +1265,7 @@ int Document::charToGlyphStartPosition(int line, int charPos) const
     QMutexLocker locker(&mMutex);
     if (line<0 || line>=count())
         return 0;
-    QList<int> glyphStartCharList = mLines[line]->glyphStartCharList();
-    int glyphIdx = charToGlyphIndex(mLines[line]->lineText(), glyphStartCharList, charPos);
+    int glyphIdx = mLines[line]->charToGlyphIndex(charPos);
     return mLines[line]->glyphStartPosition(glyphIdx);
 }
 
@@ -1117,10 +1378,14 @@ void Document::putTextStr(const QString &text)
 
 void Document::internalClear()
 {
+    mPendingContent = QByteArray();
+    mPendingPos = 0;
     if (!mLines.isEmpty()) {
         beginUpdate();
         int oldCount = mLines.count();
         mLines.clear();
+        mSyntaxStatePool.clear();
+        mTokenRunsCount = 0;
         mIndexOfLongestLine = -1;
         emit deleted(0,oldCount);
         endUpdate();
@@ -1175,7 +1440,7 @@ void Document::setLineWidth(int line, int newWidth, const QList<int> glyphStartP
         mIndexOfLongestLine = line;
         updateMaxLineWidthChanged();
     }
-    Q_ASSERT(mLines[line]->mGlyphStartPositionList.length() == mLines[line]->mGlyphStartCharList.length());
+    Q_ASSERT(mLines[line]->mGlyphStartPositionList.length() == mLines[line]->glyphsCount());
 }
 
 void Document::updateMaxLineWidthChanged()
@@ -1207,6 +1472,8 @@ void Document::updateMaxLineWidthAndNotify()
 
 QList<int> GlyphCalculator::calcGlyphPositionList(const QString &lineText, int &width) const
 {
+    if (isAsciiText(lineText))
+        return calcAsciiGlyphPositionList(lineText, 0, width);
     QList<int> glyphStartCharList = calcGlyphStartCharList(lineText);
     return calcGlyphPositionList(lineText,glyphStartCharList,0,width);
 }
@@ -1271,22 +1538,50 @@ void Document::invalidateAllNonTempLineWidth()
     }
 }
 
-DocumentLine::DocumentLine(DocumentLine::UpdateWidthFunc updateWidthFunc):
-    mSyntaxState{},
+DocumentLine::DocumentLine(const GlyphCalculator* glyphCalculator):
+    mSyntaxState{SyntaxStatePool::defaultState()},
     mWidth{-1},
     mIsTempWidth{true},
-    mUpdateWidthFunc{updateWidthFunc}
+    mIsAscii{true},
+    mGlyphStartCharListValid{true},
+    mGlyphCalculator{glyphCalculator}
+{
+}
+
+int DocumentLine::glyphsCount() const
+{
+    if (mIsAscii)
+        return mLineText.length();
+    return glyphStartCharList().length();
+}
+
+const QList<int> &DocumentLine::glyphStartCharList() const
+{
+    if (!mGlyphStartCharListValid) {
+        mGlyphStartCharList = calcGlyphStartCharList(mLineText);
+        mGlyphStartCharListValid = true;
+    }
+    return mGlyphStartCharList;
+}
+
+int DocumentLine::charToGlyphIndex(int charIdx) const
 {
+    Q_ASSERT(charIdx>=0);
+    if (mIsAscii)
+        return std::min(charIdx, (int)mLineText.length());
+    return searchForSegmentIdx(glyphStartCharList(), 0, mLineText.length(), charIdx);
 }
 
 int DocumentLine::glyphLength(int i) const
 {
-    return calcSegmentInterval(mGlyphStartCharList, mLineText.length(), i);
+    if (mIsAscii)
+        return (i>=0 && i<mLineText.length())?1:0;
+    return calcSegmentInterval(glyphStartCharList(), mLineText.length(), i);
 }
 
 QString DocumentLine::glyph(int i) const
 {
-   if (i<0 || i>=mGlyphStartCharList.length())
+   if (i<0 || i>=glyphsCount())
        return QString();
    return mLineText.mid(glyphStartChar(i),glyphLength(i));
 }
@@ -1319,14 +1614,20 @@ int DocumentLine::width()
 void DocumentLine::setLineText(const QString &newLineText)
 {
     mLineText = newLineText;
-    mGlyphStartCharList = calcGlyphStartCharList(newLineText);
+    mIsAscii = isAsciiText(newLineText);
+    mGlyphStartCharList.clear();
+    mGlyphStartCharListValid = false;
+    mTokenRuns.reset();
     invalidateWidth();
 }
 
 void DocumentLine::updateWidth()
 {
-    Q_ASSERT(mUpdateWidthFunc!=nullptr);
-    mGlyphStartPositionList = mUpdateWidthFunc(mLineText, mGlyphStartCharList, mWidth);
+    Q_ASSERT(mGlyphCalculator!=nullptr);
+    if (mIsAscii)
+        mGlyphStartPositionList = mGlyphCalculator->calcAsciiGlyphPositionList(mLineText, 0, mWidth);
+    else
+        mGlyphStartPositionList = mGlyphCalculator->calcGlyphPositionList(mLineText, glyphStartCharList(), 0, mWidth);
 //    qDebug()<<"Update Width"<<mLineText<<mWidth<<mGlyphPositionList;
 }
 
@@ -1341,9 +1642,12 @@ int DocumentLine::glyphStartChar(int i) const
 {
    if (i<0)
        return 0;
-   if (i>=mGlyphStartCharList.length())
+   if (mIsAscii)
+       return std::min(i, (int)mLineText.length());
+   const QList<int>& glyphStartCharList = this->glyphStartCharList();
+   if (i>=glyphStartCharList.length())
        return mLineText.length();
-   return mGlyphStartCharList[i];
+   return glyphStartCharList[i];
 }
 
 UndoList::UndoList():QObject()
@@ -1357,6 +1661,10 @@ UndoList::UndoList():QObject()
     mLastPoppedItemChangeNumber=0;
     mInitialChangeNumber = 0;
     mLastRestoredItemChangeNumber=0;
+    mMaxUndoActions = 0;
+    mMaxMemoryUsage = 0;
+    mMemoryUsage = 0;
+    mMergeInserts = false;
 }
 
 void UndoList::addChange(ChangeReason reason, const BufferCoord &startPos,
@@ -1369,13 +1677,18 @@ void UndoList::addChange(ChangeReason reason, const BufferCoord &startPos,
     } else {
         changeNumber = getNextChangeNumber();
     }
-    PUndoItem  newItem = std::make_shared<UndoItem>(
-                reason,
-                selMode,startPos,endPos,changeText,
-                changeNumber);
-    mItems.append(newItem);
+    if (reason!=ChangeReason::Insert
+            || !tryMergeInsert(startPos,endPos,changeText,selMode,changeNumber)) {
+        PUndoItem  newItem = std::make_shared<UndoItem>(
+                    reason,
+                    selMode,startPos,endPos,changeText,
+                    changeNumber);
+        mItems.append(newItem);
+        mMemoryUsage += newItem->memoryUsage();
+    }
 
     if (reason!=ChangeReason::GroupBreak && !inBlock()) {
+        ensureMaxEntries();
         emit addedUndo();
     }
 }
@@ -1392,6 +1705,7 @@ void UndoList::restoreChange(PUndoItem item)
 {
     size_t changeNumber = item->changeNumber();
     mItems.append(item);
+    mMemoryUsage += item->memoryUsage();
     if (changeNumber>mNextChangeNumber)
         mNextChangeNumber=changeNumber;
     if (changeNumber!=mLastRestoredItemChangeNumber) {
@@ -1422,6 +1736,7 @@ void UndoList::beginBlock()
 void UndoList::clear()
 {
     mItems.clear();
+    mMemoryUsage = 0;
     mFullUndoImposible = false;
     mInitialChangeNumber=0;
     mLastPoppedItemChangeNumber=0;
@@ -1438,6 +1753,7 @@ void UndoList::endBlock()
             size_t iBlockID = mBlockChangeNumber;
             mBlockChangeNumber = 0;
             if (mItems.count() > 0 && peekItem()->changeNumber() == iBlockID) {
+                ensureMaxEntries();
                 emit addedUndo();
             }
         }
@@ -1454,6 +1770,65 @@ unsigned int UndoList::getNextChangeNumber()
     return mNextChangeNumber++;
 }
 
+bool UndoList::tryMergeInsert(const BufferCoord &startPos, const BufferCoord &endPos,
+                              const QStringList &changeText, SelectionMode selMode, size_t changeNumber)
+{
+    if (!mMergeInserts || mItems.isEmpty())
+        return false;
+    if (selMode!=SelectionMode::Normal || !changeText.isEmpty()
+            || startPos.line!=endPos.line)
+        return false;
+    PUndoItem item = mItems.last();
+    if (item->changeReason()!=ChangeReason::Insert
+            || item->changeSelMode()!=SelectionMode::Normal
+            || !item->mChangeText.isEmpty()
+            || item->changeStartPos().line!=item->changeEndPos().line
+            || item->changeEndPos()!=startPos)
+        return false;
+    // Other items of the same change must be undone together with it,
+    // and the saved state must stay reachable by undo.
+    if (item->changeNumber()==changeNumber
+            || item->changeNumber()==mInitialChangeNumber)
+        return false;
+    if (mItems.count()>1 && mItems[mItems.count()-2]->changeNumber()==item->changeNumber())
+        return false;
+    // the merged item takes the new change number, so endBlock() still sees the change
+    item->mergeInsert(endPos, changeNumber);
+    return true;
+}
+
+void UndoList::ensureMaxEntries()
+{
+    if (mItems.isEmpty())
+        return;
+    int count = mItems.count();
+    qint64 usage = mMemoryUsage;
+    size_t lastChangeNumber = mItems.last()->changeNumber();
+    int i=0;
+    // Drop whole changes from the oldest, but never the last change
+    while ( (mMaxUndoActions>0 && count>mMaxUndoActions)
+            || (mMaxMemoryUsage>0 && usage>mMaxMemoryUsage)) {
+        size_t changeNumber = mItems[i]->changeNumber();
+        if (changeNumber == lastChangeNumber)
+            break;
+        while (i<mItems.count() && mItems[i]->changeNumber()==changeNumber) {
+            usage -= mItems[i]->memoryUsage();
+            count--;
+            i++;
+        }
+        // The unmodified state can't be reached by undo anymore.
+        // Use a dropped change number to mark it, so undoing all items
+        // left doesn't make the document unmodified.
+        if (mInitialChangeNumber == 0)
+            mInitialChangeNumber = changeNumber;
+    }
+    if (i>0) {
+        mItems.remove(0,i);
+        mMemoryUsage = usage;
+        mFullUndoImposible = true;
+    }
+}
+
 ChangeReason UndoList::lastChangeReason()
 {
     if (mItems.count() == 0)
@@ -1484,6 +1859,7 @@ PUndoItem UndoList::popItem()
 //        qDebug()<<"popped"<<item->changeNumber()<<item->changeText()<<(int)item->changeReason()<<mLastPoppedItemChangeNumber;
         mLastPoppedItemChangeNumber =  item->changeNumber();
         mItems.removeLast();
+        mMemoryUsage -= item->memoryUsage();
         return item;
     }
 }
@@ -1530,6 +1906,49 @@ bool UndoList::fullUndoImposible() const
     return mFullUndoImposible;
 }
 
+int UndoList::maxUndoActions() const
+{
+    return mMaxUndoActions;
+}
+
+void UndoList::setMaxUndoActions(int maxUndoActions)
+{
+    if (maxUndoActions!=mMaxUndoActions) {
+        mMaxUndoActions = maxUndoActions;
+        if (!inBlock())
+            ensureMaxEntries();
+    }
+}
+
+qint64 UndoList::maxMemoryUsage() const
+{
+    return mMaxMemoryUsage;
+}
+
+void UndoList::setMaxMemoryUsage(qint64 maxMemoryUsage)
+{
+    if (maxMemoryUsage!=mMaxMemoryUsage) {
+        mMaxMemoryUsage = maxMemoryUsage;
+        if (!inBlock())
+            ensureMaxEntries();
+    }
+}
+
+qint64 UndoList::memoryUsage() const
+{
+    return mMemoryUsage;
+}
+
+bool UndoList::mergeInserts() const
+{
+    return mMergeInserts;
+}
+
+void UndoList::setMergeInserts(bool mergeInserts)
+{
+    mMergeInserts = mergeInserts;
+}
+
 SelectionMode UndoItem::changeSelMode() const
 {
     return mChangeSelMode;
@@ -1555,6 +1974,17 @@ size_t UndoItem::changeNumber() const
     return mChangeNumber;
 }
 
+int UndoItem::memoryUsage() const
+{
+    return mMemoryUsage;
+}
+
+void UndoItem::mergeInsert(const BufferCoord &endPos, size_t number)
+{
+    mChangeEndPos = endPos;
+    mChangeNumber = number;
+}
+
 UndoItem::UndoItem(ChangeReason reason, SelectionMode selMode,
                                  BufferCoord startPos, BufferCoord endPos,
                                  const QStringList& text, int number)
@@ -1569,6 +1999,9 @@ UndoItem::UndoItem(ChangeReason reason, SelectionMode selMode,
     foreach (const QString& s, text) {
         length+=s.length();
     }
+    // QString header is about the size of 3 pointers
+    mMemoryUsage = sizeof(UndoItem) + length * sizeof(QChar)
+            + text.count() * 3 * sizeof(void*);
 }
 
 ChangeReason UndoItem::changeReason() const
@@ -1576,7 +2009,8 @@ ChangeReason UndoItem::changeReason() const
     return mChangeReason;
 }
 
-RedoList::RedoList()
+RedoList::RedoList():
+    mMemoryUsage{0}
 {
 
 }
@@ -1587,17 +2021,19 @@ void RedoList::addRedo(ChangeReason AReason, const BufferCoord &AStart, const Bu
                 AReason,
                 SelMode,AStart,AEnd,ChangeText,
                 changeNumber);
-    mItems.append(newItem);
+    addRedo(newItem);
 }
 
 void RedoList::addRedo(PUndoItem item)
 {
     mItems.append(item);
+    mMemoryUsage += item->memoryUsage();
 }
 
 void RedoList::clear()
 {
     mItems.clear();
+    mMemoryUsage = 0;
 }
 
 ChangeReason RedoList::lastChangeReason()
@@ -1628,6 +2064,7 @@ PUndoItem RedoList::popItem()
     else {
         PUndoItem item = mItems.last();
         mItems.removeLast();
+        mMemoryUsage -= item->memoryUsage();
         return item;
     }
 }
@@ -1642,6 +2079,11 @@ int RedoList::itemCount()
     return mItems.count();
 }
 
+qint64 RedoList::memoryUsage() const
+{
+    return mMemoryUsage;
+}
+
 BinaryFileError::BinaryFileError(const QString& reason):
     FileError(reason)
 {
@@ -1679,9 +2121,11 @@ int searchForSegmentIdx(const QList<int> &segList, int minVal, int maxVal, int v
 int GlyphCalculator::updateGlyphStartPositionList(
         const QString &lineText,
         const QList<int> &glyphStartCharList, int startChar, int endChar,
-        const QFontMetrics &fontMetrics,
+        const QFont &font,
         QList<int> &glyphStartPositionList, int left, int &right, int &startGlyph, int &endGlyph) const
 {
+    QMutexLocker locker(&mWidthCacheMutex);
+    GlyphWidthCache* cache = widthCache(font);
     right = std::max(0,left);
     startGlyph = searchForSegmentIdx(glyphStartCharList,0,lineText.length(),startChar);
     endGlyph = searchForSegmentIdx(glyphStartCharList,0,lineText.length(),endChar);
@@ -1693,8 +2137,7 @@ int GlyphCalculator::updateGlyphStartPositionList(
         } else {
             end = lineText.length();
         }
-        QString glyph = lineText.mid(start,end-start);
-        int gWidth = glyphWidth(glyph, right, fontMetrics, mForceMonospace);
+        int gWidth = cachedGlyphWidth(lineText, start, end, right, cache, mForceMonospace);
         glyphStartPositionList[i] = right;
         right += gWidth;
     }
@@ -1703,17 +2146,40 @@ int GlyphCalculator::updateGlyphStartPositionList(
     return right-left;
 }
 
-int GlyphCalculator::glyphWidth(const QString &glyph, int left, const QFontMetrics &fontMetrics, bool forceMonospace) const
+int GlyphCalculator::glyphWidth(const QString &glyph, int left, const QFont &font, bool forceMonospace) const
+{
+    QMutexLocker locker(&mWidthCacheMutex);
+    return cachedGlyphWidth(glyph, 0, glyph.length(), left, widthCache(font), forceMonospace);
+}
+
+GlyphWidthCache *GlyphCalculator::widthCache(const QFont &font) const
+{
+    if (font == mFont)
+        return &mWidthCache;
+    QString key = font.key();
+    std::shared_ptr<GlyphWidthCache> cache = mOtherWidthCaches.value(key);
+    if (!cache) {
+        // fonts used by the painter are variants of the document font, so there are only a few
+        if (mOtherWidthCaches.count()>=16)
+            mOtherWidthCaches.clear();
+        cache = std::make_shared<GlyphWidthCache>(font);
+        mOtherWidthCaches.insert(key, cache);
+    }
+    return cache.get();
+}
+
+int GlyphCalculator::cachedGlyphWidth(const QString &lineText, int start, int end, int left, GlyphWidthCache *cache, bool forceMonospace) const
 {
     int glyphWidth;
-    if (glyph.length()==0)
+    if (end<=start)
         return 0;
-    QChar ch = glyph[0];
+    QChar ch = lineText[start];
     if (ch == '\t') {
         glyphWidth = tabWidth() - left % tabWidth();
+    } else if (end-start==1) {
+        glyphWidth = cache->charWidth(ch);
     } else {
-        glyphWidth = fontMetrics.horizontalAdvance(glyph);
-        //qDebug()<<glyph<<glyphCols<<width<<mCharWidth;
+        glyphWidth = cache->clusterWidth(lineText.mid(start, end-start));
     }
     if (forceMonospace) {
         int cols = std::ceil(glyphWidth / (double)mCharWidth);
@@ -1749,9 +2215,12 @@ int segmentIntervalStart(const QList<int> &segList, int minVal, int maxVal, int
 }
 
 GlyphCalculator::GlyphCalculator(const QFont &font):
+    mFont{font},
     mFontMetrics{font},
     mTabSize{4},
-    mForceMonospace{false}
+    mForceMonospace{false},
+    mWidthCacheMutex{},
+    mWidthCache{font}
 {
     mCharWidth =  mFontMetrics.horizontalAdvance("M");
     mSpaceWidth = mFontMetrics.horizontalAdvance(" ");
@@ -1759,9 +2228,41 @@ GlyphCalculator::GlyphCalculator(const QFont &font):
 
 void GlyphCalculator::setFont(const QFont &newFont)
 {
+    QMutexLocker locker(&mWidthCacheMutex);
+    mFont = newFont;
     mFontMetrics = QFontMetrics(newFont);
     mCharWidth =  mFontMetrics.horizontalAdvance("M");
     mSpaceWidth = mFontMetrics.horizontalAdvance(" ");
+    mWidthCache = GlyphWidthCache(newFont);
+    mOtherWidthCaches.clear();
+}
+
+GlyphWidthCache::GlyphWidthCache(const QFont &font):
+    mFontMetrics{font}
+{
+    mPages.resize(256);
+}
+
+int GlyphWidthCache::charWidth(QChar ch)
+{
+    QVector<qint16>& page = mPages[ch.row()];
+    if (page.isEmpty())
+        page.fill(-1, 256);
+    qint16& width = page[ch.cell()];
+    if (width<0)
+        width = mFontMetrics.horizontalAdvance(ch);
+    return width;
+}
+
+int GlyphWidthCache::clusterWidth(const QString &glyph)
+{
+    auto it = mClusterWidths.constFind(glyph);
+    if (it!=mClusterWidths.constEnd())
+        return it.value();
+    int width = mFontMetrics.horizontalAdvance(glyph);
+    mClusterWidths.insert(glyph, width);
+    return width;
 }
 
+
 }
@@ -19,6 +19,7 @@
 
 #include <QStringList>
 #include <QFontMetrics>
+#include <QHash>
 #include <QMutex>
 #include <QVector>
 #include <memory>
@@ -37,7 +38,34 @@ void expandGlyphStartCharList(const QString& strAdded, int oldStrLen, QList<int>
 
 class Document;
 
+/**
+ * @brief A token of a line, cached for painting
+ */
+struct TokenRun {
+    int start; // char index of the token in the line text
+    int length;
+    PTokenAttribute attribute;
+    int braceLevel; // embedding level for rainbow color, -1 if the token is not a brace
+};
+
+/**
+ * @brief Tokens of a whole line, cached for painting
+ *
+ * The tokens are only valid while the line text, the syntax state of the previous line
+ * and the syntaxer are not changed.
+ */
+struct LineTokenRuns {
+    PSyntaxState startState; // state of the previous line, nullptr for the first line
+    int generation; // syntaxer generation of the editor that parsed the line
+    QVector<TokenRun> runs;
+    int endBraceLevel;
+};
+
+using PLineTokenRuns = std::shared_ptr<LineTokenRuns>;
+
 using SearchConfirmAroundProc = std::function<bool ()>;
+// called with a line before its syntax state is read
+using SyntaxStateRequestProc = std::function<void (int line)>;
 /**
  * @brief The DocumentLine class
  *
@@ -52,11 +80,11 @@ using SearchConfirmAroundProc = std::function<bool ()>;
  * Most of the member methods are not thread safe. So they are declared as private
  * to prevent ill-usage. It shoulde only be used by the document internally.
  */
+class GlyphCalculator;
+
 class DocumentLine {
 public:
-    using UpdateWidthFunc = std::function<QList<int>(const QString&, const QList<int> &, int &)>;
-
-    explicit DocumentLine(UpdateWidthFunc updateWidthFunc);
+    explicit DocumentLine(const GlyphCalculator* glyphCalculator);
     DocumentLine(const DocumentLine&)=delete;
     DocumentLine& operator=(const DocumentLine&)=delete;
 
@@ -68,13 +96,16 @@ private:
      *
      * @return the glyphs count
      */
-    int glyphsCount() const { return mGlyphStartCharList.length(); }
+    int glyphsCount() const;
 
     /**
      * @brief get list of start index of the glyphs in the line text
+     *
+     * The list is calculated when it's first used.
+     *
      * @return start indice of the glyph.
      */
-    const QList<int>& glyphStartCharList() const { return mGlyphStartCharList; }
+    const QList<int>& glyphStartCharList() const;
 
     /**
      * @brief get list of start position of the glyphs in the line text
@@ -89,6 +120,15 @@ private:
      */
     int glyphStartChar(int i) const;
 
+    /**
+     * @brief get index of the glyph which contains the specified char
+     *
+     * The glyph start char list is not calculated for ascii lines.
+     * @param charIdx index of the char in the line text (start from 0)
+     * @return index of the glyph
+     */
+    int charToGlyphIndex(int charIdx) const;
+
     /**
      * @brief get count of the chars representing the specified glyph.
      * @param i index of the glyph in the line (starting from 0)
@@ -133,12 +173,13 @@ private:
      * @brief get the state of the syntax highlighter after this line is parsed
      * @return
      */
-    const SyntaxState& syntaxState() const { return mSyntaxState; }
+    const SyntaxState& syntaxState() const { return *mSyntaxState; }
+    const PSyntaxState& syntaxStateHandle() const { return mSyntaxState; }
     /**
      * @brief set the state of the syntax highlighter after this line is parsed
      * @param newSyntaxState
      */
-    void setSyntaxState(const SyntaxState &newSyntaxState) { mSyntaxState = newSyntaxState; }
+    void setSyntaxState(const PSyntaxState &newSyntaxState) { mSyntaxState = newSyntaxState; }
 
     void setLineText(const QString &newLineText);
     void updateWidth();
@@ -151,8 +192,10 @@ private:
      * A glyph may be defined by more than one code points.
      * Each lement of mGlyphStartCharList (position) is the start index
      *  of the code points in the mLineText.
+     * It's empty until used (mGlyphStartCharListValid is false).
+     * Each char of ascii lines is a glyph, so most lines never need it.
      */
-    QList<int> mGlyphStartCharList;
+    mutable QList<int> mGlyphStartCharList;
     /**
      * @brief start columns of the glyphs
      *
@@ -167,8 +210,13 @@ private:
      *
      * QSynedit use this state to speed up syntax highlight parsing.
      * Which is also used in auto-indent calculating and other functions.
+     * It's shared with other lines in the same state (see SyntaxStatePool).
      */
-    SyntaxState mSyntaxState;
+    PSyntaxState mSyntaxState;
+    /**
+     * @brief tokens of the line cached by the painter, cleared when the text is changed
+     */
+    PLineTokenRuns mTokenRuns;
     /**
      * @brief total width (pixel) of the line text
      *
@@ -176,8 +224,10 @@ private:
      * so it must be recalculated each time the font is changed.
      */
     int mWidth;
-    bool mIsTempWidth;
-    UpdateWidthFunc mUpdateWidthFunc;
+    bool mIsTempWidth:1;
+    bool mIsAscii:1;
+    mutable bool mGlyphStartCharListValid:1;
+    const GlyphCalculator* mGlyphCalculator;
     friend class Document;
 };
 
@@ -194,6 +244,24 @@ public:
     explicit BinaryFileError (const QString& reason);
 };
 
+/**
+ * @brief Widths of glyphs for a font
+ *
+ * Advances of single chars are kept in lazily allocated pages of 256 chars,
+ * advances of clusters (surrogate pairs, combined chars) in a hash.
+ */
+class GlyphWidthCache {
+public:
+    explicit GlyphWidthCache(const QFont& font);
+    const QFontMetrics &fontMetrics() const { return mFontMetrics; }
+    int charWidth(QChar ch);
+    int clusterWidth(const QString& glyph);
+private:
+    QFontMetrics mFontMetrics;
+    QVector<QVector<qint16>> mPages;
+    QHash<QString,int> mClusterWidths;
+};
+
 class GlyphCalculator {
 public:
     explicit GlyphCalculator(const QFont& font);
@@ -223,23 +291,30 @@ public:
     void setFont(const QFont &newFont);
 
     int glyphWidth(const QString& glyph, int left,
-                   const QFontMetrics &fontMetrics,
+                   const QFont &font,
                    bool forceMonospace) const;
 
     int glyphWidth(const QString &glyph, int left) const{
-        return glyphWidth(glyph,left,mFontMetrics,mForceMonospace);
+        return glyphWidth(glyph,left,mFont,mForceMonospace);
     }
 
     QList<int> calcGlyphPositionList(const QString& lineText, const QList<int> &glyphStartCharList,
-                                     const QFontMetrics &fontMetrics,
+                                     const QFont &font,
                                      int left, int &right) const;
 
     QList<int> calcGlyphPositionList(const QString& lineText, const QList<int> &glyphStartCharList, int left, int &right) const {
         return calcGlyphPositionList(lineText, glyphStartCharList,
-                                     mFontMetrics,
+                                     mFont,
                                      left,right);
     }
 
+    /**
+     * @brief calculate glyph positions of a pure ascii string
+     *
+     * Each char of the string is a glyph, so the glyph start char list is not needed.
+     */
+    QList<int> calcAsciiGlyphPositionList(const QString& lineText, int left, int &right) const;
+
     /**
      * @brief calculate display width of a string
      *
@@ -251,7 +326,7 @@ public:
      */
     int stringWidth(const QString &str, int left) const;
 
-    int stringWidth(const QString &str, int left, const QFontMetrics &fontMetrics);
+    int stringWidth(const QString &str, int left, const QFont &font);
 
     QList<int> calcLineWidth(const QString& lineText, const QList<int> &glyphStartCharList, int &width) {
         return calcGlyphPositionList(lineText,glyphStartCharList,0,width);
@@ -262,15 +337,25 @@ public:
             const QString& lineText,
             const QList<int> &glyphStartCharList,
             int startChar, int endChar,
-            const QFontMetrics &fontMetrics,
+            const QFont &font,
             QList<int> &glyphStartPositionList,
             int left, int &right, int &startGlyph, int &endGlyph) const;
 private:
+    GlyphWidthCache* widthCache(const QFont& font) const;
+    int cachedGlyphWidth(const QString& lineText, int start, int end, int left,
+                         GlyphWidthCache* cache, bool forceMonospace) const;
+private:
+    QFont mFont;
     QFontMetrics mFontMetrics;
     int mTabSize;
     int mCharWidth;
     int mSpaceWidth;
     bool mForceMonospace;
+    // caches are only accessed with the mutex locked
+    mutable QMutex mWidthCacheMutex;
+    mutable GlyphWidthCache mWidthCache;
+    // caches of the other fonts (bold, italic...) used by the painter, keyed by QFont::key()
+    mutable QHash<QString, std::shared_ptr<GlyphWidthCache>> mOtherWidthCaches;
 };
 
 /**
@@ -382,6 +467,15 @@ public:
      */
     QString lineBreak() const;
 
+    /**
+     * @brief set the proc called before the syntax state of a line is read
+     *
+     * The editor scans the syntax of long documents in time slices, and uses it to
+     * finish scanning the line first, so all readers get its final state.
+     * It's only called in the thread of the document.
+     */
+    void setSyntaxStateRequestProc(const SyntaxStateRequestProc& proc);
+
     /**
      * @brief get state of the syntax highlighter after parsing the specified line.
      *
@@ -401,6 +495,14 @@ public:
      * @param state the new state
      */
     void setSyntaxState(int line, const SyntaxState& state);
+    /**
+     * @brief set the syntax state of the line
+     *
+     * It's thread safe.
+     *
+     * @return false if the state of the line is not changed
+     */
+    bool updateSyntaxState(int line, const SyntaxState& state);
 
     /**
      * @brief get line text of the specified line.
@@ -412,6 +514,34 @@ public:
      */
     QString getLine(int line) const;
 
+    /**
+     * @brief get the cached tokens of the specified line.
+     *
+     * It's thread safe.
+     *
+     * @param line line index (starts frome 0)
+     * @param generation current syntaxer generation of the editor
+     * @return nullptr if the tokens are not cached or are out of date
+     */
+    PLineTokenRuns getTokenRuns(int line, int generation) const;
+
+    /**
+     * @brief cache the tokens of the specified line.
+     *
+     * The start state of the tokens is set to the state of the previous line.
+     * It's thread safe.
+     *
+     * @param line line index (starts frome 0)
+     */
+    void setTokenRuns(int line, const PLineTokenRuns& tokenRuns);
+
+    /**
+     * @brief drop the cached tokens of all lines
+     *
+     * It's thread safe.
+     */
+    void clearTokenRuns();
+
     /**
      * @brief get count of the glyphs on the specified line.
      *
@@ -496,7 +626,28 @@ public:
     void insertLine(int index, const QString& s);
     void insertLines(int index, int numLines);
 
-    void loadFromFile(const QString& filename, const QByteArray& encoding, QByteArray& realEncoding);
+    /**
+     * @brief load the lines of the file
+     *
+     * When inStages is true, only the first lines of a large utf-8 / ascii file
+     * are added before it returns. The rest are added from the event loop,
+     * with loadingProgress() emitted for each part and loaded() at the end.
+     * Other files are loaded at once.
+     */
+    void loadFromFile(const QString& filename, const QByteArray& encoding, QByteArray& realEncoding, bool inStages=false);
+    /**
+     * @brief whether lines of a staged load are not added yet
+     *
+     * It's thread safe.
+     */
+    bool loading() const;
+    /**
+     * @brief add the rest lines of a staged load at once
+     *
+     * text(), contents() and saveToFile() call it, so they always get the whole file.
+     * It's thread safe.
+     */
+    void finishLoading();
     void saveToFile(QFile& file, const QByteArray& encoding,
                     const QByteArray& defaultEncoding, QByteArray& realEncoding);
 
@@ -622,6 +773,12 @@ signals:
     void inserted(int startLine, int count);
     void putted(int line);
     void maxLineWidthChanged();
+    // a part of a staged load is added, the sizes are of the lines after the first screen
+    void loadingProgress(qint64 loadedSize, qint64 totalSize);
+    // all lines of a staged load are added
+    void loaded();
+private slots:
+    void loadNextPart();
 protected:
     QString getTextStr() const;
     void setUpdateState(bool Updating);
@@ -644,7 +801,11 @@ private:
     QList<int> getGlyphStartCharList(int line);
     QList<int> getGlyphStartPositionList(int line);
     int getLineWidth(int line);
-    bool tryLoadFileByEncoding(QByteArray encodingName, QFile& file);
+    void requestSyntaxState(int line) const;
+    bool tryLoadFileByEncoding(QByteArray encodingName, const QByteArray& content);
+    // returns the position after the added lines
+    int addContentLines(const QByteArray& content, int start, int maxSize, bool allAscii);
+    void loadPendingLines(int maxSize);
     void loadUTF16BOMFile(QFile& file);
     void loadUTF32BOMFile(QFile& file);
     void saveUTF16File(QFile& file, TextEncoder &encoder);
@@ -653,7 +814,6 @@ private:
 private:
     DocumentLines mLines;
 
-    DocumentLine::UpdateWidthFunc mUpdateDocumentLineWidthFunc;
 
     NewlineType mNewlineType;
     bool mAppendNewLineAtEOF;
@@ -665,6 +825,13 @@ private:
     mutable QRecursiveMutex mMutex;
 
     GlyphCalculator mGlyphCalculator;
+    SyntaxStatePool mSyntaxStatePool;
+    int mTokenRunsCount; // lines with cached tokens, counted when set, so it may be more than actual
+    SyntaxStateRequestProc mSyntaxStateRequestProc;
+    // lines of a staged load that are not added yet (from mPendingPos)
+    QByteArray mPendingContent;
+    int mPendingPos;
+    bool mPendingAllAscii;
 
     friend class QSynEditPainter;
 };
@@ -691,6 +858,7 @@ private:
     BufferCoord mChangeEndPos;
     QStringList mChangeText;
     size_t mChangeNumber;
+    int mMemoryUsage;
 public:
     UndoItem(ChangeReason reason,
         SelectionMode selMode,
@@ -705,6 +873,11 @@ public:
     BufferCoord changeEndPos() const;
     QStringList changeText() const;
     size_t changeNumber() const;
+    // estimated bytes held by the item, including its change text
+    int memoryUsage() const;
+private:
+    friend class UndoList;
+    void mergeInsert(const BufferCoord& endPos, size_t number);
 };
 
 using PUndoItem = std::shared_ptr<UndoItem>;
@@ -737,6 +910,13 @@ public:
 
     int maxUndoActions() const;
     void setMaxUndoActions(int maxUndoActions);
+    qint64 maxMemoryUsage() const;
+    void setMaxMemoryUsage(qint64 maxMemoryUsage);
+    qint64 memoryUsage() const;
+    // Merge continuous typed inserts on the same line into one item.
+    // Only enable it when the editor undoes continuous inserts in one go.
+    bool mergeInserts() const;
+    void setMergeInserts(bool mergeInserts);
     bool initialState();
     void setInitialState();
 
@@ -750,6 +930,9 @@ signals:
 protected:
     bool inBlock();
     unsigned int getNextChangeNumber();
+    bool tryMergeInsert(const BufferCoord& startPos, const BufferCoord& endPos,
+                        const QStringList& changeText, SelectionMode selMode, size_t changeNumber);
+    void ensureMaxEntries();
 protected:
     size_t mBlockChangeNumber;
     int mBlockLock;
@@ -760,6 +943,10 @@ protected:
     unsigned int mNextChangeNumber;
     unsigned int mInitialChangeNumber;
     bool mInsideRedo;
+    int mMaxUndoActions;
+    qint64 mMaxMemoryUsage;
+    qint64 mMemoryUsage;
+    bool mMergeInserts;
 };
 
 class RedoList : public QObject {
@@ -779,9 +966,11 @@ public:
 
     bool canRedo();
     int itemCount();
+    qint64 memoryUsage() const;
 
 protected:
     QVector<PUndoItem> mItems;
+    qint64 mMemoryUsage;
 };
 
 
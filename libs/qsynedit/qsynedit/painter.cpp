@@ -792,7 +792,7 @@ void QSynEditPainter::addHighlightToken(
                     glyphStartCharList,
                     tokenStartChar,
                     tokenEndChar,
-                    QFontMetrics(mTokenAccu.font),
+                    mTokenAccu.font,
                     glyphStartPositionList,
                     tokenLeft,
                     tokenRight,
@@ -906,10 +906,12 @@ void QSynEditPainter::paintFoldAttributes()
     // Paint collapsed lines using changed pen
     if (mEdit->mCodeFolding.showCollapsedLine) {
         mPainter->setPen(mEdit->mCodeFolding.collapsedLineColor);
-        for (int i=0; i< mEdit->mAllFoldRanges->count();i++) {
+        // folds are sorted by line
+        for (int i=mEdit->mAllFoldRanges->findFirstFrom(mFirstLine); i< mEdit->mAllFoldRanges->count();i++) {
             PCodeFoldingRange range = (*mEdit->mAllFoldRanges)[i];
-            if (range->collapsed && !range->parentCollapsed() &&
-                    (range->fromLine <= mLastLine) && (range->fromLine >= mFirstLine) ) {
+            if (range->fromLine > mLastLine)
+                break;
+            if (range->collapsed && !range->parentCollapsed()) {
                 // Get starting and end points
                 int Y = (mEdit->lineToRow(range->fromLine) - mEdit->yposToRow(0) + 1) * mEdit->mTextHeight - 1;
                 mPainter->drawLine(mClip.left(),Y, mClip.right(),Y);
@@ -944,6 +946,53 @@ void QSynEditPainter::getBraceColorAttr(int level, PTokenAttribute &attr)
         attr = oldAttr;
 }
 
+void QSynEditPainter::addSyntaxToken(const QString &lineText, const QString &token, int tokenStartChar,
+                                     int line, PTokenAttribute attr,
+                                     const QList<int> &glyphStartCharList,
+                                     bool calculateGlyphPositions,
+                                     QList<int> &glyphStartPositionsList,
+                                     PTokenAttribute &preeditAttr,
+                                     int &tokenLeft)
+{
+    int tokenEndChar = tokenStartChar + token.length();
+    //input method
+    if (mIsCurrentLine && mEdit->mInputPreeditString.length()>0) {
+        int startPos = tokenStartChar+1;
+        int endPos = tokenStartChar + token.length();
+        if (!(endPos < mEdit->mCaretX
+                || startPos >= mEdit->mCaretX+mEdit->mInputPreeditString.length())) {
+            if (!preeditAttr) {
+                preeditAttr = attr;
+            } else {
+                attr = preeditAttr;
+            }
+        }
+    }
+    bool showGlyph=false;
+    if (attr && attr->tokenType() == TokenType::Space) {
+        if (tokenStartChar==0) {
+            showGlyph = mEdit->mOptions.testFlag(EditorOption::ShowLeadingSpaces);
+        } else if (tokenEndChar==lineText.length()) {
+            showGlyph = mEdit->mOptions.testFlag(EditorOption::ShowTrailingSpaces);
+        } else {
+            showGlyph = mEdit->mOptions.testFlag(EditorOption::ShowInnerSpaces);
+        }
+    }
+    int tokenWidth;
+    addHighlightToken(
+                lineText,
+                token,
+                tokenLeft,
+                line, attr,showGlyph,
+                glyphStartCharList,
+                tokenStartChar,
+                tokenEndChar,
+                calculateGlyphPositions,
+                glyphStartPositionsList,
+                tokenWidth);
+    tokenLeft+=tokenWidth;
+}
+
 void QSynEditPainter::paintLines()
 {
     mEdit->mDocument->beginSetLinesWidth();
@@ -1074,96 +1123,95 @@ void QSynEditPainter::paintLines()
             glyphStartPositionsList = mEdit->mDocument->getGlyphStartPositionList(vLine-1);
             mCurrentLineWidth = mEdit->mDocument->getLineWidth(vLine-1);
         }
-        // Initialize highlighter with line text and range info. It is
-        // necessary because we probably did not scan to the end of the last
-        // line - the internal highlighter range might be wrong.
-        if (vLine == 1) {
-            mEdit->mSyntaxer->resetState();
-        } else {
-            mEdit->mSyntaxer->setState(
-                        mEdit->mDocument->getSyntaxState(vLine-2));
-        }
-        mEdit->mSyntaxer->setLine(sLine, vLine - 1);
-        // Try to concatenate as many tokens as possible to minimize the count
-        // of ExtTextOut calls necessary. This depends on the selection state
-        // or the line having special colors. For spaces the foreground color
-        // is ignored as well.
         mTokenAccu.width = 0;
         tokenLeft = 0;
-        // Test first whether anything of this token is visible.
-        while (!mEdit->mSyntaxer->eol()) {
-            sToken = mEdit->mSyntaxer->getToken();
-            if (sToken.isEmpty())  {
-                continue;
+        int endBraceLevel = 0;
+        // Lines not changed since they are last painted reuse the cached tokens,
+        // so scrolling and repainting don't run the syntaxer again.
+        PLineTokenRuns tokenRuns;
+        if (!lineTextChanged)
+            tokenRuns = mEdit->mDocument->getTokenRuns(vLine-1, mEdit->mTokenRunsGeneration);
+        if (tokenRuns) {
+            foreach (const TokenRun& run, tokenRuns->runs) {
+                attr = run.attribute;
+                if (run.braceLevel>=0)
+                    getBraceColorAttr(run.braceLevel, attr);
+                addSyntaxToken(sLine, sLine.mid(run.start, run.length), run.start,
+                               vLine, attr, glyphStartCharList,
+                               calculateGlyphPositions, glyphStartPositionsList,
+                               preeditAttr, tokenLeft);
+                //We don't need to calculate line width,
+                //So we just quit if already out of the right edge of the editor
+                if (lineWidthValid && (tokenLeft>mRight))
+                    break;
             }
-            int tokenStartChar = mEdit->mSyntaxer->getTokenPos();
-            int tokenEndChar = tokenStartChar + sToken.length();
-
-            // It's at least partially visible. Get the token attributes now.
-            attr = mEdit->mSyntaxer->getTokenAttribute();
-
-            //rainbow parenthesis
-            if (sToken == "["
-                    || sToken == "("
-                    || sToken == "{"
-                    ) {
-                SyntaxState rangeState = mEdit->mSyntaxer->getState();
-                getBraceColorAttr(rangeState.bracketLevel
-                                  +rangeState.braceLevel
-                                  +rangeState.parenthesisLevel
-                                  ,attr);
-            } else if (sToken == "]"
-                       || sToken == ")"
-                       || sToken == "}"
-                       ){
-                SyntaxState rangeState = mEdit->mSyntaxer->getState();
-                getBraceColorAttr(rangeState.bracketLevel
-                                  +rangeState.braceLevel
-                                  +rangeState.parenthesisLevel+1,
-                                  attr);
+            endBraceLevel = tokenRuns->endBraceLevel;
+        } else {
+            // Initialize highlighter with line text and range info. It is
+            // necessary because we probably did not scan to the end of the last
+            // line - the internal highlighter range might be wrong.
+            if (vLine == 1) {
+                mEdit->mSyntaxer->resetState();
+            } else {
+                mEdit->mSyntaxer->setState(
+                            mEdit->mDocument->getSyntaxState(vLine-2));
             }
-            //input method
-            if (mIsCurrentLine && mEdit->mInputPreeditString.length()>0) {
-                int startPos = mEdit->mSyntaxer->getTokenPos()+1;
-                int endPos = mEdit->mSyntaxer->getTokenPos() + sToken.length();
-                if (!(endPos < mEdit->mCaretX
-                        || startPos >= mEdit->mCaretX+mEdit->mInputPreeditString.length())) {
-                    if (!preeditAttr) {
-                        preeditAttr = attr;
-                    } else {
-                        attr = preeditAttr;
-                    }
-                }
+            mEdit->mSyntaxer->setLine(sLine, vLine - 1);
+            // Lines with the input method's preedit text are not cached
+            if (!lineTextChanged) {
+                tokenRuns = std::make_shared<LineTokenRuns>();
+                tokenRuns->generation = mEdit->mTokenRunsGeneration;
             }
-            bool showGlyph=false;
-            if (attr && attr->tokenType() == TokenType::Space) {
-                int pos = mEdit->mSyntaxer->getTokenPos();
-                if (pos==0) {
-                    showGlyph = mEdit->mOptions.testFlag(EditorOption::ShowLeadingSpaces);
-                } else if (pos+sToken.length()==sLine.length()) {
-                    showGlyph = mEdit->mOptions.testFlag(EditorOption::ShowTrailingSpaces);
-                } else {
-                    showGlyph = mEdit->mOptions.testFlag(EditorOption::ShowInnerSpaces);
+            while (!mEdit->mSyntaxer->eol()) {
+                sToken = mEdit->mSyntaxer->getToken();
+                if (sToken.isEmpty())  {
+                    continue;
                 }
-            }
-            addHighlightToken(
-                        sLine,
-                        sToken,
-                        tokenLeft,
-                        vLine, attr,showGlyph,
-                        glyphStartCharList,
-                        tokenStartChar,
-                        tokenEndChar,
-                        calculateGlyphPositions,
-                        glyphStartPositionsList,
-                        tokenWidth);
-            tokenLeft+=tokenWidth;
-            //We don't need to calculate line width,
-            //So we just quit if already out of the right edge of the editor
-            if (lineWidthValid && (tokenLeft>mRight))
+                int tokenStartChar = mEdit->mSyntaxer->getTokenPos();
+                attr = mEdit->mSyntaxer->getTokenAttribute();
+
+                //rainbow parenthesis
+                int braceLevel = -1;
+                if (sToken == "["
+                        || sToken == "("
+                        || sToken == "{"
+                        ) {
+                    SyntaxState rangeState = mEdit->mSyntaxer->getState();
+                    braceLevel = rangeState.bracketLevel
+                            +rangeState.braceLevel
+                            +rangeState.parenthesisLevel;
+                } else if (sToken == "]"
+                           || sToken == ")"
+                           || sToken == "}"
+                           ){
+                    SyntaxState rangeState = mEdit->mSyntaxer->getState();
+                    braceLevel = rangeState.bracketLevel
+                            +rangeState.braceLevel
+                            +rangeState.parenthesisLevel+1;
+                }
+                if (tokenRuns)
+                    tokenRuns->runs.append(TokenRun{tokenStartChar, sToken.length(), attr, braceLevel});
+                if (braceLevel>=0)
+                    getBraceColorAttr(braceLevel, attr);
+                addSyntaxToken(sLine, sToken, tokenStartChar,
+                               vLine, attr, glyphStartCharList,
+                               calculateGlyphPositions, glyphStartPositionsList,
+                               preeditAttr, tokenLeft);
+                //We don't need to calculate line width,
+                //So we just quit if already out of the right edge of the editor.
+                //The rest of the line is not scanned, so it's not cached.
+                if (lineWidthValid && (tokenLeft>mRight)) {
+                    tokenRuns.reset();
                     break;
-            // Let the highlighter scan the next token.
-            mEdit->mSyntaxer->next();
+                }
+                // Let the highlighter scan the next token.
+                mEdit->mSyntaxer->next();
+            }
+            endBraceLevel = mEdit->mSyntaxer->getState().braceLevel;
+            if (tokenRuns) {
+                tokenRuns->endBraceLevel = endBraceLevel;
+                mEdit->mDocument->setTokenRuns(vLine-1, tokenRuns);
+            }
         }
         if (!lineWidthValid)
             mEdit->mDocument->setLineWidth(vLine-1, tokenLeft, glyphStartPositionsList);
@@ -1175,7 +1223,7 @@ void QSynEditPainter::paintLines()
             if ((foldRange) && foldRange->collapsed) {
                 addOnStr = mEdit->mSyntaxer->foldString(sLine);
                 attr = mEdit->mSyntaxer->symbolAttribute();
-                getBraceColorAttr(mEdit->mSyntaxer->getState().braceLevel,attr);
+                getBraceColorAttr(endBraceLevel,attr);
             } else {
                 // Draw LineBreak glyph.
                 if (mEdit->mOptions.testFlag(EditorOption::ShowLineBreaks)
@@ -102,6 +102,13 @@ private:
             QList<int> &glyphStartPositionList,
             int &tokenWidth
             );
+    void addSyntaxToken(const QString& lineText, const QString& token, int tokenStartChar,
+                        int line, PTokenAttribute attr,
+                        const QList<int>& glyphStartCharList,
+                        bool calculateGlyphPositions,
+                        QList<int>& glyphStartPositionsList,
+                        PTokenAttribute& preeditAttr,
+                        int& tokenLeft);
 
     void paintFoldAttributes();
     void getBraceColorAttr(int level, PTokenAttribute &attr);
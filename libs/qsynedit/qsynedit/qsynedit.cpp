@@ -39,12 +39,28 @@
 #include <QDrag>
 #include <QMimeData>
 #include <QTextEdit>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include <cstring>
 #include <QMimeData>
 
 #define UPDATE_HORIZONTAL_SCROLLBAR_EVENT ((QEvent::Type)(QEvent::User+1))
 #define UPDATE_VERTICAL_SCROLLBAR_EVENT ((QEvent::Type)(QEvent::User+2))
+// max count of lines (besides the visible ones) to be scanned at once, the rest are scanned later
+#define SYNTAX_SCAN_SYNC_LINES 5000
+// time of each slice of the pending syntax scan
+#define SYNTAX_SCAN_SLICE_MSECS 20
 
 namespace QSynedit {
+
+//generations are unique among editors, because a document may be shown by more than one editor
+static int newTokenRunsGeneration()
+{
+    static QAtomicInt lastGeneration{0};
+    return lastGeneration.fetchAndAddRelaxed(1)+1;
+}
+
 QSynEdit::QSynEdit(QWidget *parent) : QAbstractScrollArea(parent),
     mEditingCount{0},
     mDropped{false},
@@ -71,6 +87,7 @@ QSynEdit::QSynEdit(QWidget *parent) : QAbstractScrollArea(parent),
     connect(mDocument.get(), &Document::deleted, this, &QSynEdit::onLinesDeleted);
     connect(mDocument.get(), &Document::inserted, this, &QSynEdit::onLinesInserted);
     connect(mDocument.get(), &Document::putted, this, &QSynEdit::onLinesPutted);
+    connect(mDocument.get(), &Document::loadingProgress, this, &QSynEdit::onLinesLoaded);
     connect(mDocument.get(), &Document::maxLineWidthChanged,
             this, &QSynEdit::onMaxLineWidthChanged);
     connect(mDocument.get(), &Document::cleared, this, &QSynEdit::updateVScrollbar);
@@ -133,16 +150,35 @@ QSynEdit::QSynEdit(QWidget *parent) : QAbstractScrollArea(parent),
             | EditorOption::TabIndent | EditorOption::GroupUndo
             | EditorOption::KeepCaretX
             | EditorOption::SelectWordByDblClick;
+    mUndoList->setMergeInserts(mOptions.testFlag(EditorOption::GroupUndo));
 
     mScrollTimer = new QTimer(this);
     //mScrollTimer->setInterval(100);
     connect(mScrollTimer, &QTimer::timeout,this, &QSynEdit::onScrollTimeout);
 
+    mSyntaxScanTimer = new QTimer(this);
+    mSyntaxScanTimer->setSingleShot(true);
+    mSyntaxScanTimer->setInterval(0);
+    connect(mSyntaxScanTimer, &QTimer::timeout,this, &QSynEdit::onSyntaxScanTimeout);
+    mSyntaxScanPendingLine = -1;
+    mSyntaxScanEndLine = -1;
+    mSyntaxScanning = false;
+    //lines not scanned yet are scanned before their states are read
+    mDocument->setSyntaxStateRequestProc([this](int line){
+        if (!mSyntaxScanning && mSyntaxScanPendingLine>=0 && line>=mSyntaxScanPendingLine)
+            scanPendingSyntax(line+1, -1);
+    });
+
     qreal dpr=devicePixelRatioF();
     mContentImage = std::make_shared<QImage>(clientWidth()*dpr,clientHeight()*dpr,QImage::Format_ARGB32);
     mContentImage->setDevicePixelRatio(dpr);
+    mContentScrolled = false;
+    mMeasurePaintTime = qEnvironmentVariableIsSet("QSYNEDIT_MEASURE_PAINT_TIME");
+    mTokenRunsGeneration = newTokenRunsGeneration();
 
     mAllFoldRanges = std::make_shared<CodeFoldingRanges>();
+    mFoldDirtyStartLine = -1;
+    mFoldDirtyEndLine = -1;
     mUseCodeFolding = true;
     m_blinkTimerId = 0;
     m_blinkStatus = 0;
@@ -279,6 +315,21 @@ bool QSynEdit::canUndo() const
     return !mReadOnly && mUndoList->canUndo();
 }
 
+qint64 QSynEdit::undoMemoryUsage() const
+{
+    return mUndoList->memoryUsage() + mRedoList->memoryUsage();
+}
+
+qint64 QSynEdit::maxUndoMemoryUsage() const
+{
+    return mUndoList->maxMemoryUsage();
+}
+
+void QSynEdit::setMaxUndoMemoryUsage(qint64 newMaxUndoMemoryUsage)
+{
+    mUndoList->setMaxMemoryUsage(newMaxUndoMemoryUsage);
+}
+
 bool QSynEdit::canRedo() const
 {
     return !mReadOnly && mRedoList->canRedo();
@@ -982,14 +1033,33 @@ void QSynEdit::invalidateSelection()
 
 void QSynEdit::invalidateRect(const QRect &rect)
 {
+    mContentDirtyRegion += rect;
     viewport()->update(rect);
 }
 
 void QSynEdit::invalidate()
 {
+    mContentDirtyRegion = QRect(0, 0, clientWidth(), clientHeight());
+    mContentScrolled = false;
     viewport()->update();
 }
 
+void QSynEdit::invalidateSyntaxTokens()
+{
+    mTokenRunsGeneration = newTokenRunsGeneration();
+    invalidate();
+}
+
+bool QSynEdit::measurePaintTime() const
+{
+    return mMeasurePaintTime;
+}
+
+void QSynEdit::setMeasurePaintTime(bool newMeasurePaintTime)
+{
+    mMeasurePaintTime = newMeasurePaintTime;
+}
+
 bool QSynEdit::selAvail() const
 {
     if (mBlockBegin.ch == mBlockEnd.ch && mBlockBegin.line == mBlockEnd.line)
@@ -1733,7 +1803,8 @@ void QSynEdit::endEditing()
     if (mEditingCount==0) {
         if (!mUndoing)
             mUndoList->endBlock();
-        reparseDocument();
+        //syntax states are already updated when lines are changed
+        updateFoldRanges();
     }
     decPaintLock();
 }
@@ -2665,7 +2736,7 @@ void QSynEdit::doAddChar(const QChar& ch)
                 && undoItem->changeEndPos().line == mCaretY
                 && undoItem->changeEndPos().ch == mCaretX
                 && undoItem->changeStartPos().line == mCaretY
-                && undoItem->changeStartPos().ch == mCaretX-1) {
+                && undoItem->changeStartPos().ch < mCaretX) {
             QString s = mDocument->getLine(mCaretY-1);
             int i=mCaretX-2;
             if (i>=0 && i<s.length())
@@ -3146,7 +3217,8 @@ void QSynEdit::updateCaret()
 {
     if (mDocument->maxLineWidth()<0)
         return;
-    invalidateRect(calculateCaretRect());
+    //caret is painted over the content image, so the image is not dirty
+    viewport()->update(calculateCaretRect());
 }
 
 void QSynEdit::recalcCharExtent()
@@ -3259,35 +3331,137 @@ int QSynEdit::reparseLines(int startLine, int endLine, bool needRescanFolds, boo
     if (startLine >= endLine)
         return startLine;
 
+    //states of lines after the pending line are not valid, leave them to the pending scan
+    if (mSyntaxScanPendingLine>=0 && startLine>mSyntaxScanPendingLine)
+        return startLine;
+
+    //don't block the ui when too many lines are changed
+    int syncMaxLine = std::max(startLine + SYNTAX_SCAN_SYNC_LINES, lastVisibleLine());
+
     if (startLine == 0) {
         mSyntaxer->resetState();
     } else {
         mSyntaxer->setState(mDocument->getSyntaxState(startLine-1));
     }
+    //the old states are compared below, they must not be scanned by the request proc
+    mSyntaxScanning = true;
+    auto action = finally([this](){
+        mSyntaxScanning = false;
+    });
+    bool checkFolds = useCodeFolding();
     int line = startLine;
     do {
+        if (line >= syncMaxLine) {
+            schedulePendingSyntaxScan(line, endLine);
+            return line;
+        }
         mSyntaxer->setLine(mDocument->getLine(line), line);
         mSyntaxer->nextToEol();
         state = mSyntaxer->getState();
-        if (line >= endLine && state == mDocument->getSyntaxState(line)) {
+        //folds only depend on the block starts/ends of each line
+        if (checkFolds
+                && (state.blockStarted != mDocument->blockStarted(line)
+                    || state.blockEnded != mDocument->blockEnded(line)))
+            markFoldsDirty(line, line + 1);
+        //states are interned, so it's only a handle comparison
+        if (!mDocument->updateSyntaxState(line,state) && line >= endLine) {
             break;
         }
-        mDocument->setSyntaxState(line,state);
         line++;
     } while (line < maxLine);
 
-    //don't rescan folds if only currentLine is reparsed
-    if (line-startLine==1)
-        return line;
+    //all pending lines are scanned
+    if (mSyntaxScanPendingLine>=0 && line>=mDocument->count()) {
+        mSyntaxScanPendingLine = -1;
+        mSyntaxScanTimer->stop();
+    }
 
-    if (mEditingCount>0)
+    if (mEditingCount>0 || !needRescanFolds)
         return line;
 
-    if (needRescanFolds && useCodeFolding())
-        rescanFolds();
+    updateFoldRanges();
     return line;
 }
 
+int QSynEdit::lastVisibleLine() const
+{
+    return rowToLine(yposToRow(0) + mLinesInWindow + 1);
+}
+
+void QSynEdit::schedulePendingSyntaxScan(int line, int endLine)
+{
+    if (mSyntaxScanPendingLine<0) {
+        mSyntaxScanPendingLine = line;
+        mSyntaxScanEndLine = endLine;
+    } else {
+        mSyntaxScanPendingLine = std::min(mSyntaxScanPendingLine, line);
+        mSyntaxScanEndLine = std::max(mSyntaxScanEndLine, endLine);
+    }
+    mSyntaxScanTimer->start();
+}
+
+void QSynEdit::scanPendingSyntax(int endLine, int msecs)
+{
+    if (mSyntaxScanPendingLine<0)
+        return;
+    int count = mDocument->count();
+    int line = mSyntaxScanPendingLine;
+    if (line < count) {
+        QElapsedTimer timer;
+        timer.start();
+        if (line == 0) {
+            mSyntaxer->resetState();
+        } else {
+            mSyntaxer->setState(mDocument->getSyntaxState(line-1));
+        }
+        while (line < count) {
+            //lines before endLine are always scanned
+            if (line >= endLine) {
+                if (msecs < 0)
+                    break;
+                if ((line % 64) == 0 && timer.elapsed() >= msecs)
+                    break;
+            }
+            mSyntaxer->setLine(mDocument->getLine(line), line);
+            mSyntaxer->nextToEol();
+            if (!mDocument->updateSyntaxState(line, mSyntaxer->getState())
+                    && line >= mSyntaxScanEndLine) {
+                //the states of the following lines are not changed
+                line = count;
+                break;
+            }
+            line++;
+        }
+    }
+    if (line < count) {
+        mSyntaxScanPendingLine = line;
+        return;
+    }
+    mSyntaxScanPendingLine = -1;
+    mSyntaxScanTimer->stop();
+    if (useCodeFolding())
+        rescanFolds();
+}
+
+void QSynEdit::onSyntaxScanTimeout()
+{
+    scanPendingSyntax(0, SYNTAX_SCAN_SLICE_MSECS);
+    if (mSyntaxScanPendingLine>=0)
+        mSyntaxScanTimer->start();
+}
+
+int QSynEdit::pendingSyntaxScanLines() const
+{
+    if (mSyntaxScanPendingLine<0)
+        return 0;
+    return std::max(0, mDocument->count() - mSyntaxScanPendingLine);
+}
+
+void QSynEdit::finishSyntaxScan()
+{
+    scanPendingSyntax(INT_MAX, -1);
+}
+
 // void QSynEdit::reparseLine(int line)
 // {
 //     if (!mSyntaxer)
@@ -3310,17 +3484,19 @@ int QSynEdit::reparseLines(int startLine, int endLine, bool needRescanFolds, boo
 
 void QSynEdit::reparseDocument()
 {
+    //states of all lines are recalculated, the visible lines first
+    mTokenRunsGeneration = newTokenRunsGeneration();
+    mSyntaxScanPendingLine = -1;
+    mSyntaxScanTimer->stop();
     if (!mDocument->empty()) {
-//        qint64 begin=QDateTime::currentMSecsSinceEpoch();
-        mSyntaxer->resetState();
-        for (int i =0;i<mDocument->count();i++) {
-            mSyntaxer->setLine(mDocument->getLine(i), i);
-            mSyntaxer->nextToEol();
-            mDocument->setSyntaxState(i, mSyntaxer->getState());
+        mSyntaxScanPendingLine = 0;
+        mSyntaxScanEndLine = mDocument->count();
+        scanPendingSyntax(std::max(SYNTAX_SCAN_SYNC_LINES, lastVisibleLine()), -1);
+        //folds are rescanned when the pending scan is finished
+        if (mSyntaxScanPendingLine>=0) {
+            mSyntaxScanTimer->start();
+            return;
         }
-//        qint64 diff= QDateTime::currentMSecsSinceEpoch() - begin;
-
-//        qDebug()<<diff<<mDocument->count();
     }
     if (useCodeFolding())
         rescanFolds();
@@ -3361,39 +3537,219 @@ void QSynEdit::collapse(PCodeFoldingRange FoldRange)
     updateVScrollbar();
 }
 
+static inline qint64 foldRangeKey(const PCodeFoldingRange& range)
+{
+    return ((qint64)range->fromLine << 32) | (quint32)range->toLine;
+}
+
 void QSynEdit::foldOnLinesInserted(int Line, int Count)
 {
-    // Delete collapsed inside selection
-    for (int i = mAllFoldRanges->count()-1;i>=0;i--) {
-        PCodeFoldingRange range = (*mAllFoldRanges)[i];
+    int insertedLine = Line - 1;
+    if (mFoldDirtyStartLine>=0) {
+        if (mFoldDirtyStartLine >= insertedLine)
+            mFoldDirtyStartLine += Count;
+        if (mFoldDirtyEndLine > insertedLine)
+            mFoldDirtyEndLine += Count;
+    }
+    // folds sorted after the insertion are moved
+    int index = mAllFoldRanges->findFirstFrom(Line);
+    for (int i=index;i<mAllFoldRanges->count();i++)
+        (*mAllFoldRanges)[i]->move(Count);
+    // folds around the insertion are the last fold starting before it and its parents
+    PCodeFoldingRange range;
+    if (index>0)
+        range = (*mAllFoldRanges)[index-1];
+    while (range) {
         if (range->fromLine == Line - 1) {// insertion starts at fold line
             if (range->collapsed)
                 uncollapse(range);
-        } else if (range->fromLine >= Line) // insertion of count lines above FromLine
-            range->move(Count);
+        }
+        if (range->closingLine >= insertedLine) {
+            range->toLine += Count;
+            range->closingLine += Count;
+        }
+        range = range->parent.lock();
     }
 }
 
 void QSynEdit::foldOnLinesDeleted(int Line, int Count)
 {
-    // Delete collapsed inside selection
-    for (int i = mAllFoldRanges->count()-1;i>=0;i--) {
+    int deletedLine = Line - 1;
+    auto shiftLine = [deletedLine,Count](int line) {
+        return (line >= deletedLine + Count) ? line - Count : std::min(line, deletedLine);
+    };
+    if (mFoldDirtyStartLine>=0) {
+        mFoldDirtyStartLine = shiftLine(mFoldDirtyStartLine);
+        mFoldDirtyEndLine = std::max(shiftLine(mFoldDirtyEndLine), mFoldDirtyStartLine + 1);
+    }
+    bool damaged = false;
+    int index = mAllFoldRanges->findFirstFrom(Line);
+    for (int i=index;i<mAllFoldRanges->count();i++) {
         PCodeFoldingRange range = (*mAllFoldRanges)[i];
-        if (range->fromLine == Line && Count == 1)  {// open up because we are messing with the starting line
+        if (range->fromLine < Line + Count) {
+            // fold starts in the deleted lines, it's dropped when folds are updated
             if (range->collapsed)
                 uncollapse(range);
-        } else if (range->fromLine >= Line - 1 && range->fromLine < Line + Count) // delete inside affectec area
-            mAllFoldRanges->remove(i);
-        else if (range->fromLine >= Line + Count) // Move after affected area
+            range->fromLine = Line;
+            if (range->closingLine >= 0) {
+                range->closingLine = shiftLine(range->closingLine);
+                range->toLine = std::max(Line, range->toLine - Count);
+            } else
+                range->toLine = Line;
+            damaged = true;
+        } else // Move after affected area
             range->move(-Count);
-
     }
-
+    // folds around the deletion are the last fold starting before it and its parents
+    PCodeFoldingRange range;
+    if (index>0)
+        range = (*mAllFoldRanges)[index-1];
+    while (range) {
+        if (range->closingLine >= deletedLine + Count) {
+            range->toLine -= Count;
+            range->closingLine -= Count;
+        } else if (range->closingLine >= deletedLine) {
+            // fold is closed in the deleted lines
+            if (range->collapsed)
+                uncollapse(range);
+            range->toLine = Line;
+            range->closingLine = deletedLine;
+            damaged = true;
+        }
+        range = range->parent.lock();
+    }
+    if (damaged)
+        markFoldsDirty(deletedLine, deletedLine + 1);
 }
 
 void QSynEdit::foldOnListCleared()
 {
     mAllFoldRanges->clear();
+    mFoldDirtyStartLine = -1;
+    mFoldDirtyEndLine = -1;
+}
+
+void QSynEdit::markFoldsDirty(int startLine, int endLine)
+{
+    if (mFoldDirtyStartLine<0) {
+        mFoldDirtyStartLine = startLine;
+        mFoldDirtyEndLine = endLine;
+    } else {
+        mFoldDirtyStartLine = std::min(mFoldDirtyStartLine, startLine);
+        mFoldDirtyEndLine = std::max(mFoldDirtyEndLine, endLine);
+    }
+}
+
+void QSynEdit::updateFoldRanges()
+{
+    if (mFoldDirtyStartLine<0)
+        return;
+    if (!useCodeFolding()) {
+        mFoldDirtyStartLine = -1;
+        mFoldDirtyEndLine = -1;
+        return;
+    }
+    //folds are rescanned when the pending syntax scan is finished
+    if (mSyntaxScanPendingLine>=0)
+        return;
+    int startLine = std::min(mFoldDirtyStartLine, mDocument->count());
+    int endLine = std::min(mFoldDirtyEndLine, mDocument->count());
+    mFoldDirtyStartLine = -1;
+    mFoldDirtyEndLine = -1;
+    incPaintLock();
+    if (!rescanFoldRangesBetween(startLine, endLine))
+        rescanForFoldRanges();
+    invalidateGutter();
+    decPaintLock();
+}
+
+bool QSynEdit::rescanFoldRangesBetween(int startLine, int endLine)
+{
+    // Find the innermost fold around the changed lines, whose own lines are not changed.
+    // Only its sub folds are rescanned, if they still end at the same line.
+    int index = mAllFoldRanges->findFirstFrom(startLine + 1);
+    if (index == 0)
+        return false;
+    PCodeFoldingRange root = (*mAllFoldRanges)[index-1];
+    while (root) {
+        if (root->fromLine - 1 < startLine && root->closingLine >= endLine) {
+            // sub folds starting at the same line are not rescanned
+            int subCount = root->subFoldRanges->count();
+            if (subCount == 0 || root->subFoldRanges->range(0)->fromLine != root->fromLine)
+                break;
+        }
+        root = root->parent.lock();
+    }
+    if (!root)
+        return false;
+    int rootStart = root->fromLine - 1;
+    int rootEnd = root->closingLine;
+    int rootIndex = mAllFoldRanges->findFirstFrom(root->fromLine);
+    while ((*mAllFoldRanges)[rootIndex]!=root)
+        rootIndex++;
+
+    // old sub folds are right after the root, and start before its closing line
+    QHash<qint64,int> collapsedFolds;
+    int oldEnd = rootIndex + 1;
+    int oldOpenAtEnd = 0;
+    while (oldEnd < mAllFoldRanges->count()
+           && (*mAllFoldRanges)[oldEnd]->fromLine - 1 < rootEnd) {
+        PCodeFoldingRange range = (*mAllFoldRanges)[oldEnd];
+        if (range->closingLine == rootEnd)
+            oldOpenAtEnd++;
+        if (range->collapsed)
+            collapsedFolds.insert(foldRangeKey(range), range->linesCollapsed);
+        oldEnd++;
+    }
+
+    QVector<PCodeFoldingRange> newRanges;
+    PCodeFoldingRanges newSubFoldRanges = std::make_shared<CodeFoldingRanges>();
+    PCodeFoldingRange parent = root;
+    int openCount = 0;
+    for (int line = rootStart + 1; line < rootEnd; line++) {
+        int blockEnded=mDocument->blockEnded(line);
+        int blockStarted=mDocument->blockStarted(line);
+        for (int i=0; i<blockEnded;i++) {
+            // the root is closed before its closing line
+            if (openCount == 0)
+                return false;
+            parent->toLine = (blockStarted>0) ? line : line + 1;
+            parent->closingLine = line;
+            parent = parent->parent.lock();
+            openCount--;
+        }
+        for (int i=0; i<blockStarted;i++) {
+            PCodeFoldingRange range = std::make_shared<CodeFoldingRange>(parent, line + 1, line + 1);
+            if (parent == root)
+                newSubFoldRanges->add(range);
+            else
+                parent->subFoldRanges->add(range);
+            newRanges.append(range);
+            parent = range;
+            openCount++;
+        }
+    }
+    // the root must be closed by the same block end of its closing line
+    if (openCount != oldOpenAtEnd)
+        return false;
+    int blockStarted = mDocument->blockStarted(rootEnd);
+    while (openCount > 0) {
+        parent->toLine = (blockStarted>0) ? rootEnd : rootEnd + 1;
+        parent->closingLine = rootEnd;
+        parent = parent->parent.lock();
+        openCount--;
+    }
+
+    foreach (const PCodeFoldingRange& range, newRanges) {
+        auto it = collapsedFolds.constFind(foldRangeKey(range));
+        if (it != collapsedFolds.constEnd()) {
+            range->collapsed = true;
+            range->linesCollapsed = it.value();
+        }
+    }
+    root->subFoldRanges = newSubFoldRanges;
+    mAllFoldRanges->replace(rootIndex + 1, oldEnd - rootIndex - 1, newRanges);
+    return true;
 }
 
 void QSynEdit::rescanFolds()
@@ -3401,6 +3757,8 @@ void QSynEdit::rescanFolds()
     if (!useCodeFolding())
         return;
 
+    mFoldDirtyStartLine = -1;
+    mFoldDirtyEndLine = -1;
     incPaintLock();
     rescanForFoldRanges();
     invalidateGutter();
@@ -3409,42 +3767,23 @@ void QSynEdit::rescanFolds()
 
 void QSynEdit::rescanForFoldRanges()
 {
-    // Delete all uncollapsed folds
-//    for (int i=mAllFoldRanges.count()-1;i>=0;i--) {
-//        PSynEditFoldRange range =mAllFoldRanges[i];
-//        if (!range->collapsed && !range->parentCollapsed())
-//            mAllFoldRanges.remove(i);
-//    }
-
-    // Did we leave any collapsed folds and are we viewing a code file?
-    if (mAllFoldRanges->count() > 0) {
-        QMap<QString,PCodeFoldingRange> rangeIndexes;
-        foreach(const PCodeFoldingRange& r, mAllFoldRanges->ranges()) {
-            if (r->collapsed)
-                rangeIndexes.insert(QString("%1-%2").arg(r->fromLine).arg(r->toLine),r);
-        }
-        mAllFoldRanges->clear();
-        // Add folds to a separate list
-        PCodeFoldingRanges temporaryAllFoldRanges = std::make_shared<CodeFoldingRanges>();
-        scanForFoldRanges(temporaryAllFoldRanges);
-
-        PCodeFoldingRange tempFoldRange;
-        PCodeFoldingRange r2;
-        // Combine new with old folds, preserve parent order
-        for (int i = 0; i< temporaryAllFoldRanges->count();i++) {
-            tempFoldRange=temporaryAllFoldRanges->range(i);
-            r2=rangeIndexes.value(QString("%1-%2").arg(tempFoldRange->fromLine).arg(tempFoldRange->toLine),
-                                  PCodeFoldingRange());
-            if (r2) {
-                tempFoldRange->collapsed=true;
-                tempFoldRange->linesCollapsed=r2->linesCollapsed;
-            }
-            mAllFoldRanges->add(tempFoldRange);
+    // keep collapsed folds that are still there
+    QHash<qint64,int> collapsedFolds;
+    foreach(const PCodeFoldingRange& r, mAllFoldRanges->ranges()) {
+        if (r->collapsed)
+            collapsedFolds.insert(foldRangeKey(r), r->linesCollapsed);
+    }
+    mAllFoldRanges->clear();
+    PCodeFoldingRanges temp{mAllFoldRanges};
+    scanForFoldRanges(temp);
+    if (collapsedFolds.isEmpty())
+        return;
+    foreach(const PCodeFoldingRange& r, mAllFoldRanges->ranges()) {
+        auto it = collapsedFolds.constFind(foldRangeKey(r));
+        if (it != collapsedFolds.constEnd()) {
+            r->collapsed = true;
+            r->linesCollapsed = it.value();
         }
-    } else {
-        // We ended up with no folds after deleting, just pass standard data...
-        PCodeFoldingRanges temp{mAllFoldRanges};
-        scanForFoldRanges(temp);
     }
 }
 
@@ -3477,6 +3816,7 @@ void QSynEdit::findSubFoldRange(PCodeFoldingRanges topFoldRanges, PCodeFoldingRa
                         parent->toLine = line;
                     else
                         parent->toLine = line + 1;
+                    parent->closingLine = line;
                     parent = parent->parent.lock();
                     if (!parent) {
                         parentFoldRanges = topFoldRanges;
@@ -3503,12 +3843,12 @@ void QSynEdit::findSubFoldRange(PCodeFoldingRanges topFoldRanges, PCodeFoldingRa
 
 PCodeFoldingRange QSynEdit::collapsedFoldStartAtLine(int Line)
 {
-    for (int i = 0; i< mAllFoldRanges->count() - 1; i++ ) {
-        if ((*mAllFoldRanges)[i]->collapsed && (*mAllFoldRanges)[i]->fromLine == Line) {
+    // sorted by line
+    for (int i = mAllFoldRanges->findFirstFrom(Line); i< mAllFoldRanges->count(); i++ ) {
+        if ((*mAllFoldRanges)[i]->fromLine > Line)
+            break;
+        if ((*mAllFoldRanges)[i]->collapsed)
             return (*mAllFoldRanges)[i];
-        } else if ((*mAllFoldRanges)[i]->fromLine > Line) {
-            break; // sorted by line. don't bother scanning further
-        }
     }
     return PCodeFoldingRange();
 }
@@ -3520,13 +3860,10 @@ void QSynEdit::initializeCaret()
 
 PCodeFoldingRange QSynEdit::foldStartAtLine(int Line) const
 {
-    for (int i = 0; i<mAllFoldRanges->count();i++) {
-        PCodeFoldingRange range = (*mAllFoldRanges)[i];
-        if (range->fromLine == Line ){
-            return range;
-        } else if (range->fromLine>Line)
-            break; // sorted by line. don't bother scanning further
-    }
+    // sorted by line
+    int i = mAllFoldRanges->findFirstFrom(Line);
+    if (i<mAllFoldRanges->count() && (*mAllFoldRanges)[i]->fromLine == Line)
+        return (*mAllFoldRanges)[i];
     return PCodeFoldingRange();
 }
 
@@ -3738,8 +4075,47 @@ void QSynEdit::onHScrolled(int value)
 
 void QSynEdit::onVScrolled(int value)
 {
+    int dy = mTopPos - value;
     mTopPos = value;
-    invalidate();
+    if (!scrollContentImage(dy))
+        invalidate();
+}
+
+bool QSynEdit::scrollContentImage(int dy)
+{
+    if (dy == 0)
+        return true;
+    int height = clientHeight();
+    if (!isVisible() || std::abs(dy) >= height)
+        return false;
+    QRect rcClient(0, 0, clientWidth(), height);
+    // nothing to reuse if the whole image is dirty
+    if (QRegion(rcClient).subtracted(mContentDirtyRegion).isEmpty())
+        return false;
+    qreal dpr = mContentImage->devicePixelRatioF();
+    qreal pixels = dy * dpr;
+    int dyPixels = std::round(pixels);
+    if (pixels != dyPixels)
+        return false;
+    int bytesPerLine = mContentImage->bytesPerLine();
+    int rows = mContentImage->height() - std::abs(dyPixels);
+    if (rows<=0)
+        return false;
+    //move the rows of the image, and only paint the exposed ones
+    uchar* bits = mContentImage->bits();
+    if (dyPixels > 0)
+        memmove(bits + dyPixels * bytesPerLine, bits, rows * bytesPerLine);
+    else
+        memmove(bits, bits - dyPixels * bytesPerLine, rows * bytesPerLine);
+    mContentDirtyRegion.translate(0, dy);
+    if (dy > 0)
+        mContentDirtyRegion += QRect(0, 0, rcClient.width(), dy);
+    else
+        mContentDirtyRegion += QRect(0, height + dy, rcClient.width(), -dy);
+    mContentDirtyRegion &= rcClient;
+    mContentScrolled = true;
+    viewport()->update();
+    return true;
 }
 
 
@@ -4033,6 +4409,7 @@ void QSynEdit::setOptions(const EditorOptions &value)
                 || !sameEditorOption(value,mOptions, EditorOption::ShowLineBreaks)
                 || !sameEditorOption(value,mOptions, EditorOption::ShowRainbowColor);
         mOptions = value;
+        mUndoList->setMergeInserts(mOptions.testFlag(EditorOption::GroupUndo));
 
         setScrollBars(mScrollBars);
         mDocument->setForceMonospace(mOptions.testFlag(EditorOption::ForceMonospace) );
@@ -4627,6 +5004,9 @@ void QSynEdit::setUseCodeFolding(bool value)
 {
     if (mUseCodeFolding!=value) {
         mUseCodeFolding = value;
+        //folds are not maintained when code folding is off
+        if (mUseCodeFolding)
+            rescanFolds();
     }
 }
 
@@ -4677,6 +5057,7 @@ void QSynEdit::setSyntaxer(const PSyntaxer &syntaxer)
     Q_ASSERT(syntaxer!=nullptr);
     PSyntaxer oldSyntaxer = mSyntaxer;
     mSyntaxer = syntaxer;
+    mTokenRunsGeneration = newTokenRunsGeneration();
     if (oldSyntaxer ->language() != syntaxer->language()) {
         recalcCharExtent();
         mDocument->beginUpdate();
@@ -5829,7 +6210,7 @@ void QSynEdit::endEditingWithoutUndo()
 {
     mEditingCount--;
     if (mEditingCount==0)
-        reparseDocument();
+        updateFoldRanges();
 }
 
 bool QSynEdit::isIdentChar(const QChar &ch)
@@ -5877,14 +6258,25 @@ bool QSynEdit::isCaretVisible()
 
 void QSynEdit::paintEvent(QPaintEvent *event)
 {
+    QElapsedTimer paintTimer;
+    if (mMeasurePaintTime)
+        paintTimer.start();
     // Now paint everything while the caret is hidden.
     QPainter painter(viewport());
     //Get the invalidated rect.
     QRect rcClip = event->rect();
     QRect rcCaret;
     bool onlyUpdateCaret = false;
-    if (mDocument->maxLineWidth()>=0) {
-        onlyUpdateCaret = (calculateCaretRect() == rcClip);
+    if (mDocument->maxLineWidth()>=0 && !mContentScrolled) {
+        onlyUpdateCaret = (calculateCaretRect() == rcClip)
+                && !mContentDirtyRegion.intersects(rcClip);
+    }
+    // After the image is scrolled, only the exposed and other dirty areas are painted into it
+    QRect rcPaint = rcClip;
+    bool scrolled = mContentScrolled;
+    if (mContentScrolled) {
+        rcPaint = (mContentDirtyRegion & rcClip).boundingRect();
+        mContentScrolled = false;
     }
     if (onlyUpdateCaret) {
         rcCaret = rcClip;
@@ -5900,36 +6292,42 @@ void QSynEdit::paintEvent(QPaintEvent *event)
         painter.drawImage(rcCaret,*mContentImage,cacheRC);
     } else {
         //qDebug()<<"paint event:"<<QDateTime::currentDateTime()<<rcClip;
-        QRect rcDraw;
-        int nL1, nL2, nX1, nX2;
-        // Compute the invalid area in lines / columns.
-        // columns
-        nX1 = mLeftPos;
-        if (rcClip.left() > mGutterWidth + 2 )
-            nX1 += (rcClip.left() - mGutterWidth - 2 ) ;
-        nX2 = mLeftPos + (rcClip.right() - mGutterWidth - 2);
-        // lines
-        nL1 = minMax(yposToRow(0) + rcClip.top() / mTextHeight, yposToRow(0), displayLineCount());
-        nL2 = minMax(yposToRow(0) + (rcClip.bottom() + mTextHeight - 1) / mTextHeight, 1, displayLineCount());
-
-        //qDebug()<<"Paint:"<<nL1<<nL2<<nC1<<nC2;
-
-        QPainter cachePainter(mContentImage.get());
-        cachePainter.setFont(font());
-        QSynEditPainter textPainter(this, &cachePainter,
-                                       nL1,nL2,nX1,nX2);
-        // First paint paint the text area if it was (partly) invalidated.
-        if (rcClip.right() > mGutterWidth ) {
-            rcDraw = rcClip;
-            rcDraw.setLeft( std::max(rcDraw.left(), mGutterWidth));
-            textPainter.paintEditingArea(rcDraw);
-        }
-
-        // Then the gutter area if it was (partly) invalidated.
-        if (rcClip.left() < mGutterWidth) {
-            rcDraw = rcClip;
-            rcDraw.setRight(mGutterWidth-1);
-            textPainter.paintGutter(rcDraw);
+        if (!rcPaint.isEmpty()) {
+            QRect rcDraw;
+            int nL1, nL2, nX1, nX2;
+            // Compute the invalid area in lines / columns.
+            // columns
+            nX1 = mLeftPos;
+            if (rcPaint.left() > mGutterWidth + 2 )
+                nX1 += (rcPaint.left() - mGutterWidth - 2 ) ;
+            nX2 = mLeftPos + (rcPaint.right() - mGutterWidth - 2);
+            // lines
+            nL1 = minMax(yposToRow(0) + rcPaint.top() / mTextHeight, yposToRow(0), displayLineCount());
+            nL2 = minMax(yposToRow(0) + (rcPaint.bottom() + mTextHeight - 1) / mTextHeight, 1, displayLineCount());
+
+            //qDebug()<<"Paint:"<<nL1<<nL2<<nC1<<nC2;
+
+            //lines to be painted must have valid syntax states
+            scanPendingSyntax(rowToLine(nL2), -1);
+
+            QPainter cachePainter(mContentImage.get());
+            cachePainter.setFont(font());
+            QSynEditPainter textPainter(this, &cachePainter,
+                                           nL1,nL2,nX1,nX2);
+            // First paint paint the text area if it was (partly) invalidated.
+            if (rcPaint.right() > mGutterWidth ) {
+                rcDraw = rcPaint;
+                rcDraw.setLeft( std::max(rcDraw.left(), mGutterWidth));
+                textPainter.paintEditingArea(rcDraw);
+            }
+
+            // Then the gutter area if it was (partly) invalidated.
+            if (rcPaint.left() < mGutterWidth) {
+                rcDraw = rcPaint;
+                rcDraw.setRight(mGutterWidth-1);
+                textPainter.paintGutter(rcDraw);
+            }
+            mContentDirtyRegion -= rcPaint;
         }
 
         //PluginsAfterPaint(Canvas, rcClip, nL1, nL2);
@@ -5946,6 +6344,10 @@ void QSynEdit::paintEvent(QPaintEvent *event)
         rcCaret = calculateCaretRect();
     }
     paintCaret(painter, rcCaret);
+    if (mMeasurePaintTime) {
+        qDebug()<<"paint"<<rcClip<<"painted"<<(onlyUpdateCaret?QRect():rcPaint)
+               <<(scrolled?"scrolled":"")<<paintTimer.nsecsElapsed()/1000.0<<"us";
+    }
 }
 
 void QSynEdit::resizeEvent(QResizeEvent *)
@@ -5955,6 +6357,8 @@ void QSynEdit::resizeEvent(QResizeEvent *)
     mContentImage = std::make_shared<QImage>(clientWidth()*dpr,clientHeight()*dpr,
                                                             QImage::Format_ARGB32);
     mContentImage->setDevicePixelRatio(dpr);
+    mContentDirtyRegion = QRect(0, 0, clientWidth(), clientHeight());
+    mContentScrolled = false;
 
     onSizeOrFontChanged();
 }
@@ -6513,6 +6917,8 @@ void QSynEdit::onLinesChanging()
 
 void QSynEdit::onLinesCleared()
 {
+    mSyntaxScanPendingLine = -1;
+    mSyntaxScanTimer->stop();
     if (useCodeFolding())
         foldOnListCleared();
     clearUndo();
@@ -6528,6 +6934,10 @@ void QSynEdit::onLinesCleared()
 
 void QSynEdit::onLinesDeleted(int line, int count)
 {
+    if (mSyntaxScanPendingLine>line) {
+        mSyntaxScanPendingLine = std::max(line, mSyntaxScanPendingLine - count);
+        mSyntaxScanEndLine = std::max(line, mSyntaxScanEndLine - count);
+    }
     if (useCodeFolding())
         foldOnLinesDeleted(line + 1, count);
     if (mSyntaxer->needsLineState()) {
@@ -6538,6 +6948,12 @@ void QSynEdit::onLinesDeleted(int line, int count)
 
 void QSynEdit::onLinesInserted(int line, int count)
 {
+    if (mSyntaxScanPendingLine>=0) {
+        if (line < mSyntaxScanPendingLine)
+            mSyntaxScanPendingLine += count;
+        if (line < mSyntaxScanEndLine)
+            mSyntaxScanEndLine += count;
+    }
     if (useCodeFolding())
         foldOnLinesInserted(line + 1, count);
     if (mSyntaxer->needsLineState()) {
@@ -6549,6 +6965,13 @@ void QSynEdit::onLinesInserted(int line, int count)
     invalidateLines(line + 1, INT_MAX);
 }
 
+void QSynEdit::onLinesLoaded()
+{
+    // lines of a staged load are added without changed()
+    if (mGutter.showLineNumbers() && (mGutter.autoSize()))
+        mGutter.autoSizeDigitCount(mDocument->count());
+}
+
 void QSynEdit::onLinesPutted(int line)
 {
     if (mSyntaxer->needsLineState()) {
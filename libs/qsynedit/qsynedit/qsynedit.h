@@ -21,6 +21,7 @@
 #include <QCursor>
 #include <QDateTime>
 #include <QFrame>
+#include <QRegion>
 #include <QStringList>
 #include <QTimer>
 #include <QWidget>
@@ -215,6 +216,12 @@ public:
     void invalidateSelection();
     void invalidateRect(const QRect& rect);
     void invalidate();
+    // drop the tokens cached for painting, when settings of the syntaxer are changed
+    void invalidateSyntaxTokens();
+    // log the time used by each paint event with qDebug()
+    // it's also turned on by the QSYNEDIT_MEASURE_PAINT_TIME environment variable
+    bool measurePaintTime() const;
+    void setMeasurePaintTime(bool newMeasurePaintTime);
     bool selAvail() const;
     bool colSelAvail() const;
     QString wordAtCursor();
@@ -381,6 +388,19 @@ public:
 
     QStringList getContent(BufferCoord startPos, BufferCoord endPos, SelectionMode mode) const;
     void reparseDocument();
+    /**
+     * @brief count of lines whose syntax states are not calculated yet
+     *
+     * Large documents are scanned in time slices after the visible lines are done.
+     */
+    int pendingSyntaxScanLines() const;
+    /**
+     * @brief calculate syntax states of all the pending lines now
+     *
+     * Reading the state of a pending line from the document scans up to it,
+     * so it's only needed before walking the whole document.
+     */
+    void finishSyntaxScan();
 
     QString lineBreak() const;
 
@@ -413,6 +433,11 @@ public:
 
     bool canUndo() const;
     bool canRedo() const;
+    // estimated bytes held by the undo and redo lists
+    qint64 undoMemoryUsage() const;
+    // 0 means no limit
+    qint64 maxUndoMemoryUsage() const;
+    void setMaxUndoMemoryUsage(qint64 newMaxUndoMemoryUsage);
 
     int textHeight() const;
 
@@ -531,12 +556,18 @@ private:
     void updateModifiedStatus();
     int reparseLines(int startLine, int endLine, bool needRescanFolds = true,  bool toDocumentEnd = true);
     //void reparseLine(int line);
+    int lastVisibleLine() const;
+    void schedulePendingSyntaxScan(int line, int endLine);
+    void scanPendingSyntax(int endLine, int msecs);
     void uncollapse(PCodeFoldingRange FoldRange);
     void collapse(PCodeFoldingRange FoldRange);
 
     void foldOnLinesInserted(int Line, int Count);
     void foldOnLinesDeleted(int Line, int Count);
     void foldOnListCleared();
+    void markFoldsDirty(int startLine, int endLine);
+    void updateFoldRanges(); // update folds of the dirty lines
+    bool rescanFoldRangesBetween(int startLine, int endLine);
     void rescanFolds(); // rescan for folds
     void rescanForFoldRanges();
     void scanForFoldRanges(PCodeFoldingRanges topFoldRanges);
@@ -653,19 +684,34 @@ private slots:
     void onLinesCleared();
     void onLinesDeleted(int line, int count);
     void onLinesInserted(int line, int count);
+    void onLinesLoaded();
     void onLinesPutted(int line);
     //void onRedoAdded();
     void onScrollTimeout();
     void onDraggingScrollTimeout();
+    void onSyntaxScanTimeout();
     void onUndoAdded();
     void onSizeOrFontChanged();
     void onChanged();
     void onHScrolled(int value);
     void onVScrolled(int value);
 
+private:
+    bool scrollContentImage(int dy);
+
 private:
     std::shared_ptr<QImage> mContentImage;
+    // areas of the content image that are out of date
+    QRegion mContentDirtyRegion;
+    // the content image is scrolled, only its dirty region needs to be painted again
+    bool mContentScrolled;
+    bool mMeasurePaintTime;
+    // tokens cached in the document are only used by the syntaxer of the same generation
+    int mTokenRunsGeneration;
     PCodeFoldingRanges mAllFoldRanges;
+    // lines whose block starts/ends are changed since folds are updated, -1 if none
+    int mFoldDirtyStartLine;
+    int mFoldDirtyEndLine;
     CodeFoldingOptions mCodeFolding;
     int mEditingCount;
     bool mUseCodeFolding;
@@ -724,6 +770,13 @@ private:
     int mLastKey;
     Qt::KeyboardModifiers mLastKeyModifiers;
     QTimer*  mScrollTimer;
+    QTimer*  mSyntaxScanTimer;
+    // syntax states of lines from mSyntaxScanPendingLine are not calculated yet (-1 if all done)
+    int mSyntaxScanPendingLine;
+    // pending lines before it must be scanned even if their states are unchanged
+    int mSyntaxScanEndLine;
+    // lines are being scanned, so reading their states doesn't trigger the pending scan
+    bool mSyntaxScanning;
 
     PSynEdit  fChainedEditor;
 
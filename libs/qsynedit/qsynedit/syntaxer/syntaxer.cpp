@@ -156,7 +156,7 @@ TokenAttribute::TokenAttribute(const QString &name, TokenType tokenType):
 
 }
 
-bool SyntaxState::operator==(const SyntaxState &s2)
+bool SyntaxState::operator==(const SyntaxState &s2) const
 {
     // indents contains the information of brace/parenthesis/brackets embedded levels
     return (state == s2.state)
@@ -208,4 +208,82 @@ bool IndentInfo::operator==(const IndentInfo &i2) const
     return type==i2.type && line==i2.line;
 }
 
+SyntaxStatePool::SyntaxStatePool():
+    mCount{0},
+    mPurgeThreshold{1024}
+{
+}
+
+PSyntaxState SyntaxStatePool::intern(const SyntaxState &state)
+{
+    uint hash = hashState(state);
+    auto it = mStates.constFind(hash);
+    while (it!=mStates.constEnd() && it.key()==hash) {
+        if (sameState(*it.value(), state))
+            return it.value();
+        ++it;
+    }
+    if (mCount >= mPurgeThreshold)
+        purge();
+    PSyntaxState newState = std::make_shared<const SyntaxState>(state);
+    mStates.insert(hash, newState);
+    mCount++;
+    return newState;
+}
+
+void SyntaxStatePool::clear()
+{
+    mStates.clear();
+    mCount = 0;
+    mPurgeThreshold = 1024;
+}
+
+const PSyntaxState &SyntaxStatePool::defaultState()
+{
+    static const PSyntaxState state = std::make_shared<const SyntaxState>();
+    return state;
+}
+
+uint SyntaxStatePool::hashState(const SyntaxState &state)
+{
+    uint h = state.state;
+    h = h * 31 + state.blockLevel;
+    h = h * 31 + state.blockStarted;
+    h = h * 31 + state.blockEnded;
+    h = h * 31 + state.blockEndedLastLine;
+    h = h * 31 + state.braceLevel;
+    h = h * 31 + state.bracketLevel;
+    h = h * 31 + state.parenthesisLevel;
+    h = h * 31 + state.indents.count();
+    if (!state.indents.isEmpty()) {
+        h = h * 31 + (uint)state.indents.back().type;
+        h = h * 31 + state.indents.back().line;
+    }
+    h = h * 31 + (uint)state.lastUnindent.type;
+    h = h * 31 + state.lastUnindent.line;
+    h = h * 31 + state.hasTrailingSpaces;
+    h = h * 31 + state.extraData.count();
+    return h;
+}
+
+bool SyntaxStatePool::sameState(const SyntaxState &s1, const SyntaxState &s2)
+{
+    // operator== doesn't compare hasTrailingSpaces
+    return s1 == s2
+            && s1.hasTrailingSpaces == s2.hasTrailingSpaces;
+}
+
+void SyntaxStatePool::purge()
+{
+    // remove states not used by any line
+    for (auto it = mStates.begin(); it!=mStates.end();) {
+        if (it.value().use_count()==1) {
+            it = mStates.erase(it);
+            mCount--;
+        } else
+            ++it;
+    }
+    mPurgeThreshold = std::max(1024, mCount * 2);
+}
+
 }
@@ -20,6 +20,7 @@
 #include <QColor>
 #include <QObject>
 #include <memory>
+#include <QHash>
 #include <QMap>
 #include <QSet>
 #include <QVector>
@@ -59,12 +60,43 @@ struct SyntaxState {
     bool hasTrailingSpaces;
     QMap<QString,QVariant> extraData;
 
-    bool operator==(const SyntaxState& s2);
+    bool operator==(const SyntaxState& s2) const;
     IndentInfo getLastIndent();
     IndentType getLastIndentType();
     SyntaxState();
 };
 
+using PSyntaxState = std::shared_ptr<const SyntaxState>;
+
+/**
+ * @brief Pool of deduplicated syntax states
+ *
+ * Most consecutive lines end in the same state, so lines hold handles of
+ * the immutable states in the pool, and same states are the same handle.
+ */
+class SyntaxStatePool {
+public:
+    explicit SyntaxStatePool();
+    /**
+     * @brief get the handle of the state, the state is added to the pool if it's new
+     */
+    PSyntaxState intern(const SyntaxState& state);
+    void clear();
+    int count() const { return mCount; }
+    /**
+     * @brief the handle of the default state, shared by all pools
+     */
+    static const PSyntaxState& defaultState();
+private:
+    static uint hashState(const SyntaxState& state);
+    static bool sameState(const SyntaxState& s1, const SyntaxState& s2);
+    void purge();
+private:
+    QMultiHash<uint, PSyntaxState> mStates;
+    int mCount;
+    int mPurgeThreshold;
+};
+
 enum class TokenType {
     Default,
     Comment, // any comment